@@ -0,0 +1,36 @@
+/*
+ *
+ * Copyright (C) 2025 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef NVTOP_DAEMON_H_
+#define NVTOP_DAEMON_H_
+
+#include "list.h"
+
+#include <signal.h>
+
+// Samples the devices every update_interval milliseconds and sends the samples to the clients connected to the Unix
+// socket at socket_path (see gpuinfo_protocol.h), until stop becomes non-zero. The remote clients are served on the
+// TCP address listen_address ("[address:]port") unless it is NULL.
+// The devices must have their static information populated. Returns the exit status of the program.
+int nvtop_daemon_run(struct list_head *devices, const char *socket_path, const char *listen_address,
+                     int update_interval, volatile sig_atomic_t *stop);
+
+#endif // NVTOP_DAEMON_H_
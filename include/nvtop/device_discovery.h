@@ -22,6 +22,9 @@
 #ifndef NVTOP_DEVICE_DISCOVERY_H__
 #define NVTOP_DEVICE_DISCOVERY_H__
 
+#include <stddef.h>
+#include <stdint.h>
+
 // Devices
 typedef struct nvtop_device nvtop_device;
 
@@ -57,8 +60,28 @@ typedef struct {
 } nvtop_pcie_link;
 
 int nvtop_device_maximum_pcie_link(nvtop_device *dev, nvtop_pcie_link *pcie_info);
-int nvtop_device_current_pcie_link(nvtop_device *dev, nvtop_pcie_link *pcie_info);
 
 nvtop_device *nvtop_device_get_hwmon(nvtop_device *dev);
 
+// Sysfs attributes kept open for repeated reads.
+// Unlike nvtop_device_get_sysattr_value, the value is never cached and the file is not re-opened on each read.
+typedef struct nvtop_sysfs_attr nvtop_sysfs_attr;
+
+nvtop_sysfs_attr *nvtop_sysfs_attr_open(const char *path);
+nvtop_sysfs_attr *nvtop_sysfs_attr_open_from_device(nvtop_device *dev, const char *sysattr);
+void nvtop_sysfs_attr_close(nvtop_sysfs_attr *attr);
+
+// Returns the current content of the attribute (valid until the next read) or NULL on error
+const char *nvtop_sysfs_attr_read(nvtop_sysfs_attr *attr);
+int nvtop_sysfs_attr_read_uint64(nvtop_sysfs_attr *attr, uint64_t *value);
+// Copies up to size bytes of a binary attribute, returns the number of bytes copied or a negative error
+int nvtop_sysfs_attr_read_binary(nvtop_sysfs_attr *attr, void *buffer, size_t size);
+
+// Upstream PCIe ports of a device, resolved once to query the current link characteristics
+typedef struct nvtop_pcie_link_ports nvtop_pcie_link_ports;
+
+nvtop_pcie_link_ports *nvtop_device_pcie_link_ports(nvtop_device *dev);
+void nvtop_pcie_link_ports_free(nvtop_pcie_link_ports *ports);
+int nvtop_pcie_link_ports_current_link(nvtop_pcie_link_ports *ports, nvtop_pcie_link *pcie_info);
+
 #endif // NVTOP_DEVICE_DISCOVERY_H__
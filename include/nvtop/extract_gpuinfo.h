@@ -34,10 +34,26 @@ bool gpuinfo_populate_static_infos(struct list_head *devices);
 
 bool gpuinfo_refresh_dynamic_info(struct list_head *devices);
 
+// Number of updates between two queries of a dynamic field: 1 (the default) queries it at every update, 0 only once
+// it got a value.
+// Only the backends checking GPUINFO_DYNAMIC_FIELD_DUE honor it.
+void gpuinfo_set_dynamic_refresh_period(enum gpuinfo_dynamic_info_valid field, unsigned period);
+
+// The metrics needed on every device by the consumers of the samples besides the interface (exporter, statistics,
+// energy accounting). The interface adds them to what it subscribes the devices to.
+void gpuinfo_add_consumer_needs(gpuinfo_subscription needs);
+gpuinfo_subscription gpuinfo_consumer_needs(void);
+
 bool gpuinfo_fix_dynamic_info_from_process_info(struct list_head *devices);
 
 bool gpuinfo_refresh_processes(struct list_head *devices);
 
+// Length of the longest user name among the processes of the last refresh
+unsigned gpuinfo_largest_user_name_length(void);
+
+// Accounts for the user names of the processes that were not gathered by this instance
+void gpuinfo_set_shared_user_name_length(unsigned length);
+
 bool gpuinfo_utilisation_rate(struct list_head *devices);
 
 void gpuinfo_clean(struct list_head *devices);
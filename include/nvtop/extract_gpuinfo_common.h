@@ -81,6 +81,27 @@ struct gpuinfo_static_info {
   unsigned char valid[(gpuinfo_static_info_count + CHAR_BIT - 1) / CHAR_BIT];
 };
 
+// Engine classes of the per-engine utilization breakdown
+enum gpuinfo_engine_class {
+  gpuinfo_engine_render = 0, // 3D/graphics (Intel rcs, AMD gfx)
+  gpuinfo_engine_compute,    // Intel ccs, AMD compute
+  gpuinfo_engine_copy,       // Intel bcs, AMD dma
+  gpuinfo_engine_decode,     // Intel vcs, AMD dec
+  gpuinfo_engine_encode,     // Intel vecs, AMD enc
+  gpuinfo_engine_class_count,
+};
+
+// Reasons of the driver for holding the clocks below their maximum, bits of throttle_reasons
+enum gpuinfo_throttle_reason {
+  gpuinfo_throttle_power = 0, // Power or current limit
+  gpuinfo_throttle_thermal,   // Temperature limit
+  gpuinfo_throttle_hardware,  // Slowdown asserted by the board (power brake, VR hot)
+  gpuinfo_throttle_other,     // Reason not detailed by the driver
+  gpuinfo_throttle_reason_count,
+};
+
+#define GPUINFO_THROTTLE_REASON(reason) (1u << (reason))
+
 #define SET_GPUINFO_DYNAMIC(structPtr, field, value) SET_VALUE(structPtr, field, value, gpuinfo_)
 #define RESET_GPUINFO_DYNAMIC(structPtr, field) INVALIDATE_VALUE(structPtr, field, gpuinfo_)
 #define GPUINFO_DYNAMIC_FIELD_VALID(structPtr, field) VALUE_IS_VALID(structPtr, field, gpuinfo_)
@@ -106,9 +127,23 @@ enum gpuinfo_dynamic_info_valid {
   gpuinfo_power_draw_valid,
   gpuinfo_power_draw_max_valid,
   gpuinfo_multi_instance_mode_valid,
-  gpuinfo_dynamic_info_count,
+  gpuinfo_stale_data_age_valid,
+  gpuinfo_energy_consumed_valid,
+  gpuinfo_power_draw_peak_valid,
+  gpuinfo_power_draw_p99_valid,
+  gpuinfo_throttle_reasons_valid,
+  gpuinfo_engine_util_rate_valid, // One valid bit per engine class
+  gpuinfo_dynamic_info_count = gpuinfo_engine_util_rate_valid + gpuinfo_engine_class_count,
 };
 
+#define SET_GPUINFO_DYNAMIC_ENGINE(structPtr, engine, value)                                                           \
+  do {                                                                                                                 \
+    (structPtr)->engine_util_rate[engine] = (value);                                                                   \
+    SET_VALID(gpuinfo_engine_util_rate_valid + (engine), (structPtr)->valid);                                          \
+  } while (0)
+#define GPUINFO_DYNAMIC_ENGINE_VALID(structPtr, engine)                                                                \
+  IS_VALID(gpuinfo_engine_util_rate_valid + (engine), (structPtr)->valid)
+
 struct gpuinfo_dynamic_info {
   unsigned int gpu_clock_speed;     // Device clock speed in MHz
   unsigned int gpu_clock_speed_max; // Maximum clock speed in MHz
@@ -131,6 +166,12 @@ struct gpuinfo_dynamic_info {
   unsigned int power_draw;          // Power usage in milliwatts
   unsigned int power_draw_max;      // Max power usage in milliwatts
   bool multi_instance_mode;          // True if the GPU is in multi-instance mode
+  unsigned int stale_data_age;       // Age in seconds of the data when sampled asynchronously, only valid when stale
+  unsigned long long energy_consumed; // Energy in millijoules consumed since nvtop started
+  unsigned int power_draw_peak;       // Highest power sampled in milliwatts since the previous refresh
+  unsigned int power_draw_p99;        // 99th percentile of the power sampled in milliwatts since the previous refresh
+  unsigned int throttle_reasons;      // Set of GPUINFO_THROTTLE_REASON holding the clocks down, 0 when not throttled
+  unsigned int engine_util_rate[gpuinfo_engine_class_count]; // Utilization rate in % of each engine class
   unsigned char valid[(gpuinfo_dynamic_info_count + CHAR_BIT - 1) / CHAR_BIT];
 };
 
@@ -162,9 +203,20 @@ enum gpuinfo_process_info_valid {
   gpuinfo_process_cpu_memory_res_valid,
   gpuinfo_process_gpu_cycles_valid,
   gpuinfo_process_sample_delta_valid,
-  gpuinfo_process_info_count
+  gpuinfo_process_energy_consumed_valid,
+  gpuinfo_process_cpu_locality_valid,
+  gpuinfo_process_engine_usage_valid, // One valid bit per engine class
+  gpuinfo_process_info_count = gpuinfo_process_engine_usage_valid + gpuinfo_engine_class_count
 };
 
+#define SET_GPUINFO_PROCESS_ENGINE(structPtr, engine, value)                                                           \
+  do {                                                                                                                 \
+    (structPtr)->engine_usage[engine] = (value);                                                                       \
+    SET_VALID(gpuinfo_process_engine_usage_valid + (engine), (structPtr)->valid);                                      \
+  } while (0)
+#define GPUINFO_PROCESS_ENGINE_VALID(structPtr, engine)                                                                \
+  IS_VALID(gpuinfo_process_engine_usage_valid + (engine), (structPtr)->valid)
+
 struct gpu_process {
   enum gpu_process_type type;
   pid_t pid;                           // Process ID
@@ -179,17 +231,52 @@ struct gpu_process {
   unsigned gpu_usage;                  // Percentage of GPU used by the process
   unsigned encode_usage;               // Percentage of GPU encoder used by the process
   unsigned decode_usage;               // Percentage of GPU decoder used by the process
+  unsigned engine_usage[gpuinfo_engine_class_count]; // Percentage of each engine class used by the process
   unsigned long long gpu_memory_usage; // Memory used by the process
   unsigned gpu_memory_percentage;      // Percentage of the total device memory
                                        // consumed by the process
   unsigned cpu_usage;
   unsigned long cpu_memory_virt;
   unsigned long cpu_memory_res;
+  unsigned long long energy_consumed; // Share in millijoules of the device energy since nvtop saw the process
+  unsigned cpu_locality;              // Percentage of the threads last run on a CPU of the NUMA node of the device
   unsigned char valid[(gpuinfo_process_info_count + CHAR_BIT - 1) / CHAR_BIT];
 };
 
 struct gpu_info;
 
+// Groups of metrics the interface (or any other consumer) needs from a device.
+// The backends skip the queries of the groups nobody subscribed to and leave these fields invalid.
+enum gpuinfo_subscription_group {
+  gpuinfo_subscribe_clocks,        // Current and maximum clock speeds
+  gpuinfo_subscribe_utilisation,   // GPU utilization rate
+  gpuinfo_subscribe_encode_decode, // Encoder and decoder utilization rates
+  gpuinfo_subscribe_memory,        // Memory usage
+  gpuinfo_subscribe_pcie,          // PCIe link and throughput
+  gpuinfo_subscribe_thermal,       // Temperature and fan speed
+  gpuinfo_subscribe_power,         // Power draw and limit
+  gpuinfo_subscribe_processes,     // Running processes and their usage (also gives the per-engine utilization)
+  gpuinfo_subscribe_group_count,
+};
+
+typedef unsigned gpuinfo_subscription;
+
+#define GPUINFO_SUBSCRIPTION(group) (1u << (group))
+#define GPUINFO_SUBSCRIPTION_ALL (GPUINFO_SUBSCRIPTION(gpuinfo_subscribe_group_count) - 1)
+#define GPUINFO_SUBSCRIBED(gpuInfoPtr, group) (((gpuInfoPtr)->subscription & GPUINFO_SUBSCRIPTION(group)) != 0)
+
+// Set before each refresh_dynamic_info call for the fields to query during this update: subscribed to and due
+// according to their refresh period (see gpuinfo_set_dynamic_refresh_period). The valid bit of these fields is
+// cleared beforehand; the other fields keep their value and valid bit from the previous updates.
+#define GPUINFO_DYNAMIC_FIELD_DUE(gpuInfoPtr, field) IS_VALID(gpuinfo_##field##_valid, (gpuInfoPtr)->dynamic_due)
+
+// Instantaneous reading of the power sensor or of the energy counter of a device
+struct gpuinfo_power_reading {
+  bool is_energy;        // The value is a counter in microjoules instead of a power in milliwatts
+  unsigned counter_bits; // Width of the energy counter: below 64 it wraps around, otherwise a decrease is a reset
+  uint64_t value;
+};
+
 struct gpu_vendor {
   struct list_head list;
 
@@ -205,6 +292,10 @@ struct gpu_vendor {
   void (*refresh_utilisation_rate)(struct gpu_info *gpu_info);
 
   void (*refresh_running_processes)(struct gpu_info *gpu_info);
+  // Optional, reads the power of a device from the power sampler thread. Must not touch any other state of the backend.
+  bool (*sample_power)(struct gpu_info *gpu_info, struct gpuinfo_power_reading *reading);
+  // The pids of the processes are not the ones of this host, or of its pid namespace: they must not be signaled
+  bool foreign_pids;
   char *name;
 };
 
@@ -217,6 +308,11 @@ struct gpu_info {
   unsigned processes_count;
   struct gpu_process *processes;
   unsigned processes_array_size;
+  gpuinfo_subscription subscription; // Metrics to refresh, everything unless changed by the interface
+  unsigned dynamic_refresh_count;     // Number of dynamic info refreshes
+  unsigned char dynamic_due[(gpuinfo_dynamic_info_count + CHAR_BIT - 1) / CHAR_BIT];
+  // Queried at least once, and with success for the fields queried only once
+  unsigned char dynamic_queried[(gpuinfo_dynamic_info_count + CHAR_BIT - 1) / CHAR_BIT];
   char pdev[PDEV_LEN];
 };
 
@@ -236,6 +332,54 @@ inline unsigned busy_usage_from_time_usage_round(uint64_t current_use_ns, uint64
          time_between_measurement;
 }
 
+// Engine counters of a DRM client (time in ns or cycles) read from fdinfo.
+// The slots meaning is up to the backend; the gpuinfo_client_engine slots are used by the common helpers.
+#define GPUINFO_CLIENT_COUNTER_SLOTS 10
+enum gpuinfo_client_engine {
+  gpuinfo_client_gfx_engine = 0,
+  gpuinfo_client_compute_engine,
+  gpuinfo_client_enc_engine,
+  gpuinfo_client_dec_engine,
+  gpuinfo_client_copy_engine,
+  gpuinfo_client_gpu_cycles,
+};
+
+struct gpuinfo_client_counters {
+  uint64_t value[GPUINFO_CLIENT_COUNTER_SLOTS];
+  unsigned char valid[(GPUINFO_CLIENT_COUNTER_SLOTS + CHAR_BIT - 1) / CHAR_BIT];
+};
+
+struct gpuinfo_client_delta {
+  uint64_t time_elapsed; // Nanoseconds since the previous update
+  uint64_t value[GPUINFO_CLIENT_COUNTER_SLOTS];
+  // Set when the counter was read during both updates and did not go backward
+  unsigned char valid[(GPUINFO_CLIENT_COUNTER_SLOTS + CHAR_BIT - 1) / CHAR_BIT];
+};
+
+#define SET_GPUINFO_CLIENT_COUNTER(structPtr, slot, val)                                                               \
+  do {                                                                                                                 \
+    (structPtr)->value[slot] = (val);                                                                                  \
+    SET_VALID(slot, (structPtr)->valid);                                                                               \
+  } while (0)
+#define GPUINFO_CLIENT_COUNTER_VALID(structPtr, slot) IS_VALID(slot, (structPtr)->valid)
+
+// Stores the counters of a client for this update in the cache shared by all the devices.
+// Returns true and fills delta when the client was also seen during the previous update.
+bool gpuinfo_client_counters_update(const struct gpu_info *gpu_info, pid_t pid, unsigned client_id,
+                                    const struct gpuinfo_client_counters *counters, struct gpuinfo_client_delta *delta);
+
+// Busy percentage of an engine from its time counter delta, false if the delta is unusable
+bool gpuinfo_client_busy_usage(const struct gpuinfo_client_delta *delta, unsigned slot, unsigned *usage);
+// Busy percentage of an engine from its busy cycles and total cycles counters delta
+bool gpuinfo_client_cycles_usage(const struct gpuinfo_client_delta *delta, unsigned busy_slot, unsigned total_slot,
+                                 unsigned *usage);
+
+// Fills the gpuinfo_client_engine slots from the process gfx/compute/enc/dec engine time
+void gpuinfo_client_counters_from_process(const struct gpu_process *process,
+                                          struct gpuinfo_client_counters *counters);
+// Sets the process gpu (gfx + compute), encode, decode and per-engine class usage from the engine time deltas
+void gpuinfo_process_usage_from_client_delta(struct gpu_process *process, const struct gpuinfo_client_delta *delta);
+
 unsigned nvtop_pcie_gen_from_link_speed(unsigned linkSpeed);
 
 #endif // EXTRACT_GPUINFO_COMMON_H__
@@ -0,0 +1,82 @@
+/*
+ *
+ * Copyright (C) 2025 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef EXTRACT_GPUINFO_REMOTE_H_
+#define EXTRACT_GPUINFO_REMOTE_H_
+
+#include "nvtop/extract_gpuinfo_common.h"
+
+#include <stdbool.h>
+
+// Devices sampled by nvtop daemons (see daemon.h) and received through their sockets.
+
+#ifdef HAS_LINUX_SERVICES
+
+// Connects to the daemon listening on socket_path, or when NULL to the daemon of the user, then of the system.
+// The devices list is filled with the devices of the daemon, which are only updated by gpuinfo_remote_refresh.
+// Returns false if no daemon answered.
+bool gpuinfo_remote_attach(const char *socket_path, unsigned *devices_count, struct list_head *devices);
+
+// Connects to the daemons of several hosts listening on TCP ("host[:port]") or Unix sockets (absolute paths).
+// The hosts are separated by commas or spaces; "@path" reads them from a file, one per line. The device names are
+// prefixed with their host. The hosts that do not send their devices within a few seconds join later through
+// gpuinfo_remote_join_hosts. Returns false if no host answered.
+bool gpuinfo_remote_attach_hosts(const char *hosts, unsigned *devices_count, struct list_head *devices);
+
+// Updates the devices from the samples received since the last call, reconnecting if the daemon went away.
+// The processes are left untouched when refresh_processes is false.
+void gpuinfo_remote_refresh(struct list_head *devices, bool refresh_processes);
+
+// Adds the devices of the hosts that sent them since the attach or the previous call to the list, to be updated by
+// the next gpuinfo_remote_refresh. Returns the number of devices added.
+unsigned gpuinfo_remote_join_hosts(struct list_head *devices);
+
+// Removes the devices from their list and frees them
+void gpuinfo_remote_detach(void);
+
+#else // The daemon is only built for Linux
+
+static inline bool gpuinfo_remote_attach(const char *socket_path, unsigned *devices_count, struct list_head *devices) {
+  (void)socket_path;
+  (void)devices_count;
+  (void)devices;
+  return false;
+}
+static inline bool gpuinfo_remote_attach_hosts(const char *hosts, unsigned *devices_count,
+                                               struct list_head *devices) {
+  (void)hosts;
+  (void)devices_count;
+  (void)devices;
+  return false;
+}
+static inline void gpuinfo_remote_refresh(struct list_head *devices, bool refresh_processes) {
+  (void)devices;
+  (void)refresh_processes;
+}
+static inline unsigned gpuinfo_remote_join_hosts(struct list_head *devices) {
+  (void)devices;
+  return 0;
+}
+static inline void gpuinfo_remote_detach(void) {}
+
+#endif // HAS_LINUX_SERVICES
+
+#endif // EXTRACT_GPUINFO_REMOTE_H_
@@ -0,0 +1,66 @@
+/*
+ *
+ * Copyright (C) 2025 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef EXTRACT_GPUINFO_SHM_H_
+#define EXTRACT_GPUINFO_SHM_H_
+
+#include "nvtop/extract_gpuinfo_common.h"
+
+#include <stdbool.h>
+
+// The nvtop instances of a user share their samples through a segment in /dev/shm.
+// One instance, the collector, gathers the samples and publishes them; the others only read the latest sample.
+// When the collector exits, the next instance refreshing its devices takes over the collection.
+
+#ifdef HAS_LINUX_SERVICES
+
+// Attaches to the shared segment, becoming the collector if no other instance is.
+// The devices list is filled with the devices of the segment, which are only updated by gpuinfo_shm_refresh.
+// Returns false if the segment cannot be used, e.g. when it is published by an incompatible nvtop version.
+bool gpuinfo_shm_attach(unsigned *devices_count, struct list_head *devices);
+
+// Collects and publishes a sample when this instance is the collector, then updates the devices from the latest
+// sample. The processes are left untouched when refresh_processes is false.
+void gpuinfo_shm_refresh(struct list_head *devices, bool refresh_processes);
+
+// True if this instance collects the samples for the others
+bool gpuinfo_shm_is_collector(void);
+
+// Removes the devices from their list and frees them
+void gpuinfo_shm_detach(void);
+
+#else // The shared segment is only built for Linux
+
+static inline bool gpuinfo_shm_attach(unsigned *devices_count, struct list_head *devices) {
+  (void)devices_count;
+  (void)devices;
+  return false;
+}
+static inline void gpuinfo_shm_refresh(struct list_head *devices, bool refresh_processes) {
+  (void)devices;
+  (void)refresh_processes;
+}
+static inline bool gpuinfo_shm_is_collector(void) { return false; }
+static inline void gpuinfo_shm_detach(void) {}
+
+#endif // HAS_LINUX_SERVICES
+
+#endif // EXTRACT_GPUINFO_SHM_H_
@@ -23,6 +23,7 @@
 #define GET_PROCESS_INFO_H_
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <sys/types.h>
 
@@ -42,4 +43,22 @@ void get_command_from_pid(pid_t pid, char **buffer);
 
 bool get_process_info(pid_t pid, struct process_cpu_usage *usage);
 
+// Set of CPUs, the CPUs above NVTOP_MAX_CPUS are ignored
+#define NVTOP_MAX_CPUS 8192
+struct nvtop_cpu_set {
+  uint64_t bits[NVTOP_MAX_CPUS / 64];
+};
+#define NVTOP_CPU_SET(cpu, set) ((set)->bits[(cpu) / 64] |= UINT64_C(1) << ((cpu) % 64))
+#define NVTOP_CPU_ISSET(cpu, set) ((((set)->bits[(cpu) / 64] >> ((cpu) % 64)) & 1) != 0)
+
+// CPUs of the NUMA node of the PCI device. False when the device is not attached to a node or when all the CPUs are
+// local to it.
+bool get_pci_device_local_cpus(const char *pdev, struct nvtop_cpu_set *cpus);
+
+// CPUs the process is allowed to run on
+bool get_process_allowed_cpus(pid_t pid, struct nvtop_cpu_set *cpus);
+
+// CPU each thread of the process last ran on. The array is grown as needed.
+bool get_process_thread_cpus(pid_t pid, unsigned **cpus, unsigned *count, unsigned *size);
+
 #endif // GET_PROCESS_INFO_H_
@@ -0,0 +1,62 @@
+/*
+ *
+ * Copyright (C) 2025 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef NVTOP_GPUINFO_ENERGY_H_
+#define NVTOP_GPUINFO_ENERGY_H_
+
+#include "list.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+// Energy consumed by the devices since nvtop started, integrated from their power draw with the trapezoidal rule.
+// The energy of a device is shared between its processes in proportion of the time they kept its engines busy, from
+// the engine counters when the driver has them and from the utilization rate otherwise. The energy drawn while no
+// process is busy is only counted for the device.
+
+// Processes that exited are remembered up to this number, the oldest exits are forgotten first
+#define GPUINFO_ENERGY_EXITED_PROCESSES 64
+#define GPUINFO_ENERGY_CMDLINE_SIZE 64
+
+struct gpuinfo_energy_exited_process {
+  uint64_t sequence; // Increases with each exit, for the consumers reporting each exit once
+  pid_t pid;
+  unsigned device; // Position of the device in the list
+  char cmdline[GPUINFO_ENERGY_CMDLINE_SIZE];
+  uint64_t energy; // Millijoules
+};
+
+// Integrates the power drawn since the previous call and sets the energy_consumed of the devices. When the processes
+// were refreshed, the energy drawn since their previous refresh is shared between them and their energy_consumed is
+// set. Called by the collector after the processes utilization is computed.
+void gpuinfo_energy_account(struct list_head *devices, bool processes_refreshed);
+// Same for a sample taken at now (NVTOP_CLOCK nanoseconds)
+void gpuinfo_energy_account_at(struct list_head *devices, bool processes_refreshed, uint64_t now);
+
+// The processes that exited, from the most recent
+unsigned gpuinfo_energy_exited_count(void);
+const struct gpuinfo_energy_exited_process *gpuinfo_energy_exited(unsigned index);
+
+// Frees the accounting
+void gpuinfo_energy_clear(void);
+
+#endif // NVTOP_GPUINFO_ENERGY_H_
@@ -0,0 +1,95 @@
+/*
+ *
+ * Copyright (C) 2025 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef GPUINFO_PROTOCOL_H_
+#define GPUINFO_PROTOCOL_H_
+
+#include "nvtop/extract_gpuinfo_common.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Binary protocol between the nvtop daemon and its clients.
+// Each message is a 32-bit little endian payload length followed by the payload, whose first byte is the message type.
+// The daemon sends a hello message with the static information of the devices when a client connects, then a
+// sample message per update. A sample only holds the fields that changed since the previous sample, except the
+// keyframe sent after the hello message. The integers are encoded as LEB128 varints.
+
+#define GPUINFO_PROTOCOL_VERSION 5
+// Socket of the daemon run by the system; the daemon of a user listens in its XDG_RUNTIME_DIR
+#define GPUINFO_PROTOCOL_SYSTEM_SOCKET "/run/nvtopd.sock"
+// TCP port of a daemon serving remote clients
+#define GPUINFO_PROTOCOL_DEFAULT_PORT "7787"
+
+enum gpuinfo_protocol_message {
+  gpuinfo_protocol_hello = 1,
+  gpuinfo_protocol_sample = 2,
+};
+
+struct gpuinfo_protocol_device {
+  char pdev[PDEV_LEN];
+  struct gpuinfo_static_info static_info;
+  struct gpuinfo_dynamic_info dynamic_info;
+  unsigned processes_count;
+  struct gpu_process *processes; // The command lines and user names are owned by the state
+};
+
+// The devices as last sent or received
+struct gpuinfo_protocol_state {
+  unsigned devices_count;
+  struct gpuinfo_protocol_device *devices;
+};
+
+struct gpuinfo_protocol_buffer {
+  unsigned char *data;
+  size_t size;
+  size_t capacity;
+};
+
+// Path of the socket of the user daemon, false if the user has no runtime directory
+bool gpuinfo_protocol_user_socket_path(char *path, size_t size);
+
+// Splits "host", "host:port" or "[address]:port" in place. The host is NULL if empty and the port NULL if absent.
+void gpuinfo_protocol_split_address(char *address, char **host, char **port);
+
+// Replaces the state with a copy of the devices
+void gpuinfo_protocol_state_from_devices(struct gpuinfo_protocol_state *state, struct list_head *devices);
+
+void gpuinfo_protocol_state_clear(struct gpuinfo_protocol_state *state);
+
+// Appends a hello message describing the devices of the state
+void gpuinfo_protocol_encode_hello(struct gpuinfo_protocol_buffer *buffer, const struct gpuinfo_protocol_state *state);
+
+// Appends a sample message with the differences from previous to current, or a keyframe if previous is NULL
+void gpuinfo_protocol_encode_sample(struct gpuinfo_protocol_buffer *buffer,
+                                    const struct gpuinfo_protocol_state *previous,
+                                    const struct gpuinfo_protocol_state *current);
+
+// Length of the complete message at the start of data, 0 if more data is needed
+size_t gpuinfo_protocol_message_length(const unsigned char *data, size_t size);
+
+// Applies a complete message to the state. Returns false if the message is malformed.
+bool gpuinfo_protocol_decode(const unsigned char *message, size_t length, struct gpuinfo_protocol_state *state,
+                             enum gpuinfo_protocol_message *type);
+
+void gpuinfo_protocol_buffer_free(struct gpuinfo_protocol_buffer *buffer);
+
+#endif // GPUINFO_PROTOCOL_H_
@@ -0,0 +1,133 @@
+/*
+ *
+ * Copyright (C) 2025 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef NVTOP_GPUINFO_STATS_H_
+#define NVTOP_GPUINFO_STATS_H_
+
+#include "list.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+// Statistics of the metrics over the lifetime of nvtop: minimum, mean, maximum and percentiles of each device metric,
+// and of each process on each device. The distributions are kept in fixed-size histograms with logarithmic buckets
+// (within 1.6% of the exact percentiles), so the memory does not grow with the number of samples.
+
+enum gpuinfo_stats_device_metric {
+  gpuinfo_stats_gpu_util,    // %
+  gpuinfo_stats_mem_util,    // %
+  gpuinfo_stats_power,       // mW
+  gpuinfo_stats_memory_used, // MiB
+  gpuinfo_stats_temperature, // °C
+  gpuinfo_stats_gpu_clock,   // MHz
+  gpuinfo_stats_device_metric_count,
+};
+
+// Conditions slowing a device down, whose time is accounted
+enum gpuinfo_stats_residency {
+  gpuinfo_stats_throttled,          // The driver reports a reason for holding the clocks down
+  gpuinfo_stats_throttled_power,    // ... because of the power limit
+  gpuinfo_stats_throttled_thermal,  // ... because of the temperature
+  gpuinfo_stats_throttled_hardware, // ... because of a slowdown asserted by the board
+  gpuinfo_stats_throttled_other,    // ... for a reason the driver does not detail
+  gpuinfo_stats_below_max_clock,    // Busy with the clock below 95% of its maximum
+  gpuinfo_stats_hot,                // Temperature at or above the slowdown threshold
+  gpuinfo_stats_power_capped,       // Power draw at or above 95% of the limit
+  gpuinfo_stats_residency_count,
+};
+
+enum gpuinfo_stats_process_metric {
+  gpuinfo_stats_process_gpu_usage,  // %
+  gpuinfo_stats_process_gpu_memory, // MiB
+  gpuinfo_stats_process_metric_count,
+};
+
+struct gpuinfo_stats_summary {
+  uint64_t count; // Samples where the metric was available, the other fields are only meaningful if not 0
+  double min;
+  double mean;
+  double max;
+  double p50;
+  double p95;
+  double p99;
+};
+
+struct gpuinfo_stats_residency_time {
+  double observed; // Seconds during which the condition could be evaluated
+  double time;     // Seconds spent in the condition
+};
+
+struct gpuinfo_stats_process {
+  pid_t pid;
+  unsigned device;    // Position of the device in the list
+  const char *cmdline; // Truncated command line, may be empty
+  double lifetime;    // Seconds between the first and the last sample showing the process
+  bool has_busy_time; // The device reports the time spent by the process on its engines
+  double busy_time;   // Seconds spent on the graphics and compute engines, exact when has_busy_time
+  bool has_energy;
+  double energy; // Joules attributed to the process when it was last seen
+  bool running;       // In the latest sample
+  struct gpuinfo_stats_summary metrics[gpuinfo_stats_process_metric_count];
+};
+
+// Name of the metrics in the statistics pane and in the JSON output, and their unit
+const char *gpuinfo_stats_device_metric_name(enum gpuinfo_stats_device_metric metric);
+const char *gpuinfo_stats_device_metric_unit(enum gpuinfo_stats_device_metric metric);
+const char *gpuinfo_stats_residency_name(enum gpuinfo_stats_residency residency);
+const char *gpuinfo_stats_process_metric_name(enum gpuinfo_stats_process_metric metric);
+const char *gpuinfo_stats_process_metric_unit(enum gpuinfo_stats_process_metric metric);
+
+// Adds the current sample of the devices, and of their processes if refreshed since the previous call.
+// Writes the statistics first if a dump was requested.
+void gpuinfo_stats_record(struct list_head *devices, bool processes_refreshed);
+
+// Seconds covered by the statistics and number of samples
+double gpuinfo_stats_duration(void);
+uint64_t gpuinfo_stats_samples(void);
+
+unsigned gpuinfo_stats_devices_count(void);
+// Name of the device, NULL if unknown
+const char *gpuinfo_stats_device_name(unsigned device);
+void gpuinfo_stats_device_summary(unsigned device, enum gpuinfo_stats_device_metric metric,
+                                  struct gpuinfo_stats_summary *summary);
+// Joules consumed by the device in the latest sample that had it, false if never known
+bool gpuinfo_stats_device_energy(unsigned device, double *energy);
+// Time spent by the device in a condition, each interval between two samples is attributed to the condition of the
+// first one
+void gpuinfo_stats_device_residency(unsigned device, enum gpuinfo_stats_residency residency,
+                                    struct gpuinfo_stats_residency_time *time);
+
+// The processes are tracked up to a fixed number, the ones not seen for the longest time make room for the new ones
+unsigned gpuinfo_stats_processes_count(void);
+void gpuinfo_stats_process_summary(unsigned index, struct gpuinfo_stats_process *process);
+
+// Writes the statistics as JSON to path (replaced atomically), or to the standard output if path is "-"
+bool gpuinfo_stats_write_json(const char *path);
+
+// Async-signal-safe: the statistics are written to path at the next sample. Set path with gpuinfo_stats_set_dump_path.
+void gpuinfo_stats_request_dump(void);
+void gpuinfo_stats_set_dump_path(const char *path);
+
+// Frees the statistics
+void gpuinfo_stats_clear(void);
+
+#endif // NVTOP_GPUINFO_STATS_H_
@@ -37,6 +37,12 @@ void interface_check_monitored_gpu_change(struct nvtop_interface **interface, un
                                           unsigned *num_monitored_gpus, struct list_head *monitoredGpus,
                                           struct list_head *nonMonitoredGpus);
 
+// Moves the devices that joined after the start (see gpuinfo_remote_join_hosts) from joinedGpus to the monitored
+// devices, rebuilding the interface. Waits for the setup window to be closed.
+void interface_add_joined_gpus(struct nvtop_interface **interface, unsigned *allDevCount, unsigned *num_monitored_gpus,
+                               struct list_head *monitoredGpus, struct list_head *nonMonitoredGpus,
+                               struct list_head *joinedGpus);
+
 unsigned interface_largest_gpu_name(struct list_head *devices);
 
 void draw_gpu_info_ncurses(unsigned monitored_dev_count, struct list_head *devices, struct nvtop_interface *interface);
@@ -51,8 +57,14 @@ bool is_escape_for_quit(struct nvtop_interface *inter);
 
 bool interface_freeze_processes(struct nvtop_interface *interface);
 
+// Subscribes each device to the metrics the interface displays, the backends skip the others
+void interface_update_subscriptions(const struct nvtop_interface *interface, struct list_head *devices);
+
 int interface_update_interval(const struct nvtop_interface *interface);
 
+// Milliseconds to wait before drawing the frame held back by the low bandwidth mode, -1 if there is none
+int interface_frame_delay(const struct nvtop_interface *interface);
+
 bool show_information_messages(unsigned num_messages, const char **messages);
 
 void print_snapshot(struct list_head *devices, bool use_fahrenheit_option);
@@ -32,6 +32,9 @@ enum plot_information {
   plot_fan_speed,
   plot_gpu_clock_rate,
   plot_gpu_mem_clock_rate,
+  plot_render_engine_rate,
+  plot_compute_engine_rate,
+  plot_copy_engine_rate,
   plot_information_count
 };
 
@@ -45,9 +48,14 @@ enum process_field {
   process_gpu_rate,
   process_enc_rate,
   process_dec_rate,
+  process_render_rate,
+  process_compute_rate,
+  process_copy_rate,
   process_memory,
   process_cpu_usage,
   process_cpu_mem_usage,
+  process_energy,
+  process_locality,
   process_command,
   process_field_count,
 };
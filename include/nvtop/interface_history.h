@@ -0,0 +1,157 @@
+/*
+ *
+ * Copyright (C) 2021 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef INTERFACE_HISTORY_H__
+#define INTERFACE_HISTORY_H__
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Value of the slots for which nothing was recorded
+#define HISTORY_NO_DATA UINT8_MAX
+// Value pushed when a metric is unavailable, any other value is recorded as data
+#define HISTORY_UNAVAILABLE UINT32_MAX
+
+// The sample tier keeps one slot per update interval (1 second by default) for 10 minutes. The other tiers aggregate
+// the samples over 10 seconds for 6 hours and over 1 minute for 7 days, shortened to 1 hour and 1 day for the fleets
+// of devices.
+enum interface_history_tier {
+  history_tier_sample,
+  history_tier_10s,
+  history_tier_1min,
+  history_tier_count,
+};
+
+enum interface_history_aggregate {
+  history_min,
+  history_avg,
+  history_max,
+  history_aggregate_count,
+};
+
+// Ring of slots, grown on demand up to the size of the tier
+struct interface_history_slots {
+  unsigned capacity;
+  unsigned start;
+  unsigned count;
+  uint8_t *values[history_aggregate_count]; // The sample tier only stores history_avg
+};
+
+// Slot of an aggregating tier still receiving samples
+struct interface_history_pending {
+  unsigned long long slot;
+  unsigned samples;
+  unsigned sum;
+  uint8_t min;
+  uint8_t max;
+};
+
+struct interface_history_series {
+  struct interface_history_slots tiers[history_tier_count];
+  struct interface_history_pending pending[history_tier_count];
+};
+
+typedef struct interface_history_st {
+  unsigned monitored_dev_count;
+  unsigned metrics_per_device;
+  unsigned tier_size[history_tier_count];
+  unsigned tier_period[history_tier_count]; // Milliseconds covered by a slot, the update interval for the sample tier
+  struct interface_history_series *series;
+} interface_history;
+
+// With short_tiers, a metric takes at most about 6KB at the default update interval instead of 37KB
+void interface_alloc_history(unsigned monitored_dev_count, unsigned metrics_per_device, unsigned update_interval,
+                             bool short_tiers, interface_history *history);
+
+void interface_free_history(interface_history *history);
+
+// Aggregate of a range of slots
+struct interface_history_reduction {
+  uint8_t min; // HISTORY_NO_DATA when none of the slots has data
+  uint8_t max; // HISTORY_NO_DATA when none of the slots has data
+  unsigned sum;
+  unsigned values; // Slots with data
+};
+
+// Records a sample taken at time_ms (milliseconds of a monotonic clock), HISTORY_UNAVAILABLE if the metric was
+// unavailable
+void interface_history_push(interface_history *history, unsigned device, unsigned metric, unsigned value,
+                            unsigned long long time_ms);
+
+// Reduces the count slots of the tier starting at the first-th one (from the oldest), including the slot still
+// aggregating samples
+void interface_history_reduce(const interface_history *history, unsigned device, unsigned metric,
+                              enum interface_history_tier tier, unsigned first, unsigned count,
+                              struct interface_history_reduction *reduction);
+
+// Merges count contiguous slots into the reduction
+typedef void (*interface_history_reduce_fn)(const uint8_t *min, const uint8_t *avg, const uint8_t *max,
+                                            unsigned count, struct interface_history_reduction *reduction);
+
+struct interface_history_reduce_kernel {
+  const char *name;
+  interface_history_reduce_fn reduce;
+};
+
+// The reduction kernels built in that the processor supports, from the scalar one to the fastest one which is used
+unsigned interface_history_reduce_kernels(const struct interface_history_reduce_kernel **kernels);
+
+inline const struct interface_history_series *interface_history_get_series(const interface_history *history,
+                                                                           unsigned device, unsigned metric) {
+  assert(device < history->monitored_dev_count && metric < history->metrics_per_device);
+  return &history->series[device * history->metrics_per_device + metric];
+}
+
+// Number of slots of the tier that can be read, including the one still aggregating samples
+inline unsigned interface_history_stored(const interface_history *history, unsigned device, unsigned metric,
+                                         enum interface_history_tier tier) {
+  const struct interface_history_series *series = interface_history_get_series(history, device, metric);
+  return series->tiers[tier].count + (series->pending[tier].samples > 0);
+}
+
+// Reads the index-th slot of the tier, starting from the oldest one
+inline uint8_t interface_history_get(const interface_history *history, unsigned device, unsigned metric,
+                                     enum interface_history_tier tier, enum interface_history_aggregate aggregate,
+                                     unsigned index) {
+  assert(interface_history_stored(history, device, metric, tier) > index);
+  const struct interface_history_series *series = interface_history_get_series(history, device, metric);
+  const struct interface_history_slots *slots = &series->tiers[tier];
+  if (index == slots->count) {
+    const struct interface_history_pending *pending = &series->pending[tier];
+    switch (aggregate) {
+    case history_min:
+      return pending->min;
+    case history_max:
+      return pending->max;
+    default:
+      return (pending->sum + pending->samples / 2) / pending->samples;
+    }
+  }
+  if (tier == history_tier_sample)
+    aggregate = history_avg;
+  unsigned location = slots->start + index;
+  if (location >= slots->capacity)
+    location -= slots->capacity;
+  return slots->values[aggregate][location];
+}
+
+#endif // INTERFACE_HISTORY_H__
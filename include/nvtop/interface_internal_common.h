@@ -23,8 +23,8 @@
 #define INTERFACE_INTERNAL_COMMON_H__
 
 #include "nvtop/common.h"
+#include "nvtop/interface_history.h"
 #include "nvtop/interface_options.h"
-#include "nvtop/interface_ring_buffer.h"
 #include "nvtop/time.h"
 
 #include <ncurses.h>
@@ -69,6 +69,7 @@ struct device_window {
   WINDOW *shader_cores;
   WINDOW *l2_cache_size;
   WINDOW *exec_engines;
+  WINDOW *throttle_info;
   bool enc_was_visible;
   bool dec_was_visible;
   nvtop_time last_decode_seen;
@@ -84,6 +85,14 @@ struct option_window {
   WINDOW *option_win;
 };
 
+// Sort key of the last sorted row in the previous frame, used to skip the processes that are far from the top
+struct process_sort_cache {
+  bool valid;
+  enum process_field criterion;
+  bool descending;
+  uint64_t cutoff_key;
+};
+
 struct process_window {
   unsigned offset;
   unsigned offset_column;
@@ -91,12 +100,19 @@ struct process_window {
   WINDOW *process_with_option_win;
   unsigned selected_row;
   pid_t selected_pid;
+  bool selected_pid_foreign; // The selected process does not run on this host, it can not be killed
   struct option_window option_window;
+  struct process_sort_cache sort_cache;
+  bool show_stats;       // The statistics of the metrics replace the process list
+  unsigned stats_offset; // First row of statistics shown
 };
 
 struct plot_window {
   size_t num_data;
   double *data;
+  double *data_min; // Lowest value aggregated by each entry of data
+  double *data_max; // Highest value aggregated by each entry of data
+  unsigned long long data_sample; // Sample generation held by data, 0 when it has to be filled again
   WINDOW *win;
   WINDOW *plot_window;
   unsigned num_devices_to_plot;
@@ -123,18 +139,71 @@ struct setup_window {
   unsigned options_selected[2];
 };
 
+enum heatmap_metric {
+  heatmap_gpu_rate,
+  heatmap_mem_rate,
+  heatmap_encode_rate,
+  heatmap_decode_rate,
+  heatmap_temperature,
+  heatmap_power_rate,
+  heatmap_fan_speed,
+  heatmap_metric_count,
+};
+
+#define HEATMAP_NO_DATA UINT8_MAX
+
+// Dense view for many devices: one cell per device and metric in place of the device headers, followed by the header
+// of the selected device. The plots only show the selected device.
+struct heatmap_window {
+  bool enabled; // The current layout uses the heatmap
+  WINDOW *win;
+  unsigned selected_device;
+  uint8_t *values; // Metric-major: value of the metric for each device, HEATMAP_NO_DATA when unavailable
+};
+
+// Generation counters used to only draw the windows whose content changed
+struct interface_generation {
+  unsigned long long sample; // A new sample was saved
+  unsigned long long ui;     // A key was pressed
+  unsigned long long layout; // The windows were created again or uncovered
+};
+
+struct interface_drawn_generations {
+  struct interface_generation devices;
+  struct interface_generation plots;
+  struct interface_generation processes;
+  struct interface_generation shortcuts;
+};
+
+// Terminal output accounting for the low bandwidth mode
+struct interface_output {
+  int io_stats_fd;               // Process I/O statistics, -1 when unavailable
+  unsigned long long bytes;      // Bytes written to the terminal
+  unsigned long long rate_bytes; // Value of bytes at rate_since
+  nvtop_time rate_since;
+  double rate;                   // Output rate in bytes per second
+  nvtop_time last_frame;         // Last time a frame was drawn
+  bool frame_pending;            // Some windows could not be drawn in the last frame
+  unsigned plot_coarseness;      // Samples aggregated by each plot column
+};
+
 // Keep gpu information every 1 second for 10 minutes
 struct nvtop_interface {
   nvtop_interface_option options;
   unsigned total_dev_count;
   unsigned monitored_dev_count;
   struct device_window *devices_win;
+  struct heatmap_window heatmap;
   struct process_window process;
   WINDOW *shortcut_window;
   unsigned num_plots;
   struct plot_window *plots;
-  interface_ring_buffer saved_data_ring;
+  interface_history history;
+  unsigned plot_zoom; // Index in the zoom levels of the plots, 0 showing each sample
   struct setup_window setup_win;
+  struct interface_generation generation;
+  struct interface_drawn_generations drawn;
+  struct interface_output output;
 };
 
 enum device_field {
@@ -148,6 +217,7 @@ enum device_field {
   device_shadercores,
   device_l2features,
   device_execengines,
+  device_throttle,
   device_field_count,
 };
 
@@ -21,4 +21,20 @@ void compute_sizes_from_layout(unsigned monitored_dev_count, unsigned device_hea
                                struct window_position *process_position, struct window_position *setup_position,
                                bool process_win_hide);
 
+// The devices are shown as a heatmap when asked to, and always above MAX_CHARTS devices since the layout cannot place
+// the plots of all of them
+bool heatmap_layout_selected(unsigned monitored_dev_count, bool dense_device_view);
+
+// Layout of a heatmap of heatmap_rows rows at the top of the screen, above the header and the plots of the selected
+// device alone. The other devices have no window: their map_device_to_plot is UINT_MAX and their position is not set.
+void compute_sizes_from_heatmap_layout(unsigned monitored_dev_count, unsigned selected_device, unsigned heatmap_rows,
+                                       unsigned device_header_rows, unsigned device_header_cols, unsigned rows,
+                                       unsigned cols, const nvtop_interface_gpu_opts *gpu_opts,
+                                       process_field_displayed process_field_displayed,
+                                       struct window_position *heatmap_position,
+                                       struct window_position *device_positions, unsigned *num_plots,
+                                       struct window_position plot_positions[MAX_CHARTS], unsigned *map_device_to_plot,
+                                       struct window_position *process_position, struct window_position *setup_position,
+                                       bool process_win_hide);
+
 #endif // INTERFACE_LAYOUT_SELECTION_H__
@@ -49,9 +49,16 @@ typedef struct nvtop_interface_option_struct {
                                                     // process list are displayed
   bool show_startup_messages;                       // True to show the startup messages
   bool filter_nvtop_pid;                            // Do not show nvtop pid in the processes list
+  bool filter_local_processes;                      // Only show the processes running remote to their device
   bool has_monitored_set_changed;                   // True if the set of monitored gpu was modified through the interface
   bool has_gpu_info_bar;                            // Show info bar with additional GPU parametres
+  bool dense_device_view;                           // Show the devices as a heatmap, always done above MAX_CHARTS
   bool hide_processes_list;                         // Hide processes list
+  bool low_bandwidth_mode;                          // Limit the terminal output for slow links
+  unsigned low_bandwidth_max_fps;                   // Maximum frames per second in low bandwidth mode
+  unsigned low_bandwidth_frame_budget;              // Bytes each frame may write in low bandwidth mode
+  unsigned power_sampling_rate;                     // Power samples per second, 0 when the power is not sampled
+  unsigned dynamic_refresh_period[gpuinfo_dynamic_info_count]; // Updates between two queries of a field, 0 for once
 } nvtop_interface_option;
 
 inline bool plot_isset_draw_info(enum plot_information check_info, plot_info_to_draw to_draw) {
@@ -110,6 +117,11 @@ inline process_field_displayed process_default_displayed_field(void) {
   }
   to_display = process_remove_field_to_display(process_enc_rate, to_display);
   to_display = process_remove_field_to_display(process_dec_rate, to_display);
+  to_display = process_remove_field_to_display(process_render_rate, to_display);
+  to_display = process_remove_field_to_display(process_compute_rate, to_display);
+  to_display = process_remove_field_to_display(process_copy_rate, to_display);
+  to_display = process_remove_field_to_display(process_energy, to_display);
+  to_display = process_remove_field_to_display(process_locality, to_display);
   return to_display;
 }
 
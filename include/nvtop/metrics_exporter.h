@@ -0,0 +1,61 @@
+/*
+ *
+ * Copyright (C) 2025 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef NVTOP_METRICS_EXPORTER_H_
+#define NVTOP_METRICS_EXPORTER_H_
+
+#include "list.h"
+
+#include <stdbool.h>
+
+// Pushes the samples of the devices to a metrics relay (Telegraf, statsd, ...) in InfluxDB line protocol or StatsD.
+// The samples are batched into datagrams and sent without ever blocking: when the relay does not keep up, the oldest
+// datagrams are dropped.
+
+// Number of processes exported per device, the ones using the GPU the most
+#define METRICS_EXPORTER_TOP_PROCESSES 5
+
+#ifdef HAS_LINUX_SERVICES
+
+// Starts exporting to destination "[influx:|statsd:]address", the address being "host[:port]" for UDP or the
+// absolute path of a Unix datagram socket. The format defaults to the InfluxDB line protocol.
+// Returns false if the destination is invalid.
+bool metrics_exporter_open(const char *destination);
+
+// Queues the current sample of the devices and sends the datagrams that are full or old enough.
+// Does nothing if the exporter is not open.
+void metrics_exporter_push(struct list_head *devices);
+
+// Sends what is left of the queue if the relay accepts it and closes the exporter
+void metrics_exporter_close(void);
+
+#else // The exporter is only built for Linux
+
+static inline bool metrics_exporter_open(const char *destination) {
+  (void)destination;
+  return false;
+}
+static inline void metrics_exporter_push(struct list_head *devices) { (void)devices; }
+static inline void metrics_exporter_close(void) {}
+
+#endif // HAS_LINUX_SERVICES
+
+#endif // NVTOP_METRICS_EXPORTER_H_
@@ -30,8 +30,10 @@
 
 #define PLOT_MAX_LEGEND_SIZE 35
 
-void nvtop_line_plot(WINDOW *win, size_t num_data, const double *data, unsigned num_plots, bool legend_left,
-                     char legend[MAX_LINES_PER_PLOT][PLOT_MAX_LEGEND_SIZE]);
+// data_min and data_max, when not NULL, hold the range of the values summarized by each entry of data. The range is drawn
+// as a dim envelope around the lines.
+void nvtop_line_plot(WINDOW *win, size_t num_data, const double *data, const double *data_min, const double *data_max,
+                     unsigned num_plots, bool legend_left, char legend[MAX_LINES_PER_PLOT][PLOT_MAX_LEGEND_SIZE]);
 
 void draw_rectangle(WINDOW *win, unsigned startX, unsigned startY, unsigned sizeX, unsigned sizeY);
 
@@ -0,0 +1,62 @@
+/*
+ *
+ * Copyright (C) 2025 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef NVTOP_POWER_SAMPLER_H_
+#define NVTOP_POWER_SAMPLER_H_
+
+#include "list.h"
+
+#include <stdbool.h>
+
+// Background sampling of the power of the devices, much faster than the refresh of the interface so that the short
+// power spikes are seen. The samples are handed over to the refresh through a lock-free ring per device.
+
+#define POWER_SAMPLER_MIN_RATE 50
+#define POWER_SAMPLER_MAX_RATE 200
+
+struct gpu_info;
+
+#ifdef HAS_LINUX_SERVICES
+
+// Samples the devices whose backend can be read from another thread rate times per second.
+// Returns false if none of the devices can be sampled or the thread could not be started.
+bool power_sampler_start(struct list_head *devices, unsigned rate);
+
+// Sets the power_draw of a device to the average of the samples taken since the previous call, and its power_draw_peak
+// and power_draw_p99 to their highest value and 99th percentile. Called after the backend refreshed the device.
+void power_sampler_apply(struct gpu_info *device);
+
+// Stops the sampling thread, does nothing if it is not running
+void power_sampler_stop(void);
+
+#else // The sampler is only built for Linux
+
+static inline bool power_sampler_start(struct list_head *devices, unsigned rate) {
+  (void)devices;
+  (void)rate;
+  return false;
+}
+static inline void power_sampler_apply(struct gpu_info *device) { (void)device; }
+static inline void power_sampler_stop(void) {}
+
+#endif // HAS_LINUX_SERVICES
+
+#endif // NVTOP_POWER_SAMPLER_H_
@@ -0,0 +1,42 @@
+/*
+ *
+ * Copyright (C) 2025 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef NVTOP_SNAPSHOT_H_
+#define NVTOP_SNAPSHOT_H_
+
+#include "list.h"
+
+#include <signal.h>
+#include <stdio.h>
+
+// Version of the JSON document, increased when a field changes meaning or is removed
+#define NVTOP_SNAPSHOT_SCHEMA_VERSION 1
+
+#define NVTOP_SNAPSHOT_DEFAULT_DURATION 1.
+#define NVTOP_SNAPSHOT_DEFAULT_INTERVAL .1
+
+// Samples the devices every interval seconds for duration seconds, or until stop becomes non-zero, and writes the
+// minimum, mean, maximum and last value of the metrics of each device and process as JSON to output.
+// The devices must have their static information populated. Returns the exit status of the program.
+int nvtop_snapshot_run(struct list_head *devices, double duration, double interval, FILE *output,
+                       volatile sig_atomic_t *stop);
+
+#endif // NVTOP_SNAPSHOT_H_
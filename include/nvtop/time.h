@@ -55,7 +55,7 @@ inline uint64_t nvtop_difftime_u64(nvtop_time t0, nvtop_time t1) {
 }
 
 inline nvtop_time nvtop_hmns_to_time(unsigned hour, unsigned minutes, unsigned long nanosec) {
-  nvtop_time t = {hour * 60 * 60 + 60 * minutes + nanosec / 1000000, nanosec % 1000000};
+  nvtop_time t = {(time_t)(hour * 60 * 60 + 60 * minutes + nanosec / 1000000), (long)(nanosec % 1000000)};
   return t;
 }
 
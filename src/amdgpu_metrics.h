@@ -0,0 +1,35 @@
+/*
+ *
+ * Copyright (C) 2025 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef AMDGPU_METRICS_H_
+#define AMDGPU_METRICS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Bytes of the gpu_metrics table to read for its throttle status, whatever its revision
+#define GPU_METRICS_THROTTLE_READ_SIZE 128
+
+// Decodes the throttle status of the start of a gpu_metrics table into a set of GPUINFO_THROTTLE_REASON. Returns
+// false for an unknown revision, a short table or a status the device does not report.
+bool amdgpu_metrics_throttle_reasons(const unsigned char *metrics, size_t size, unsigned *reasons);
+
+#endif // AMDGPU_METRICS_H_
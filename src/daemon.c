@@ -0,0 +1,388 @@
+/*
+ *
+ * Copyright (C) 2025 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "nvtop/daemon.h"
+#include "nvtop/common.h"
+#include "nvtop/extract_gpuinfo.h"
+#include "nvtop/gpuinfo_energy.h"
+#include "nvtop/gpuinfo_protocol.h"
+#include "nvtop/gpuinfo_stats.h"
+#include "nvtop/metrics_exporter.h"
+#include "nvtop/time.h"
+
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// A client that does not read its samples is disconnected once this much data is waiting for it
+#define DAEMON_MAX_PENDING_OUTPUT (4u << 20)
+#define DAEMON_LISTEN_BACKLOG SOMAXCONN
+// The Unix socket and the TCP sockets, one per address family
+#define DAEMON_MAX_LISTEN_SOCKETS 4
+
+struct daemon_client {
+  int fd;
+  struct gpuinfo_protocol_buffer output;
+  size_t output_sent;
+};
+
+static struct {
+  unsigned listen_count;
+  int listen_fds[DAEMON_MAX_LISTEN_SOCKETS];
+  bool listen_tcp[DAEMON_MAX_LISTEN_SOCKETS];
+  unsigned clients_count;
+  unsigned clients_capacity;
+  struct daemon_client *clients;
+  struct pollfd *poll_fds;
+  struct gpuinfo_protocol_state state; // Latest sample
+  struct gpuinfo_protocol_state next_state;
+  struct gpuinfo_protocol_buffer sample;   // Latest sample as a delta from the previous one
+  struct gpuinfo_protocol_buffer greeting; // Devices and latest sample for the new clients, built on demand
+} daemon_data;
+
+static int daemon_listen_unix(const char *socket_path) {
+  struct sockaddr_un address = {.sun_family = AF_UNIX};
+  if (strlen(socket_path) >= sizeof(address.sun_path)) {
+    fprintf(stderr, "The socket path %s is too long\n", socket_path);
+    return -1;
+  }
+  strcpy(address.sun_path, socket_path);
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+  if (fd < 0) {
+    perror("Cannot create the daemon socket: ");
+    return -1;
+  }
+  // The clients see the processes of every user: the socket is restricted to the user of the daemon, and to its group
+  // for the daemon of the system, from the bind on
+  mode_t previous_umask = umask(geteuid() ? S_IXUSR | S_IRWXG | S_IRWXO : S_IXUSR | S_IXGRP | S_IRWXO);
+  int bound = bind(fd, (struct sockaddr *)&address, sizeof(address));
+  if (bound && errno == EADDRINUSE) {
+    // Left behind by a daemon that did not exit cleanly, unless it is still answering
+    int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    bool answering = probe >= 0 && connect(probe, (struct sockaddr *)&address, sizeof(address)) == 0;
+    if (probe >= 0)
+      close(probe);
+    if (answering) {
+      fprintf(stderr, "Another nvtop daemon listens on %s\n", socket_path);
+      umask(previous_umask);
+      close(fd);
+      return -1;
+    }
+    unlink(socket_path);
+    bound = bind(fd, (struct sockaddr *)&address, sizeof(address));
+  }
+  umask(previous_umask);
+  if (bound) {
+    fprintf(stderr, "Cannot bind the daemon socket %s: %s\n", socket_path, strerror(errno));
+    close(fd);
+    return -1;
+  }
+  if (listen(fd, DAEMON_LISTEN_BACKLOG)) {
+    perror("Cannot listen on the daemon socket: ");
+    close(fd);
+    unlink(socket_path);
+    return -1;
+  }
+  return fd;
+}
+
+static bool daemon_listen_tcp(const char *listen_address) {
+  char *address = strdup(listen_address);
+  if (!address) {
+    perror("Cannot allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+  char *host, *port;
+  if (strspn(address, "0123456789") == strlen(address)) {
+    host = NULL;
+    port = address;
+  } else {
+    gpuinfo_protocol_split_address(address, &host, &port);
+  }
+  // The samples show the processes of every user: without an address, only the clients of this host are served.
+  // "*" stands for every address.
+  struct addrinfo hints = {.ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM};
+  if (host && strcmp(host, "*") == 0) {
+    host = NULL;
+    hints.ai_flags = AI_PASSIVE;
+  }
+  struct addrinfo *addresses;
+  int error = getaddrinfo(host, port ? port : GPUINFO_PROTOCOL_DEFAULT_PORT, &hints, &addresses);
+  free(address);
+  if (error) {
+    fprintf(stderr, "Cannot resolve the listen address %s: %s\n", listen_address, gai_strerror(error));
+    return false;
+  }
+  unsigned listening = 0;
+  for (struct addrinfo *info = addresses; info && daemon_data.listen_count < DAEMON_MAX_LISTEN_SOCKETS;
+       info = info->ai_next) {
+    int fd = socket(info->ai_family, info->ai_socktype | SOCK_CLOEXEC | SOCK_NONBLOCK, info->ai_protocol);
+    if (fd < 0)
+      continue;
+    int enable = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    // The IPv4 addresses get their own socket
+    if (info->ai_family == AF_INET6)
+      setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &enable, sizeof(enable));
+    if (bind(fd, info->ai_addr, info->ai_addrlen) || listen(fd, DAEMON_LISTEN_BACKLOG)) {
+      close(fd);
+      continue;
+    }
+    daemon_data.listen_tcp[daemon_data.listen_count] = true;
+    daemon_data.listen_fds[daemon_data.listen_count++] = fd;
+    listening++;
+  }
+  freeaddrinfo(addresses);
+  if (!listening)
+    fprintf(stderr, "Cannot listen on %s\n", listen_address);
+  return listening > 0;
+}
+
+static void client_remove(unsigned index) {
+  struct daemon_client *client = &daemon_data.clients[index];
+  close(client->fd);
+  gpuinfo_protocol_buffer_free(&client->output);
+  daemon_data.clients[index] = daemon_data.clients[--daemon_data.clients_count];
+}
+
+// Returns the number of bytes sent, or -1 if the client is gone
+static ssize_t client_send(int fd, const unsigned char *data, size_t size) {
+  size_t sent = 0;
+  while (sent < size) {
+    ssize_t written = send(fd, data + sent, size - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (written < 0) {
+      if (errno == EINTR)
+        continue;
+      if (errno == EAGAIN)
+        break;
+      return -1;
+    }
+    sent += written;
+  }
+  return sent;
+}
+
+// Returns false if the client is gone
+static bool client_flush(struct daemon_client *client) {
+  ssize_t sent =
+      client_send(client->fd, client->output.data + client->output_sent, client->output.size - client->output_sent);
+  if (sent < 0)
+    return false;
+  client->output_sent += sent;
+  if (client->output_sent == client->output.size) {
+    client->output.size = 0;
+    client->output_sent = 0;
+  }
+  return true;
+}
+
+// Sends the message, keeping what the socket did not take for later. Returns false if the client is gone.
+static bool client_queue(struct daemon_client *client, const struct gpuinfo_protocol_buffer *message) {
+  size_t sent = 0;
+  if (!client->output.size) {
+    // Spare a copy when the socket takes the whole message
+    ssize_t written = client_send(client->fd, message->data, message->size);
+    if (written < 0)
+      return false;
+    sent = written;
+    if (sent == message->size)
+      return true;
+  } else if (client->output_sent) {
+    memmove(client->output.data, client->output.data + client->output_sent, client->output.size - client->output_sent);
+    client->output.size -= client->output_sent;
+    client->output_sent = 0;
+  }
+  size_t size = client->output.size + message->size - sent;
+  if (size > client->output.capacity) {
+    client->output.data = realloc(client->output.data, size);
+    if (!client->output.data) {
+      perror("Cannot allocate memory: ");
+      exit(EXIT_FAILURE);
+    }
+    client->output.capacity = size;
+  }
+  memcpy(client->output.data + client->output.size, message->data + sent, message->size - sent);
+  client->output.size = size;
+  return true;
+}
+
+static void daemon_accept(unsigned listen_index) {
+  while (true) {
+    int fd = accept4(daemon_data.listen_fds[listen_index], NULL, NULL, SOCK_CLOEXEC | SOCK_NONBLOCK);
+    if (fd < 0)
+      return;
+    if (daemon_data.listen_tcp[listen_index]) {
+      // A sample is a single write, there is nothing to coalesce
+      int enable = 1;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    }
+    if (daemon_data.clients_count == daemon_data.clients_capacity) {
+      daemon_data.clients_capacity = daemon_data.clients_capacity ? 2 * daemon_data.clients_capacity : 8;
+      daemon_data.clients =
+          reallocarray(daemon_data.clients, daemon_data.clients_capacity, sizeof(*daemon_data.clients));
+      daemon_data.poll_fds =
+          reallocarray(daemon_data.poll_fds, daemon_data.clients_capacity + DAEMON_MAX_LISTEN_SOCKETS,
+                       sizeof(*daemon_data.poll_fds));
+      if (!daemon_data.clients || !daemon_data.poll_fds) {
+        perror("Cannot allocate memory: ");
+        exit(EXIT_FAILURE);
+      }
+    }
+    // The client gets the devices and the latest sample right away
+    if (!daemon_data.greeting.size) {
+      gpuinfo_protocol_encode_hello(&daemon_data.greeting, &daemon_data.state);
+      gpuinfo_protocol_encode_sample(&daemon_data.greeting, NULL, &daemon_data.state);
+    }
+    struct daemon_client *client = &daemon_data.clients[daemon_data.clients_count++];
+    *client = (struct daemon_client){.fd = fd};
+    if (!client_queue(client, &daemon_data.greeting))
+      client_remove(daemon_data.clients_count - 1);
+  }
+}
+
+static void daemon_collect(struct list_head *devices) {
+  gpuinfo_refresh_dynamic_info(devices);
+  gpuinfo_refresh_processes(devices);
+  gpuinfo_utilisation_rate(devices);
+  gpuinfo_fix_dynamic_info_from_process_info(devices);
+  gpuinfo_energy_account(devices, true);
+  gpuinfo_stats_record(devices, true);
+  metrics_exporter_push(devices);
+  gpuinfo_protocol_state_from_devices(&daemon_data.next_state, devices);
+
+  daemon_data.sample.size = 0;
+  daemon_data.greeting.size = 0;
+  gpuinfo_protocol_encode_sample(&daemon_data.sample, &daemon_data.state, &daemon_data.next_state);
+  struct gpuinfo_protocol_state previous = daemon_data.state;
+  daemon_data.state = daemon_data.next_state;
+  daemon_data.next_state = previous;
+
+  for (unsigned i = 0; i < daemon_data.clients_count;) {
+    struct daemon_client *client = &daemon_data.clients[i];
+    if (!client_queue(client, &daemon_data.sample) ||
+        client->output.size - client->output_sent > DAEMON_MAX_PENDING_OUTPUT)
+      client_remove(i);
+    else
+      ++i;
+  }
+}
+
+static void daemon_close_listen_sockets(const char *socket_path) {
+  for (unsigned i = 0; i < daemon_data.listen_count; ++i)
+    close(daemon_data.listen_fds[i]);
+  daemon_data.listen_count = 0;
+  unlink(socket_path);
+}
+
+int nvtop_daemon_run(struct list_head *devices, const char *socket_path, const char *listen_address,
+                     int update_interval, volatile sig_atomic_t *stop) {
+  // Publish a complete first sample to the clients
+  daemon_collect(devices);
+  int unix_fd = daemon_listen_unix(socket_path);
+  if (unix_fd < 0)
+    return EXIT_FAILURE;
+  daemon_data.listen_fds[daemon_data.listen_count++] = unix_fd;
+  if (listen_address && !daemon_listen_tcp(listen_address)) {
+    daemon_close_listen_sockets(socket_path);
+    return EXIT_FAILURE;
+  }
+  daemon_data.poll_fds = malloc(DAEMON_MAX_LISTEN_SOCKETS * sizeof(*daemon_data.poll_fds));
+  if (!daemon_data.poll_fds) {
+    perror("Cannot allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+
+  nvtop_time next_sample;
+  nvtop_get_current_time(&next_sample);
+  uint64_t interval = (uint64_t)update_interval * UINT64_C(1000000);
+  while (!*stop) {
+    nvtop_time now;
+    nvtop_get_current_time(&now);
+    uint64_t now_ns = nvtop_time_u64(now);
+    uint64_t next_ns = nvtop_time_u64(next_sample);
+    if (now_ns >= next_ns) {
+      daemon_collect(devices);
+      // Skip the missed samples when the collection took longer than the interval
+      next_ns = next_ns + interval > now_ns ? next_ns + interval : now_ns + interval;
+      next_sample.tv_sec = next_ns / UINT64_C(1000000000);
+      next_sample.tv_nsec = next_ns % UINT64_C(1000000000);
+      continue;
+    }
+
+    unsigned listen_count = daemon_data.listen_count;
+    for (unsigned i = 0; i < listen_count; ++i)
+      daemon_data.poll_fds[i] = (struct pollfd){.fd = daemon_data.listen_fds[i], .events = POLLIN};
+    struct pollfd *client_poll_fds = daemon_data.poll_fds + listen_count;
+    for (unsigned i = 0; i < daemon_data.clients_count; ++i) {
+      const struct daemon_client *client = &daemon_data.clients[i];
+      client_poll_fds[i] = (struct pollfd){.fd = client->fd, .events = POLLIN | (client->output.size ? POLLOUT : 0)};
+    }
+    unsigned polled_clients = daemon_data.clients_count;
+    int timeout = (next_ns - now_ns + UINT64_C(999999)) / UINT64_C(1000000);
+    if (poll(daemon_data.poll_fds, listen_count + polled_clients, timeout) <= 0)
+      continue;
+
+    // Walk backward since removing a client moves the last one in its place
+    for (unsigned i = polled_clients; i > 0; --i) {
+      struct daemon_client *client = &daemon_data.clients[i - 1];
+      short revents = client_poll_fds[i - 1].revents;
+      bool alive = !(revents & (POLLERR | POLLNVAL));
+      if (alive && (revents & (POLLIN | POLLHUP))) {
+        // The clients have nothing to say, reading only tells if they left
+        char discard[256];
+        ssize_t received = recv(client->fd, discard, sizeof(discard), MSG_DONTWAIT);
+        alive = received > 0 || (received < 0 && (errno == EAGAIN || errno == EINTR));
+      }
+      if (alive && (revents & POLLOUT))
+        alive = client_flush(client);
+      if (!alive)
+        client_remove(i - 1);
+    }
+    // Read before accepting, which may move the array
+    short listen_revents[DAEMON_MAX_LISTEN_SOCKETS];
+    for (unsigned i = 0; i < listen_count; ++i)
+      listen_revents[i] = daemon_data.poll_fds[i].revents;
+    for (unsigned i = 0; i < listen_count; ++i) {
+      if (listen_revents[i] & POLLIN)
+        daemon_accept(i);
+    }
+  }
+
+  while (daemon_data.clients_count)
+    client_remove(daemon_data.clients_count - 1);
+  free(daemon_data.clients);
+  free(daemon_data.poll_fds);
+  daemon_close_listen_sockets(socket_path);
+  gpuinfo_protocol_state_clear(&daemon_data.state);
+  gpuinfo_protocol_state_clear(&daemon_data.next_state);
+  gpuinfo_protocol_buffer_free(&daemon_data.sample);
+  gpuinfo_protocol_buffer_free(&daemon_data.greeting);
+  return EXIT_SUCCESS;
+}
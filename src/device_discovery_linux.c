@@ -20,10 +20,14 @@
 
 #include "nvtop/device_discovery.h"
 
+#include <errno.h>
+#include <fcntl.h>
 #include <limits.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #if defined(USING_LIBUDEV) && defined(USING_LIBSYSTEMD)
 #error Cannot use libudev and libsystemd at the same time
@@ -322,21 +326,6 @@ int nvtop_device_maximum_pcie_link(nvtop_device *dev, nvtop_pcie_link *pcie_info
   return pcie_walker_helper(dev, pcie_info, "max_link_speed", "max_link_width");
 }
 
-int nvtop_device_current_pcie_link(nvtop_device *dev, nvtop_pcie_link *pcie_info) {
-  // We open a new device to avoid cached values
-  const char *path;
-  nvtop_device_get_syspath(dev, &path);
-  nvtop_device *dev_samepath;
-  int ret = nvtop_device_new_from_syspath(&dev_samepath, path);
-  if (ret < 0)
-    return ret;
-  pcie_info->speed = UINT_MAX;
-  pcie_info->width = UINT_MAX;
-  ret = pcie_walker_helper(dev_samepath, pcie_info, "current_link_speed", "current_link_width");
-  nvtop_device_unref(dev_samepath);
-  return ret;
-}
-
 nvtop_device *nvtop_device_get_hwmon(nvtop_device *dev) {
   nvtop_device_enumerator *enumerator;
   int ret = nvtop_enumerator_new(&enumerator);
@@ -355,3 +344,149 @@ nvtop_device *nvtop_device_get_hwmon(nvtop_device *dev) {
   nvtop_enumerator_unref(enumerator);
   return hwmon;
 }
+
+#define NVTOP_SYSFS_ATTR_BUFFER_SIZE 256
+
+struct nvtop_sysfs_attr {
+  int fd;
+  char buffer[NVTOP_SYSFS_ATTR_BUFFER_SIZE];
+};
+
+nvtop_sysfs_attr *nvtop_sysfs_attr_open(const char *path) {
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return NULL;
+  nvtop_sysfs_attr *attr = malloc(sizeof(*attr));
+  if (!attr) {
+    close(fd);
+    return NULL;
+  }
+  attr->fd = fd;
+  attr->buffer[0] = '\0';
+  return attr;
+}
+
+nvtop_sysfs_attr *nvtop_sysfs_attr_open_from_device(nvtop_device *dev, const char *sysattr) {
+  const char *syspath;
+  if (!dev || nvtop_device_get_syspath(dev, &syspath) < 0)
+    return NULL;
+  char path[PATH_MAX];
+  int written = snprintf(path, sizeof(path), "%s/%s", syspath, sysattr);
+  if (written < 0 || (size_t)written >= sizeof(path))
+    return NULL;
+  return nvtop_sysfs_attr_open(path);
+}
+
+void nvtop_sysfs_attr_close(nvtop_sysfs_attr *attr) {
+  if (!attr)
+    return;
+  close(attr->fd);
+  free(attr);
+}
+
+const char *nvtop_sysfs_attr_read(nvtop_sysfs_attr *attr) {
+  if (!attr)
+    return NULL;
+  // Sysfs regenerates the attribute content on each read at offset 0
+  ssize_t nread = pread(attr->fd, attr->buffer, sizeof(attr->buffer) - 1, 0);
+  if (nread < 0)
+    return NULL;
+  attr->buffer[nread] = '\0';
+  return attr->buffer;
+}
+
+int nvtop_sysfs_attr_read_uint64(nvtop_sysfs_attr *attr, uint64_t *value) {
+  const char *content = nvtop_sysfs_attr_read(attr);
+  if (!content)
+    return -EIO;
+  while (*content == ' ' || *content == '\t')
+    content++;
+  if (*content < '0' || *content > '9')
+    return -EINVAL;
+  uint64_t val = 0;
+  for (; *content >= '0' && *content <= '9'; ++content) {
+    val = val * 10 + (uint64_t)(*content - '0');
+  }
+  *value = val;
+  return 0;
+}
+
+int nvtop_sysfs_attr_read_binary(nvtop_sysfs_attr *attr, void *buffer, size_t size) {
+  if (!attr)
+    return -EINVAL;
+  ssize_t nread = pread(attr->fd, buffer, size, 0);
+  if (nread < 0)
+    return -errno;
+  return (int)nread;
+}
+
+struct nvtop_pcie_link_ports {
+  unsigned num_ports;
+  struct {
+    nvtop_sysfs_attr *speed;
+    nvtop_sysfs_attr *width;
+  } ports[];
+};
+
+nvtop_pcie_link_ports *nvtop_device_pcie_link_ports(nvtop_device *dev) {
+  // The PCIe topology does not change at runtime: walk the parents up to the root complex once and keep the current
+  // link attributes of the pcieport bridges open.
+  unsigned num_ports = 0;
+  const char *driver;
+  for (nvtop_device *curr = dev; curr && nvtop_device_get_driver(curr, &driver) >= 0;) {
+    if (!strcmp(driver, "pcieport"))
+      num_ports++;
+    if (nvtop_device_get_parent(curr, &curr) < 0)
+      break;
+  }
+  if (!num_ports)
+    return NULL;
+
+  nvtop_pcie_link_ports *ports = calloc(1, sizeof(*ports) + num_ports * sizeof(*ports->ports));
+  if (!ports)
+    return NULL;
+  for (nvtop_device *curr = dev; curr && ports->num_ports < num_ports && nvtop_device_get_driver(curr, &driver) >= 0;) {
+    if (!strcmp(driver, "pcieport")) {
+      unsigned idx = ports->num_ports++;
+      ports->ports[idx].speed = nvtop_sysfs_attr_open_from_device(curr, "current_link_speed");
+      ports->ports[idx].width = nvtop_sysfs_attr_open_from_device(curr, "current_link_width");
+      if (!ports->ports[idx].speed || !ports->ports[idx].width) {
+        nvtop_pcie_link_ports_free(ports);
+        return NULL;
+      }
+    }
+    if (nvtop_device_get_parent(curr, &curr) < 0)
+      break;
+  }
+  return ports;
+}
+
+void nvtop_pcie_link_ports_free(nvtop_pcie_link_ports *ports) {
+  if (!ports)
+    return;
+  for (unsigned i = 0; i < ports->num_ports; ++i) {
+    nvtop_sysfs_attr_close(ports->ports[i].speed);
+    nvtop_sysfs_attr_close(ports->ports[i].width);
+  }
+  free(ports);
+}
+
+int nvtop_pcie_link_ports_current_link(nvtop_pcie_link_ports *ports, nvtop_pcie_link *pcie_info) {
+  if (!ports)
+    return -ENOENT;
+  pcie_info->speed = UINT_MAX;
+  pcie_info->width = UINT_MAX;
+  // The link is as fast as the slowest of the upstream ports
+  for (unsigned i = 0; i < ports->num_ports; ++i) {
+    uint64_t speed, width;
+    int ret = nvtop_sysfs_attr_read_uint64(ports->ports[i].speed, &speed);
+    if (ret < 0)
+      return ret;
+    ret = nvtop_sysfs_attr_read_uint64(ports->ports[i].width, &width);
+    if (ret < 0)
+      return ret;
+    pcie_info->speed = pcie_info->speed > speed ? speed : pcie_info->speed;
+    pcie_info->width = pcie_info->width > width ? width : pcie_info->width;
+  }
+  return 0;
+}
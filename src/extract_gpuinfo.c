@@ -19,6 +19,7 @@
  *
  */
 
+#include <assert.h>
 #include <ctype.h>
 #include <math.h>
 #include <stdio.h>
@@ -26,9 +27,11 @@
 #include <string.h>
 
 #include "nvtop/extract_gpuinfo.h"
+#include "nvtop/common.h"
 #include "nvtop/extract_gpuinfo_common.h"
 #include "nvtop/extract_processinfo_fdinfo.h"
 #include "nvtop/get_process_info.h"
+#include "nvtop/power_sampler.h"
 #include "nvtop/time.h"
 #include "uthash.h"
 
@@ -45,12 +48,75 @@ struct process_info_cache {
   char *user_name;
   double last_total_consumed_cpu_time;
   nvtop_time last_measurement_timestamp;
+  // CPU placement of the process, read again once older than CPU_PLACEMENT_REFRESH_PERIOD
+  bool has_placement;
+  bool has_allowed_cpus;
+  bool has_thread_cpus; // Only read when the allowed CPUs are both local and remote to a device
+  nvtop_time placement_timestamp;
+  struct nvtop_cpu_set allowed_cpus;
+  unsigned threads_count;
+  unsigned threads_size;
+  unsigned *thread_cpus;
   UT_hash_handle hh;
 };
 
 struct process_info_cache *cached_process_info = NULL;
 struct process_info_cache *updated_process_info = NULL;
 
+// Number of cached processes per user name length, so that the widest name is known without going through them all
+#define USER_NAME_LENGTH_MAX 255
+static unsigned user_name_length_count[USER_NAME_LENGTH_MAX + 1];
+
+static void count_user_name(const char *user_name, bool added) {
+  if (!user_name)
+    return;
+  size_t length = strlen(user_name);
+  if (length > USER_NAME_LENGTH_MAX)
+    length = USER_NAME_LENGTH_MAX;
+  if (added)
+    user_name_length_count[length]++;
+  else
+    user_name_length_count[length]--;
+}
+
+// DRM client counters of all the devices, shared by every fdinfo backend (AMDGPU, Intel, MSM, V3D, Mali) and stored
+// in a flat open-addressing table (linear probing).
+// An entry is written with the generation of the update that last saw the client. Entries older than the previous
+// generation are stale: their slot is reused by new clients and dropped when the table is rebuilt.
+struct client_counters_entry {
+  const struct gpu_info *gpu_info;
+  pid_t pid;
+  unsigned client_id;
+  unsigned generation; // 0 for a slot that was never used
+  nvtop_time last_measurement_tstamp;
+  struct gpuinfo_client_counters counters;
+};
+
+static struct {
+  struct client_counters_entry *entries;
+  size_t capacity; // Power of two
+  size_t used;     // Slots with a generation, stale ones included
+  unsigned generation;
+} client_counters_cache = {.generation = 1};
+
+#define CLIENT_COUNTERS_CACHE_MIN_CAPACITY 64
+
+// Seconds between two reads of the CPUs the threads of a process run on
+#define CPU_PLACEMENT_REFRESH_PERIOD 2.
+
+// CPUs of the NUMA node of the devices, read the first time their processes are populated
+struct device_local_cpus {
+  const struct gpu_info *device;
+  bool numa_local; // False when the device is not attached to a NUMA node, or when all the CPUs are local to it
+  struct nvtop_cpu_set cpus;
+};
+
+static struct {
+  unsigned count;
+  unsigned capacity;
+  struct device_local_cpus *devices;
+} local_cpus_cache;
+
 static LIST_HEAD(gpu_vendors);
 
 void register_gpu_vendor(struct gpu_vendor *vendor) { list_add(&vendor->list, &gpu_vendors); }
@@ -73,6 +139,9 @@ bool gpuinfo_init_info_extraction(unsigned *monitored_dev_count, struct list_hea
     *monitored_dev_count += vendor_devices_count;
   }
 
+  struct gpu_info *device;
+  list_for_each_entry(device, devices, list) { device->subscription = GPUINFO_SUBSCRIPTION_ALL; }
+
   return true;
 }
 
@@ -80,6 +149,8 @@ bool gpuinfo_shutdown_info_extraction(struct list_head *devices) {
   struct gpu_info *device, *tmp;
   struct gpu_vendor *vendor;
 
+  // The sampling thread reads the devices through their backend
+  power_sampler_stop();
   list_for_each_entry_safe(device, tmp, devices, list) {
     free(device->processes);
     list_del(&device->list);
@@ -87,6 +158,8 @@ bool gpuinfo_shutdown_info_extraction(struct list_head *devices) {
 
   list_for_each_entry(vendor, &gpu_vendors, list) { vendor->shutdown(); }
   gpuinfo_clear_cache();
+  free(local_cpus_cache.devices);
+  memset(&local_cpus_cache, 0, sizeof(local_cpus_cache));
   return true;
 }
 
@@ -97,10 +170,101 @@ bool gpuinfo_populate_static_infos(struct list_head *devices) {
   return true;
 }
 
+// Refresh schedule of each dynamic field, zero initialized to query them at every update
+static struct {
+  bool once;
+  unsigned period;
+} dynamic_refresh_schedule[gpuinfo_dynamic_info_count];
+
+// The subscription group of each dynamic field, gpuinfo_subscribe_group_count for the fields always refreshed
+static const enum gpuinfo_subscription_group dynamic_field_group[gpuinfo_dynamic_info_count] = {
+    [gpuinfo_gpu_clock_speed_valid] = gpuinfo_subscribe_clocks,
+    [gpuinfo_gpu_clock_speed_max_valid] = gpuinfo_subscribe_clocks,
+    [gpuinfo_mem_clock_speed_valid] = gpuinfo_subscribe_clocks,
+    [gpuinfo_mem_clock_speed_max_valid] = gpuinfo_subscribe_clocks,
+    [gpuinfo_gpu_util_rate_valid] = gpuinfo_subscribe_utilisation,
+    [gpuinfo_mem_util_rate_valid] = gpuinfo_subscribe_memory,
+    [gpuinfo_encoder_rate_valid] = gpuinfo_subscribe_encode_decode,
+    [gpuinfo_decoder_rate_valid] = gpuinfo_subscribe_encode_decode,
+    [gpuinfo_total_memory_valid] = gpuinfo_subscribe_memory,
+    [gpuinfo_free_memory_valid] = gpuinfo_subscribe_memory,
+    [gpuinfo_used_memory_valid] = gpuinfo_subscribe_memory,
+    [gpuinfo_pcie_link_gen_valid] = gpuinfo_subscribe_pcie,
+    [gpuinfo_pcie_link_width_valid] = gpuinfo_subscribe_pcie,
+    [gpuinfo_pcie_rx_valid] = gpuinfo_subscribe_pcie,
+    [gpuinfo_pcie_tx_valid] = gpuinfo_subscribe_pcie,
+    [gpuinfo_fan_speed_valid] = gpuinfo_subscribe_thermal,
+    [gpuinfo_fan_rpm_valid] = gpuinfo_subscribe_thermal,
+    [gpuinfo_gpu_temp_valid] = gpuinfo_subscribe_thermal,
+    [gpuinfo_power_draw_valid] = gpuinfo_subscribe_power,
+    [gpuinfo_power_draw_max_valid] = gpuinfo_subscribe_power,
+    [gpuinfo_multi_instance_mode_valid] = gpuinfo_subscribe_group_count,
+    [gpuinfo_stale_data_age_valid] = gpuinfo_subscribe_group_count,
+    [gpuinfo_energy_consumed_valid] = gpuinfo_subscribe_power,
+    [gpuinfo_power_draw_peak_valid] = gpuinfo_subscribe_power,
+    [gpuinfo_power_draw_p99_valid] = gpuinfo_subscribe_power,
+    [gpuinfo_throttle_reasons_valid] = gpuinfo_subscribe_clocks,
+    [gpuinfo_engine_util_rate_valid + gpuinfo_engine_render] = gpuinfo_subscribe_processes,
+    [gpuinfo_engine_util_rate_valid + gpuinfo_engine_compute] = gpuinfo_subscribe_processes,
+    [gpuinfo_engine_util_rate_valid + gpuinfo_engine_copy] = gpuinfo_subscribe_processes,
+    [gpuinfo_engine_util_rate_valid + gpuinfo_engine_decode] = gpuinfo_subscribe_processes,
+    [gpuinfo_engine_util_rate_valid + gpuinfo_engine_encode] = gpuinfo_subscribe_processes,
+};
+
+static gpuinfo_subscription consumer_needs;
+
+void gpuinfo_add_consumer_needs(gpuinfo_subscription needs) { consumer_needs |= needs; }
+
+gpuinfo_subscription gpuinfo_consumer_needs(void) { return consumer_needs; }
+
+void gpuinfo_set_dynamic_refresh_period(enum gpuinfo_dynamic_info_valid field, unsigned period) {
+  dynamic_refresh_schedule[field].once = period == 0;
+  dynamic_refresh_schedule[field].period = period;
+}
+
+// Decides which fields the backend queries during this update and invalidates them
+static void gpuinfo_schedule_dynamic_refresh(struct gpu_info *device) {
+  unsigned count = device->dynamic_refresh_count++;
+  RESET_ALL(device->dynamic_due);
+  for (unsigned field = 0; field < gpuinfo_dynamic_info_count; ++field) {
+    enum gpuinfo_subscription_group group = dynamic_field_group[field];
+    if (group != gpuinfo_subscribe_group_count && !(device->subscription & GPUINFO_SUBSCRIPTION(group))) {
+      // Not needed anymore: forget the value so that it is queried again when subscribed
+      RESET_VALID(field, device->dynamic_info.valid);
+      RESET_VALID(field, device->dynamic_queried);
+      continue;
+    }
+    unsigned period = dynamic_refresh_schedule[field].period;
+    bool due = !IS_VALID(field, device->dynamic_queried) ||
+               (!dynamic_refresh_schedule[field].once && (period <= 1 || count % period == 0));
+    if (due) {
+      SET_VALID(field, device->dynamic_due);
+      // The fields queried once are retried until they get a value (see gpuinfo_record_dynamic_refresh)
+      if (!dynamic_refresh_schedule[field].once)
+        SET_VALID(field, device->dynamic_queried);
+      RESET_VALID(field, device->dynamic_info.valid);
+    }
+  }
+}
+
+// A field queried once is not queried again only if the backend could read it
+static void gpuinfo_record_dynamic_refresh(struct gpu_info *device) {
+  for (unsigned field = 0; field < gpuinfo_dynamic_info_count; ++field) {
+    if (dynamic_refresh_schedule[field].once && IS_VALID(field, device->dynamic_due) &&
+        IS_VALID(field, device->dynamic_info.valid))
+      SET_VALID(field, device->dynamic_queried);
+  }
+}
+
 bool gpuinfo_refresh_dynamic_info(struct list_head *devices) {
   struct gpu_info *device;
 
-  list_for_each_entry(device, devices, list) { device->vendor->refresh_dynamic_info(device); }
+  list_for_each_entry(device, devices, list) {
+    gpuinfo_schedule_dynamic_refresh(device);
+    device->vendor->refresh_dynamic_info(device);
+    power_sampler_apply(device);
+    gpuinfo_record_dynamic_refresh(device);
+  }
   return true;
 }
 
@@ -124,9 +288,22 @@ bool gpuinfo_fix_dynamic_info_from_process_info(struct list_head *devices) {
     // Update them here since per-process sysfs exposes this information.
     bool needGpuEncode = !GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, encoder_rate);
     bool needGpuDecode = !GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, decoder_rate);
+    // The per-engine class utilization is only reported per process
+    for (enum gpuinfo_engine_class engine = 0; engine < gpuinfo_engine_class_count; ++engine)
+      RESET_VALID(gpuinfo_engine_util_rate_valid + engine, dynamic_info->valid);
     if (needGpuRate || needGpuEncode || needGpuDecode) {
       for (unsigned processIdx = 0; processIdx < device->processes_count; ++processIdx) {
         struct gpu_process *process_info = &device->processes[processIdx];
+        for (enum gpuinfo_engine_class engine = 0; engine < gpuinfo_engine_class_count; ++engine) {
+          if (GPUINFO_PROCESS_ENGINE_VALID(process_info, engine)) {
+            if (GPUINFO_DYNAMIC_ENGINE_VALID(dynamic_info, engine)) {
+              dynamic_info->engine_util_rate[engine] =
+                  MYMIN(100, dynamic_info->engine_util_rate[engine] + process_info->engine_usage[engine]);
+            } else {
+              SET_GPUINFO_DYNAMIC_ENGINE(dynamic_info, engine, MYMIN(100, process_info->engine_usage[engine]));
+            }
+          }
+        }
         if (needGpuRate && GPUINFO_PROCESS_FIELD_VALID(process_info, gpu_usage)) {
           if (GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, gpu_util_rate)) {
             dynamic_info->gpu_util_rate = MYMIN(100, dynamic_info->gpu_util_rate + process_info->gpu_usage);
@@ -162,6 +339,79 @@ bool gpuinfo_fix_dynamic_info_from_process_info(struct list_head *devices) {
 }
 #undef MYMIN
 
+static const struct nvtop_cpu_set *gpuinfo_device_local_cpus(const struct gpu_info *device) {
+  for (unsigned i = 0; i < local_cpus_cache.count; ++i) {
+    if (local_cpus_cache.devices[i].device == device)
+      return local_cpus_cache.devices[i].numa_local ? &local_cpus_cache.devices[i].cpus : NULL;
+  }
+  if (local_cpus_cache.count == local_cpus_cache.capacity) {
+    unsigned capacity = local_cpus_cache.capacity + COMMON_PROCESS_LINEAR_REALLOC_INC;
+    struct device_local_cpus *devices = reallocarray(local_cpus_cache.devices, capacity, sizeof(*devices));
+    if (!devices) {
+      perror("Cannot allocate memory: ");
+      exit(EXIT_FAILURE);
+    }
+    local_cpus_cache.devices = devices;
+    local_cpus_cache.capacity = capacity;
+  }
+  struct device_local_cpus *local_cpus = &local_cpus_cache.devices[local_cpus_cache.count++];
+  local_cpus->device = device;
+  local_cpus->numa_local = get_pci_device_local_cpus(device->pdev, &local_cpus->cpus);
+  return local_cpus->numa_local ? &local_cpus->cpus : NULL;
+}
+
+// Share of the threads of the process that last ran on a CPU of the NUMA node of the device. The threads are only
+// looked at when the affinity of the process allows both local and remote CPUs.
+static void gpuinfo_populate_cpu_locality(const struct gpu_info *device, struct gpu_process *process,
+                                          struct process_info_cache *cached_pid_info) {
+  const struct nvtop_cpu_set *local_cpus = gpuinfo_device_local_cpus(device);
+  if (!local_cpus)
+    return;
+
+  nvtop_time now;
+  nvtop_get_current_time(&now);
+  if (!cached_pid_info->has_placement ||
+      nvtop_difftime(cached_pid_info->placement_timestamp, now) >= CPU_PLACEMENT_REFRESH_PERIOD) {
+    cached_pid_info->has_placement = true;
+    cached_pid_info->placement_timestamp = now;
+    cached_pid_info->has_allowed_cpus = get_process_allowed_cpus(process->pid, &cached_pid_info->allowed_cpus);
+    cached_pid_info->has_thread_cpus = false;
+    cached_pid_info->threads_count = 0;
+  }
+  if (!cached_pid_info->has_allowed_cpus)
+    return;
+
+  bool allows_local = false, allows_remote = false;
+  for (size_t i = 0; i < NVTOP_MAX_CPUS / 64; ++i) {
+    allows_local = allows_local || (cached_pid_info->allowed_cpus.bits[i] & local_cpus->bits[i]);
+    allows_remote = allows_remote || (cached_pid_info->allowed_cpus.bits[i] & ~local_cpus->bits[i]);
+  }
+  if (!allows_remote) {
+    SET_GPUINFO_PROCESS(process, cpu_locality, 100);
+    return;
+  }
+  if (!allows_local) {
+    SET_GPUINFO_PROCESS(process, cpu_locality, 0);
+    return;
+  }
+
+  if (!cached_pid_info->has_thread_cpus) {
+    cached_pid_info->has_thread_cpus =
+        get_process_thread_cpus(process->pid, &cached_pid_info->thread_cpus, &cached_pid_info->threads_count,
+                                &cached_pid_info->threads_size);
+    if (!cached_pid_info->has_thread_cpus)
+      return;
+  }
+  unsigned local_threads = 0;
+  for (unsigned i = 0; i < cached_pid_info->threads_count; ++i) {
+    unsigned cpu = cached_pid_info->thread_cpus[i];
+    if (cpu < NVTOP_MAX_CPUS && NVTOP_CPU_ISSET(cpu, local_cpus))
+      local_threads++;
+  }
+  SET_GPUINFO_PROCESS(process, cpu_locality,
+                      (local_threads * 100 + cached_pid_info->threads_count / 2) / cached_pid_info->threads_count);
+}
+
 static void gpuinfo_populate_process_info(struct gpu_info *device) {
   for (unsigned j = 0; j < device->processes_count; ++j) {
     pid_t current_pid = device->processes[j].pid;
@@ -175,6 +425,7 @@ static void gpuinfo_populate_process_info(struct gpu_info *device) {
         cached_pid_info = calloc(1, sizeof(*cached_pid_info));
         cached_pid_info->pid = current_pid;
         get_username_from_pid(current_pid, &cached_pid_info->user_name);
+        count_user_name(cached_pid_info->user_name, true);
         get_command_from_pid(current_pid, &cached_pid_info->cmdline);
         cached_pid_info->last_total_consumed_cpu_time = -1.;
         HASH_ADD_PID(updated_process_info, cached_pid_info);
@@ -212,6 +463,8 @@ static void gpuinfo_populate_process_info(struct gpu_info *device) {
       cached_pid_info->last_total_consumed_cpu_time = -1;
     }
 
+    gpuinfo_populate_cpu_locality(device, &device->processes[j], cached_pid_info);
+
     // Process memory usage percent of total device memory
     if (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, total_memory) &&
         GPUINFO_PROCESS_FIELD_VALID(&device->processes[j], gpu_memory_usage)) {
@@ -227,23 +480,56 @@ static void gpuinfo_clean_old_cache(void) {
   struct process_info_cache *pid_not_encountered, *tmp;
   HASH_ITER(hh, cached_process_info, pid_not_encountered, tmp) {
     HASH_DEL(cached_process_info, pid_not_encountered);
+    count_user_name(pid_not_encountered->user_name, false);
     free(pid_not_encountered->cmdline);
     free(pid_not_encountered->user_name);
+    free(pid_not_encountered->thread_cpus);
     free(pid_not_encountered);
   }
   cached_process_info = updated_process_info;
   updated_process_info = NULL;
 }
 
+// The device-wide utilization rates that the backend could not read are summed from the processes usage
+static bool gpuinfo_needs_processes(const struct gpu_info *device) {
+  const struct gpuinfo_dynamic_info *dynamic_info = &device->dynamic_info;
+  if (GPUINFO_SUBSCRIBED(device, gpuinfo_subscribe_processes))
+    return true;
+  if (GPUINFO_SUBSCRIBED(device, gpuinfo_subscribe_utilisation) &&
+      !GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, gpu_util_rate))
+    return true;
+  return GPUINFO_SUBSCRIBED(device, gpuinfo_subscribe_encode_decode) &&
+         (!GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, encoder_rate) ||
+          !GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, decoder_rate));
+}
+
 bool gpuinfo_refresh_processes(struct list_head *devices) {
   struct gpu_info *device;
+  bool any_device_needs_processes = false;
+
+  list_for_each_entry(device, devices, list) {
+    device->processes_count = 0;
+    any_device_needs_processes = any_device_needs_processes || gpuinfo_needs_processes(device);
+  }
 
-  list_for_each_entry(device, devices, list) { device->processes_count = 0; }
+  // Nobody looks at the processes: skip the /proc sweep and drop the per process history, which would be outdated
+  // once the processes are needed again
+  if (!any_device_needs_processes) {
+    if (cached_process_info || client_counters_cache.used)
+      gpuinfo_clear_cache();
+    return true;
+  }
+
+  // Clients not seen during this update will be stale for the next one
+  if (++client_counters_cache.generation == 0)
+    client_counters_cache.generation = 1;
 
   // Go through the /proc hierarchy once and populate the processes for all registered GPUs
   processinfo_sweep_fdinfos();
 
   list_for_each_entry(device, devices, list) {
+    if (!gpuinfo_needs_processes(device))
+      continue;
     device->vendor->refresh_running_processes(device);
     gpuinfo_populate_process_info(device);
   }
@@ -252,6 +538,20 @@ bool gpuinfo_refresh_processes(struct list_head *devices) {
   return true;
 }
 
+// Longest user name of the processes read from a sample of another instance
+static unsigned shared_user_name_length;
+
+void gpuinfo_set_shared_user_name_length(unsigned length) {
+  shared_user_name_length = length < USER_NAME_LENGTH_MAX ? length : USER_NAME_LENGTH_MAX;
+}
+
+unsigned gpuinfo_largest_user_name_length(void) {
+  unsigned length = USER_NAME_LENGTH_MAX;
+  while (length > 0 && !user_name_length_count[length])
+    --length;
+  return length > shared_user_name_length ? length : shared_user_name_length;
+}
+
 bool gpuinfo_utilisation_rate(struct list_head *devices) {
   struct gpu_info *device;
 
@@ -270,9 +570,15 @@ void gpuinfo_clear_cache(void) {
       HASH_DEL(cached_process_info, pid_cached);
       free(pid_cached->cmdline);
       free(pid_cached->user_name);
+      free(pid_cached->thread_cpus);
       free(pid_cached);
     }
   }
+  memset(user_name_length_count, 0, sizeof(user_name_length_count));
+  free(client_counters_cache.entries);
+  client_counters_cache.entries = NULL;
+  client_counters_cache.capacity = 0;
+  client_counters_cache.used = 0;
 }
 
 bool extract_drm_fdinfo_key_value(char *buf, char **key, char **val) {
@@ -297,6 +603,161 @@ bool extract_drm_fdinfo_key_value(char *buf, char **key, char **val) {
 extern inline unsigned busy_usage_from_time_usage_round(uint64_t current_use_ns, uint64_t previous_use_ns,
                                                         uint64_t time_between_measurement);
 
+static size_t client_counters_hash(const struct gpu_info *gpu_info, pid_t pid, unsigned client_id) {
+  uint64_t hash = (uint64_t)(uintptr_t)gpu_info ^ ((uint64_t)(uint32_t)pid << 32 | client_id);
+  // splitmix64 finalizer
+  hash = (hash ^ (hash >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+  hash = (hash ^ (hash >> 27)) * UINT64_C(0x94d049bb133111eb);
+  return (size_t)(hash ^ (hash >> 31));
+}
+
+static bool client_counters_entry_is_stale(const struct client_counters_entry *entry) {
+  unsigned previous_generation = client_counters_cache.generation - 1;
+  if (!previous_generation)
+    previous_generation = UINT_MAX;
+  return entry->generation != client_counters_cache.generation && entry->generation != previous_generation;
+}
+
+// Returns the entry of the client, or the slot where it should be inserted if it is not in the table
+static struct client_counters_entry *client_counters_lookup(const struct gpu_info *gpu_info, pid_t pid,
+                                                            unsigned client_id) {
+  size_t mask = client_counters_cache.capacity - 1;
+  struct client_counters_entry *reusable = NULL;
+  for (size_t idx = client_counters_hash(gpu_info, pid, client_id) & mask;; idx = (idx + 1) & mask) {
+    struct client_counters_entry *entry = &client_counters_cache.entries[idx];
+    if (!entry->generation)
+      return reusable ? reusable : entry;
+    if (entry->gpu_info == gpu_info && entry->pid == pid && entry->client_id == client_id)
+      return entry;
+    if (!reusable && client_counters_entry_is_stale(entry))
+      reusable = entry;
+  }
+}
+
+// Rebuilds the table without its stale entries, growing it if needed
+static bool client_counters_rehash(void) {
+  struct client_counters_entry *old_entries = client_counters_cache.entries;
+  size_t old_capacity = client_counters_cache.capacity;
+  size_t live = 0;
+  for (size_t i = 0; i < old_capacity; ++i) {
+    if (old_entries[i].generation && !client_counters_entry_is_stale(&old_entries[i]))
+      live++;
+  }
+  size_t capacity = CLIENT_COUNTERS_CACHE_MIN_CAPACITY;
+  while (capacity < 2 * (live + 1))
+    capacity *= 2;
+
+  struct client_counters_entry *entries = calloc(capacity, sizeof(*entries));
+  if (!entries)
+    return false;
+  client_counters_cache.entries = entries;
+  client_counters_cache.capacity = capacity;
+  client_counters_cache.used = 0;
+  for (size_t i = 0; i < old_capacity; ++i) {
+    if (old_entries[i].generation && !client_counters_entry_is_stale(&old_entries[i])) {
+      struct client_counters_entry *slot =
+          client_counters_lookup(old_entries[i].gpu_info, old_entries[i].pid, old_entries[i].client_id);
+      *slot = old_entries[i];
+      client_counters_cache.used++;
+    }
+  }
+  free(old_entries);
+  return true;
+}
+
+bool gpuinfo_client_counters_update(const struct gpu_info *gpu_info, pid_t pid, unsigned client_id,
+                                    const struct gpuinfo_client_counters *counters,
+                                    struct gpuinfo_client_delta *delta) {
+  nvtop_time current_time;
+  nvtop_get_current_time(&current_time);
+
+  // Keep at least a quarter of the slots empty so that the probing stays short
+  if (4 * (client_counters_cache.used + 1) > 3 * client_counters_cache.capacity && !client_counters_rehash())
+    return false;
+
+  struct client_counters_entry *entry = client_counters_lookup(gpu_info, pid, client_id);
+  bool has_previous = false;
+  if (entry->generation && entry->gpu_info == gpu_info && entry->pid == pid && entry->client_id == client_id) {
+    // We should only process one fdinfo entry per client id per update
+    assert(entry->generation != client_counters_cache.generation &&
+           "We should not be processing a client id twice per update");
+    has_previous = !client_counters_entry_is_stale(entry);
+  } else if (!entry->generation) {
+    client_counters_cache.used++;
+  }
+
+  if (has_previous) {
+    RESET_ALL(delta->valid);
+    delta->time_elapsed = nvtop_difftime_u64(entry->last_measurement_tstamp, current_time);
+    for (unsigned slot = 0; slot < GPUINFO_CLIENT_COUNTER_SLOTS; ++slot) {
+      // In some rare occasions, the usage reported by the driver is lowering (might be a driver bug)
+      if (GPUINFO_CLIENT_COUNTER_VALID(counters, slot) && GPUINFO_CLIENT_COUNTER_VALID(&entry->counters, slot) &&
+          counters->value[slot] >= entry->counters.value[slot])
+        SET_GPUINFO_CLIENT_COUNTER(delta, slot, counters->value[slot] - entry->counters.value[slot]);
+    }
+  }
+
+  entry->gpu_info = gpu_info;
+  entry->pid = pid;
+  entry->client_id = client_id;
+  entry->generation = client_counters_cache.generation;
+  entry->last_measurement_tstamp = current_time;
+  entry->counters = *counters;
+  return has_previous;
+}
+
+bool gpuinfo_client_busy_usage(const struct gpuinfo_client_delta *delta, unsigned slot, unsigned *usage) {
+  if (!GPUINFO_CLIENT_COUNTER_VALID(delta, slot) || !delta->time_elapsed || delta->value[slot] > delta->time_elapsed)
+    return false;
+  *usage = busy_usage_from_time_usage_round(delta->value[slot], 0, delta->time_elapsed);
+  return true;
+}
+
+bool gpuinfo_client_cycles_usage(const struct gpuinfo_client_delta *delta, unsigned busy_slot, unsigned total_slot,
+                                 unsigned *usage) {
+  if (!GPUINFO_CLIENT_COUNTER_VALID(delta, busy_slot) || !GPUINFO_CLIENT_COUNTER_VALID(delta, total_slot) ||
+      !delta->value[total_slot])
+    return false;
+  *usage = delta->value[busy_slot] * 100 / delta->value[total_slot];
+  return true;
+}
+
+void gpuinfo_client_counters_from_process(const struct gpu_process *process,
+                                          struct gpuinfo_client_counters *counters) {
+  if (GPUINFO_PROCESS_FIELD_VALID(process, gfx_engine_used))
+    SET_GPUINFO_CLIENT_COUNTER(counters, gpuinfo_client_gfx_engine, process->gfx_engine_used);
+  if (GPUINFO_PROCESS_FIELD_VALID(process, compute_engine_used))
+    SET_GPUINFO_CLIENT_COUNTER(counters, gpuinfo_client_compute_engine, process->compute_engine_used);
+  if (GPUINFO_PROCESS_FIELD_VALID(process, enc_engine_used))
+    SET_GPUINFO_CLIENT_COUNTER(counters, gpuinfo_client_enc_engine, process->enc_engine_used);
+  if (GPUINFO_PROCESS_FIELD_VALID(process, dec_engine_used))
+    SET_GPUINFO_CLIENT_COUNTER(counters, gpuinfo_client_dec_engine, process->dec_engine_used);
+}
+
+void gpuinfo_process_usage_from_client_delta(struct gpu_process *process, const struct gpuinfo_client_delta *delta) {
+  static const enum gpuinfo_engine_class engine_of_slot[] = {
+      [gpuinfo_client_gfx_engine] = gpuinfo_engine_render, [gpuinfo_client_compute_engine] = gpuinfo_engine_compute,
+      [gpuinfo_client_enc_engine] = gpuinfo_engine_encode, [gpuinfo_client_dec_engine] = gpuinfo_engine_decode,
+      [gpuinfo_client_copy_engine] = gpuinfo_engine_copy,
+  };
+  for (unsigned slot = 0; slot < sizeof(engine_of_slot) / sizeof(*engine_of_slot); ++slot) {
+    unsigned usage;
+    if (gpuinfo_client_busy_usage(delta, slot, &usage))
+      SET_GPUINFO_PROCESS_ENGINE(process, engine_of_slot[slot], usage);
+  }
+
+  bool gfx_valid = GPUINFO_PROCESS_ENGINE_VALID(process, gpuinfo_engine_render);
+  bool compute_valid = GPUINFO_PROCESS_ENGINE_VALID(process, gpuinfo_engine_compute);
+  if (gfx_valid || compute_valid)
+    SET_GPUINFO_PROCESS(process, gpu_usage,
+                        (gfx_valid ? process->engine_usage[gpuinfo_engine_render] : 0) +
+                            (compute_valid ? process->engine_usage[gpuinfo_engine_compute] : 0));
+  if (GPUINFO_PROCESS_ENGINE_VALID(process, gpuinfo_engine_encode))
+    SET_GPUINFO_PROCESS(process, encode_usage, process->engine_usage[gpuinfo_engine_encode]);
+  if (GPUINFO_PROCESS_ENGINE_VALID(process, gpuinfo_engine_decode))
+    SET_GPUINFO_PROCESS(process, decode_usage, process->engine_usage[gpuinfo_engine_decode]);
+}
+
 unsigned nvtop_pcie_gen_from_link_speed(unsigned linkSpeed) {
   unsigned pcieGen = 0;
   switch (linkSpeed) {
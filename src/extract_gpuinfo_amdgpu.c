@@ -28,6 +28,8 @@
 #include "nvtop/extract_processinfo_fdinfo.h"
 #include "nvtop/time.h"
 
+#include "amdgpu_metrics.h"
+
 #include <assert.h>
 #include <dirent.h>
 #include <dlfcn.h>
@@ -46,7 +48,6 @@
 #include <sys/syscall.h>
 #include <sys/types.h>
 #include <unistd.h>
-#include <uthash.h>
 #include <xf86drm.h>
 
 // extern
@@ -78,39 +79,6 @@ static int last_libdrm_return_status = 0;
 static char didnt_call_gpuinfo_init[] = "uninitialized";
 static const char *local_error_string = didnt_call_gpuinfo_init;
 
-#define HASH_FIND_CLIENT(head, key_ptr, out_ptr) HASH_FIND(hh, head, key_ptr, sizeof(struct unique_cache_id), out_ptr)
-
-#define HASH_ADD_CLIENT(head, in_ptr) HASH_ADD(hh, head, client_id, sizeof(struct unique_cache_id), in_ptr)
-
-#define SET_AMDGPU_CACHE(cachePtr, field, value) SET_VALUE(cachePtr, field, value, amdgpu_cache_)
-#define RESET_AMDGPU_CACHE(cachePtr, field) INVALIDATE_VALUE(cachePtr, field, amdgpu_cache_)
-#define AMDGPU_CACHE_FIELD_VALID(cachePtr, field) VALUE_IS_VALID(cachePtr, field, amdgpu_cache_)
-
-enum amdgpu_process_info_cache_valid {
-  amdgpu_cache_gfx_engine_used_valid = 0,
-  amdgpu_cache_compute_engine_used_valid,
-  amdgpu_cache_enc_engine_used_valid,
-  amdgpu_cache_dec_engine_used_valid,
-  amdgpu_cache_process_info_cache_valid_count
-};
-
-struct __attribute__((__packed__)) unique_cache_id {
-  unsigned client_id;
-  pid_t pid;
-  char *pdev;
-};
-
-struct amdgpu_process_info_cache {
-  struct unique_cache_id client_id;
-  uint64_t gfx_engine_used;
-  uint64_t compute_engine_used;
-  uint64_t enc_engine_used;
-  uint64_t dec_engine_used;
-  nvtop_time last_measurement_tstamp;
-  unsigned char valid[(amdgpu_cache_process_info_cache_valid_count + CHAR_BIT - 1) / CHAR_BIT];
-  UT_hash_handle hh;
-};
-
 struct gpu_info_amdgpu {
   struct gpu_info base;
 
@@ -119,14 +87,15 @@ struct gpu_info_amdgpu {
   amdgpu_device_handle amdgpu_device;
 
   // We poll the fan frequently enough and want to avoid the open/close overhead of the sysfs file
-  FILE *fanSpeedFILE; // FILE* for this device current fan speed
-  FILE *PCIeBW;       // FILE* for this device PCIe bandwidth over one second
-  FILE *powerCap;     // FILE* for this device power cap
+  nvtop_sysfs_attr *fanSpeed;    // This device current fan speed
+  nvtop_sysfs_attr *PCIeBW;      // This device PCIe bandwidth over one second
+  nvtop_sysfs_attr *powerCap;    // This device power cap
+  nvtop_sysfs_attr *powerSample; // This device power sensor, only read by the power sampler thread
+  nvtop_sysfs_attr *gpuMetrics;  // This device metrics table of the firmware
 
-  nvtop_device *amdgpuDevice; // The AMDGPU driver device
-  nvtop_device *hwmonDevice;  // The AMDGPU driver hwmon device
-
-  struct amdgpu_process_info_cache *last_update_process_cache, *current_update_process_cache; // Cached processes info
+  nvtop_device *amdgpuDevice;           // The AMDGPU driver device
+  nvtop_device *hwmonDevice;            // The AMDGPU driver hwmon device
+  nvtop_pcie_link_ports *pcieLinkPorts; // The upstream PCIe ports of the device
 
   // Used to compute the actual fan speed
   unsigned maxFanValue;
@@ -142,6 +111,7 @@ static bool gpuinfo_amdgpu_get_device_handles(struct list_head *devices, unsigne
 static void gpuinfo_amdgpu_populate_static_info(struct gpu_info *_gpu_info);
 static void gpuinfo_amdgpu_refresh_dynamic_info(struct gpu_info *_gpu_info);
 static void gpuinfo_amdgpu_get_running_processes(struct gpu_info *_gpu_info);
+static bool gpuinfo_amdgpu_sample_power(struct gpu_info *_gpu_info, struct gpuinfo_power_reading *reading);
 
 struct gpu_vendor gpu_vendor_amdgpu = {
     .init = gpuinfo_amdgpu_init,
@@ -151,6 +121,7 @@ struct gpu_vendor gpu_vendor_amdgpu = {
     .populate_static_info = gpuinfo_amdgpu_populate_static_info,
     .refresh_dynamic_info = gpuinfo_amdgpu_refresh_dynamic_info,
     .refresh_running_processes = gpuinfo_amdgpu_get_running_processes,
+    .sample_power = gpuinfo_amdgpu_sample_power,
     .name = "AMD",
 };
 
@@ -235,22 +206,16 @@ init_error_clean_exit:
 static void gpuinfo_amdgpu_shutdown(void) {
   for (unsigned i = 0; i < amdgpu_count; ++i) {
     struct gpu_info_amdgpu *gpu_info = &gpu_infos[i];
-    if (gpu_info->fanSpeedFILE)
-      fclose(gpu_info->fanSpeedFILE);
-    if (gpu_info->PCIeBW)
-      fclose(gpu_info->PCIeBW);
-    if (gpu_info->powerCap)
-      fclose(gpu_info->powerCap);
+    nvtop_sysfs_attr_close(gpu_info->fanSpeed);
+    nvtop_sysfs_attr_close(gpu_info->PCIeBW);
+    nvtop_sysfs_attr_close(gpu_info->powerCap);
+    nvtop_sysfs_attr_close(gpu_info->powerSample);
+    nvtop_sysfs_attr_close(gpu_info->gpuMetrics);
+    nvtop_pcie_link_ports_free(gpu_info->pcieLinkPorts);
     nvtop_device_unref(gpu_info->amdgpuDevice);
     nvtop_device_unref(gpu_info->hwmonDevice);
     _drmFreeVersion(gpu_info->drmVersion);
     _amdgpu_device_deinitialize(gpu_info->amdgpu_device);
-    // Clean the process cache
-    struct amdgpu_process_info_cache *cache_entry, *cache_tmp;
-    HASH_ITER(hh, gpu_info->last_update_process_cache, cache_entry, cache_tmp) {
-      HASH_DEL(gpu_info->last_update_process_cache, cache_entry);
-      free(cache_entry);
-    }
   }
   free(gpu_infos);
   gpu_infos = NULL;
@@ -325,13 +290,8 @@ static void initDeviceSysfsPaths(struct gpu_info_amdgpu *gpu_info) {
 
   gpu_info->hwmonDevice = nvtop_device_get_hwmon(gpu_info->amdgpuDevice);
   if (gpu_info->hwmonDevice) {
-    // Open the device hwmon folder (Fan speed are available there)
-    const char *hwmonPath;
-    nvtop_device_get_syspath(gpu_info->hwmonDevice, &hwmonPath);
-    int hwmonFD = open(hwmonPath, O_RDONLY);
-
     // Look for which fan to use (PWM or RPM)
-    gpu_info->fanSpeedFILE = NULL;
+    gpu_info->fanSpeed = NULL;
     unsigned pwmIsEnabled;
     int NreadPatterns = readAttributeFromDevice(gpu_info->hwmonDevice, "pwm1_enable", "%u", &pwmIsEnabled);
     bool usePWMSensor = NreadPatterns == 1 && pwmIsEnabled > 0;
@@ -352,32 +312,21 @@ static void initDeviceSysfsPaths(struct gpu_info_amdgpu *gpu_info) {
       if (NreadPatterns == 1) {
         gpu_info->maxFanValue = maxSpeedVal;
         // Open the fan file for dynamic info gathering
-        int fanSpeedFD = openat(hwmonFD, fanSensorFile, O_RDONLY);
-        if (fanSpeedFD >= 0) {
-          gpu_info->fanSpeedFILE = fdopen(fanSpeedFD, "r");
-          if (!gpu_info->fanSpeedFILE)
-            close(fanSpeedFD);
-        }
+        gpu_info->fanSpeed = nvtop_sysfs_attr_open_from_device(gpu_info->hwmonDevice, fanSensorFile);
       }
     }
     // Open the power cap file for dynamic info gathering
-    gpu_info->powerCap = NULL;
-    int powerCapFD = openat(hwmonFD, "power1_cap", O_RDONLY);
-    if (powerCapFD) {
-      gpu_info->powerCap = fdopen(powerCapFD, "r");
-    }
-    close(hwmonFD);
+    gpu_info->powerCap = nvtop_sysfs_attr_open_from_device(gpu_info->hwmonDevice, "power1_cap");
+    // The instantaneous power sensor of the recent devices, the average one otherwise
+    gpu_info->powerSample = nvtop_sysfs_attr_open_from_device(gpu_info->hwmonDevice, "power1_input");
+    if (!gpu_info->powerSample)
+      gpu_info->powerSample = nvtop_sysfs_attr_open_from_device(gpu_info->hwmonDevice, "power1_average");
   }
 
-  int sysfsFD = open(devicePath, O_RDONLY);
   // Open the PCIe bandwidth file for dynamic info gathering
-  gpu_info->PCIeBW = NULL;
-  int pcieBWFD = openat(sysfsFD, "pcie_bw", O_RDONLY);
-  if (pcieBWFD) {
-    gpu_info->PCIeBW = fdopen(pcieBWFD, "r");
-  }
-
-  close(sysfsFD);
+  gpu_info->PCIeBW = nvtop_sysfs_attr_open_from_device(gpu_info->amdgpuDevice, "pcie_bw");
+  // Open the metrics table for the throttle status
+  gpu_info->gpuMetrics = nvtop_sysfs_attr_open_from_device(gpu_info->amdgpuDevice, "gpu_metrics");
 }
 
 #define VENDOR_AMD 0x1002
@@ -480,14 +429,13 @@ static bool gpuinfo_amdgpu_get_device_handles(struct list_head *devices, unsigne
   return true;
 }
 
-static int rewindAndReadPattern(FILE *file, const char *format, ...) {
-  if (!file)
+static int readPatternFromAttr(nvtop_sysfs_attr *attr, const char *format, ...) {
+  const char *val = nvtop_sysfs_attr_read(attr);
+  if (!val)
     return 0;
   va_list args;
   va_start(args, format);
-  rewind(file);
-  fflush(file);
-  int matches = vfscanf(file, format, args);
+  int matches = vsscanf(val, format, args);
   va_end(args);
   return matches;
 }
@@ -636,6 +584,8 @@ static void gpuinfo_amdgpu_populate_static_info(struct gpu_info *_gpu_info) {
     unsigned pcieGen = nvtop_pcie_gen_from_link_speed(max_link_characteristics.speed);
     SET_GPUINFO_STATIC(static_info, max_pcie_gen, pcieGen);
   }
+  nvtop_pcie_link_ports_free(gpu_info->pcieLinkPorts);
+  gpu_info->pcieLinkPorts = nvtop_device_pcie_link_ports(gpu_info->amdgpuDevice);
 
   // Mark integrated graphics
   if (info_query_success && (info.ids_flags & AMDGPU_IDS_FLAGS_FUSION)) {
@@ -651,6 +601,12 @@ static void gpuinfo_amdgpu_populate_static_info(struct gpu_info *_gpu_info) {
   }
 }
 
+static bool gpuinfo_amdgpu_read_throttle_reasons(nvtop_sysfs_attr *gpuMetrics, unsigned *reasons) {
+  unsigned char metrics[GPU_METRICS_THROTTLE_READ_SIZE];
+  int size = nvtop_sysfs_attr_read_binary(gpuMetrics, metrics, sizeof(metrics));
+  return size > 0 && amdgpu_metrics_throttle_reasons(metrics, size, reasons);
+}
+
 static void gpuinfo_amdgpu_refresh_dynamic_info(struct gpu_info *_gpu_info) {
   struct gpu_info_amdgpu *gpu_info = container_of(_gpu_info, struct gpu_info_amdgpu, base);
   struct gpuinfo_dynamic_info *dynamic_info = &gpu_info->base.dynamic_info;
@@ -658,111 +614,129 @@ static void gpuinfo_amdgpu_refresh_dynamic_info(struct gpu_info *_gpu_info) {
   struct amdgpu_gpu_info info;
   uint32_t out32;
 
-  RESET_ALL(dynamic_info->valid);
-
-  if (libdrm_amdgpu_handle && _amdgpu_query_gpu_info)
-    info_query_success = !_amdgpu_query_gpu_info(gpu_info->amdgpu_device, &info);
+  // The fields that are not due keep their value from a previous update
+  if (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, gpu_clock_speed_max) ||
+      GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, mem_clock_speed_max)) {
+    if (libdrm_amdgpu_handle && _amdgpu_query_gpu_info)
+      info_query_success = !_amdgpu_query_gpu_info(gpu_info->amdgpu_device, &info);
+  }
 
   // GPU current speed
-  if (libdrm_amdgpu_handle && _amdgpu_query_sensor_info)
-    last_libdrm_return_status =
-        _amdgpu_query_sensor_info(gpu_info->amdgpu_device, AMDGPU_INFO_SENSOR_GFX_SCLK, sizeof(out32), &out32);
-  else
-    last_libdrm_return_status = 1;
-  if (!last_libdrm_return_status) {
-    SET_GPUINFO_DYNAMIC(dynamic_info, gpu_clock_speed, out32);
+  if (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, gpu_clock_speed)) {
+    if (libdrm_amdgpu_handle && _amdgpu_query_sensor_info)
+      last_libdrm_return_status =
+          _amdgpu_query_sensor_info(gpu_info->amdgpu_device, AMDGPU_INFO_SENSOR_GFX_SCLK, sizeof(out32), &out32);
+    else
+      last_libdrm_return_status = 1;
+    if (!last_libdrm_return_status) {
+      SET_GPUINFO_DYNAMIC(dynamic_info, gpu_clock_speed, out32);
+    }
   }
 
   // GPU max speed
-  if (info_query_success) {
+  if (info_query_success && GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, gpu_clock_speed_max)) {
     SET_GPUINFO_DYNAMIC(dynamic_info, gpu_clock_speed_max, info.max_engine_clk / 1000);
   }
 
   // Memory current speed
-  if (libdrm_amdgpu_handle && _amdgpu_query_sensor_info)
-    last_libdrm_return_status =
-        _amdgpu_query_sensor_info(gpu_info->amdgpu_device, AMDGPU_INFO_SENSOR_GFX_MCLK, sizeof(out32), &out32);
-  else
-    last_libdrm_return_status = 1;
-  if (!last_libdrm_return_status) {
-    SET_GPUINFO_DYNAMIC(dynamic_info, mem_clock_speed, out32);
+  if (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, mem_clock_speed)) {
+    if (libdrm_amdgpu_handle && _amdgpu_query_sensor_info)
+      last_libdrm_return_status =
+          _amdgpu_query_sensor_info(gpu_info->amdgpu_device, AMDGPU_INFO_SENSOR_GFX_MCLK, sizeof(out32), &out32);
+    else
+      last_libdrm_return_status = 1;
+    if (!last_libdrm_return_status) {
+      SET_GPUINFO_DYNAMIC(dynamic_info, mem_clock_speed, out32);
+    }
   }
 
   // Memory max speed
-  if (info_query_success) {
+  if (info_query_success && GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, mem_clock_speed_max)) {
     SET_GPUINFO_DYNAMIC(dynamic_info, mem_clock_speed_max, info.max_memory_clk / 1000);
   }
 
   // Load
-  if (libdrm_amdgpu_handle && _amdgpu_query_sensor_info)
-    last_libdrm_return_status =
-        _amdgpu_query_sensor_info(gpu_info->amdgpu_device, AMDGPU_INFO_SENSOR_GPU_LOAD, sizeof(out32), &out32);
-  else
-    last_libdrm_return_status = 1;
-  if (!last_libdrm_return_status) {
-    SET_GPUINFO_DYNAMIC(dynamic_info, gpu_util_rate, out32);
-  }
-
-  // Memory usage
-  struct drm_amdgpu_memory_info memory_info;
-  if (libdrm_amdgpu_handle && _amdgpu_query_info)
-    last_libdrm_return_status =
-        _amdgpu_query_info(gpu_info->amdgpu_device, AMDGPU_INFO_MEMORY, sizeof(memory_info), &memory_info);
-  else
-    last_libdrm_return_status = 1;
-  if (!last_libdrm_return_status) {
-    // TODO: Determine if we want to include GTT (GPU accessible system memory)
-    SET_GPUINFO_DYNAMIC(dynamic_info, total_memory, memory_info.vram.total_heap_size);
-    SET_GPUINFO_DYNAMIC(dynamic_info, used_memory, memory_info.vram.heap_usage);
-    SET_GPUINFO_DYNAMIC(dynamic_info, free_memory, memory_info.vram.total_heap_size - dynamic_info->used_memory);
-    SET_GPUINFO_DYNAMIC(dynamic_info, mem_util_rate,
-                        (dynamic_info->total_memory - dynamic_info->free_memory) * 100 / dynamic_info->total_memory);
+  if (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, gpu_util_rate)) {
+    if (libdrm_amdgpu_handle && _amdgpu_query_sensor_info)
+      last_libdrm_return_status =
+          _amdgpu_query_sensor_info(gpu_info->amdgpu_device, AMDGPU_INFO_SENSOR_GPU_LOAD, sizeof(out32), &out32);
+    else
+      last_libdrm_return_status = 1;
+    if (!last_libdrm_return_status) {
+      SET_GPUINFO_DYNAMIC(dynamic_info, gpu_util_rate, out32);
+    }
+  }
+
+  // Memory usage, all the memory fields come from the same query
+  if (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, total_memory) || GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, used_memory) ||
+      GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, free_memory) || GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, mem_util_rate)) {
+    struct drm_amdgpu_memory_info memory_info;
+    if (libdrm_amdgpu_handle && _amdgpu_query_info)
+      last_libdrm_return_status =
+          _amdgpu_query_info(gpu_info->amdgpu_device, AMDGPU_INFO_MEMORY, sizeof(memory_info), &memory_info);
+    else
+      last_libdrm_return_status = 1;
+    if (!last_libdrm_return_status) {
+      // TODO: Determine if we want to include GTT (GPU accessible system memory)
+      SET_GPUINFO_DYNAMIC(dynamic_info, total_memory, memory_info.vram.total_heap_size);
+      SET_GPUINFO_DYNAMIC(dynamic_info, used_memory, memory_info.vram.heap_usage);
+      SET_GPUINFO_DYNAMIC(dynamic_info, free_memory, memory_info.vram.total_heap_size - dynamic_info->used_memory);
+      SET_GPUINFO_DYNAMIC(dynamic_info, mem_util_rate,
+                          (dynamic_info->total_memory - dynamic_info->free_memory) * 100 / dynamic_info->total_memory);
+    }
   }
 
   // GPU temperature
-  if (libdrm_amdgpu_handle && _amdgpu_query_sensor_info)
-    last_libdrm_return_status =
-        _amdgpu_query_sensor_info(gpu_info->amdgpu_device, AMDGPU_INFO_SENSOR_GPU_TEMP, sizeof(out32), &out32);
-  else
-    last_libdrm_return_status = 1;
-  if (!last_libdrm_return_status) {
-    SET_GPUINFO_DYNAMIC(dynamic_info, gpu_temp, out32 / 1000);
+  if (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, gpu_temp)) {
+    if (libdrm_amdgpu_handle && _amdgpu_query_sensor_info)
+      last_libdrm_return_status =
+          _amdgpu_query_sensor_info(gpu_info->amdgpu_device, AMDGPU_INFO_SENSOR_GPU_TEMP, sizeof(out32), &out32);
+    else
+      last_libdrm_return_status = 1;
+    if (!last_libdrm_return_status) {
+      SET_GPUINFO_DYNAMIC(dynamic_info, gpu_temp, out32 / 1000);
+    }
   }
 
   // Fan speed
-  unsigned currentFanSpeed;
-  int patternsMatched = rewindAndReadPattern(gpu_info->fanSpeedFILE, "%u", &currentFanSpeed);
-  if (patternsMatched == 1) {
+  uint64_t currentFanSpeed;
+  if (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, fan_speed) &&
+      nvtop_sysfs_attr_read_uint64(gpu_info->fanSpeed, &currentFanSpeed) >= 0) {
     SET_GPUINFO_DYNAMIC(dynamic_info, fan_speed, currentFanSpeed * 100 / gpu_info->maxFanValue);
   }
 
   // Device power usage
-  if (libdrm_amdgpu_handle && _amdgpu_query_sensor_info)
-    last_libdrm_return_status =
-        _amdgpu_query_sensor_info(gpu_info->amdgpu_device, AMDGPU_INFO_SENSOR_GPU_AVG_POWER, sizeof(out32), &out32);
-  else
-    last_libdrm_return_status = 1;
-  if (!last_libdrm_return_status) {
-    SET_GPUINFO_DYNAMIC(dynamic_info, power_draw, out32 * 1000);
+  if (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, power_draw)) {
+    if (libdrm_amdgpu_handle && _amdgpu_query_sensor_info)
+      last_libdrm_return_status =
+          _amdgpu_query_sensor_info(gpu_info->amdgpu_device, AMDGPU_INFO_SENSOR_GPU_AVG_POWER, sizeof(out32), &out32);
+    else
+      last_libdrm_return_status = 1;
+    if (!last_libdrm_return_status) {
+      SET_GPUINFO_DYNAMIC(dynamic_info, power_draw, out32 * 1000);
+    }
   }
 
-  nvtop_pcie_link curr_link_characteristics;
-  int ret = nvtop_device_current_pcie_link(gpu_info->amdgpuDevice, &curr_link_characteristics);
-  if (ret >= 0) {
-    SET_GPUINFO_DYNAMIC(dynamic_info, pcie_link_width, curr_link_characteristics.width);
-    unsigned pcieGen = nvtop_pcie_gen_from_link_speed(curr_link_characteristics.speed);
-    SET_GPUINFO_DYNAMIC(dynamic_info, pcie_link_gen, pcieGen);
+  if (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, pcie_link_gen) || GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, pcie_link_width)) {
+    nvtop_pcie_link curr_link_characteristics;
+    int ret = nvtop_pcie_link_ports_current_link(gpu_info->pcieLinkPorts, &curr_link_characteristics);
+    if (ret >= 0) {
+      SET_GPUINFO_DYNAMIC(dynamic_info, pcie_link_width, curr_link_characteristics.width);
+      unsigned pcieGen = nvtop_pcie_gen_from_link_speed(curr_link_characteristics.speed);
+      SET_GPUINFO_DYNAMIC(dynamic_info, pcie_link_gen, pcieGen);
+    }
   }
 
   // PCIe bandwidth
-  if (gpu_info->PCIeBW) {
+  if (gpu_info->PCIeBW &&
+      (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, pcie_rx) || GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, pcie_tx))) {
     // According to https://github.com/torvalds/linux/blob/master/drivers/gpu/drm/amd/pm/amdgpu_pm.c, under the pcie_bw
     // section, we should be able to read the number of packets received and sent by the GPU and get the maximum payload
     // size during the last second. This is untested but should work when the file is populated by the driver.
     uint64_t received, transmitted;
     int maxPayloadSize;
     int NreadPatterns =
-        rewindAndReadPattern(gpu_info->PCIeBW, "%" SCNu64 " %" SCNu64 " %i", &received, &transmitted, &maxPayloadSize);
+        readPatternFromAttr(gpu_info->PCIeBW, "%" SCNu64 " %" SCNu64 " %i", &received, &transmitted, &maxPayloadSize);
     if (NreadPatterns == 3) {
       received *= maxPayloadSize;
       transmitted *= maxPayloadSize;
@@ -774,14 +748,36 @@ static void gpuinfo_amdgpu_refresh_dynamic_info(struct gpu_info *_gpu_info) {
     }
   }
 
-  if (gpu_info->powerCap) {
+  if (gpu_info->powerCap && GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, power_draw_max)) {
     // The power cap in microwatts
-    unsigned powerCap;
-    int NreadPatterns = rewindAndReadPattern(gpu_info->powerCap, "%u", &powerCap);
-    if (NreadPatterns == 1) {
+    uint64_t powerCap;
+    if (nvtop_sysfs_attr_read_uint64(gpu_info->powerCap, &powerCap) >= 0) {
       SET_GPUINFO_DYNAMIC(dynamic_info, power_draw_max, powerCap / 1000);
     }
   }
+
+  unsigned throttle_reasons;
+  if (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, throttle_reasons) &&
+      gpuinfo_amdgpu_read_throttle_reasons(gpu_info->gpuMetrics, &throttle_reasons))
+    SET_GPUINFO_DYNAMIC(dynamic_info, throttle_reasons, throttle_reasons);
+}
+
+static bool gpuinfo_amdgpu_sample_power(struct gpu_info *_gpu_info, struct gpuinfo_power_reading *reading) {
+  struct gpu_info_amdgpu *gpu_info = container_of(_gpu_info, struct gpu_info_amdgpu, base);
+  // The hwmon sensor in microwatts, the sensor query of the driver in watts otherwise
+  uint64_t power;
+  if (gpu_info->powerSample && nvtop_sysfs_attr_read_uint64(gpu_info->powerSample, &power) >= 0) {
+    reading->is_energy = false;
+    reading->value = power / 1000;
+    return true;
+  }
+  uint32_t out32;
+  if (!libdrm_amdgpu_handle || !_amdgpu_query_sensor_info ||
+      _amdgpu_query_sensor_info(gpu_info->amdgpu_device, AMDGPU_INFO_SENSOR_GPU_AVG_POWER, sizeof(out32), &out32))
+    return false;
+  reading->is_energy = false;
+  reading->value = (uint64_t)out32 * 1000;
+  return true;
 }
 
 static const char drm_amdgpu_pdev_old[] = "pdev";
@@ -795,6 +791,7 @@ static const char drm_amdgpu_dec_old[] = "dec";
 static const char drm_amdgpu_dec[] = "drm-engine-dec";
 static const char drm_amdgpu_enc_old[] = "enc";
 static const char drm_amdgpu_enc[] = "drm-engine-enc";
+static const char drm_amdgpu_dma[] = "drm-engine-dma";
 
 static bool parse_drm_fdinfo_amd(struct gpu_info *info, FILE *fdinfo_file, struct gpu_process *process_info) {
   struct gpu_info_amdgpu *gpu_info = container_of(info, struct gpu_info_amdgpu, base);
@@ -805,8 +802,7 @@ static bool parse_drm_fdinfo_amd(struct gpu_info *info, FILE *fdinfo_file, struc
 
   bool client_id_set = false;
   unsigned cid;
-  nvtop_time current_time;
-  nvtop_get_current_time(&current_time);
+  struct gpuinfo_client_counters counters = {0};
 
   while ((count = getline(&line, &line_buf_size, fdinfo_file)) != -1) {
     char *key, *val;
@@ -852,6 +848,7 @@ static bool parse_drm_fdinfo_amd(struct gpu_info *info, FILE *fdinfo_file, struc
       bool is_dec_new = !strncmp(key, drm_amdgpu_dec, sizeof(drm_amdgpu_dec) - 1);
       bool is_enc_new = !strncmp(key, drm_amdgpu_enc, sizeof(drm_amdgpu_enc) - 1);
       bool is_compute_new = !strncmp(key, drm_amdgpu_compute, sizeof(drm_amdgpu_compute) - 1);
+      bool is_dma_new = !strncmp(key, drm_amdgpu_dma, sizeof(drm_amdgpu_dma) - 1);
 
       if (is_gfx_old || is_compute_old || is_dec_old || is_enc_old) {
         // The old interface exposes a usage percentage with an unknown update interval
@@ -881,17 +878,31 @@ static bool parse_drm_fdinfo_amd(struct gpu_info *info, FILE *fdinfo_file, struc
         if (endptr == val || strcmp(endptr, "%"))
           continue;
 
+        enum gpuinfo_engine_class engine;
         if (is_gfx_old) {
           process_info->type |= gpu_process_graphical;
           SET_GPUINFO_PROCESS(process_info, gpu_usage, process_info->gpu_usage + usage_percent_int);
+          engine = gpuinfo_engine_render;
         } else if (is_compute_old) {
           process_info->type |= gpu_process_compute;
           SET_GPUINFO_PROCESS(process_info, gpu_usage, process_info->gpu_usage + usage_percent_int);
+          engine = gpuinfo_engine_compute;
         } else if (is_dec_old) {
           SET_GPUINFO_PROCESS(process_info, decode_usage, process_info->decode_usage + usage_percent_int);
-        } else if (is_enc_old) {
+          engine = gpuinfo_engine_decode;
+        } else {
           SET_GPUINFO_PROCESS(process_info, encode_usage, process_info->encode_usage + usage_percent_int);
+          engine = gpuinfo_engine_encode;
         }
+        unsigned engine_usage =
+            GPUINFO_PROCESS_ENGINE_VALID(process_info, engine) ? process_info->engine_usage[engine] : 0;
+        SET_GPUINFO_PROCESS_ENGINE(process_info, engine, engine_usage + usage_percent_int);
+      } else if (is_dma_new) {
+        char *endptr;
+        uint64_t time_spent = strtoull(val, &endptr, 10);
+        if (endptr == val || strcmp(endptr, " ns"))
+          continue;
+        SET_GPUINFO_CLIENT_COUNTER(&counters, gpuinfo_client_copy_engine, time_spent);
       } else if (is_gfx_new || is_compute_new || is_dec_new || is_enc_new) {
         char *endptr;
         uint64_t time_spent = strtoull(val, &endptr, 10);
@@ -919,104 +930,22 @@ static bool parse_drm_fdinfo_amd(struct gpu_info *info, FILE *fdinfo_file, struc
   // which uses an internal update interval. Now, we can compute an accurate
   // busy percentage since the last measurement.
   if (client_id_set) {
-    struct amdgpu_process_info_cache *cache_entry;
-    struct unique_cache_id ucid = {.client_id = cid, .pid = process_info->pid, .pdev = gpu_info->base.pdev};
-    HASH_FIND_CLIENT(gpu_info->last_update_process_cache, &ucid, cache_entry);
-    if (cache_entry) {
-      uint64_t time_elapsed = nvtop_difftime_u64(cache_entry->last_measurement_tstamp, current_time);
-      HASH_DEL(gpu_info->last_update_process_cache, cache_entry);
-      if (GPUINFO_PROCESS_FIELD_VALID(process_info, gfx_engine_used) &&
-          AMDGPU_CACHE_FIELD_VALID(cache_entry, gfx_engine_used) &&
-          // In some rare occasions, the gfx engine usage reported by the driver is lowering (might be a driver bug)
-          process_info->gfx_engine_used >= cache_entry->gfx_engine_used &&
-          process_info->gfx_engine_used - cache_entry->gfx_engine_used <= time_elapsed) {
-        SET_GPUINFO_PROCESS(process_info, gpu_usage,
-                            busy_usage_from_time_usage_round(process_info->gfx_engine_used,
-                                                             cache_entry->gfx_engine_used, time_elapsed));
-      }
-      if (GPUINFO_PROCESS_FIELD_VALID(process_info, compute_engine_used) &&
-          AMDGPU_CACHE_FIELD_VALID(cache_entry, compute_engine_used) &&
-          process_info->compute_engine_used >= cache_entry->compute_engine_used &&
-          process_info->compute_engine_used - cache_entry->compute_engine_used <= time_elapsed) {
-        unsigned gfx_usage = GPUINFO_PROCESS_FIELD_VALID(process_info, gpu_usage) ? process_info->gpu_usage : 0;
-        SET_GPUINFO_PROCESS(process_info, gpu_usage,
-                            gfx_usage + busy_usage_from_time_usage_round(process_info->compute_engine_used,
-                                                                         cache_entry->compute_engine_used,
-                                                                         time_elapsed));
-      }
-      if (GPUINFO_PROCESS_FIELD_VALID(process_info, dec_engine_used) &&
-          AMDGPU_CACHE_FIELD_VALID(cache_entry, dec_engine_used) &&
-          process_info->dec_engine_used >= cache_entry->dec_engine_used &&
-          process_info->dec_engine_used - cache_entry->dec_engine_used <= time_elapsed) {
-        SET_GPUINFO_PROCESS(process_info, decode_usage,
-                            busy_usage_from_time_usage_round(process_info->dec_engine_used,
-                                                             cache_entry->dec_engine_used, time_elapsed));
-      }
-      if (GPUINFO_PROCESS_FIELD_VALID(process_info, enc_engine_used) &&
-          AMDGPU_CACHE_FIELD_VALID(cache_entry, enc_engine_used) &&
-          process_info->enc_engine_used >= cache_entry->enc_engine_used &&
-          process_info->enc_engine_used - cache_entry->enc_engine_used <= time_elapsed) {
-        SET_GPUINFO_PROCESS(process_info, encode_usage,
-                            busy_usage_from_time_usage_round(process_info->enc_engine_used,
-                                                             cache_entry->enc_engine_used, time_elapsed));
-      }
-    } else {
-      cache_entry = calloc(1, sizeof(*cache_entry));
-      if (!cache_entry)
-        goto parse_fdinfo_exit;
-      cache_entry->client_id.client_id = cid;
-      cache_entry->client_id.pid = process_info->pid;
-      cache_entry->client_id.pdev = gpu_info->base.pdev;
-    }
+    struct gpuinfo_client_delta delta;
+    gpuinfo_client_counters_from_process(process_info, &counters);
+    if (gpuinfo_client_counters_update(&gpu_info->base, process_info->pid, cid, &counters, &delta))
+      gpuinfo_process_usage_from_client_delta(process_info, &delta);
 
     // The UI only shows the decode usage when `encode_decode_shared` is true
     // but amdgpu should only use the encode usage field when it is shared.
     // Lets add both together for good measure.
     if (static_info->encode_decode_shared)
       SET_GPUINFO_PROCESS(process_info, decode_usage, process_info->decode_usage + process_info->encode_usage);
-
-#ifndef NDEBUG
-    // We should only process one fdinfo entry per client id per update
-    struct amdgpu_process_info_cache *cache_entry_check;
-    HASH_FIND_CLIENT(gpu_info->current_update_process_cache, &cache_entry->client_id, cache_entry_check);
-    assert(!cache_entry_check && "We should not be processing a client id twice per update");
-#endif
-
-    // Store this measurement data
-    RESET_ALL(cache_entry->valid);
-    if (GPUINFO_PROCESS_FIELD_VALID(process_info, gfx_engine_used))
-      SET_AMDGPU_CACHE(cache_entry, gfx_engine_used, process_info->gfx_engine_used);
-    if (GPUINFO_PROCESS_FIELD_VALID(process_info, compute_engine_used))
-      SET_AMDGPU_CACHE(cache_entry, compute_engine_used, process_info->compute_engine_used);
-    if (GPUINFO_PROCESS_FIELD_VALID(process_info, dec_engine_used))
-      SET_AMDGPU_CACHE(cache_entry, dec_engine_used, process_info->dec_engine_used);
-    if (GPUINFO_PROCESS_FIELD_VALID(process_info, enc_engine_used))
-      SET_AMDGPU_CACHE(cache_entry, enc_engine_used, process_info->enc_engine_used);
-
-    cache_entry->last_measurement_tstamp = current_time;
-    HASH_ADD_CLIENT(gpu_info->current_update_process_cache, cache_entry);
   }
 
-parse_fdinfo_exit:
   return true;
 }
 
-static void swap_process_cache_for_next_update(struct gpu_info_amdgpu *gpu_info) {
-  // Free old cache data and set the cache for the next update
-  if (gpu_info->last_update_process_cache) {
-    struct amdgpu_process_info_cache *cache_entry, *tmp;
-    HASH_ITER(hh, gpu_info->last_update_process_cache, cache_entry, tmp) {
-      HASH_DEL(gpu_info->last_update_process_cache, cache_entry);
-      free(cache_entry);
-    }
-  }
-  gpu_info->last_update_process_cache = gpu_info->current_update_process_cache;
-  gpu_info->current_update_process_cache = NULL;
-}
-
 static void gpuinfo_amdgpu_get_running_processes(struct gpu_info *_gpu_info) {
   // For AMDGPU, we register a fdinfo callback that will fill the gpu_process datastructure of the gpu_info structure
   // for us. This avoids going through /proc multiple times per update for multiple GPUs.
-  struct gpu_info_amdgpu *gpu_info = container_of(_gpu_info, struct gpu_info_amdgpu, base);
-  swap_process_cache_for_next_update(gpu_info);
 }
@@ -0,0 +1,99 @@
+/*
+ *
+ * Copyright (C) 2025 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "nvtop/extract_gpuinfo_common.h"
+
+#include "amdgpu_metrics.h"
+
+#include <stdint.h>
+#include <string.h>
+
+// Offsets in the gpu_metrics tables of the driver (kgd_pp_interface.h), whose layout depends on their revision. The
+// header holds the table size (16 bits), the format revision and the content revision.
+#define GPU_METRICS_HEADER_SIZE 4
+#define GPU_METRICS_V1_THROTTLE_STATUS 68 // Revisions 1.0 to 1.3 of the discrete devices, ASIC specific bits
+#define GPU_METRICS_V1_3_INDEP_THROTTLE_STATUS 112
+// Revision 2.0 of the APUs aligns system_clock_counter after the header, 2.1 and 2.2 moved it after the activities
+#define GPU_METRICS_V2_0_THROTTLE_STATUS 112 // ASIC specific bits
+#define GPU_METRICS_V2_1_THROTTLE_STATUS 108 // Revisions 2.1 and 2.2, ASIC specific bits
+#define GPU_METRICS_V2_2_INDEP_THROTTLE_STATUS 120
+// Groups of bits of the ASIC independent throttle status
+#define SMU_THROTTLER_POWER_MASK UINT64_C(0x00000000ffffffff)    // Package power tracking and current limits
+#define SMU_THROTTLER_THERMAL_MASK UINT64_C(0x00000fff00000000)  // Temperature limits
+#define SMU_THROTTLER_HARDWARE_MASK UINT64_C(0x0000f00000000000) // VRHOT and PROCHOT signals
+#define SMU_THROTTLER_OTHER_MASK UINT64_C(0x0300000000000000)    // Platform power management
+
+_Static_assert(GPU_METRICS_THROTTLE_READ_SIZE >= GPU_METRICS_V2_2_INDEP_THROTTLE_STATUS + sizeof(uint64_t),
+               "The throttle status of the last revision is not read");
+
+// The fields that the device does not support are filled with ones
+static bool read_indep_throttle_status(const unsigned char *metrics, size_t size, size_t offset, unsigned *reasons) {
+  uint64_t indep_status;
+  if (size < offset + sizeof(indep_status))
+    return false;
+  memcpy(&indep_status, &metrics[offset], sizeof(indep_status));
+  if (indep_status == UINT64_MAX)
+    return false;
+  *reasons = 0;
+  if (indep_status & SMU_THROTTLER_POWER_MASK)
+    *reasons |= GPUINFO_THROTTLE_REASON(gpuinfo_throttle_power);
+  if (indep_status & SMU_THROTTLER_THERMAL_MASK)
+    *reasons |= GPUINFO_THROTTLE_REASON(gpuinfo_throttle_thermal);
+  if (indep_status & SMU_THROTTLER_HARDWARE_MASK)
+    *reasons |= GPUINFO_THROTTLE_REASON(gpuinfo_throttle_hardware);
+  if (indep_status & SMU_THROTTLER_OTHER_MASK)
+    *reasons |= GPUINFO_THROTTLE_REASON(gpuinfo_throttle_other);
+  return true;
+}
+
+bool amdgpu_metrics_throttle_reasons(const unsigned char *metrics, size_t size, unsigned *reasons) {
+  if (size < GPU_METRICS_HEADER_SIZE)
+    return false;
+  unsigned format_revision = metrics[2];
+  unsigned content_revision = metrics[3];
+
+  // The ASIC independent status tells the reasons apart, the ASIC specific one only says "other"
+  size_t offset;
+  if (format_revision == 1 && content_revision <= 3) {
+    if (content_revision == 3 &&
+        read_indep_throttle_status(metrics, size, GPU_METRICS_V1_3_INDEP_THROTTLE_STATUS, reasons))
+      return true;
+    offset = GPU_METRICS_V1_THROTTLE_STATUS;
+  } else if (format_revision == 2 && content_revision == 0) {
+    offset = GPU_METRICS_V2_0_THROTTLE_STATUS;
+  } else if (format_revision == 2 && content_revision <= 2) {
+    if (content_revision == 2 &&
+        read_indep_throttle_status(metrics, size, GPU_METRICS_V2_2_INDEP_THROTTLE_STATUS, reasons))
+      return true;
+    offset = GPU_METRICS_V2_1_THROTTLE_STATUS;
+  } else {
+    return false;
+  }
+
+  uint32_t status;
+  if (size < offset + sizeof(status))
+    return false;
+  memcpy(&status, &metrics[offset], sizeof(status));
+  if (status == UINT32_MAX)
+    return false;
+  *reasons = status ? GPUINFO_THROTTLE_REASON(gpuinfo_throttle_other) : 0;
+  return true;
+}
@@ -29,9 +29,9 @@
 #include <assert.h>
 #include <fcntl.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
-#include <uthash.h>
 
 static bool gpuinfo_intel_init(void);
 static void gpuinfo_intel_shutdown(void);
@@ -40,6 +40,7 @@ static bool gpuinfo_intel_get_device_handles(struct list_head *devices, unsigned
 static void gpuinfo_intel_populate_static_info(struct gpu_info *_gpu_info);
 static void gpuinfo_intel_refresh_dynamic_info(struct gpu_info *_gpu_info);
 static void gpuinfo_intel_get_running_processes(struct gpu_info *_gpu_info);
+static bool gpuinfo_intel_sample_power(struct gpu_info *_gpu_info, struct gpuinfo_power_reading *reading);
 
 struct gpu_vendor gpu_vendor_intel = {
     .init = gpuinfo_intel_init,
@@ -49,6 +50,7 @@ struct gpu_vendor gpu_vendor_intel = {
     .populate_static_info = gpuinfo_intel_populate_static_info,
     .refresh_dynamic_info = gpuinfo_intel_refresh_dynamic_info,
     .refresh_running_processes = gpuinfo_intel_get_running_processes,
+    .sample_power = gpuinfo_intel_sample_power,
     .name = "Intel",
 };
 
@@ -57,6 +59,7 @@ static struct gpu_info_intel *gpu_infos;
 
 #define STRINGIFY(x) STRINGIFY_HELPER_(x)
 #define STRINGIFY_HELPER_(x) #x
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
 
 #define VENDOR_INTEL 0x8086
 #define VENDOR_INTEL_STR STRINGIFY(VENDOR_INTEL)
@@ -67,11 +70,28 @@ static struct gpu_info_intel *gpu_infos;
 __attribute__((constructor)) static void init_extract_gpuinfo_intel(void) { register_gpu_vendor(&gpu_vendor_intel); }
 
 bool gpuinfo_intel_init(void) { return true; }
+
+static void close_sysfs_attributes(struct gpu_info_intel *gpu_info) {
+  nvtop_pcie_link_ports_free(gpu_info->sysfs.pcie_link_ports);
+  nvtop_sysfs_attr_close(gpu_info->sysfs.cur_freq);
+  nvtop_sysfs_attr_close(gpu_info->sysfs.max_freq);
+  nvtop_sysfs_attr_close(gpu_info->sysfs.fan_rpm);
+  nvtop_sysfs_attr_close(gpu_info->sysfs.temp);
+  for (unsigned i = 0; i < ARRAY_SIZE(gpu_info->sysfs.power_max); ++i)
+    nvtop_sysfs_attr_close(gpu_info->sysfs.power_max[i]);
+  for (unsigned i = 0; i < ARRAY_SIZE(gpu_info->sysfs.energy); ++i)
+    nvtop_sysfs_attr_close(gpu_info->sysfs.energy[i]);
+  for (unsigned i = 0; i < ARRAY_SIZE(gpu_info->sysfs.sample_energy); ++i)
+    nvtop_sysfs_attr_close(gpu_info->sysfs.sample_energy[i]);
+  memset(&gpu_info->sysfs, 0, sizeof(gpu_info->sysfs));
+}
+
 void gpuinfo_intel_shutdown(void) {
   for (unsigned i = 0; i < intel_gpu_count; ++i) {
     struct gpu_info_intel *current = &gpu_infos[i];
     if (current->card_fd)
       close(current->card_fd);
+    close_sysfs_attributes(current);
     nvtop_device_unref(current->card_device);
     nvtop_device_unref(current->driver_device);
   }
@@ -214,55 +234,71 @@ void gpuinfo_intel_populate_static_info(struct gpu_info *_gpu_info) {
     unsigned pcieGen = nvtop_pcie_gen_from_link_speed(max_link_characteristics.speed);
     SET_GPUINFO_STATIC(static_info, max_pcie_gen, pcieGen);
   }
+
+  // Open the sysfs attributes polled by the dynamic info refresh once and for all
+  bool is_xe = gpu_info->driver == DRIVER_XE;
+  close_sysfs_attributes(gpu_info);
+  if (!static_info->integrated_graphics)
+    gpu_info->sysfs.pcie_link_ports =
+        nvtop_device_pcie_link_ports(gpu_info->bridge_device ? gpu_info->bridge_device : gpu_info->driver_device);
+  nvtop_device *clock_device = is_xe ? gpu_info->driver_device : gpu_info->card_device;
+  gpu_info->sysfs.cur_freq =
+      nvtop_sysfs_attr_open_from_device(clock_device, is_xe ? "tile0/gt0/freq0/cur_freq" : "gt_cur_freq_mhz");
+  gpu_info->sysfs.max_freq =
+      nvtop_sysfs_attr_open_from_device(clock_device, is_xe ? "tile0/gt0/freq0/max_freq" : "gt_max_freq_mhz");
+  if (gpu_info->hwmon_device) {
+    gpu_info->sysfs.fan_rpm = nvtop_sysfs_attr_open_from_device(gpu_info->hwmon_device, "fan1_input");
+    // temp1 is for i915, temp2 is for `pkg` on xe
+    gpu_info->sysfs.temp =
+        nvtop_sysfs_attr_open_from_device(gpu_info->hwmon_device, is_xe ? "temp2_input" : "temp1_input");
+    // power1 is for i915 and `card` on supported cards on xe, power2 is `pkg` on xe.
+    // Battlemage (xe) uses power*_crit. Both drivers have power*_rated_max, but it seems to be 0.
+    static const char *power_max_attrs[] = {"power1_max", "power1_crit", "power1_rated_max",
+                                            "power2_max", "power2_crit", "power2_rated_max"};
+    unsigned num_power_max = is_xe ? 6 : 3;
+    for (unsigned i = 0; i < num_power_max; ++i)
+      gpu_info->sysfs.power_max[i] = nvtop_sysfs_attr_open_from_device(gpu_info->hwmon_device, power_max_attrs[i]);
+    // energy1 is for i915 and `card` on supported cards on xe, energy2 is `pkg` on xe
+    gpu_info->sysfs.energy[0] = nvtop_sysfs_attr_open_from_device(gpu_info->hwmon_device, "energy1_input");
+    gpu_info->sysfs.sample_energy[0] = nvtop_sysfs_attr_open_from_device(gpu_info->hwmon_device, "energy1_input");
+    if (is_xe) {
+      gpu_info->sysfs.energy[1] = nvtop_sysfs_attr_open_from_device(gpu_info->hwmon_device, "energy2_input");
+      gpu_info->sysfs.sample_energy[1] = nvtop_sysfs_attr_open_from_device(gpu_info->hwmon_device, "energy2_input");
+    }
+  }
+}
+
+// Reads the first candidate attribute holding a non-zero value.
+// Returns false if none of the attributes could be read.
+static bool read_first_nonzero_attr(nvtop_sysfs_attr **candidates, unsigned num_candidates, uint64_t *value) {
+  bool found = false;
+  *value = 0;
+  for (unsigned i = 0; i < num_candidates && *value == 0; ++i) {
+    if (candidates[i] && nvtop_sysfs_attr_read_uint64(candidates[i], value) >= 0)
+      found = true;
+  }
+  return found;
 }
 
 void gpuinfo_intel_refresh_dynamic_info(struct gpu_info *_gpu_info) {
   struct gpu_info_intel *gpu_info = container_of(_gpu_info, struct gpu_info_intel, base);
   struct gpuinfo_static_info *static_info = &gpu_info->base.static_info;
   struct gpuinfo_dynamic_info *dynamic_info = &gpu_info->base.dynamic_info;
-  bool is_xe = gpu_info->driver == DRIVER_XE;
-
-  RESET_ALL(dynamic_info->valid);
-
-  // We are creating new devices because the device_get_sysattr_value caches its querries
-  const char *syspath;
-  nvtop_device *card_dev_noncached = NULL;
-  if (nvtop_device_get_syspath(gpu_info->card_device, &syspath) >= 0)
-    nvtop_device_new_from_syspath(&card_dev_noncached, syspath);
-  nvtop_device *driver_dev_noncached = NULL;
-  if (nvtop_device_get_syspath(gpu_info->driver_device, &syspath) >= 0)
-    nvtop_device_new_from_syspath(&driver_dev_noncached, syspath);
-  nvtop_device *hwmon_dev_noncached = NULL;
-  if (gpu_info->hwmon_device) {
-    if (nvtop_device_get_syspath(gpu_info->hwmon_device, &syspath) >= 0)
-      nvtop_device_new_from_syspath(&hwmon_dev_noncached, syspath);
-  }
-  nvtop_device *bridge_dev_noncached = NULL;
-  if (gpu_info->bridge_device) {
-    if (nvtop_device_get_syspath(gpu_info->bridge_device, &syspath) >= 0)
-      nvtop_device_new_from_syspath(&bridge_dev_noncached, syspath);
-  } else {
-    bridge_dev_noncached = driver_dev_noncached;
-  }
 
-  nvtop_device *clock_device = is_xe ? driver_dev_noncached : card_dev_noncached;
+  // The fields that are not due keep their value from a previous update
+  uint64_t val;
   // GPU clock
-  const char *gt_cur_freq;
-  const char *gt_cur_freq_sysattr = is_xe ? "tile0/gt0/freq0/cur_freq" : "gt_cur_freq_mhz";
-  if (nvtop_device_get_sysattr_value(clock_device, gt_cur_freq_sysattr, &gt_cur_freq) >= 0) {
-    unsigned val = strtoul(gt_cur_freq, NULL, 10);
+  if (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, gpu_clock_speed) &&
+      nvtop_sysfs_attr_read_uint64(gpu_info->sysfs.cur_freq, &val) >= 0)
     SET_GPUINFO_DYNAMIC(dynamic_info, gpu_clock_speed, val);
-  }
-  const char *gt_max_freq;
-  const char *gt_max_freq_sysattr = is_xe ? "tile0/gt0/freq0/max_freq" : "gt_max_freq_mhz";
-  if (nvtop_device_get_sysattr_value(clock_device, gt_max_freq_sysattr, &gt_max_freq) >= 0) {
-    unsigned val = strtoul(gt_max_freq, NULL, 10);
+  if (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, gpu_clock_speed_max) &&
+      nvtop_sysfs_attr_read_uint64(gpu_info->sysfs.max_freq, &val) >= 0)
     SET_GPUINFO_DYNAMIC(dynamic_info, gpu_clock_speed_max, val);
-  }
 
-  if (!static_info->integrated_graphics) {
+  if (!static_info->integrated_graphics &&
+      (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, pcie_link_gen) || GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, pcie_link_width))) {
     nvtop_pcie_link curr_link_characteristics;
-    int ret = nvtop_device_current_pcie_link(bridge_dev_noncached, &curr_link_characteristics);
+    int ret = nvtop_pcie_link_ports_current_link(gpu_info->sysfs.pcie_link_ports, &curr_link_characteristics);
     if (ret >= 0) {
       SET_GPUINFO_DYNAMIC(dynamic_info, pcie_link_width, curr_link_characteristics.width);
       unsigned pcieGen = nvtop_pcie_gen_from_link_speed(curr_link_characteristics.speed);
@@ -270,58 +306,27 @@ void gpuinfo_intel_refresh_dynamic_info(struct gpu_info *_gpu_info) {
     }
   }
 
-  if (hwmon_dev_noncached) {
-    const char *hwmon_fan;
-    if (nvtop_device_get_sysattr_value(hwmon_dev_noncached, "fan1_input", &hwmon_fan) >= 0) {
-      unsigned val = strtoul(hwmon_fan, NULL, 10);
+  if (gpu_info->hwmon_device) {
+    if (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, fan_rpm) &&
+        nvtop_sysfs_attr_read_uint64(gpu_info->sysfs.fan_rpm, &val) >= 0)
       SET_GPUINFO_DYNAMIC(dynamic_info, fan_rpm, val);
-    }
 
-    const char *hwmon_temp;
-    // temp1 is for i915, temp2 is for `pkg` on xe
-    if (nvtop_device_get_sysattr_value(hwmon_dev_noncached, is_xe ? "temp2_input" : "temp1_input", &hwmon_temp) >= 0) {
-      unsigned val = strtoul(hwmon_temp, NULL, 10);
+    if (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, gpu_temp) && nvtop_sysfs_attr_read_uint64(gpu_info->sysfs.temp, &val) >= 0)
       SET_GPUINFO_DYNAMIC(dynamic_info, gpu_temp, val / 1000);
-    }
-
-    const char *hwmon_power_max = NULL;
-    const char *hwmon_energy = NULL;
-    for (unsigned i = 0; i < (is_xe ? 2 : 1); i++) {
-      // Max Power
-      if (hwmon_power_max == NULL || hwmon_power_max[0] == '0') {
-        // power1 is for i915 and `card` on supported cards on xe, power2 is `pkg` on xe
-        nvtop_device_get_sysattr_value(hwmon_dev_noncached, i == 0 ? "power1_max" : "power2_max", &hwmon_power_max);
-      }
-      if (hwmon_power_max == NULL || hwmon_power_max[0] == '0') {
-        // Battlemage (xe) uses power*_crit
-        nvtop_device_get_sysattr_value(hwmon_dev_noncached, i == 0 ? "power1_crit" : "power2_crit", &hwmon_power_max);
-      }
-      if (hwmon_power_max == NULL || hwmon_power_max[0] == '0') {
-        // Both drivers have this, but it seems to be 0
-        nvtop_device_get_sysattr_value(hwmon_dev_noncached, i == 0 ? "power1_rated_max" : "power2_rated_max", &hwmon_power_max);
-      }
 
-      // Energy Usage
-      if (hwmon_energy == NULL || hwmon_energy[0] == '0') {
-        // energy1 is for i915 and `card` on supported cards on xe, energy2 is `pkg` on xe
-        nvtop_device_get_sysattr_value(hwmon_dev_noncached, i == 0 ? "energy1_input" : "energy2_input", &hwmon_energy);
-      }
-    }
-
-    // Check if we found the max power draw
-    if (hwmon_power_max != NULL) {
-      unsigned val = strtoul(hwmon_power_max, NULL, 10);
+    // Max Power
+    if (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, power_draw_max) &&
+        read_first_nonzero_attr(gpu_info->sysfs.power_max, ARRAY_SIZE(gpu_info->sysfs.power_max), &val))
       SET_GPUINFO_DYNAMIC(dynamic_info, power_draw_max, val / 1000);
-    }
 
     // Check if we found the energy usage and convert it into a wattage
-    if (hwmon_energy != NULL) {
+    if (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, power_draw) &&
+        read_first_nonzero_attr(gpu_info->sysfs.energy, ARRAY_SIZE(gpu_info->sysfs.energy), &val)) {
       nvtop_time ts;
       nvtop_get_current_time(&ts);
-      unsigned val = strtoul(hwmon_energy, NULL, 10);
-      // Skip the first update so we have a time delta
-      if (gpu_info->energy.time.tv_sec != 0) {
-        unsigned old = gpu_info->energy.energy_uj;
+      // Skip the first update so we have a time delta, and the updates where the counter wrapped around
+      if (gpu_info->energy.time.tv_sec != 0 && val >= gpu_info->energy.energy_uj) {
+        uint64_t old = gpu_info->energy.energy_uj;
         uint64_t time = nvtop_difftime_u64(gpu_info->energy.time, ts);
         unsigned power = ((val - old) * 1000000000LL) / time;
         SET_GPUINFO_DYNAMIC(dynamic_info, power_draw, power / 1000);
@@ -331,38 +336,31 @@ void gpuinfo_intel_refresh_dynamic_info(struct gpu_info *_gpu_info) {
     }
   }
 
-  switch (gpu_info->driver) {
-  case DRIVER_I915:
-    gpuinfo_intel_i915_refresh_dynamic_info(_gpu_info);
-    break;
-  case DRIVER_XE:
-    gpuinfo_intel_xe_refresh_dynamic_info(_gpu_info);
-    break;
+  // The memory fields all come from the same driver query
+  if (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, total_memory) || GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, used_memory) ||
+      GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, free_memory) || GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, mem_util_rate)) {
+    switch (gpu_info->driver) {
+    case DRIVER_I915:
+      gpuinfo_intel_i915_refresh_dynamic_info(_gpu_info);
+      break;
+    case DRIVER_XE:
+      gpuinfo_intel_xe_refresh_dynamic_info(_gpu_info);
+      break;
+    }
   }
-
-  // Let the temporary devices be garbage collected
-  nvtop_device_unref(card_dev_noncached);
-  nvtop_device_unref(driver_dev_noncached);
-  if (hwmon_dev_noncached)
-    nvtop_device_unref(hwmon_dev_noncached);
 }
 
-static void swap_process_cache_for_next_update(struct gpu_info_intel *gpu_info) {
-  // Free old cache data and set the cache for the next update
-  if (gpu_info->last_update_process_cache) {
-    struct intel_process_info_cache *cache_entry, *tmp;
-    HASH_ITER(hh, gpu_info->last_update_process_cache, cache_entry, tmp) {
-      HASH_DEL(gpu_info->last_update_process_cache, cache_entry);
-      free(cache_entry);
-    }
-  }
-  gpu_info->last_update_process_cache = gpu_info->current_update_process_cache;
-  gpu_info->current_update_process_cache = NULL;
+static bool gpuinfo_intel_sample_power(struct gpu_info *_gpu_info, struct gpuinfo_power_reading *reading) {
+  struct gpu_info_intel *gpu_info = container_of(_gpu_info, struct gpu_info_intel, base);
+  nvtop_sysfs_attr **candidates = gpu_info->sysfs.sample_energy;
+  if (!read_first_nonzero_attr(candidates, ARRAY_SIZE(gpu_info->sysfs.sample_energy), &reading->value))
+    return false;
+  reading->is_energy = true;
+  reading->counter_bits = 64;
+  return true;
 }
 
 void gpuinfo_intel_get_running_processes(struct gpu_info *_gpu_info) {
   // For Intel, we register a fdinfo callback that will fill the gpu_process datastructure of the gpu_info structure
   // for us. This avoids going through /proc multiple times per update for multiple GPUs.
-  struct gpu_info_intel *gpu_info = container_of(_gpu_info, struct gpu_info_intel, base);
-  swap_process_cache_for_next_update(gpu_info);
 }
@@ -32,6 +32,7 @@
 #include <libdrm/drm.h>
 #include <libdrm/i915_drm.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/ioctl.h>
 #include <unistd.h>
@@ -175,8 +176,7 @@ bool parse_drm_fdinfo_intel_i915(struct gpu_info *info, FILE *fdinfo_file, struc
 
   bool client_id_set = false;
   unsigned cid;
-  nvtop_time current_time;
-  nvtop_get_current_time(&current_time);
+  struct gpuinfo_client_counters counters = {0};
 
   while ((count = getline(&line, &line_buf_size, fdinfo_file)) != -1) {
     char *key, *val;
@@ -227,7 +227,8 @@ bool parse_drm_fdinfo_intel_i915(struct gpu_info *info, FILE *fdinfo_file, struc
           SET_GPUINFO_PROCESS(process_info, gfx_engine_used, time_spent);
         }
         if (is_copy) {
-          // TODO: what is copy?
+          // Blitter engine, only reported in the per-engine class utilization
+          SET_GPUINFO_CLIENT_COUNTER(&counters, gpuinfo_client_copy_engine, time_spent);
         }
         if (is_video) {
           // Video represents encode and decode
@@ -252,77 +253,12 @@ bool parse_drm_fdinfo_intel_i915(struct gpu_info *info, FILE *fdinfo_file, struc
   if (GPUINFO_PROCESS_FIELD_VALID(process_info, compute_engine_used) && process_info->compute_engine_used > 0)
     process_info->type |= gpu_process_compute;
 
-  struct intel_process_info_cache *cache_entry;
-  struct unique_cache_id ucid = {.client_id = cid, .pid = process_info->pid, .pdev = gpu_info->base.pdev};
-  HASH_FIND_CLIENT(gpu_info->last_update_process_cache, &ucid, cache_entry);
   // TODO: find how to extract global utilization
   // gpu util will be computed as the sum of all the processes utilization for now
-  if (cache_entry) {
-    uint64_t time_elapsed = nvtop_difftime_u64(cache_entry->last_measurement_tstamp, current_time);
-    HASH_DEL(gpu_info->last_update_process_cache, cache_entry);
-    if (GPUINFO_PROCESS_FIELD_VALID(process_info, gfx_engine_used) &&
-        INTEL_CACHE_FIELD_VALID(cache_entry, engine_render) &&
-        // In some rare occasions, the gfx engine usage reported by the driver is lowering (might be a driver bug)
-        process_info->gfx_engine_used >= cache_entry->engine_render &&
-        process_info->gfx_engine_used - cache_entry->engine_render <= time_elapsed) {
-      SET_GPUINFO_PROCESS(
-          process_info, gpu_usage,
-          busy_usage_from_time_usage_round(process_info->gfx_engine_used, cache_entry->engine_render, time_elapsed));
-    }
-    if (GPUINFO_PROCESS_FIELD_VALID(process_info, dec_engine_used) &&
-        INTEL_CACHE_FIELD_VALID(cache_entry, engine_video) &&
-        process_info->dec_engine_used >= cache_entry->engine_video &&
-        process_info->dec_engine_used - cache_entry->engine_video <= time_elapsed) {
-      SET_GPUINFO_PROCESS(
-          process_info, decode_usage,
-          busy_usage_from_time_usage_round(process_info->dec_engine_used, cache_entry->engine_video, time_elapsed));
-    }
-    if (GPUINFO_PROCESS_FIELD_VALID(process_info, enc_engine_used) &&
-        INTEL_CACHE_FIELD_VALID(cache_entry, engine_video_enhance) &&
-        process_info->enc_engine_used >= cache_entry->engine_video_enhance &&
-        process_info->enc_engine_used - cache_entry->engine_video_enhance <= time_elapsed) {
-      SET_GPUINFO_PROCESS(process_info, encode_usage,
-                          busy_usage_from_time_usage_round(process_info->enc_engine_used,
-                                                           cache_entry->engine_video_enhance, time_elapsed));
-    }
-    if (GPUINFO_PROCESS_FIELD_VALID(process_info, compute_engine_used) &&
-        GPUINFO_PROCESS_FIELD_VALID(process_info, gpu_usage) && INTEL_CACHE_FIELD_VALID(cache_entry, engine_compute) &&
-        process_info->compute_engine_used >= cache_entry->engine_compute &&
-        process_info->compute_engine_used - cache_entry->engine_compute <= time_elapsed) {
-      SET_GPUINFO_PROCESS(process_info, gpu_usage,
-                          process_info->gpu_usage + busy_usage_from_time_usage_round(process_info->compute_engine_used,
-                                                                                     cache_entry->engine_compute,
-                                                                                     time_elapsed));
-    }
-  } else {
-    cache_entry = calloc(1, sizeof(*cache_entry));
-    if (!cache_entry)
-      goto parse_fdinfo_exit;
-    cache_entry->client_id.client_id = cid;
-    cache_entry->client_id.pid = process_info->pid;
-    cache_entry->client_id.pdev = gpu_info->base.pdev;
-  }
+  struct gpuinfo_client_delta delta;
+  gpuinfo_client_counters_from_process(process_info, &counters);
+  if (gpuinfo_client_counters_update(&gpu_info->base, process_info->pid, cid, &counters, &delta))
+    gpuinfo_process_usage_from_client_delta(process_info, &delta);
 
-#ifndef NDEBUG
-  // We should only process one fdinfo entry per client id per update
-  struct intel_process_info_cache *cache_entry_check;
-  HASH_FIND_CLIENT(gpu_info->current_update_process_cache, &cache_entry->client_id, cache_entry_check);
-  assert(!cache_entry_check && "We should not be processing a client id twice per update");
-#endif
-
-  RESET_ALL(cache_entry->valid);
-  if (GPUINFO_PROCESS_FIELD_VALID(process_info, gfx_engine_used))
-    SET_INTEL_CACHE(cache_entry, engine_render, process_info->gfx_engine_used);
-  if (GPUINFO_PROCESS_FIELD_VALID(process_info, dec_engine_used))
-    SET_INTEL_CACHE(cache_entry, engine_video, process_info->dec_engine_used);
-  if (GPUINFO_PROCESS_FIELD_VALID(process_info, enc_engine_used))
-    SET_INTEL_CACHE(cache_entry, engine_video_enhance, process_info->enc_engine_used);
-  if (GPUINFO_PROCESS_FIELD_VALID(process_info, compute_engine_used))
-    SET_INTEL_CACHE(cache_entry, engine_compute, process_info->compute_engine_used);
-
-  cache_entry->last_measurement_tstamp = current_time;
-  HASH_ADD_CLIENT(gpu_info->current_update_process_cache, cache_entry);
-
-parse_fdinfo_exit:
   return true;
 }
\ No newline at end of file
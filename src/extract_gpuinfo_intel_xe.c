@@ -31,11 +31,12 @@
 #include <libdrm/xe_drm.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <stddef.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/ioctl.h>
 #include <unistd.h>
-#include <uthash.h>
 
 #define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
 
@@ -127,133 +128,99 @@ static const char *total_cycles_keys[] = {xe_drm_intel_total_cycles_rcs, xe_drm_
                                           xe_drm_intel_total_cycles_vecs, xe_drm_intel_total_cycles_bcs,
                                           xe_drm_intel_total_cycles_ccs};
 
-bool parse_drm_fdinfo_intel_xe(struct gpu_info *info, FILE *fdinfo_file, struct gpu_process *process_info) {
-struct gpu_info_intel *gpu_info = container_of(info, struct gpu_info_intel, base);
-static char *line = NULL;
-static size_t line_buf_size = 0;
-ssize_t count = 0;
-
-bool client_id_set = false;
-unsigned cid;
+// Slots of the busy cycles and total cycles of each engine class in the client counters cache
+#define XE_CYCLES_SLOT(engine) (offsetof(union intel_cycles, engine) / sizeof(uint64_t))
+#define XE_TOTAL_CYCLES_SLOT(engine) (ARRAY_SIZE(((union intel_cycles *)0)->array) + XE_CYCLES_SLOT(engine))
 
-union intel_cycles gpu_cycles = {.array = {0}};
-union intel_cycles total_cycles = {.array = {0}};
+bool parse_drm_fdinfo_intel_xe(struct gpu_info *info, FILE *fdinfo_file, struct gpu_process *process_info) {
+  struct gpu_info_intel *gpu_info = container_of(info, struct gpu_info_intel, base);
+  static char *line = NULL;
+  static size_t line_buf_size = 0;
+  ssize_t count = 0;
+
+  bool client_id_set = false;
+  unsigned cid;
+
+  union intel_cycles gpu_cycles = {.array = {0}};
+  union intel_cycles total_cycles = {.array = {0}};
+
+  while ((count = getline(&line, &line_buf_size, fdinfo_file)) != -1) {
+    char *key, *val;
+    // Get rid of the newline if present
+    if (line[count - 1] == '\n') {
+      line[--count] = '\0';
+    }
 
-// 1. Parse the file
-while ((count = getline(&line, &line_buf_size, fdinfo_file)) != -1) {
-  char *key, *val;
-  if (line[count - 1] == '\n') line[--count] = '\0';
-  if (!extract_drm_fdinfo_key_value(line, &key, &val)) continue;
+    if (!extract_drm_fdinfo_key_value(line, &key, &val))
+      continue;
 
-  if (!strcmp(key, drm_pdev)) {
-    if (strcmp(val, gpu_info->base.pdev)) return false;
-  } else if (!strcmp(key, drm_client_id)) {
-    char *endptr;
-    cid = strtoul(val, &endptr, 10);
-    if (*endptr) continue;
-    client_id_set = true;
-  } else {
-    if (!strcmp(key, xe_drm_intel_vram)) {
+    if (!strcmp(key, drm_pdev)) {
+      if (strcmp(val, gpu_info->base.pdev)) {
+        return false;
+      }
+    } else if (!strcmp(key, drm_client_id)) {
+      char *endptr;
+      cid = strtoul(val, &endptr, 10);
+      if (*endptr)
+        continue;
+      client_id_set = true;
+    } else if (!strcmp(key, xe_drm_intel_vram)) {
       unsigned long mem_int = strtoul(val, NULL, 10);
       if (GPUINFO_PROCESS_FIELD_VALID(process_info, gpu_memory_usage))
         SET_GPUINFO_PROCESS(process_info, gpu_memory_usage, process_info->gpu_memory_usage + (mem_int * 1024));
       else
         SET_GPUINFO_PROCESS(process_info, gpu_memory_usage, mem_int * 1024);
     } else {
-      // Capture cycles for all engines
       for (unsigned i = 0; i < ARRAY_SIZE(gpu_cycles.array); i++) {
-        if (!strcmp(key, cycles_keys[i])) gpu_cycles.array[i] = strtoull(val, NULL, 10);
+        if (!strcmp(key, cycles_keys[i]))
+          gpu_cycles.array[i] = strtoull(val, NULL, 10);
       }
-      for (unsigned i = 0; i < ARRAY_SIZE(total_cycles_keys); i++) {
-        if (!strcmp(key, total_cycles_keys[i])) total_cycles.array[i] = strtoull(val, NULL, 10);
+      for (unsigned i = 0; i < ARRAY_SIZE(total_cycles.array); i++) {
+        if (!strcmp(key, total_cycles_keys[i]))
+          total_cycles.array[i] = strtoull(val, NULL, 10);
       }
     }
   }
-}
 
-// Sum cycles just for internal bookkeeping
-{
   uint64_t cycles_sum = 0;
-  for (unsigned i = 0; i < ARRAY_SIZE(gpu_cycles.array); i++) cycles_sum += gpu_cycles.array[i];
+  for (unsigned i = 0; i < ARRAY_SIZE(gpu_cycles.array); i++)
+    cycles_sum += gpu_cycles.array[i];
   SET_GPUINFO_PROCESS(process_info, gpu_cycles, cycles_sum);
-}
-
-if (!client_id_set) return false;
-
-// Set process type flags
-process_info->type = gpu_process_unknown;
-if (gpu_cycles.rcs != 0) process_info->type |= gpu_process_graphical;
-if (gpu_cycles.ccs != 0) process_info->type |= gpu_process_compute;
-
-struct intel_process_info_cache *cache_entry;
-struct unique_cache_id ucid = {.client_id = cid, .pid = process_info->pid, .pdev = gpu_info->base.pdev};
-HASH_FIND_CLIENT(gpu_info->last_update_process_cache, &ucid, cache_entry);
-
-if (cache_entry) {
-  HASH_DEL(gpu_info->last_update_process_cache, cache_entry);
-
-  // --- THE FIX STARTS HERE ---
 
-  // 1. Force GPU Usage to Valid 0% immediately.
-  // This ensures you never get "null" in JSON, even if the GPU is idle.
-  SET_GPUINFO_PROCESS(process_info, gpu_usage, 0);
-  SET_GPUINFO_PROCESS(process_info, decode_usage, 0);
-  SET_GPUINFO_PROCESS(process_info, encode_usage, 0);
+  if (!client_id_set)
+    return false;
 
-  // 2. Helper Macro to add usage safely
-  #define ADD_USAGE(engine_name, target_field) \
-  do { \
-    uint64_t d = gpu_cycles.engine_name - cache_entry->gpu_cycles.engine_name; \
-    uint64_t td = total_cycles.engine_name - cache_entry->total_cycles.engine_name; \
-    if (td > 0) { \
-      unsigned u = d * 100 / td; \
-      SET_GPUINFO_PROCESS(process_info, target_field, process_info->target_field + u); \
-    } \
-  } while(0)
+  process_info->type = gpu_process_unknown;
+  if (gpu_cycles.rcs != 0)
+    process_info->type |= gpu_process_graphical;
+  if (gpu_cycles.ccs != 0)
+    process_info->type |= gpu_process_compute;
 
-  // 3. Calculate Engines
-  // RCS = 3D Render
-  ADD_USAGE(rcs, gpu_usage);
-
-  // CCS = Compute (Frigate/AI)
-  ADD_USAGE(ccs, gpu_usage);
-
-  // VCS = Video Decode (Plex)
-  // NOTE: We add this to BOTH decode_usage (standard) AND gpu_usage (custom for you)
-  // This ensures Plex load shows up in the main "gpu_util" JSON field.
-  ADD_USAGE(vcs, decode_usage);
-  ADD_USAGE(vcs, gpu_usage);
-
-  // VECS = Video Encode (Plex)
-  ADD_USAGE(vecs, encode_usage);
-  ADD_USAGE(vecs, gpu_usage); // Add to main usage too
-
-  // BCS = Copy Engine (Moving data)
-  ADD_USAGE(bcs, gpu_usage);
-
-  #undef ADD_USAGE
-  // --- THE FIX ENDS HERE ---
-
-} else {
-  // New process: initialize cache
-  cache_entry = calloc(1, sizeof(*cache_entry));
-  if (!cache_entry) goto parse_fdinfo_exit;
-  cache_entry->client_id.client_id = cid;
-  cache_entry->client_id.pid = process_info->pid;
-  cache_entry->client_id.pdev = gpu_info->base.pdev;
-}
-
-#ifndef NDEBUG
-struct intel_process_info_cache *cache_entry_check;
-HASH_FIND_CLIENT(gpu_info->current_update_process_cache, &cache_entry->client_id, cache_entry_check);
-assert(!cache_entry_check && "We should not be processing a client id twice per update");
-#endif
-
-RESET_ALL(cache_entry->valid);
-SET_INTEL_CACHE(cache_entry, gpu_cycles, gpu_cycles);
-SET_INTEL_CACHE(cache_entry, total_cycles, total_cycles);
-HASH_ADD_CLIENT(gpu_info->current_update_process_cache, cache_entry);
-
-parse_fdinfo_exit:
-return true;
+  struct gpuinfo_client_counters counters = {0};
+  struct gpuinfo_client_delta delta;
+  for (unsigned i = 0; i < ARRAY_SIZE(gpu_cycles.array); i++) {
+    SET_GPUINFO_CLIENT_COUNTER(&counters, i, gpu_cycles.array[i]);
+    SET_GPUINFO_CLIENT_COUNTER(&counters, ARRAY_SIZE(gpu_cycles.array) + i, total_cycles.array[i]);
+  }
+  if (!gpuinfo_client_counters_update(&gpu_info->base, process_info->pid, cid, &counters, &delta))
+    return true;
+
+  // The usage is reported even when idle. Every engine class counts toward the gpu usage, video decode (vcs) and
+  // video enhance (vecs) are also reported as the decode and encode usage.
+  unsigned rcs = 0, ccs = 0, vcs = 0, vecs = 0, bcs = 0;
+  gpuinfo_client_cycles_usage(&delta, XE_CYCLES_SLOT(rcs), XE_TOTAL_CYCLES_SLOT(rcs), &rcs);
+  gpuinfo_client_cycles_usage(&delta, XE_CYCLES_SLOT(ccs), XE_TOTAL_CYCLES_SLOT(ccs), &ccs);
+  gpuinfo_client_cycles_usage(&delta, XE_CYCLES_SLOT(vcs), XE_TOTAL_CYCLES_SLOT(vcs), &vcs);
+  gpuinfo_client_cycles_usage(&delta, XE_CYCLES_SLOT(vecs), XE_TOTAL_CYCLES_SLOT(vecs), &vecs);
+  gpuinfo_client_cycles_usage(&delta, XE_CYCLES_SLOT(bcs), XE_TOTAL_CYCLES_SLOT(bcs), &bcs);
+  SET_GPUINFO_PROCESS(process_info, gpu_usage, rcs + ccs + vcs + vecs + bcs);
+  SET_GPUINFO_PROCESS(process_info, decode_usage, vcs);
+  SET_GPUINFO_PROCESS(process_info, encode_usage, vecs);
+  SET_GPUINFO_PROCESS_ENGINE(process_info, gpuinfo_engine_render, rcs);
+  SET_GPUINFO_PROCESS_ENGINE(process_info, gpuinfo_engine_compute, ccs);
+  SET_GPUINFO_PROCESS_ENGINE(process_info, gpuinfo_engine_copy, bcs);
+  SET_GPUINFO_PROCESS_ENGINE(process_info, gpuinfo_engine_decode, vcs);
+  SET_GPUINFO_PROCESS_ENGINE(process_info, gpuinfo_engine_encode, vecs);
+
+  return true;
 }
@@ -28,25 +28,6 @@
 
 #include "mali_common.h"
 
-enum mali_process_info_cache_valid {
-  mali_cache_engine_render_valid = 0,
-  mali_cache_process_info_cache_valid_count
-};
-
-struct __attribute__((__packed__)) unique_cache_id {
-  unsigned client_id;
-  pid_t pid;
-};
-
-struct mali_process_info_cache {
-  struct unique_cache_id client_id;
-  uint64_t engine_render;
-  uint64_t last_cycles;
-  nvtop_time last_measurement_tstamp;
-  unsigned char valid[(mali_cache_process_info_cache_valid_count + CHAR_BIT - 1) / CHAR_BIT];
-  UT_hash_handle hh;
-};
-
 bool mali_init_drm_funcs(struct drmFuncTable *drmFuncs,
 			 struct mali_gpu_state *state)
 {
@@ -373,19 +354,6 @@ void mali_common_refresh_dynamic_info(struct gpuinfo_dynamic_info *dynamic_info,
                       (dynamic_info->total_memory - dynamic_info->free_memory) * 100 / dynamic_info->total_memory);
 }
 
-static void swap_process_cache_for_next_update(struct gpu_info_mali *gpu_info) {
-  // Free old cache data and set the cache for the next update
-  if (gpu_info->last_update_process_cache) {
-    struct mali_process_info_cache *cache_entry, *tmp;
-    HASH_ITER(hh, gpu_info->last_update_process_cache, cache_entry, tmp) {
-      HASH_DEL(gpu_info->last_update_process_cache, cache_entry);
-      free(cache_entry);
-    }
-  }
-  gpu_info->last_update_process_cache = gpu_info->current_update_process_cache;
-  gpu_info->current_update_process_cache = NULL;
-}
-
 void mali_common_get_running_processes(struct gpu_info *_gpu_info, enum mali_version version) {
   // For Mali, we register a fdinfo callback that will fill the gpu_process datastructure of the gpu_info structure
   // for us. This avoids going through /proc multiple times per update for multiple GPUs.
@@ -394,60 +362,28 @@ void mali_common_get_running_processes(struct gpu_info *_gpu_info, enum mali_ver
     fprintf(stderr, "Wrong device version: %u\n", gpu_info->version);
     abort();
   }
-
-  swap_process_cache_for_next_update(gpu_info);
 }
 
 void mali_common_parse_fdinfo_handle_cache(struct gpu_info_mali *gpu_info,
 					   struct gpu_process *process_info,
-					   nvtop_time current_time,
 					   uint64_t total_cycles,
 					   unsigned cid,
 					   bool engine_count)
 {
-  struct mali_process_info_cache *cache_entry;
-  struct unique_cache_id ucid = {.client_id = cid, .pid = process_info->pid};
-
-  HASH_FIND_CLIENT(gpu_info->last_update_process_cache, &ucid, cache_entry);
-
-  if (cache_entry) {
-    uint64_t time_elapsed = nvtop_difftime_u64(cache_entry->last_measurement_tstamp, current_time);
-    SET_GPUINFO_PROCESS(process_info, sample_delta, time_elapsed);
-    if (engine_count)
-      SET_GPUINFO_PROCESS(process_info, gpu_cycles, total_cycles - cache_entry->last_cycles);
-    cache_entry->last_cycles = total_cycles;
-    HASH_DEL(gpu_info->last_update_process_cache, cache_entry);
-    if (GPUINFO_PROCESS_FIELD_VALID(process_info, gfx_engine_used) &&
-        MALI_CACHE_FIELD_VALID(cache_entry, engine_render) &&
-        // In some rare occasions, the gfx engine usage reported by the driver is lowering (might be a driver bug)
-        process_info->gfx_engine_used >= cache_entry->engine_render &&
-        process_info->gfx_engine_used - cache_entry->engine_render <= time_elapsed) {
-      SET_GPUINFO_PROCESS(
-          process_info, gpu_usage,
-          busy_usage_from_time_usage_round(process_info->gfx_engine_used, cache_entry->engine_render, time_elapsed));
-    }
-  } else {
-    cache_entry = calloc(1, sizeof(*cache_entry));
-    if (!cache_entry)
-      return;
-    cache_entry->client_id.client_id = cid;
-    cache_entry->client_id.pid = process_info->pid;
-    cache_entry->last_cycles = total_cycles;
-  }
+  struct gpuinfo_client_counters counters = {0};
+  struct gpuinfo_client_delta delta;
 
-#ifndef NDEBUG
-  // We should only process one fdinfo entry per client id per update
-  struct mali_process_info_cache *cache_entry_check;
-  HASH_FIND_CLIENT(gpu_info->current_update_process_cache, &cache_entry->client_id, cache_entry_check);
-  assert(!cache_entry_check && "We should not be processing a client id twice per update");
-#endif
+  gpuinfo_client_counters_from_process(process_info, &counters);
+  if (engine_count)
+    SET_GPUINFO_CLIENT_COUNTER(&counters, gpuinfo_client_gpu_cycles, total_cycles);
 
-  RESET_ALL(cache_entry->valid);
-  if (GPUINFO_PROCESS_FIELD_VALID(process_info, gfx_engine_used))
-    SET_MALI_CACHE(cache_entry, engine_render, process_info->gfx_engine_used);
+  if (!gpuinfo_client_counters_update(&gpu_info->base, process_info->pid, cid, &counters, &delta))
+    return;
 
-  cache_entry->last_measurement_tstamp = current_time;
-  HASH_ADD_CLIENT(gpu_info->current_update_process_cache, cache_entry);
+  SET_GPUINFO_PROCESS(process_info, sample_delta, delta.time_elapsed);
+  if (GPUINFO_CLIENT_COUNTER_VALID(&delta, gpuinfo_client_gpu_cycles))
+    SET_GPUINFO_PROCESS(process_info, gpu_cycles, delta.value[gpuinfo_client_gpu_cycles]);
+  gpuinfo_process_usage_from_client_delta(process_info, &delta);
 }
 
 bool mali_common_parse_drm_fdinfo(struct gpu_info *info, FILE *fdinfo_file,
@@ -30,46 +30,19 @@
 #include <fcntl.h>
 #include <libdrm/msm_drm.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/sysinfo.h>
 #include <unistd.h>
-#include <uthash.h>
 #include <xf86drm.h>
 
 // extern
 const char * msm_parse_marketing_name(uint64_t gpu_id);
 
-#define HASH_FIND_CLIENT(head, key_ptr, out_ptr) HASH_FIND(hh, head, key_ptr, sizeof(unsigned), out_ptr)
-#define HASH_ADD_CLIENT(head, in_ptr) HASH_ADD(hh, head, client_id, sizeof(unsigned), in_ptr)
-
-#define SET_MSM_CACHE(cachePtr, field, value) SET_VALUE(cachePtr, field, value, msm_cache_)
-#define RESET_MSM_CACHE(cachePtr, field) INVALIDATE_VALUE(cachePtr, field, msm_cache_)
-#define MSM_CACHE_FIELD_VALID(cachePtr, field) VALUE_IS_VALID(cachePtr, field, msm_cache_)
-
-enum intel_process_info_cache_valid {
-  msm_cache_engine_render_valid = 0,
-  msm_cache_process_info_cache_valid_count
-};
-
-struct __attribute__((__packed__)) unique_cache_id {
-  unsigned client_id;
-  pid_t pid;
-};
-
-struct msm_process_info_cache {
-  struct unique_cache_id client_id;
-  uint64_t engine_render;
-  nvtop_time last_measurement_tstamp;
-  unsigned char valid[(msm_cache_process_info_cache_valid_count + CHAR_BIT - 1) / CHAR_BIT];
-  UT_hash_handle hh;
-};
-
 struct gpu_info_msm {
   drmVersionPtr drmVersion;
   struct gpu_info base;
   int fd;
-
-  struct msm_process_info_cache *last_update_process_cache, *current_update_process_cache; // Cached processes info
 };
 
 static bool gpuinfo_msm_init(void);
@@ -281,8 +254,6 @@ static bool parse_drm_fdinfo_msm(struct gpu_info *info, FILE *fdinfo_file, struc
 
   bool client_id_set = false;
   unsigned cid;
-  nvtop_time current_time;
-  nvtop_get_current_time(&current_time);
 
   while ((count = getline(&line, &line_buf_size, fdinfo_file)) != -1) {
     char *key, *val;
@@ -334,44 +305,12 @@ static bool parse_drm_fdinfo_msm(struct gpu_info *info, FILE *fdinfo_file, struc
   // The msm driver does not expose compute engine metrics as of yet
   process_info->type |= gpu_process_graphical;
 
-  struct msm_process_info_cache *cache_entry;
-  struct unique_cache_id ucid = {.client_id = cid, .pid = process_info->pid};
-  HASH_FIND_CLIENT(gpu_info->last_update_process_cache, &ucid, cache_entry);
-  if (cache_entry) {
-    uint64_t time_elapsed = nvtop_difftime_u64(cache_entry->last_measurement_tstamp, current_time);
-    HASH_DEL(gpu_info->last_update_process_cache, cache_entry);
-    if (GPUINFO_PROCESS_FIELD_VALID(process_info, gfx_engine_used) &&
-        MSM_CACHE_FIELD_VALID(cache_entry, engine_render) &&
-        // In some rare occasions, the gfx engine usage reported by the driver is lowering (might be a driver bug)
-        process_info->gfx_engine_used >= cache_entry->engine_render &&
-        process_info->gfx_engine_used - cache_entry->engine_render <= time_elapsed) {
-      SET_GPUINFO_PROCESS(
-          process_info, gpu_usage,
-          busy_usage_from_time_usage_round(process_info->gfx_engine_used, cache_entry->engine_render, time_elapsed));
-    }
-  } else {
-    cache_entry = calloc(1, sizeof(*cache_entry));
-    if (!cache_entry)
-      goto parse_fdinfo_exit;
-    cache_entry->client_id.client_id = cid;
-    cache_entry->client_id.pid = process_info->pid;
-  }
-
-#ifndef NDEBUG
-  // We should only process one fdinfo entry per client id per update
-  struct msm_process_info_cache *cache_entry_check;
-  HASH_FIND_CLIENT(gpu_info->current_update_process_cache, &cid, cache_entry_check);
-  assert(!cache_entry_check && "We should not be processing a client id twice per update");
-#endif
-
-  RESET_ALL(cache_entry->valid);
-  if (GPUINFO_PROCESS_FIELD_VALID(process_info, gfx_engine_used))
-    SET_MSM_CACHE(cache_entry, engine_render, process_info->gfx_engine_used);
-
-  cache_entry->last_measurement_tstamp = current_time;
-  HASH_ADD_CLIENT(gpu_info->current_update_process_cache, cache_entry);
+  struct gpuinfo_client_counters counters = {0};
+  struct gpuinfo_client_delta delta;
+  gpuinfo_client_counters_from_process(process_info, &counters);
+  if (gpuinfo_client_counters_update(&gpu_info->base, process_info->pid, cid, &counters, &delta))
+    gpuinfo_process_usage_from_client_delta(process_info, &delta);
 
-parse_fdinfo_exit:
   return true;
 }
 
@@ -559,22 +498,7 @@ void gpuinfo_msm_refresh_dynamic_info(struct gpu_info *_gpu_info) {
                       (dynamic_info->total_memory - dynamic_info->free_memory) * 100 / dynamic_info->total_memory);
 }
 
-static void swap_process_cache_for_next_update(struct gpu_info_msm *gpu_info) {
-  // Free old cache data and set the cache for the next update
-  if (gpu_info->last_update_process_cache) {
-    struct msm_process_info_cache *cache_entry, *tmp;
-    HASH_ITER(hh, gpu_info->last_update_process_cache, cache_entry, tmp) {
-      HASH_DEL(gpu_info->last_update_process_cache, cache_entry);
-      free(cache_entry);
-    }
-  }
-  gpu_info->last_update_process_cache = gpu_info->current_update_process_cache;
-  gpu_info->current_update_process_cache = NULL;
-}
-
 void gpuinfo_msm_get_running_processes(struct gpu_info *_gpu_info) {
   // For Adreno, we register a fdinfo callback that will fill the gpu_process datastructure of the gpu_info structure
   // for us. This avoids going through /proc multiple times per update for multiple GPUs.
-  struct gpu_info_msm *gpu_info = container_of(_gpu_info, struct gpu_info_msm, base);
-  swap_process_cache_for_next_update(gpu_info);
 }
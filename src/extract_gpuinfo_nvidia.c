@@ -144,6 +144,18 @@ static nvmlReturn_t (*nvmlDeviceGetPowerUsage)(nvmlDevice_t device, unsigned int
 
 static nvmlReturn_t (*nvmlDeviceGetEnforcedPowerLimit)(nvmlDevice_t device, unsigned int *limit);
 
+static nvmlReturn_t (*nvmlDeviceGetTotalEnergyConsumption)(nvmlDevice_t device, unsigned long long *energy);
+
+// Reasons for the clocks being below their maximum, renamed "clock event reasons" by the recent drivers
+#define nvmlClocksThrottleReasonSwPowerCap 0x4ull
+#define nvmlClocksThrottleReasonHwSlowdown 0x8ull
+#define nvmlClocksThrottleReasonSyncBoost 0x10ull
+#define nvmlClocksThrottleReasonSwThermalSlowdown 0x20ull
+#define nvmlClocksThrottleReasonHwThermalSlowdown 0x40ull
+#define nvmlClocksThrottleReasonHwPowerBrakeSlowdown 0x80ull
+
+static nvmlReturn_t (*nvmlDeviceGetCurrentClocksThrottleReasons)(nvmlDevice_t device, unsigned long long *reasons);
+
 static nvmlReturn_t (*nvmlDeviceGetEncoderUtilization)(nvmlDevice_t device, unsigned int *utilization,
                                                        unsigned int *samplingPeriodUs);
 
@@ -234,6 +246,7 @@ struct gpu_info_nvidia {
 
   nvmlDevice_t gpuhandle;
   bool isInMigMode;
+  nvmlClockType_t max_clock_from; // Clock reporting the current speed, graphics or SM
   unsigned long long last_utilization_timestamp;
 };
 
@@ -246,6 +259,7 @@ static bool gpuinfo_nvidia_get_device_handles(struct list_head *devices, unsigne
 static void gpuinfo_nvidia_populate_static_info(struct gpu_info *_gpu_info);
 static void gpuinfo_nvidia_refresh_dynamic_info(struct gpu_info *_gpu_info);
 static void gpuinfo_nvidia_get_running_processes(struct gpu_info *_gpu_info);
+static bool gpuinfo_nvidia_sample_power(struct gpu_info *_gpu_info, struct gpuinfo_power_reading *reading);
 
 struct gpu_vendor gpu_vendor_nvidia = {
     .init = gpuinfo_nvidia_init,
@@ -255,6 +269,7 @@ struct gpu_vendor gpu_vendor_nvidia = {
     .populate_static_info = gpuinfo_nvidia_populate_static_info,
     .refresh_dynamic_info = gpuinfo_nvidia_refresh_dynamic_info,
     .refresh_running_processes = gpuinfo_nvidia_get_running_processes,
+    .sample_power = gpuinfo_nvidia_sample_power,
     .name = "NVIDIA",
 };
 
@@ -428,6 +443,10 @@ static bool gpuinfo_nvidia_init(void) {
   // These ones might not be available
   nvmlDeviceGetProcessUtilization = dlsym(libnvidia_ml_handle, "nvmlDeviceGetProcessUtilization");
   nvmlDeviceGetMigMode = dlsym(libnvidia_ml_handle, "nvmlDeviceGetMigMode");
+  nvmlDeviceGetTotalEnergyConsumption = dlsym(libnvidia_ml_handle, "nvmlDeviceGetTotalEnergyConsumption");
+  nvmlDeviceGetCurrentClocksThrottleReasons = dlsym(libnvidia_ml_handle, "nvmlDeviceGetCurrentClocksEventReasons");
+  if (!nvmlDeviceGetCurrentClocksThrottleReasons)
+    nvmlDeviceGetCurrentClocksThrottleReasons = dlsym(libnvidia_ml_handle, "nvmlDeviceGetCurrentClocksThrottleReasons");
 
   last_nvml_return_status = nvmlInit();
   if (last_nvml_return_status != NVML_SUCCESS) {
@@ -547,266 +566,319 @@ static void gpuinfo_nvidia_refresh_dynamic_info(struct gpu_info *_gpu_info) {
   unsigned graphics_clock;
   bool sm_clock_valid = false;
   unsigned sm_clock;
-  nvmlClockType_t getMaxClockFrom = NVML_CLOCK_GRAPHICS;
-
-  RESET_ALL(dynamic_info->valid);
-
-  // GPU current speed
-  // Maximum between SM and Graphical
-  last_nvml_return_status = nvmlDeviceGetClockInfo(device, NVML_CLOCK_GRAPHICS, &graphics_clock);
-  graphics_clock_valid = last_nvml_return_status == NVML_SUCCESS;
 
-  last_nvml_return_status = nvmlDeviceGetClockInfo(device, NVML_CLOCK_SM, &sm_clock);
-  sm_clock_valid = last_nvml_return_status == NVML_SUCCESS;
-
-  if (graphics_clock_valid && sm_clock_valid && graphics_clock < sm_clock) {
-    getMaxClockFrom = NVML_CLOCK_SM;
-  } else if (!graphics_clock_valid && sm_clock_valid) {
-    getMaxClockFrom = NVML_CLOCK_SM;
-  }
+  // The fields that are not due keep their value from a previous update
+  if (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, gpu_clock_speed)) {
+    nvmlClockType_t getMaxClockFrom = NVML_CLOCK_GRAPHICS;
+    // GPU current speed
+    // Maximum between SM and Graphical
+    last_nvml_return_status = nvmlDeviceGetClockInfo(device, NVML_CLOCK_GRAPHICS, &graphics_clock);
+    graphics_clock_valid = last_nvml_return_status == NVML_SUCCESS;
+
+    last_nvml_return_status = nvmlDeviceGetClockInfo(device, NVML_CLOCK_SM, &sm_clock);
+    sm_clock_valid = last_nvml_return_status == NVML_SUCCESS;
+
+    if (graphics_clock_valid && sm_clock_valid && graphics_clock < sm_clock) {
+      getMaxClockFrom = NVML_CLOCK_SM;
+    } else if (!graphics_clock_valid && sm_clock_valid) {
+      getMaxClockFrom = NVML_CLOCK_SM;
+    }
 
-  if (getMaxClockFrom == NVML_CLOCK_GRAPHICS && graphics_clock_valid) {
-    SET_GPUINFO_DYNAMIC(dynamic_info, gpu_clock_speed, graphics_clock);
-  }
-  if (getMaxClockFrom == NVML_CLOCK_SM && sm_clock_valid) {
-    SET_GPUINFO_DYNAMIC(dynamic_info, gpu_clock_speed, sm_clock);
+    if (getMaxClockFrom == NVML_CLOCK_GRAPHICS && graphics_clock_valid) {
+      SET_GPUINFO_DYNAMIC(dynamic_info, gpu_clock_speed, graphics_clock);
+    }
+    if (getMaxClockFrom == NVML_CLOCK_SM && sm_clock_valid) {
+      SET_GPUINFO_DYNAMIC(dynamic_info, gpu_clock_speed, sm_clock);
+    }
+    gpu_info->max_clock_from = getMaxClockFrom;
   }
 
   // GPU max speed
-  last_nvml_return_status = nvmlDeviceGetMaxClockInfo(device, getMaxClockFrom, &dynamic_info->gpu_clock_speed_max);
-  if (last_nvml_return_status == NVML_SUCCESS)
-    SET_VALID(gpuinfo_gpu_clock_speed_max_valid, dynamic_info->valid);
+  if (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, gpu_clock_speed_max)) {
+    last_nvml_return_status =
+        nvmlDeviceGetMaxClockInfo(device, gpu_info->max_clock_from, &dynamic_info->gpu_clock_speed_max);
+    if (last_nvml_return_status == NVML_SUCCESS)
+      SET_VALID(gpuinfo_gpu_clock_speed_max_valid, dynamic_info->valid);
+  }
 
   // Memory current speed
-  last_nvml_return_status = nvmlDeviceGetClockInfo(device, NVML_CLOCK_MEM, &dynamic_info->mem_clock_speed);
-  if (last_nvml_return_status == NVML_SUCCESS)
-    SET_VALID(gpuinfo_mem_clock_speed_valid, dynamic_info->valid);
+  if (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, mem_clock_speed)) {
+    last_nvml_return_status = nvmlDeviceGetClockInfo(device, NVML_CLOCK_MEM, &dynamic_info->mem_clock_speed);
+    if (last_nvml_return_status == NVML_SUCCESS)
+      SET_VALID(gpuinfo_mem_clock_speed_valid, dynamic_info->valid);
+  }
 
   // Memory max speed
-  last_nvml_return_status = nvmlDeviceGetMaxClockInfo(device, NVML_CLOCK_MEM, &dynamic_info->mem_clock_speed_max);
-  if (last_nvml_return_status == NVML_SUCCESS)
-    SET_VALID(gpuinfo_mem_clock_speed_max_valid, dynamic_info->valid);
+  if (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, mem_clock_speed_max)) {
+    last_nvml_return_status = nvmlDeviceGetMaxClockInfo(device, NVML_CLOCK_MEM, &dynamic_info->mem_clock_speed_max);
+    if (last_nvml_return_status == NVML_SUCCESS)
+      SET_VALID(gpuinfo_mem_clock_speed_max_valid, dynamic_info->valid);
+  }
+
+  // Throttling, the idle and application clock settings are not limits
+  unsigned long long reasons;
+  if (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, throttle_reasons) && nvmlDeviceGetCurrentClocksThrottleReasons) {
+    last_nvml_return_status = nvmlDeviceGetCurrentClocksThrottleReasons(device, &reasons);
+    if (last_nvml_return_status == NVML_SUCCESS) {
+      unsigned throttle_reasons = 0;
+      if (reasons & nvmlClocksThrottleReasonSwPowerCap)
+        throttle_reasons |= GPUINFO_THROTTLE_REASON(gpuinfo_throttle_power);
+      if (reasons & (nvmlClocksThrottleReasonSwThermalSlowdown | nvmlClocksThrottleReasonHwThermalSlowdown))
+        throttle_reasons |= GPUINFO_THROTTLE_REASON(gpuinfo_throttle_thermal);
+      if (reasons & (nvmlClocksThrottleReasonHwSlowdown | nvmlClocksThrottleReasonHwPowerBrakeSlowdown))
+        throttle_reasons |= GPUINFO_THROTTLE_REASON(gpuinfo_throttle_hardware);
+      if (reasons & nvmlClocksThrottleReasonSyncBoost)
+        throttle_reasons |= GPUINFO_THROTTLE_REASON(gpuinfo_throttle_other);
+      SET_GPUINFO_DYNAMIC(dynamic_info, throttle_reasons, throttle_reasons);
+    }
+  }
 
   // CPU and Memory utilization rates
-  nvmlUtilization_t utilization_percentages;
-  last_nvml_return_status = nvmlDeviceGetUtilizationRates(device, &utilization_percentages);
-  if (last_nvml_return_status == NVML_SUCCESS) {
-    SET_GPUINFO_DYNAMIC(dynamic_info, gpu_util_rate, utilization_percentages.gpu);
+  if (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, gpu_util_rate)) {
+    nvmlUtilization_t utilization_percentages;
+    last_nvml_return_status = nvmlDeviceGetUtilizationRates(device, &utilization_percentages);
+    if (last_nvml_return_status == NVML_SUCCESS) {
+      SET_GPUINFO_DYNAMIC(dynamic_info, gpu_util_rate, utilization_percentages.gpu);
+    }
   }
 
   // Encoder utilization rate
   unsigned ignored_period;
-  last_nvml_return_status = nvmlDeviceGetEncoderUtilization(device, &dynamic_info->encoder_rate, &ignored_period);
-  if (last_nvml_return_status == NVML_SUCCESS)
-    SET_VALID(gpuinfo_encoder_rate_valid, dynamic_info->valid);
+  if (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, encoder_rate)) {
+    last_nvml_return_status = nvmlDeviceGetEncoderUtilization(device, &dynamic_info->encoder_rate, &ignored_period);
+    if (last_nvml_return_status == NVML_SUCCESS)
+      SET_VALID(gpuinfo_encoder_rate_valid, dynamic_info->valid);
+  }
 
   // Decoder utilization rate
-  last_nvml_return_status = nvmlDeviceGetDecoderUtilization(device, &dynamic_info->decoder_rate, &ignored_period);
-  if (last_nvml_return_status == NVML_SUCCESS)
-    SET_VALID(gpuinfo_decoder_rate_valid, dynamic_info->valid);
-
-  // Device memory info (total,used,free)
-  bool got_meminfo = false;
-  bool has_unified_memory = false;
+  if (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, decoder_rate)) {
+    last_nvml_return_status = nvmlDeviceGetDecoderUtilization(device, &dynamic_info->decoder_rate, &ignored_period);
+    if (last_nvml_return_status == NVML_SUCCESS)
+      SET_VALID(gpuinfo_decoder_rate_valid, dynamic_info->valid);
+  }
 
-  if (nvmlDeviceGetMemoryInfo_v2) {
-    nvmlMemory_v2_t memory_info;
-    memory_info.version = 2;
-    last_nvml_return_status = nvmlDeviceGetMemoryInfo_v2(device, &memory_info);
-    if (last_nvml_return_status == NVML_SUCCESS) {
-      // Check if this is a unified memory GPU (total == 0 indicates unified memory)
-      if (memory_info.total == 0) {
-        has_unified_memory = true;
+  // The memory fields all come from the same query
+  if (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, total_memory) || GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, used_memory) ||
+      GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, free_memory) || GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, mem_util_rate)) {
+    // Device memory info (total,used,free)
+    bool got_meminfo = false;
+    bool has_unified_memory = false;
+
+    if (nvmlDeviceGetMemoryInfo_v2) {
+      nvmlMemory_v2_t memory_info;
+      memory_info.version = 2;
+      last_nvml_return_status = nvmlDeviceGetMemoryInfo_v2(device, &memory_info);
+      if (last_nvml_return_status == NVML_SUCCESS) {
+        // Check if this is a unified memory GPU (total == 0 indicates unified memory)
+        if (memory_info.total == 0) {
+          has_unified_memory = true;
+        } else {
+          got_meminfo = true;
+          SET_GPUINFO_DYNAMIC(dynamic_info, total_memory, memory_info.total);
+          SET_GPUINFO_DYNAMIC(dynamic_info, used_memory, memory_info.used);
+          SET_GPUINFO_DYNAMIC(dynamic_info, free_memory, memory_info.free);
+          SET_GPUINFO_DYNAMIC(dynamic_info, mem_util_rate, memory_info.used * 100 / memory_info.total);
+        }
       } else {
-        got_meminfo = true;
-        SET_GPUINFO_DYNAMIC(dynamic_info, total_memory, memory_info.total);
-        SET_GPUINFO_DYNAMIC(dynamic_info, used_memory, memory_info.used);
-        SET_GPUINFO_DYNAMIC(dynamic_info, free_memory, memory_info.free);
-        SET_GPUINFO_DYNAMIC(dynamic_info, mem_util_rate, memory_info.used * 100 / memory_info.total);
+        // Memory query failed - likely unified memory GPU (error code 13 = NOT_SUPPORTED)
+        has_unified_memory = true;
       }
-    } else {
-      // Memory query failed - likely unified memory GPU (error code 13 = NOT_SUPPORTED)
-      has_unified_memory = true;
     }
-  }
-  if (!got_meminfo && !has_unified_memory && nvmlDeviceGetMemoryInfo) {
-    nvmlMemory_v1_t memory_info;
-    last_nvml_return_status = nvmlDeviceGetMemoryInfo(device, &memory_info);
-    if (last_nvml_return_status == NVML_SUCCESS) {
-      // Check if this is a unified memory GPU (total == 0 indicates unified memory)
-      if (memory_info.total == 0) {
-        has_unified_memory = true;
+    if (!got_meminfo && !has_unified_memory && nvmlDeviceGetMemoryInfo) {
+      nvmlMemory_v1_t memory_info;
+      last_nvml_return_status = nvmlDeviceGetMemoryInfo(device, &memory_info);
+      if (last_nvml_return_status == NVML_SUCCESS) {
+        // Check if this is a unified memory GPU (total == 0 indicates unified memory)
+        if (memory_info.total == 0) {
+          has_unified_memory = true;
+        } else {
+          SET_GPUINFO_DYNAMIC(dynamic_info, total_memory, memory_info.total);
+          SET_GPUINFO_DYNAMIC(dynamic_info, used_memory, memory_info.used);
+          SET_GPUINFO_DYNAMIC(dynamic_info, free_memory, memory_info.free);
+          SET_GPUINFO_DYNAMIC(dynamic_info, mem_util_rate, memory_info.used * 100 / memory_info.total);
+        }
       } else {
-        SET_GPUINFO_DYNAMIC(dynamic_info, total_memory, memory_info.total);
-        SET_GPUINFO_DYNAMIC(dynamic_info, used_memory, memory_info.used);
-        SET_GPUINFO_DYNAMIC(dynamic_info, free_memory, memory_info.free);
-        SET_GPUINFO_DYNAMIC(dynamic_info, mem_util_rate, memory_info.used * 100 / memory_info.total);
+        // Memory query failed - likely unified memory GPU
+        has_unified_memory = true;
       }
-    } else {
-      // Memory query failed - likely unified memory GPU
-      has_unified_memory = true;
     }
-  }
 
-  // Handle unified memory GPUs - query actual GPU allocations and system memory
-  if (has_unified_memory) {
-    // Get actual GPU memory usage from running processes
-    unsigned long long gpu_used_memory = 0;
-
-    // Sum up memory used by compute processes
-    if (nvmlDeviceGetComputeRunningProcesses_v3 || nvmlDeviceGetComputeRunningProcesses_v2 ||
-        nvmlDeviceGetComputeRunningProcesses_v1) {
-      unsigned int process_count = 0;
-      nvmlReturn_t (*getProcesses)(nvmlDevice_t, unsigned int *, void *) = NULL;
-      size_t process_info_size = 0;
-
-      // Choose the latest available version
-      if (nvmlDeviceGetComputeRunningProcesses_v3) {
-        getProcesses = nvmlDeviceGetComputeRunningProcesses[3];
-        process_info_size = sizeof(nvmlProcessInfo_v3_t);
-      } else if (nvmlDeviceGetComputeRunningProcesses_v2) {
-        getProcesses = nvmlDeviceGetComputeRunningProcesses[2];
-        process_info_size = sizeof(nvmlProcessInfo_v2_t);
-      } else {
-        getProcesses = nvmlDeviceGetComputeRunningProcesses[1];
-        process_info_size = sizeof(nvmlProcessInfo_v1_t);
-      }
+    // Handle unified memory GPUs - query actual GPU allocations and system memory
+    if (has_unified_memory) {
+      // Get actual GPU memory usage from running processes
+      unsigned long long gpu_used_memory = 0;
+
+      // Sum up memory used by compute processes
+      if (nvmlDeviceGetComputeRunningProcesses_v3 || nvmlDeviceGetComputeRunningProcesses_v2 ||
+          nvmlDeviceGetComputeRunningProcesses_v1) {
+        unsigned int process_count = 0;
+        nvmlReturn_t (*getProcesses)(nvmlDevice_t, unsigned int *, void *) = NULL;
+        size_t process_info_size = 0;
+
+        // Choose the latest available version
+        if (nvmlDeviceGetComputeRunningProcesses_v3) {
+          getProcesses = nvmlDeviceGetComputeRunningProcesses[3];
+          process_info_size = sizeof(nvmlProcessInfo_v3_t);
+        } else if (nvmlDeviceGetComputeRunningProcesses_v2) {
+          getProcesses = nvmlDeviceGetComputeRunningProcesses[2];
+          process_info_size = sizeof(nvmlProcessInfo_v2_t);
+        } else {
+          getProcesses = nvmlDeviceGetComputeRunningProcesses[1];
+          process_info_size = sizeof(nvmlProcessInfo_v1_t);
+        }
 
-      // First call to get count
-      nvmlReturn_t ret = getProcesses(device, &process_count, NULL);
-      if (ret == NVML_SUCCESS || ret == NVML_ERROR_INSUFFICIENT_SIZE) {
-        if (process_count > 0) {
-          void *process_infos = malloc(process_count * process_info_size);
-          if (process_infos) {
-            ret = getProcesses(device, &process_count, process_infos);
-            if (ret == NVML_SUCCESS) {
-              // Sum up memory from all processes
-              for (unsigned int i = 0; i < process_count; i++) {
-                if (nvmlDeviceGetComputeRunningProcesses_v3) {
-                  gpu_used_memory += ((nvmlProcessInfo_v3_t *)process_infos)[i].usedGpuMemory;
-                } else if (nvmlDeviceGetComputeRunningProcesses_v2) {
-                  gpu_used_memory += ((nvmlProcessInfo_v2_t *)process_infos)[i].usedGpuMemory;
-                } else {
-                  gpu_used_memory += ((nvmlProcessInfo_v1_t *)process_infos)[i].usedGpuMemory;
+        // First call to get count
+        nvmlReturn_t ret = getProcesses(device, &process_count, NULL);
+        if (ret == NVML_SUCCESS || ret == NVML_ERROR_INSUFFICIENT_SIZE) {
+          if (process_count > 0) {
+            void *process_infos = malloc(process_count * process_info_size);
+            if (process_infos) {
+              ret = getProcesses(device, &process_count, process_infos);
+              if (ret == NVML_SUCCESS) {
+                // Sum up memory from all processes
+                for (unsigned int i = 0; i < process_count; i++) {
+                  if (nvmlDeviceGetComputeRunningProcesses_v3) {
+                    gpu_used_memory += ((nvmlProcessInfo_v3_t *)process_infos)[i].usedGpuMemory;
+                  } else if (nvmlDeviceGetComputeRunningProcesses_v2) {
+                    gpu_used_memory += ((nvmlProcessInfo_v2_t *)process_infos)[i].usedGpuMemory;
+                  } else {
+                    gpu_used_memory += ((nvmlProcessInfo_v1_t *)process_infos)[i].usedGpuMemory;
+                  }
                 }
               }
+              free(process_infos);
             }
-            free(process_infos);
           }
         }
       }
-    }
 
-    // Also check graphics processes
-    if (nvmlDeviceGetGraphicsRunningProcesses_v3 || nvmlDeviceGetGraphicsRunningProcesses_v2 ||
-        nvmlDeviceGetGraphicsRunningProcesses_v1) {
-      unsigned int process_count = 0;
-      nvmlReturn_t (*getProcesses)(nvmlDevice_t, unsigned int *, void *) = NULL;
-      size_t process_info_size = 0;
-
-      if (nvmlDeviceGetGraphicsRunningProcesses_v3) {
-        getProcesses = nvmlDeviceGetGraphicsRunningProcesses[3];
-        process_info_size = sizeof(nvmlProcessInfo_v3_t);
-      } else if (nvmlDeviceGetGraphicsRunningProcesses_v2) {
-        getProcesses = nvmlDeviceGetGraphicsRunningProcesses[2];
-        process_info_size = sizeof(nvmlProcessInfo_v2_t);
-      } else {
-        getProcesses = nvmlDeviceGetGraphicsRunningProcesses[1];
-        process_info_size = sizeof(nvmlProcessInfo_v1_t);
-      }
+      // Also check graphics processes
+      if (nvmlDeviceGetGraphicsRunningProcesses_v3 || nvmlDeviceGetGraphicsRunningProcesses_v2 ||
+          nvmlDeviceGetGraphicsRunningProcesses_v1) {
+        unsigned int process_count = 0;
+        nvmlReturn_t (*getProcesses)(nvmlDevice_t, unsigned int *, void *) = NULL;
+        size_t process_info_size = 0;
+
+        if (nvmlDeviceGetGraphicsRunningProcesses_v3) {
+          getProcesses = nvmlDeviceGetGraphicsRunningProcesses[3];
+          process_info_size = sizeof(nvmlProcessInfo_v3_t);
+        } else if (nvmlDeviceGetGraphicsRunningProcesses_v2) {
+          getProcesses = nvmlDeviceGetGraphicsRunningProcesses[2];
+          process_info_size = sizeof(nvmlProcessInfo_v2_t);
+        } else {
+          getProcesses = nvmlDeviceGetGraphicsRunningProcesses[1];
+          process_info_size = sizeof(nvmlProcessInfo_v1_t);
+        }
 
-      nvmlReturn_t ret = getProcesses(device, &process_count, NULL);
-      if (ret == NVML_SUCCESS || ret == NVML_ERROR_INSUFFICIENT_SIZE) {
-        if (process_count > 0) {
-          void *process_infos = malloc(process_count * process_info_size);
-          if (process_infos) {
-            ret = getProcesses(device, &process_count, process_infos);
-            if (ret == NVML_SUCCESS) {
-              for (unsigned int i = 0; i < process_count; i++) {
-                if (nvmlDeviceGetGraphicsRunningProcesses_v3) {
-                  gpu_used_memory += ((nvmlProcessInfo_v3_t *)process_infos)[i].usedGpuMemory;
-                } else if (nvmlDeviceGetGraphicsRunningProcesses_v2) {
-                  gpu_used_memory += ((nvmlProcessInfo_v2_t *)process_infos)[i].usedGpuMemory;
-                } else {
-                  gpu_used_memory += ((nvmlProcessInfo_v1_t *)process_infos)[i].usedGpuMemory;
+        nvmlReturn_t ret = getProcesses(device, &process_count, NULL);
+        if (ret == NVML_SUCCESS || ret == NVML_ERROR_INSUFFICIENT_SIZE) {
+          if (process_count > 0) {
+            void *process_infos = malloc(process_count * process_info_size);
+            if (process_infos) {
+              ret = getProcesses(device, &process_count, process_infos);
+              if (ret == NVML_SUCCESS) {
+                for (unsigned int i = 0; i < process_count; i++) {
+                  if (nvmlDeviceGetGraphicsRunningProcesses_v3) {
+                    gpu_used_memory += ((nvmlProcessInfo_v3_t *)process_infos)[i].usedGpuMemory;
+                  } else if (nvmlDeviceGetGraphicsRunningProcesses_v2) {
+                    gpu_used_memory += ((nvmlProcessInfo_v2_t *)process_infos)[i].usedGpuMemory;
+                  } else {
+                    gpu_used_memory += ((nvmlProcessInfo_v1_t *)process_infos)[i].usedGpuMemory;
+                  }
                 }
               }
+              free(process_infos);
             }
-            free(process_infos);
           }
         }
       }
-    }
 
-    // Read MemAvailable from /proc/meminfo for available memory
-    FILE *meminfo = fopen("/proc/meminfo", "r");
-    if (meminfo) {
-      unsigned long long available_ram = 0;
-      char line[256];
+      // Read MemAvailable from /proc/meminfo for available memory
+      FILE *meminfo = fopen("/proc/meminfo", "r");
+      if (meminfo) {
+        unsigned long long available_ram = 0;
+        char line[256];
 
-      while (fgets(line, sizeof(line), meminfo)) {
-        if (sscanf(line, "MemAvailable: %llu kB", &available_ram) == 1) {
-          available_ram *= 1024; // Convert KB to bytes
-          break;
+        while (fgets(line, sizeof(line), meminfo)) {
+          if (sscanf(line, "MemAvailable: %llu kB", &available_ram) == 1) {
+            available_ram *= 1024; // Convert KB to bytes
+            break;
+          }
         }
-      }
-      fclose(meminfo);
+        fclose(meminfo);
 
-      if (available_ram > 0) {
-        unsigned long long total_memory = gpu_used_memory + available_ram;
+        if (available_ram > 0) {
+          unsigned long long total_memory = gpu_used_memory + available_ram;
 
-        SET_GPUINFO_DYNAMIC(dynamic_info, total_memory, total_memory);
-        SET_GPUINFO_DYNAMIC(dynamic_info, used_memory, gpu_used_memory);
-        SET_GPUINFO_DYNAMIC(dynamic_info, free_memory, available_ram);
-        if (total_memory > 0) {
-          SET_GPUINFO_DYNAMIC(dynamic_info, mem_util_rate, gpu_used_memory * 100 / total_memory);
+          SET_GPUINFO_DYNAMIC(dynamic_info, total_memory, total_memory);
+          SET_GPUINFO_DYNAMIC(dynamic_info, used_memory, gpu_used_memory);
+          SET_GPUINFO_DYNAMIC(dynamic_info, free_memory, available_ram);
+          if (total_memory > 0) {
+            SET_GPUINFO_DYNAMIC(dynamic_info, mem_util_rate, gpu_used_memory * 100 / total_memory);
+          }
         }
       }
     }
   }
 
   // Pcie generation used by the device
-  last_nvml_return_status = nvmlDeviceGetCurrPcieLinkGeneration(device, &dynamic_info->pcie_link_gen);
-  if (last_nvml_return_status == NVML_SUCCESS)
-    SET_VALID(gpuinfo_pcie_link_gen_valid, dynamic_info->valid);
+  if (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, pcie_link_gen)) {
+    last_nvml_return_status = nvmlDeviceGetCurrPcieLinkGeneration(device, &dynamic_info->pcie_link_gen);
+    if (last_nvml_return_status == NVML_SUCCESS)
+      SET_VALID(gpuinfo_pcie_link_gen_valid, dynamic_info->valid);
+  }
 
   // Pcie width used by the device
-  last_nvml_return_status = nvmlDeviceGetCurrPcieLinkWidth(device, &dynamic_info->pcie_link_width);
-  if (last_nvml_return_status == NVML_SUCCESS)
-    SET_VALID(gpuinfo_pcie_link_width_valid, dynamic_info->valid);
+  if (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, pcie_link_width)) {
+    last_nvml_return_status = nvmlDeviceGetCurrPcieLinkWidth(device, &dynamic_info->pcie_link_width);
+    if (last_nvml_return_status == NVML_SUCCESS)
+      SET_VALID(gpuinfo_pcie_link_width_valid, dynamic_info->valid);
+  }
 
   // Pcie reception throughput
-  last_nvml_return_status = nvmlDeviceGetPcieThroughput(device, NVML_PCIE_UTIL_RX_BYTES, &dynamic_info->pcie_rx);
-  if (last_nvml_return_status == NVML_SUCCESS)
-    SET_VALID(gpuinfo_pcie_rx_valid, dynamic_info->valid);
+  if (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, pcie_rx)) {
+    last_nvml_return_status = nvmlDeviceGetPcieThroughput(device, NVML_PCIE_UTIL_RX_BYTES, &dynamic_info->pcie_rx);
+    if (last_nvml_return_status == NVML_SUCCESS)
+      SET_VALID(gpuinfo_pcie_rx_valid, dynamic_info->valid);
+  }
 
   // Pcie transmission throughput
-  last_nvml_return_status = nvmlDeviceGetPcieThroughput(device, NVML_PCIE_UTIL_TX_BYTES, &dynamic_info->pcie_tx);
-  if (last_nvml_return_status == NVML_SUCCESS)
-    SET_VALID(gpuinfo_pcie_tx_valid, dynamic_info->valid);
+  if (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, pcie_tx)) {
+    last_nvml_return_status = nvmlDeviceGetPcieThroughput(device, NVML_PCIE_UTIL_TX_BYTES, &dynamic_info->pcie_tx);
+    if (last_nvml_return_status == NVML_SUCCESS)
+      SET_VALID(gpuinfo_pcie_tx_valid, dynamic_info->valid);
+  }
 
   // Fan speed
-  last_nvml_return_status = nvmlDeviceGetFanSpeed(device, &dynamic_info->fan_speed);
-  if (last_nvml_return_status == NVML_SUCCESS)
-    SET_VALID(gpuinfo_fan_speed_valid, dynamic_info->valid);
+  if (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, fan_speed)) {
+    last_nvml_return_status = nvmlDeviceGetFanSpeed(device, &dynamic_info->fan_speed);
+    if (last_nvml_return_status == NVML_SUCCESS)
+      SET_VALID(gpuinfo_fan_speed_valid, dynamic_info->valid);
+  }
 
   // GPU temperature
-  last_nvml_return_status = nvmlDeviceGetTemperature(device, NVML_TEMPERATURE_GPU, &dynamic_info->gpu_temp);
-  if (last_nvml_return_status == NVML_SUCCESS)
-    SET_VALID(gpuinfo_gpu_temp_valid, dynamic_info->valid);
+  if (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, gpu_temp)) {
+    last_nvml_return_status = nvmlDeviceGetTemperature(device, NVML_TEMPERATURE_GPU, &dynamic_info->gpu_temp);
+    if (last_nvml_return_status == NVML_SUCCESS)
+      SET_VALID(gpuinfo_gpu_temp_valid, dynamic_info->valid);
+  }
 
   // Device power usage
-  last_nvml_return_status = nvmlDeviceGetPowerUsage(device, &dynamic_info->power_draw);
-  if (last_nvml_return_status == NVML_SUCCESS)
-    SET_VALID(gpuinfo_power_draw_valid, dynamic_info->valid);
+  if (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, power_draw)) {
+    last_nvml_return_status = nvmlDeviceGetPowerUsage(device, &dynamic_info->power_draw);
+    if (last_nvml_return_status == NVML_SUCCESS)
+      SET_VALID(gpuinfo_power_draw_valid, dynamic_info->valid);
+  }
 
   // Maximum enforced power usage
-  last_nvml_return_status = nvmlDeviceGetEnforcedPowerLimit(device, &dynamic_info->power_draw_max);
-  if (last_nvml_return_status == NVML_SUCCESS)
-    SET_VALID(gpuinfo_power_draw_max_valid, dynamic_info->valid);
+  if (GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, power_draw_max)) {
+    last_nvml_return_status = nvmlDeviceGetEnforcedPowerLimit(device, &dynamic_info->power_draw_max);
+    if (last_nvml_return_status == NVML_SUCCESS)
+      SET_VALID(gpuinfo_power_draw_max_valid, dynamic_info->valid);
+  }
 
   // MIG mode
-  if (nvmlDeviceGetMigMode) {
+  if (nvmlDeviceGetMigMode && GPUINFO_DYNAMIC_FIELD_DUE(_gpu_info, multi_instance_mode)) {
     unsigned currentMode, pendingMode;
     last_nvml_return_status = nvmlDeviceGetMigMode(device, &currentMode, &pendingMode);
     if (last_nvml_return_status == NVML_SUCCESS) {
@@ -1000,3 +1072,22 @@ static void gpuinfo_nvidia_get_running_processes(struct gpu_info *_gpu_info) {
         !gpu_info->base.dynamic_info.multi_instance_mode))
     gpuinfo_nvidia_get_process_utilization(gpu_info, _gpu_info->processes_count, _gpu_info->processes);
 }
+
+// The energy counter is preferred since the power usage is averaged over a second by the recent drivers
+static bool gpuinfo_nvidia_sample_power(struct gpu_info *_gpu_info, struct gpuinfo_power_reading *reading) {
+  struct gpu_info_nvidia *gpu_info = container_of(_gpu_info, struct gpu_info_nvidia, base);
+  unsigned long long energy;
+  if (nvmlDeviceGetTotalEnergyConsumption &&
+      nvmlDeviceGetTotalEnergyConsumption(gpu_info->gpuhandle, &energy) == NVML_SUCCESS) {
+    reading->is_energy = true;
+    reading->counter_bits = 64;
+    reading->value = energy * 1000;
+    return true;
+  }
+  unsigned power;
+  if (nvmlDeviceGetPowerUsage(gpu_info->gpuhandle, &power) != NVML_SUCCESS)
+    return false;
+  reading->is_energy = false;
+  reading->value = power;
+  return true;
+}
@@ -93,14 +93,11 @@ static bool parse_drm_fdinfo_panthor(struct gpu_info *info, FILE *fdinfo_file, s
   struct gpuinfo_dynamic_info *dynamic_info = &gpu_info->base.dynamic_info;
   struct fdinfo_data res = {0};
 
-  nvtop_time current_time;
-  nvtop_get_current_time(&current_time);
-
   if (!mali_common_parse_drm_fdinfo(info, fdinfo_file, process_info, dynamic_info,
                                     panthor_check_fdinfo_keys, &res))
     return false;
 
-  mali_common_parse_fdinfo_handle_cache(gpu_info, process_info, current_time, res.total_cycles,
+  mali_common_parse_fdinfo_handle_cache(gpu_info, process_info, res.total_cycles,
 					res.cid, res.engine_count >= 1 ? true : false);
 
   return true;
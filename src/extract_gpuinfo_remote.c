@@ -0,0 +1,682 @@
+/*
+ *
+ * Copyright (C) 2025 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "nvtop/extract_gpuinfo_remote.h"
+#include "nvtop/common.h"
+#include "nvtop/extract_gpuinfo.h"
+#include "nvtop/gpuinfo_protocol.h"
+#include "nvtop/time.h"
+
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// A daemon sends the devices and its latest sample as soon as a client connects. The connections are non-blocking
+// and multiplexed with poll, so that a fleet of hosts is followed by a single thread: a refresh only decodes the
+// data of the hosts that sent something and only updates the devices of the hosts whose sample changed.
+
+#define REMOTE_HANDSHAKE_TIMEOUT_MS 2000
+// Hosts that did not send their devices in this time join once they do
+#define REMOTE_FLEET_TIMEOUT_MS 3000
+#define REMOTE_RECONNECT_DELAY_NS UINT64_C(1000000000)
+#define REMOTE_READ_SIZE 16384
+
+struct remote_connection {
+  char *label;   // Prefixed to the device names when following several hosts
+  char *address; // Socket path or host name
+  char *port;    // NULL for a Unix socket
+  struct addrinfo *addresses;        // Resolved once when following the host, NULL for a Unix socket
+  const struct addrinfo *next_address; // Connected to, or tried next when the connection fails
+  int fd;
+  bool connecting;       // Non-blocking connection in progress
+  unsigned char *input;  // Received bytes not decoded yet
+  size_t input_size;
+  size_t input_capacity;
+  struct gpuinfo_protocol_state state;
+  bool has_devices;
+  bool has_sample;
+  bool local_pids; // The daemon runs in the pid namespace of nvtop
+  bool dynamic_changed;   // A sample arrived since the devices were updated
+  bool processes_changed; // Same for the processes, which are not updated while the interface freezes them
+  bool stale;
+  uint64_t received_at; // NVTOP_CLOCK time of the latest sample in nanoseconds
+  uint64_t sample_period;
+  uint64_t reconnect_at;
+  bool joined; // The devices of the host were created
+  unsigned devices_count;
+  struct gpu_info_remote *devices;
+  unsigned largest_user_name;
+};
+
+struct gpu_info_remote {
+  struct gpu_info base;
+  unsigned connection;
+  unsigned state_index; // Index of the device in the state of the connection
+  char *strings;        // Command lines and user names of the processes
+  size_t strings_size;
+};
+
+static struct {
+  unsigned connections_count;
+  struct remote_connection *connections;
+  struct pollfd *poll_fds; // One per connection
+} remote;
+
+static bool gpuinfo_remote_init(void) { return true; }
+
+static void gpuinfo_remote_shutdown(void) {}
+
+static const char *gpuinfo_remote_last_error_string(void) { return "No error"; }
+
+static bool gpuinfo_remote_get_device_handles(struct list_head *devices, unsigned *count) {
+  (void)devices;
+  *count = 0;
+  return true;
+}
+
+// The devices are only updated from the samples by gpuinfo_remote_refresh
+static void gpuinfo_remote_nothing_to_refresh(struct gpu_info *gpu_info) { (void)gpu_info; }
+
+#define GPU_VENDOR_REMOTE_CALLBACKS                                                                                    \
+  .init = gpuinfo_remote_init,                                                                                         \
+  .shutdown = gpuinfo_remote_shutdown,                                                                                 \
+  .last_error_string = gpuinfo_remote_last_error_string,                                                               \
+  .get_device_handles = gpuinfo_remote_get_device_handles,                                                             \
+  .populate_static_info = gpuinfo_remote_nothing_to_refresh,                                                           \
+  .refresh_dynamic_info = gpuinfo_remote_nothing_to_refresh,                                                           \
+  .refresh_running_processes = gpuinfo_remote_nothing_to_refresh
+
+// The devices of a daemon running on another host, or in another pid namespace
+static struct gpu_vendor gpu_vendor_remote = {
+    GPU_VENDOR_REMOTE_CALLBACKS,
+    .foreign_pids = true,
+    .name = "Daemon",
+};
+
+// The devices of a daemon sharing the pids of nvtop, whose processes can be signaled
+static struct gpu_vendor gpu_vendor_remote_local = {
+    GPU_VENDOR_REMOTE_CALLBACKS,
+    .foreign_pids = false,
+    .name = "Daemon",
+};
+
+static uint64_t remote_now(void) {
+  nvtop_time now;
+  nvtop_get_current_time(&now);
+  return nvtop_time_u64(now);
+}
+
+static char *remote_strdup(const char *string) {
+  if (!string)
+    return NULL;
+  char *copy = strdup(string);
+  if (!copy) {
+    perror("Cannot allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+  return copy;
+}
+
+static void connection_close(struct remote_connection *connection) {
+  if (connection->fd >= 0)
+    close(connection->fd);
+  connection->fd = -1;
+  connection->connecting = false;
+  connection->input_size = 0;
+  connection->has_devices = false;
+  connection->has_sample = false;
+  connection->reconnect_at = remote_now() + REMOTE_RECONNECT_DELAY_NS;
+}
+
+// Returns the socket, connect_error is 0 once connected or the errno of the connection attempt
+static int connection_socket(const struct remote_connection *connection, int *connect_error) {
+  if (!connection->port) {
+    struct sockaddr_un address = {.sun_family = AF_UNIX};
+    if (strlen(connection->address) >= sizeof(address.sun_path))
+      return -1;
+    strcpy(address.sun_path, connection->address);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (fd >= 0)
+      *connect_error = connect(fd, (struct sockaddr *)&address, sizeof(address)) ? errno : 0;
+    return fd;
+  }
+  const struct addrinfo *address = connection->next_address;
+  int fd = socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC | SOCK_NONBLOCK, address->ai_protocol);
+  if (fd >= 0) {
+    int enable = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    *connect_error = connect(fd, address->ai_addr, address->ai_addrlen) ? errno : 0;
+  }
+  return fd;
+}
+
+// Drops the socket of the address tried and moves to the next address of the host. Returns false if none is left.
+static bool connection_next_address(struct remote_connection *connection) {
+  if (connection->fd >= 0)
+    close(connection->fd);
+  connection->fd = -1;
+  if (!connection->next_address || !connection->next_address->ai_next)
+    return false;
+  connection->next_address = connection->next_address->ai_next;
+  return true;
+}
+
+// Connects to next_address, or to the following addresses of the host while the connection fails right away
+static void connection_connect(struct remote_connection *connection) {
+  while (true) {
+    int connect_error = 0;
+    connection->fd = connection_socket(connection, &connect_error);
+    connection->connecting = connect_error != 0;
+    if (connection->fd >= 0 && (!connect_error || connect_error == EINPROGRESS || connect_error == EAGAIN))
+      return;
+    if (!connection_next_address(connection)) {
+      connection_close(connection);
+      return;
+    }
+  }
+}
+
+static void connection_open(struct remote_connection *connection) {
+  connection->next_address = connection->addresses;
+  connection_connect(connection);
+}
+
+// Reads what the daemon sent. Returns false if the connection is lost.
+static bool connection_receive(struct remote_connection *connection) {
+  while (true) {
+    if (connection->input_capacity - connection->input_size < REMOTE_READ_SIZE) {
+      connection->input_capacity = connection->input_size + 2 * REMOTE_READ_SIZE;
+      connection->input = realloc(connection->input, connection->input_capacity);
+      if (!connection->input) {
+        perror("Cannot allocate memory: ");
+        exit(EXIT_FAILURE);
+      }
+    }
+    ssize_t received = recv(connection->fd, connection->input + connection->input_size,
+                            connection->input_capacity - connection->input_size, MSG_DONTWAIT);
+    if (received > 0) {
+      connection->input_size += received;
+      continue;
+    }
+    if (received < 0 && errno == EINTR)
+      continue;
+    return received < 0 && errno == EAGAIN;
+  }
+}
+
+// A daemon reached through a Unix socket reports the pids of nvtop when it runs in the same pid namespace: its pid is
+// then visible and the NSpid line of its status has a single entry. Unlike /proc/<pid>/ns/pid, the status is
+// readable whoever owns the daemon.
+static bool connection_peer_shares_pids(const struct remote_connection *connection) {
+  if (connection->port)
+    return false;
+  struct ucred credentials;
+  socklen_t credentials_size = sizeof(credentials);
+  if (getsockopt(connection->fd, SOL_SOCKET, SO_PEERCRED, &credentials, &credentials_size) || credentials.pid <= 0)
+    return false;
+  char path[64];
+  snprintf(path, sizeof(path), "/proc/%d/status", (int)credentials.pid);
+  FILE *status = fopen(path, "r");
+  if (!status)
+    return false;
+  bool shared = false;
+  char line[256];
+  while (fgets(line, sizeof(line), status)) {
+    int pids[2];
+    if (!strncmp(line, "NSpid:", 6)) {
+      shared = sscanf(line + 6, "%d %d", &pids[0], &pids[1]) == 1;
+      break;
+    }
+  }
+  fclose(status);
+  return shared;
+}
+
+// Applies the complete messages received. Returns false on a protocol error.
+static bool connection_decode(struct remote_connection *connection) {
+  size_t position = 0;
+  bool valid = true;
+  while (valid) {
+    size_t length =
+        gpuinfo_protocol_message_length(connection->input + position, connection->input_size - position);
+    if (!length)
+      break;
+    enum gpuinfo_protocol_message type;
+    valid = gpuinfo_protocol_decode(connection->input + position, length, &connection->state, &type);
+    if (valid && type == gpuinfo_protocol_hello) {
+      connection->has_devices = true;
+      connection->has_sample = false;
+      connection->local_pids = connection_peer_shares_pids(connection);
+    } else if (valid && type == gpuinfo_protocol_sample) {
+      // A sample before the devices cannot be decoded
+      valid = connection->has_devices;
+      connection->has_sample = true;
+      connection->dynamic_changed = true;
+      connection->processes_changed = true;
+      uint64_t received_at = remote_now();
+      connection->sample_period = connection->received_at ? received_at - connection->received_at : 0;
+      connection->received_at = received_at;
+    }
+    position += length;
+  }
+  memmove(connection->input, connection->input + position, connection->input_size - position);
+  connection->input_size -= position;
+  return valid;
+}
+
+static void connection_event(struct remote_connection *connection, short events) {
+  if (connection->connecting) {
+    int error = 0;
+    socklen_t error_size = sizeof(error);
+    if (getsockopt(connection->fd, SOL_SOCKET, SO_ERROR, &error, &error_size) || error) {
+      if (connection_next_address(connection))
+        connection_connect(connection);
+      else
+        connection_close(connection);
+      return;
+    }
+    connection->connecting = false;
+  }
+  if ((events & (POLLIN | POLLHUP | POLLERR)) && (!connection_receive(connection) || !connection_decode(connection)))
+    connection_close(connection);
+}
+
+// Handles the events of the connections for at most timeout_ms milliseconds
+static void remote_poll(int timeout_ms) {
+  for (unsigned i = 0; i < remote.connections_count; ++i) {
+    const struct remote_connection *connection = &remote.connections[i];
+    // Writable once connected; poll skips the closed connections, whose fd is negative
+    remote.poll_fds[i] =
+        (struct pollfd){.fd = connection->fd, .events = POLLIN | (connection->connecting ? POLLOUT : 0)};
+  }
+  if (poll(remote.poll_fds, remote.connections_count, timeout_ms) <= 0)
+    return;
+  for (unsigned i = 0; i < remote.connections_count; ++i) {
+    if (remote.poll_fds[i].revents)
+      connection_event(&remote.connections[i], remote.poll_fds[i].revents);
+  }
+}
+
+// Waits for every connection to receive its first sample
+static void remote_wait_first_samples(int timeout_ms) {
+  uint64_t deadline = remote_now() + (uint64_t)timeout_ms * UINT64_C(1000000);
+  while (true) {
+    bool waiting = false;
+    for (unsigned i = 0; i < remote.connections_count && !waiting; ++i)
+      waiting = remote.connections[i].fd >= 0 && !remote.connections[i].has_sample;
+    uint64_t now = remote_now();
+    if (!waiting || now >= deadline)
+      return;
+    remote_poll((deadline - now + UINT64_C(999999)) / UINT64_C(1000000));
+  }
+}
+
+// Returns false if the host name cannot be resolved
+static bool remote_add_connection(const char *label, const char *address, const char *port) {
+  // The addresses are resolved once, a blocking resolution on each reconnection would stall the interface
+  struct addrinfo *addresses = NULL;
+  if (port) {
+    struct addrinfo hints = {.ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM};
+    int error = getaddrinfo(address, port, &hints, &addresses);
+    if (error) {
+      fprintf(stderr, "Cannot resolve %s: %s\n", address, gai_strerror(error));
+      return false;
+    }
+  }
+  remote.connections = reallocarray(remote.connections, remote.connections_count + 1, sizeof(*remote.connections));
+  remote.poll_fds = reallocarray(remote.poll_fds, remote.connections_count + 1, sizeof(*remote.poll_fds));
+  if (!remote.connections || !remote.poll_fds) {
+    perror("Cannot allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+  struct remote_connection *connection = &remote.connections[remote.connections_count++];
+  *connection = (struct remote_connection){.label = remote_strdup(label),
+                                           .address = remote_strdup(address),
+                                           .port = remote_strdup(port),
+                                           .addresses = addresses,
+                                           .fd = -1};
+  return true;
+}
+
+static void connection_free(struct remote_connection *connection) {
+  for (unsigned i = 0; i < connection->devices_count; ++i) {
+    list_del(&connection->devices[i].base.list);
+    free(connection->devices[i].base.processes);
+    free(connection->devices[i].strings);
+  }
+  free(connection->devices);
+  if (connection->addresses)
+    freeaddrinfo(connection->addresses);
+  connection_close(connection);
+  gpuinfo_protocol_state_clear(&connection->state);
+  free(connection->input);
+  free(connection->label);
+  free(connection->address);
+  free(connection->port);
+}
+
+static void remote_free_connections(void) {
+  for (unsigned i = 0; i < remote.connections_count; ++i)
+    connection_free(&remote.connections[i]);
+  free(remote.connections);
+  free(remote.poll_fds);
+  remote.connections = NULL;
+  remote.poll_fds = NULL;
+  remote.connections_count = 0;
+}
+
+// Connects to a single daemon through its Unix socket
+static bool remote_try_socket(const char *socket_path) {
+  remote_free_connections();
+  remote_add_connection(NULL, socket_path, NULL);
+  connection_open(&remote.connections[0]);
+  remote_wait_first_samples(REMOTE_HANDSHAKE_TIMEOUT_MS);
+  return remote.connections[0].has_sample;
+}
+
+static const struct gpuinfo_protocol_device *remote_find_device(struct gpu_info_remote *device) {
+  const struct gpuinfo_protocol_state *state = &remote.connections[device->connection].state;
+  if (device->state_index < state->devices_count &&
+      strncmp(state->devices[device->state_index].pdev, device->base.pdev, PDEV_LEN) == 0)
+    return &state->devices[device->state_index];
+  // The daemon may have restarted with other devices
+  for (unsigned i = 0; i < state->devices_count; ++i) {
+    if (strncmp(state->devices[i].pdev, device->base.pdev, PDEV_LEN) == 0) {
+      device->state_index = i;
+      return &state->devices[i];
+    }
+  }
+  return NULL;
+}
+
+static void remote_update_processes(struct gpu_info_remote *device, const struct gpuinfo_protocol_device *received) {
+  unsigned processes_count = received->processes_count;
+  size_t strings_size = 0;
+  for (unsigned i = 0; i < processes_count; ++i) {
+    if (received->processes[i].cmdline)
+      strings_size += strlen(received->processes[i].cmdline) + 1;
+    if (received->processes[i].user_name)
+      strings_size += strlen(received->processes[i].user_name) + 1;
+  }
+  if (strings_size > device->strings_size) {
+    device->strings_size = strings_size;
+    device->strings = realloc(device->strings, strings_size);
+    if (!device->strings) {
+      perror("Cannot allocate memory: ");
+      exit(EXIT_FAILURE);
+    }
+  }
+  if (processes_count > device->base.processes_array_size) {
+    device->base.processes_array_size = processes_count + COMMON_PROCESS_LINEAR_REALLOC_INC;
+    device->base.processes =
+        reallocarray(device->base.processes, device->base.processes_array_size, sizeof(*device->base.processes));
+    if (!device->base.processes) {
+      perror("Cannot allocate memory: ");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  size_t strings_used = 0;
+  for (unsigned i = 0; i < processes_count; ++i) {
+    struct gpu_process *process = &device->base.processes[i];
+    *process = received->processes[i];
+    if (received->processes[i].cmdline) {
+      process->cmdline = strcpy(device->strings + strings_used, received->processes[i].cmdline);
+      strings_used += strlen(process->cmdline) + 1;
+    }
+    if (received->processes[i].user_name) {
+      process->user_name = strcpy(device->strings + strings_used, received->processes[i].user_name);
+      strings_used += strlen(process->user_name) + 1;
+    }
+  }
+  device->base.processes_count = processes_count;
+}
+
+// Returns true if the longest user name of the host changed
+static bool remote_update_connection_devices(struct remote_connection *connection, bool refresh_processes,
+                                             uint64_t now) {
+  // The daemon stopped sending samples, e.g. it exited or is suspended
+  uint64_t age = now - connection->received_at;
+  bool stale = connection->fd < 0 || connection->connecting ||
+               age > 2 * connection->sample_period + UINT64_C(1000000000);
+  bool update_processes = refresh_processes && connection->processes_changed;
+  bool was_stale = connection->stale;
+  connection->stale = stale;
+  bool update_dynamic = connection->dynamic_changed || stale || was_stale;
+  if (!update_dynamic && !update_processes)
+    return false;
+
+  unsigned largest_user_name = 0;
+  for (unsigned i = 0; i < connection->devices_count; ++i) {
+    struct gpu_info_remote *remote_device = &connection->devices[i];
+    struct gpu_info *device = &remote_device->base;
+    const struct gpuinfo_protocol_device *received = remote_find_device(remote_device);
+    if (!received) {
+      RESET_ALL(device->dynamic_info.valid);
+      device->processes_count = 0;
+      continue;
+    }
+    if (update_dynamic)
+      device->dynamic_info = received->dynamic_info;
+    // The daemon may have been restarted elsewhere since the devices were created
+    device->vendor = connection->local_pids ? &gpu_vendor_remote_local : &gpu_vendor_remote;
+    if (stale)
+      SET_GPUINFO_DYNAMIC(&device->dynamic_info, stale_data_age, (age + UINT64_C(999999999)) / UINT64_C(1000000000));
+    if (update_processes)
+      remote_update_processes(remote_device, received);
+    for (unsigned j = 0; update_processes && j < device->processes_count; ++j) {
+      if (GPUINFO_PROCESS_FIELD_VALID(&device->processes[j], user_name)) {
+        size_t length = strlen(device->processes[j].user_name);
+        if (length > largest_user_name)
+          largest_user_name = length;
+      }
+    }
+  }
+  connection->dynamic_changed = false;
+  if (!update_processes)
+    return false;
+  connection->processes_changed = false;
+  bool user_name_changed = largest_user_name != connection->largest_user_name;
+  connection->largest_user_name = largest_user_name;
+  return user_name_changed;
+}
+
+static void remote_update_devices(bool refresh_processes) {
+  uint64_t now = remote_now();
+  bool user_name_changed = false;
+  for (unsigned i = 0; i < remote.connections_count; ++i) {
+    if (remote_update_connection_devices(&remote.connections[i], refresh_processes, now))
+      user_name_changed = true;
+  }
+  if (!user_name_changed)
+    return;
+  unsigned largest_user_name = 0;
+  for (unsigned i = 0; i < remote.connections_count; ++i) {
+    if (remote.connections[i].largest_user_name > largest_user_name)
+      largest_user_name = remote.connections[i].largest_user_name;
+  }
+  gpuinfo_set_shared_user_name_length(largest_user_name);
+}
+
+// Writes "host: name", truncated to the device name size
+static void remote_prefix_device_name(char *device_name, const char *label, const char *name) {
+  int written = snprintf(device_name, MAX_DEVICE_NAME, "%s: ", label);
+  if (written < 0 || written >= MAX_DEVICE_NAME - 1)
+    return;
+  size_t length = strlen(name);
+  if (length > (size_t)(MAX_DEVICE_NAME - 1 - written))
+    length = MAX_DEVICE_NAME - 1 - written;
+  memcpy(device_name + written, name, length);
+  device_name[written + length] = '\0';
+}
+
+// Creates the devices of the connections that received their first sample since the previous call.
+// Returns the number of devices added to the list.
+static unsigned remote_create_devices(struct list_head *devices) {
+  unsigned added = 0;
+  for (unsigned i = 0; i < remote.connections_count; ++i) {
+    struct remote_connection *connection = &remote.connections[i];
+    if (connection->joined || !connection->has_sample)
+      continue;
+    connection->joined = true;
+    connection->devices_count = connection->state.devices_count;
+    connection->devices = calloc(connection->devices_count, sizeof(*connection->devices));
+    if (connection->devices_count && !connection->devices) {
+      perror("Cannot allocate memory: ");
+      exit(EXIT_FAILURE);
+    }
+    for (unsigned j = 0; j < connection->devices_count; ++j) {
+      const struct gpuinfo_protocol_device *received = &connection->state.devices[j];
+      struct gpu_info_remote *device = &connection->devices[j];
+      device->base.vendor = connection->local_pids ? &gpu_vendor_remote_local : &gpu_vendor_remote;
+      device->base.static_info = received->static_info;
+      if (connection->label) {
+        remote_prefix_device_name(device->base.static_info.device_name, connection->label,
+                                  GPUINFO_STATIC_FIELD_VALID(&received->static_info, device_name)
+                                      ? received->static_info.device_name
+                                      : "N/A");
+        SET_VALID(gpuinfo_device_name_valid, device->base.static_info.valid);
+      }
+      device->base.subscription = GPUINFO_SUBSCRIPTION_ALL;
+      memcpy(device->base.pdev, received->pdev, PDEV_LEN);
+      device->connection = i;
+      device->state_index = j;
+      list_add_tail(&device->base.list, devices);
+    }
+    added += connection->devices_count;
+  }
+  return added;
+}
+
+bool gpuinfo_remote_attach(const char *socket_path, unsigned *devices_count, struct list_head *devices) {
+  bool connected;
+  if (socket_path) {
+    connected = remote_try_socket(socket_path);
+  } else {
+    char user_socket_path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+    connected = (gpuinfo_protocol_user_socket_path(user_socket_path, sizeof(user_socket_path)) &&
+                 remote_try_socket(user_socket_path)) ||
+                remote_try_socket(GPUINFO_PROTOCOL_SYSTEM_SOCKET);
+  }
+  if (!connected) {
+    gpuinfo_remote_detach();
+    return false;
+  }
+  *devices_count = remote_create_devices(devices);
+  remote_update_devices(true);
+  return true;
+}
+
+static char *remote_read_hosts_file(const char *path) {
+  FILE *file = fopen(path, "r");
+  if (!file)
+    return NULL;
+  size_t size = 0, capacity = 4096;
+  char *content = malloc(capacity);
+  if (!content) {
+    perror("Cannot allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+  size_t read;
+  while ((read = fread(content + size, 1, capacity - size - 1, file)) > 0) {
+    size += read;
+    if (capacity - size == 1) {
+      capacity *= 2;
+      content = realloc(content, capacity);
+      if (!content) {
+        perror("Cannot allocate memory: ");
+        exit(EXIT_FAILURE);
+      }
+    }
+  }
+  fclose(file);
+  content[size] = '\0';
+  return content;
+}
+
+bool gpuinfo_remote_attach_hosts(const char *hosts, unsigned *devices_count, struct list_head *devices) {
+  char *list = hosts[0] == '@' ? remote_read_hosts_file(hosts + 1) : remote_strdup(hosts);
+  if (!list) {
+    fprintf(stderr, "Cannot read the hosts from %s: %s\n", hosts + 1, strerror(errno));
+    return false;
+  }
+  char *line_saveptr, *entry_saveptr;
+  for (char *line = strtok_r(list, "\n", &line_saveptr); line; line = strtok_r(NULL, "\n", &line_saveptr)) {
+    char *comment = strchr(line, '#');
+    if (comment)
+      *comment = '\0';
+    for (char *entry = strtok_r(line, ", \t\r", &entry_saveptr); entry;
+         entry = strtok_r(NULL, ", \t\r", &entry_saveptr)) {
+      if (entry[0] == '/') {
+        remote_add_connection(entry, entry, NULL);
+        continue;
+      }
+      char *label = remote_strdup(entry);
+      char *host, *port;
+      gpuinfo_protocol_split_address(entry, &host, &port);
+      if (host)
+        remote_add_connection(label, host, port ? port : GPUINFO_PROTOCOL_DEFAULT_PORT);
+      free(label);
+    }
+  }
+  free(list);
+
+  for (unsigned i = 0; i < remote.connections_count; ++i)
+    connection_open(&remote.connections[i]);
+  remote_wait_first_samples(REMOTE_FLEET_TIMEOUT_MS);
+  unsigned answered = 0;
+  for (unsigned i = 0; i < remote.connections_count; ++i)
+    answered += remote.connections[i].has_sample;
+  if (answered < remote.connections_count)
+    fprintf(stderr, "%u of the %u hosts did not answer yet and will join once they do\n",
+            remote.connections_count - answered, remote.connections_count);
+  if (!answered) {
+    gpuinfo_remote_detach();
+    return false;
+  }
+  *devices_count = remote_create_devices(devices);
+  remote_update_devices(true);
+  return true;
+}
+
+void gpuinfo_remote_refresh(struct list_head *devices, bool refresh_processes) {
+  (void)devices;
+  remote_poll(0);
+  uint64_t now = remote_now();
+  for (unsigned i = 0; i < remote.connections_count; ++i) {
+    struct remote_connection *connection = &remote.connections[i];
+    if (connection->fd < 0 && now >= connection->reconnect_at)
+      connection_open(connection);
+  }
+  remote_update_devices(refresh_processes);
+}
+
+unsigned gpuinfo_remote_join_hosts(struct list_head *devices) { return remote_create_devices(devices); }
+
+void gpuinfo_remote_detach(void) { remote_free_connections(); }
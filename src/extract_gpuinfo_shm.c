@@ -0,0 +1,547 @@
+/*
+ *
+ * Copyright (C) 2025 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "nvtop/extract_gpuinfo_shm.h"
+#include "nvtop/common.h"
+#include "nvtop/extract_gpuinfo.h"
+#include "nvtop/gpuinfo_energy.h"
+#include "nvtop/time.h"
+
+#include <fcntl.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// The segment holds a header followed by the latest sample. The collector holds an exclusive lock on the segment for
+// as long as it runs, so that the lock is released by the kernel whatever the way it exits.
+// The sample is protected by a sequence lock: the collector makes the sequence odd while it writes, and the readers
+// retry their copy if the sequence was odd or changed meanwhile.
+
+// Bump when the layout of the segment changes
+#define SHM_LAYOUT_VERSION 5
+#define SHM_NAME_FORMAT "/nvtop-%u"
+#define SHM_NO_STRING UINT64_MAX
+#define SHM_MIN_SIZE 4096
+// Time given to a starting collector to publish its first sample
+#define SHM_FIRST_SAMPLE_TIMEOUT_MS 3000
+#define SHM_READ_ATTEMPTS 1000
+
+static const char shm_magic[8] = {'N', 'V', 'T', 'O', 'P', 'S', 'H', 'M'};
+
+struct shm_header {
+  char magic[8];
+  uint32_t version;
+  // The structures are copied as is, their size must match between the instances
+  uint32_t static_info_size;
+  uint32_t dynamic_info_size;
+  uint32_t process_size;
+  _Atomic uint64_t sequence; // Odd while the collector writes the sample
+  uint64_t sample_size;      // Bytes of the sample following the header
+  uint64_t published_at;     // NVTOP_CLOCK time of the sample in nanoseconds
+  uint64_t publish_period;   // Nanoseconds between the last two samples
+};
+
+// A sample is followed by its devices, the processes of all the devices and the strings of the processes
+struct shm_sample {
+  uint32_t devices_count;
+  uint32_t processes_count;
+  uint64_t strings_size;
+};
+
+struct shm_device {
+  char pdev[PDEV_LEN];
+  struct gpuinfo_static_info static_info;
+  struct gpuinfo_dynamic_info dynamic_info;
+  uint32_t first_process;
+  uint32_t processes_count;
+};
+
+struct shm_process {
+  struct gpu_process process; // Without its strings
+  uint64_t cmdline;           // Offset in the strings, SHM_NO_STRING if invalid
+  uint64_t user_name;
+};
+
+struct gpu_info_shm {
+  struct gpu_info base;
+  unsigned published_index; // Index of the device in the samples
+  char *strings;            // Command lines and user names of the processes
+  size_t strings_size;
+};
+
+static struct {
+  int fd;
+  struct shm_header *header;
+  size_t mapped_size;
+  bool collector;
+  char *sample; // Latest sample, built by the collector or copied by a reader
+  size_t sample_size;
+  size_t sample_capacity;
+  uint64_t published_at;
+  uint64_t publish_period;
+  unsigned devices_count;
+  struct gpu_info_shm *devices;
+} shm = {.fd = -1};
+
+// The devices gathered by this instance when it is the collector
+static LIST_HEAD(collected_devices);
+
+static bool gpuinfo_shm_init(void) { return true; }
+
+static void gpuinfo_shm_shutdown(void) {}
+
+static const char *gpuinfo_shm_last_error_string(void) { return "No error"; }
+
+static bool gpuinfo_shm_get_device_handles(struct list_head *devices, unsigned *count) {
+  (void)devices;
+  *count = 0;
+  return true;
+}
+
+// The devices are only updated from the samples by gpuinfo_shm_refresh
+static void gpuinfo_shm_nothing_to_refresh(struct gpu_info *gpu_info) { (void)gpu_info; }
+
+static struct gpu_vendor gpu_vendor_shm = {
+    .init = gpuinfo_shm_init,
+    .shutdown = gpuinfo_shm_shutdown,
+    .last_error_string = gpuinfo_shm_last_error_string,
+    .get_device_handles = gpuinfo_shm_get_device_handles,
+    .populate_static_info = gpuinfo_shm_nothing_to_refresh,
+    .refresh_dynamic_info = gpuinfo_shm_nothing_to_refresh,
+    .refresh_running_processes = gpuinfo_shm_nothing_to_refresh,
+    .name = "Shared",
+};
+
+static bool shm_map(size_t size) {
+  if (shm.header)
+    munmap(shm.header, shm.mapped_size);
+  int protection = shm.collector ? PROT_READ | PROT_WRITE : PROT_READ;
+  void *address = mmap(NULL, size, protection, MAP_SHARED, shm.fd, 0);
+  if (address == MAP_FAILED) {
+    shm.header = NULL;
+    shm.mapped_size = 0;
+    return false;
+  }
+  shm.header = address;
+  shm.mapped_size = size;
+  return true;
+}
+
+// Maps the whole segment, which only grows
+static bool shm_map_segment(void) {
+  struct stat segment_stat;
+  if (fstat(shm.fd, &segment_stat) || (size_t)segment_stat.st_size < sizeof(struct shm_header))
+    return false;
+  if ((size_t)segment_stat.st_size == shm.mapped_size)
+    return true;
+  return shm_map(segment_stat.st_size);
+}
+
+static void shm_reserve_sample(size_t size) {
+  if (size <= shm.sample_capacity)
+    return;
+  shm.sample_capacity = size + size / 2;
+  shm.sample = realloc(shm.sample, shm.sample_capacity);
+  if (!shm.sample) {
+    perror("Cannot allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+}
+
+static void shm_build_sample(void) {
+  unsigned devices_count = 0, processes_count = 0;
+  size_t strings_size = 0;
+  struct gpu_info *device;
+  list_for_each_entry(device, &collected_devices, list) {
+    devices_count++;
+    processes_count += device->processes_count;
+    for (unsigned i = 0; i < device->processes_count; ++i) {
+      if (GPUINFO_PROCESS_FIELD_VALID(&device->processes[i], cmdline))
+        strings_size += strlen(device->processes[i].cmdline) + 1;
+      if (GPUINFO_PROCESS_FIELD_VALID(&device->processes[i], user_name))
+        strings_size += strlen(device->processes[i].user_name) + 1;
+    }
+  }
+  shm.sample_size = sizeof(struct shm_sample) + devices_count * sizeof(struct shm_device) +
+                    processes_count * sizeof(struct shm_process) + strings_size;
+  shm_reserve_sample(shm.sample_size);
+  memset(shm.sample, 0, shm.sample_size);
+
+  struct shm_sample *sample = (struct shm_sample *)shm.sample;
+  struct shm_device *published_devices = (struct shm_device *)(sample + 1);
+  struct shm_process *published_processes = (struct shm_process *)(published_devices + devices_count);
+  char *strings = (char *)(published_processes + processes_count);
+  sample->devices_count = devices_count;
+  sample->processes_count = processes_count;
+  sample->strings_size = strings_size;
+
+  size_t strings_used = 0;
+  unsigned process_idx = 0;
+  struct shm_device *published_device = published_devices;
+  list_for_each_entry(device, &collected_devices, list) {
+    memcpy(published_device->pdev, device->pdev, PDEV_LEN);
+    published_device->static_info = device->static_info;
+    published_device->dynamic_info = device->dynamic_info;
+    published_device->first_process = process_idx;
+    published_device->processes_count = device->processes_count;
+    for (unsigned i = 0; i < device->processes_count; ++i, ++process_idx) {
+      struct shm_process *published_process = &published_processes[process_idx];
+      published_process->process = device->processes[i];
+      published_process->process.cmdline = NULL;
+      published_process->process.user_name = NULL;
+      published_process->cmdline = SHM_NO_STRING;
+      published_process->user_name = SHM_NO_STRING;
+      if (GPUINFO_PROCESS_FIELD_VALID(&device->processes[i], cmdline)) {
+        published_process->cmdline = strings_used;
+        strcpy(strings + strings_used, device->processes[i].cmdline);
+        strings_used += strlen(device->processes[i].cmdline) + 1;
+      }
+      if (GPUINFO_PROCESS_FIELD_VALID(&device->processes[i], user_name)) {
+        published_process->user_name = strings_used;
+        strcpy(strings + strings_used, device->processes[i].user_name);
+        strings_used += strlen(device->processes[i].user_name) + 1;
+      }
+    }
+    published_device++;
+  }
+}
+
+static bool shm_write_sample(void) {
+  size_t needed = sizeof(struct shm_header) + shm.sample_size;
+  if (needed > shm.mapped_size) {
+    size_t size = shm.mapped_size > SHM_MIN_SIZE ? shm.mapped_size : SHM_MIN_SIZE;
+    while (size < needed)
+      size *= 2;
+    if (ftruncate(shm.fd, size) || !shm_map(size))
+      return false;
+  }
+
+  nvtop_time now;
+  nvtop_get_current_time(&now);
+  uint64_t published_at = nvtop_time_u64(now);
+  shm.publish_period = shm.published_at ? published_at - shm.published_at : 0;
+  shm.published_at = published_at;
+
+  struct shm_header *header = shm.header;
+  // A collector that died while writing left the sequence odd
+  uint64_t sequence = (atomic_load_explicit(&header->sequence, memory_order_relaxed) + 1) & ~UINT64_C(1);
+  atomic_store_explicit(&header->sequence, sequence + 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  memcpy(header->magic, shm_magic, sizeof(shm_magic));
+  header->version = SHM_LAYOUT_VERSION;
+  header->static_info_size = sizeof(struct gpuinfo_static_info);
+  header->dynamic_info_size = sizeof(struct gpuinfo_dynamic_info);
+  header->process_size = sizeof(struct gpu_process);
+  header->sample_size = shm.sample_size;
+  header->published_at = shm.published_at;
+  header->publish_period = shm.publish_period;
+  memcpy(header + 1, shm.sample, shm.sample_size);
+  atomic_store_explicit(&header->sequence, sequence + 2, memory_order_release);
+  return true;
+}
+
+static bool shm_sample_is_consistent(void) {
+  if (shm.sample_size < sizeof(struct shm_sample))
+    return false;
+  const struct shm_sample *sample = (const struct shm_sample *)shm.sample;
+  uint64_t expected_size = sizeof(struct shm_sample) + (uint64_t)sample->devices_count * sizeof(struct shm_device) +
+                           (uint64_t)sample->processes_count * sizeof(struct shm_process) + sample->strings_size;
+  if (expected_size != shm.sample_size)
+    return false;
+  // Every string offset then reads a terminated string
+  return sample->strings_size == 0 || shm.sample[shm.sample_size - 1] == '\0';
+}
+
+// Copies the latest sample of the collector
+static bool shm_read_sample(void) {
+  for (unsigned attempt = 0; attempt < SHM_READ_ATTEMPTS; ++attempt) {
+    if (attempt)
+      sched_yield();
+    if (!shm.header && !shm_map_segment())
+      return false;
+    struct shm_header *header = shm.header;
+    uint64_t sequence = atomic_load_explicit(&header->sequence, memory_order_acquire);
+    if (sequence == 0) // Nothing published yet
+      return false;
+    if (sequence & 1)
+      continue;
+    bool compatible = memcmp(header->magic, shm_magic, sizeof(shm_magic)) == 0 &&
+                      header->version == SHM_LAYOUT_VERSION &&
+                      header->static_info_size == sizeof(struct gpuinfo_static_info) &&
+                      header->dynamic_info_size == sizeof(struct gpuinfo_dynamic_info) &&
+                      header->process_size == sizeof(struct gpu_process);
+    size_t sample_size = header->sample_size;
+    uint64_t published_at = header->published_at;
+    uint64_t publish_period = header->publish_period;
+    if (sample_size > shm.mapped_size - sizeof(struct shm_header)) {
+      // The segment grew since it was mapped
+      if (!shm_map_segment())
+        return false;
+      continue;
+    }
+    shm_reserve_sample(sample_size);
+    memcpy(shm.sample, header + 1, sample_size);
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&header->sequence, memory_order_relaxed) != sequence)
+      continue;
+    if (!compatible)
+      return false;
+    shm.sample_size = sample_size;
+    shm.published_at = published_at;
+    shm.publish_period = publish_period;
+    return shm_sample_is_consistent();
+  }
+  return false;
+}
+
+static void shm_collect_and_publish(void) {
+  gpuinfo_refresh_dynamic_info(&collected_devices);
+  gpuinfo_refresh_processes(&collected_devices);
+  gpuinfo_utilisation_rate(&collected_devices);
+  gpuinfo_fix_dynamic_info_from_process_info(&collected_devices);
+  gpuinfo_energy_account(&collected_devices, true);
+  shm_build_sample();
+  shm_write_sample();
+}
+
+// Called with the lock held: gathers the devices and publishes their static information
+static bool shm_become_collector(void) {
+  shm.collector = true;
+  unsigned collected_count;
+  gpuinfo_init_info_extraction(&collected_count, &collected_devices);
+  gpuinfo_populate_static_infos(&collected_devices);
+  if (shm.header) {
+    // Mapped read-only until now
+    munmap(shm.header, shm.mapped_size);
+    shm.header = NULL;
+    shm.mapped_size = 0;
+  }
+  shm_map_segment();
+  shm_build_sample();
+  return shm_write_sample();
+}
+
+static bool shm_wait_first_sample(void) {
+  for (unsigned waited = 0; waited < SHM_FIRST_SAMPLE_TIMEOUT_MS; waited += 10) {
+    if (shm_read_sample())
+      return true;
+    // The collector exited before publishing
+    if (flock(shm.fd, LOCK_EX | LOCK_NB) == 0)
+      return shm_become_collector();
+    usleep(10000);
+  }
+  return false;
+}
+
+static const struct shm_device *shm_find_device(const struct gpu_info_shm *device) {
+  const struct shm_sample *sample = (const struct shm_sample *)shm.sample;
+  const struct shm_device *published_devices = (const struct shm_device *)(sample + 1);
+  if (device->published_index < sample->devices_count &&
+      strncmp(published_devices[device->published_index].pdev, device->base.pdev, PDEV_LEN) == 0)
+    return &published_devices[device->published_index];
+  for (unsigned i = 0; i < sample->devices_count; ++i) {
+    if (strncmp(published_devices[i].pdev, device->base.pdev, PDEV_LEN) == 0)
+      return &published_devices[i];
+  }
+  return NULL;
+}
+
+static void shm_update_processes(struct gpu_info_shm *device, const struct shm_device *published_device) {
+  const struct shm_sample *sample = (const struct shm_sample *)shm.sample;
+  const struct shm_device *published_devices = (const struct shm_device *)(sample + 1);
+  const struct shm_process *published_processes =
+      (const struct shm_process *)(published_devices + sample->devices_count) + published_device->first_process;
+  const char *strings = (const char *)((const struct shm_process *)(published_devices + sample->devices_count) +
+                                       sample->processes_count);
+
+  device->base.processes_count = 0;
+  if ((uint64_t)published_device->first_process + published_device->processes_count > sample->processes_count)
+    return;
+
+  unsigned processes_count = published_device->processes_count;
+  size_t strings_size = 0;
+  for (unsigned i = 0; i < processes_count; ++i) {
+    if (published_processes[i].cmdline < sample->strings_size)
+      strings_size += strlen(strings + published_processes[i].cmdline) + 1;
+    if (published_processes[i].user_name < sample->strings_size)
+      strings_size += strlen(strings + published_processes[i].user_name) + 1;
+  }
+  if (strings_size > device->strings_size) {
+    device->strings_size = strings_size;
+    device->strings = realloc(device->strings, strings_size);
+    if (!device->strings) {
+      perror("Cannot allocate memory: ");
+      exit(EXIT_FAILURE);
+    }
+  }
+  if (processes_count > device->base.processes_array_size) {
+    device->base.processes_array_size = processes_count + COMMON_PROCESS_LINEAR_REALLOC_INC;
+    device->base.processes =
+        reallocarray(device->base.processes, device->base.processes_array_size, sizeof(*device->base.processes));
+    if (!device->base.processes) {
+      perror("Cannot allocate memory: ");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  size_t strings_used = 0;
+  for (unsigned i = 0; i < processes_count; ++i) {
+    struct gpu_process *process = &device->base.processes[i];
+    *process = published_processes[i].process;
+    RESET_GPUINFO_PROCESS(process, cmdline);
+    RESET_GPUINFO_PROCESS(process, user_name);
+    if (published_processes[i].cmdline < sample->strings_size) {
+      char *cmdline = strcpy(device->strings + strings_used, strings + published_processes[i].cmdline);
+      strings_used += strlen(cmdline) + 1;
+      SET_GPUINFO_PROCESS(process, cmdline, cmdline);
+    }
+    if (published_processes[i].user_name < sample->strings_size) {
+      char *user_name = strcpy(device->strings + strings_used, strings + published_processes[i].user_name);
+      strings_used += strlen(user_name) + 1;
+      SET_GPUINFO_PROCESS(process, user_name, user_name);
+    }
+  }
+  device->base.processes_count = processes_count;
+}
+
+static void shm_update_devices(struct list_head *devices, bool refresh_processes) {
+  // The collector stopped publishing without exiting, e.g. it is suspended
+  nvtop_time now;
+  nvtop_get_current_time(&now);
+  uint64_t age = nvtop_time_u64(now) - shm.published_at;
+  bool stale = !shm.collector && age > 2 * shm.publish_period + UINT64_C(1000000000);
+
+  unsigned largest_user_name = 0;
+  struct gpu_info *device;
+  list_for_each_entry(device, devices, list) {
+    struct gpu_info_shm *shm_device = container_of(device, struct gpu_info_shm, base);
+    const struct shm_device *published_device = shm_find_device(shm_device);
+    if (!published_device) {
+      RESET_ALL(device->dynamic_info.valid);
+      device->processes_count = 0;
+      continue;
+    }
+    device->dynamic_info = published_device->dynamic_info;
+    if (stale)
+      SET_GPUINFO_DYNAMIC(&device->dynamic_info, stale_data_age,
+                          (age + UINT64_C(999999999)) / UINT64_C(1000000000));
+    if (refresh_processes)
+      shm_update_processes(shm_device, published_device);
+    for (unsigned i = 0; i < device->processes_count; ++i) {
+      if (GPUINFO_PROCESS_FIELD_VALID(&device->processes[i], user_name)) {
+        size_t length = strlen(device->processes[i].user_name);
+        if (length > largest_user_name)
+          largest_user_name = length;
+      }
+    }
+  }
+  gpuinfo_set_shared_user_name_length(largest_user_name);
+}
+
+bool gpuinfo_shm_attach(unsigned *devices_count, struct list_head *devices) {
+  char name[32];
+  snprintf(name, sizeof(name), SHM_NAME_FORMAT, (unsigned)getuid());
+  shm.fd = shm_open(name, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+  if (shm.fd < 0)
+    return false;
+
+  // Do not trust a segment that someone else could have written
+  struct stat segment_stat;
+  bool ready = fstat(shm.fd, &segment_stat) == 0 && segment_stat.st_uid == getuid() &&
+               (segment_stat.st_mode & (S_IWGRP | S_IWOTH)) == 0;
+  if (ready) {
+    if (flock(shm.fd, LOCK_EX | LOCK_NB) == 0)
+      ready = shm_become_collector();
+    else
+      ready = shm_wait_first_sample();
+  }
+  if (!ready) {
+    gpuinfo_shm_detach();
+    return false;
+  }
+
+  const struct shm_sample *sample = (const struct shm_sample *)shm.sample;
+  const struct shm_device *published_devices = (const struct shm_device *)(sample + 1);
+  shm.devices_count = sample->devices_count;
+  shm.devices = calloc(shm.devices_count, sizeof(*shm.devices));
+  if (shm.devices_count && !shm.devices) {
+    perror("Cannot allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+  for (unsigned i = 0; i < shm.devices_count; ++i) {
+    struct gpu_info_shm *device = &shm.devices[i];
+    device->base.vendor = &gpu_vendor_shm;
+    device->base.static_info = published_devices[i].static_info;
+    device->base.subscription = GPUINFO_SUBSCRIPTION_ALL;
+    memcpy(device->base.pdev, published_devices[i].pdev, PDEV_LEN);
+    device->base.pdev[PDEV_LEN - 1] = '\0';
+    device->published_index = i;
+    list_add_tail(&device->base.list, devices);
+  }
+  *devices_count = shm.devices_count;
+  shm_update_devices(devices, true);
+  return true;
+}
+
+void gpuinfo_shm_refresh(struct list_head *devices, bool refresh_processes) {
+  // The lock is free once the collector exited
+  if (!shm.collector && flock(shm.fd, LOCK_EX | LOCK_NB) == 0)
+    shm_become_collector();
+  if (shm.collector)
+    shm_collect_and_publish();
+  else if (!shm_read_sample())
+    return;
+  shm_update_devices(devices, refresh_processes);
+}
+
+bool gpuinfo_shm_is_collector(void) { return shm.collector; }
+
+void gpuinfo_shm_detach(void) {
+  for (unsigned i = 0; i < shm.devices_count; ++i) {
+    list_del(&shm.devices[i].base.list);
+    free(shm.devices[i].base.processes);
+    free(shm.devices[i].strings);
+  }
+  free(shm.devices);
+  shm.devices = NULL;
+  shm.devices_count = 0;
+  if (shm.collector)
+    gpuinfo_shutdown_info_extraction(&collected_devices);
+  shm.collector = false;
+  if (shm.header)
+    munmap(shm.header, shm.mapped_size);
+  shm.header = NULL;
+  shm.mapped_size = 0;
+  // Releases the lock for another instance to take over
+  if (shm.fd >= 0)
+    close(shm.fd);
+  shm.fd = -1;
+  free(shm.sample);
+  shm.sample = NULL;
+  shm.sample_size = 0;
+  shm.sample_capacity = 0;
+}
@@ -29,13 +29,9 @@
 #include <unistd.h>
 #include <math.h>
 #include <dlfcn.h>
+#include <pthread.h>
 #include <sys/time.h>
 
-struct gpu_info_tpu {
-  struct gpu_info base;
-  int device_id;
-};
-
 struct tpu_chip_usage_data {
   char name[8];
   int64_t device_id;
@@ -45,6 +41,14 @@ struct tpu_chip_usage_data {
   int64_t pid;
 };
 
+struct gpu_info_tpu {
+  struct gpu_info base;
+  int device_id;
+  // Copy of the latest published sample, taken when refreshing the dynamic info
+  struct tpu_chip_usage_data usage_data;
+  bool has_usage_data;
+};
+
 static bool gpuinfo_tpu_init(void);
 static void gpuinfo_tpu_shutdown(void);
 static const char *gpuinfo_tpu_last_error_string(void);
@@ -52,9 +56,6 @@ static bool gpuinfo_tpu_get_device_handles(struct list_head *devices, unsigned *
 static void gpuinfo_tpu_populate_static_info(struct gpu_info *_gpu_info);
 static void gpuinfo_tpu_refresh_dynamic_info(struct gpu_info *_gpu_info);
 static void gpuinfo_tpu_get_running_processes(struct gpu_info *_gpu_info);
-static bool is_cache_valid(void);
-static bool refresh_tpu_cache(void);
-static void reset_tpu_cache(bool);
 static void free_ptr(void **ptr);
 
 struct gpu_vendor gpu_vendor_tpu = {
@@ -98,58 +99,202 @@ char *libname = "libtpuinfo.so";
 int tpu_runtime_monitoring_port = -1;  
 
 /* TPU info cache ------------------------------------------------------------------------------- */
-struct tpu_chip_usage_data *latest_chips_usage_data = NULL;
-nvtop_time last_cache_refresh;
-int64 *_pids, *_device_ids, *_memory_usage, *_total_memory;
-double* _duty_cycle_pct;
+// The runtime monitoring port is queried by a background thread so that a slow or hung runtime never stalls the
+// interface. The poller fills the back buffer without holding the lock and then swaps it with the front buffer; the
+// readers only copy out of the front buffer.
+// env NVTOP_TPU_POLL_PERIOD_MS={int} sets the polling period (1000ms by default)
+// $ env NVTOP_TPU_POLL_PERIOD_MS=500 nvtop
+#define TPU_DEFAULT_POLL_PERIOD_MS 1000
+// A sample is stale once the poller missed this many periods
+#define TPU_STALE_AFTER_PERIODS 2
+
+struct tpu_cache_buffer {
+  struct tpu_chip_usage_data *chips;
+  nvtop_time sampled_at;
+  bool has_sample;
+};
 
-bool is_cache_valid(void) {
-  nvtop_time current_time;
-  nvtop_get_current_time(&current_time);
-  uint64_t t_diff_ns = nvtop_difftime_u64(last_cache_refresh, current_time);
-  return t_diff_ns < 900 * 1000 * 1000; // 900ms
+struct tpu_poller {
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t wakeup;
+  bool stop;
+  bool querying; // Inside a libtpuinfo call
+  bool detached; // Shut down while querying, the poller releases itself on exit
+  uint64_t period_ns;
+  int64_t chip_count;
+  unsigned front;
+  struct tpu_cache_buffer buffers[2];
+  // Scratch arrays handed to libtpuinfo, only touched by the poller
+  int64 *pids, *device_ids, *memory_usage, *total_memory;
+  double *duty_cycle_pct;
+};
+
+static struct tpu_poller *tpu_poller;
+
+static void reset_tpu_chips(struct tpu_chip_usage_data *chips, int64_t chip_count, bool fully) {
+  for (int64_t i = 0; i < chip_count; i++) {
+    chips[i].memory_usage = 0;
+    chips[i].duty_cycle_pct = 0;
+    chips[i].pid = -1;
+    if (fully) {
+      snprintf(chips[i].name, sizeof(chips[i].name), "%s", "N/A");
+      chips[i].device_id = 0;
+      chips[i].total_memory = 0;
+    }
+  }
 }
 
-bool refresh_tpu_cache(void) {
-  if (is_cache_valid()) return true;
-  nvtop_get_current_time(&last_cache_refresh);
-  if (tpu_chip_count <= 0) return false;
-  if (_tpu_pids(_pids, tpu_chip_count) != 0) {
-    reset_tpu_cache(false);
-    return false;
+static void tpu_poller_free(struct tpu_poller *poller) {
+  for (unsigned i = 0; i < 2; ++i)
+    free(poller->buffers[i].chips);
+  free(poller->pids);
+  free(poller->device_ids);
+  free(poller->memory_usage);
+  free(poller->total_memory);
+  free(poller->duty_cycle_pct);
+  pthread_cond_destroy(&poller->wakeup);
+  pthread_mutex_destroy(&poller->lock);
+  free(poller);
+}
+
+static uint64_t tpu_poll_period_ns(void) {
+  const char *period_str = getenv("NVTOP_TPU_POLL_PERIOD_MS");
+  if (period_str) {
+    char *end;
+    unsigned long period_ms = strtoul(period_str, &end, 10);
+    if (end != period_str && *end == '\0' && period_ms > 0)
+      return (uint64_t)period_ms * 1000 * 1000;
+  }
+  return (uint64_t)TPU_DEFAULT_POLL_PERIOD_MS * 1000 * 1000;
+}
+
+// Queries the runtime into the back buffer. Returns false if nothing should be published.
+static bool tpu_poller_sample(struct tpu_poller *poller, struct tpu_cache_buffer *back,
+                              const struct tpu_cache_buffer *front) {
+  int64_t chip_count = poller->chip_count;
+  memcpy(back->chips, front->chips, chip_count * sizeof(*back->chips));
+  if (_tpu_pids(poller->pids, chip_count) != 0) {
+    // No runtime to talk to: publish idle chips
+    reset_tpu_chips(back->chips, chip_count, false);
+    return true;
   }
-  for (int64_t i = 0; i < tpu_chip_count; i++) latest_chips_usage_data[i].pid = _pids[i];
-
-  if (_tpu_metrics(tpu_runtime_monitoring_port, _device_ids, _memory_usage, _total_memory,
-                   _duty_cycle_pct, tpu_chip_count) != 0) return false;
-  for (int64_t i = 0; i < tpu_chip_count; i++) {
-    latest_chips_usage_data[i].device_id = _device_ids[i];
-    latest_chips_usage_data[i].memory_usage = _memory_usage[i];
-    latest_chips_usage_data[i].total_memory = _total_memory[i];
-    latest_chips_usage_data[i].duty_cycle_pct = _duty_cycle_pct[i];
+  for (int64_t i = 0; i < chip_count; i++)
+    back->chips[i].pid = poller->pids[i];
+
+  if (_tpu_metrics(tpu_runtime_monitoring_port, poller->device_ids, poller->memory_usage, poller->total_memory,
+                   poller->duty_cycle_pct, chip_count) != 0)
+    return false;
+  for (int64_t i = 0; i < chip_count; i++) {
+    back->chips[i].device_id = poller->device_ids[i];
+    back->chips[i].memory_usage = poller->memory_usage[i];
+    back->chips[i].total_memory = poller->total_memory[i];
+    back->chips[i].duty_cycle_pct = poller->duty_cycle_pct[i];
   }
   return true;
 }
 
-void reset_tpu_cache(bool fully) {
-  for (int64_t i = 0; i < tpu_chip_count; i++) {
-    latest_chips_usage_data[i].memory_usage = 0;
-    latest_chips_usage_data[i].duty_cycle_pct = 0;
-    latest_chips_usage_data[i].pid = -1;
-    if (fully) {
-      snprintf(latest_chips_usage_data[i].name, sizeof(latest_chips_usage_data[i].name), "%s", "N/A");
-      latest_chips_usage_data[i].device_id = 0;
-      latest_chips_usage_data[i].total_memory = 0;
+static void *tpu_poller_loop(void *arg) {
+  struct tpu_poller *poller = arg;
+  pthread_mutex_lock(&poller->lock);
+  while (!poller->stop) {
+    // Only the poller moves the front index, so the back buffer is ours until the swap
+    struct tpu_cache_buffer *back = &poller->buffers[poller->front ^ 1];
+    const struct tpu_cache_buffer *front = &poller->buffers[poller->front];
+    poller->querying = true;
+    pthread_mutex_unlock(&poller->lock);
+
+    bool publish = tpu_poller_sample(poller, back, front);
+
+    pthread_mutex_lock(&poller->lock);
+    poller->querying = false;
+    if (publish) {
+      nvtop_get_current_time(&back->sampled_at);
+      back->has_sample = true;
+      poller->front ^= 1;
     }
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    uint64_t deadline_ns = nvtop_time_u64(deadline) + poller->period_ns;
+    deadline.tv_sec = deadline_ns / UINT64_C(1000000000);
+    deadline.tv_nsec = deadline_ns % UINT64_C(1000000000);
+    while (!poller->stop && pthread_cond_timedwait(&poller->wakeup, &poller->lock, &deadline) == 0)
+      ;
+  }
+  bool detached = poller->detached;
+  pthread_mutex_unlock(&poller->lock);
+  if (detached)
+    tpu_poller_free(poller);
+  return NULL;
+}
+
+static struct tpu_poller *tpu_poller_start(int64_t chip_count) {
+  struct tpu_poller *poller = calloc(1, sizeof(*poller));
+  if (!poller)
+    return NULL;
+  poller->period_ns = tpu_poll_period_ns();
+  poller->chip_count = chip_count;
+  for (unsigned i = 0; i < 2; ++i) {
+    poller->buffers[i].chips = calloc(chip_count, sizeof(*poller->buffers[i].chips));
+    if (poller->buffers[i].chips)
+      reset_tpu_chips(poller->buffers[i].chips, chip_count, true);
+  }
+  poller->pids = calloc(chip_count, sizeof(*poller->pids));
+  poller->device_ids = calloc(chip_count, sizeof(*poller->device_ids));
+  poller->memory_usage = calloc(chip_count, sizeof(*poller->memory_usage));
+  poller->total_memory = calloc(chip_count, sizeof(*poller->total_memory));
+  poller->duty_cycle_pct = calloc(chip_count, sizeof(*poller->duty_cycle_pct));
+
+  pthread_condattr_t cond_attr;
+  pthread_condattr_init(&cond_attr);
+  pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+  pthread_mutex_init(&poller->lock, NULL);
+  pthread_cond_init(&poller->wakeup, &cond_attr);
+  pthread_condattr_destroy(&cond_attr);
+
+  if (!poller->buffers[0].chips || !poller->buffers[1].chips || !poller->pids || !poller->device_ids ||
+      !poller->memory_usage || !poller->total_memory || !poller->duty_cycle_pct ||
+      pthread_create(&poller->thread, NULL, tpu_poller_loop, poller) != 0) {
+    tpu_poller_free(poller);
+    return NULL;
+  }
+  return poller;
+}
+
+static void tpu_poller_stop(struct tpu_poller *poller) {
+  pthread_mutex_lock(&poller->lock);
+  poller->stop = true;
+  pthread_cond_signal(&poller->wakeup);
+  // Do not wait on a runtime that hangs, let the poller clean up after itself when it returns
+  bool querying = poller->querying;
+  poller->detached = querying;
+  pthread_mutex_unlock(&poller->lock);
+  if (querying) {
+    pthread_detach(poller->thread);
+  } else {
+    pthread_join(poller->thread, NULL);
+    tpu_poller_free(poller);
+  }
+}
+
+// Copies the latest sample of a chip. Never blocks on the runtime.
+static bool tpu_poller_read(struct tpu_poller *poller, int64_t chip, struct tpu_chip_usage_data *usage_data,
+                            nvtop_time *sampled_at) {
+  pthread_mutex_lock(&poller->lock);
+  const struct tpu_cache_buffer *front = &poller->buffers[poller->front];
+  bool has_sample = front->has_sample;
+  if (has_sample) {
+    *usage_data = front->chips[chip];
+    *sampled_at = front->sampled_at;
   }
+  pthread_mutex_unlock(&poller->lock);
+  return has_sample;
 }
 /* TPU info cache ------------------------------------------------------------------------------- */
 
 bool gpuinfo_tpu_init(void) {
   char* error_msg;
-  nvtop_get_current_time(&last_cache_refresh);
-  // invalidate cache by putting it in the past
-  last_cache_refresh = nvtop_substract_time(last_cache_refresh, (nvtop_time){10, 0}); 
 
   // Load dynamic library symbols
   void *handle = dlopen(libname, RTLD_LAZY);
@@ -196,14 +341,12 @@ bool gpuinfo_tpu_init(void) {
     return false;
   }
 
-  // Allocate memory for TPU device data cache
-  latest_chips_usage_data = (struct tpu_chip_usage_data*)malloc(tpu_chip_count*sizeof(struct tpu_chip_usage_data));
-  _pids = (int64*)malloc(sizeof(int64) * tpu_chip_count);
-  _device_ids = (int64*)malloc(sizeof(int64) * tpu_chip_count);
-  _memory_usage = (int64*)malloc(sizeof(int64) * tpu_chip_count);
-  _total_memory = (int64*)malloc(sizeof(int64) * tpu_chip_count);
-  _duty_cycle_pct = (double*)malloc(sizeof(double) * tpu_chip_count);
-  reset_tpu_cache(true);
+  // Start polling the runtime in the background
+  tpu_poller = tpu_poller_start(tpu_chip_count);
+  if (!tpu_poller) {
+    tpu_chip_count = -1;
+    return false;
+  }
   return true;
 }
 
@@ -215,13 +358,11 @@ void free_ptr(void **ptr) {
 }
 
 void gpuinfo_tpu_shutdown(void) {
+  if (tpu_poller) {
+    tpu_poller_stop(tpu_poller);
+    tpu_poller = NULL;
+  }
   free_ptr((void **)&gpu_infos);
-  free_ptr((void **)&latest_chips_usage_data);
-  free_ptr((void **)&_pids);
-  free_ptr((void **)&_device_ids);
-  free_ptr((void **)&_memory_usage);
-  free_ptr((void **)&_total_memory);
-  free_ptr((void **)&_duty_cycle_pct);
   tpu_chip_count = -1;
 }
 
@@ -265,10 +406,14 @@ void gpuinfo_tpu_refresh_dynamic_info(struct gpu_info *_gpu_info) {
   // struct gpuinfo_static_info *static_info = &gpu_info->base.static_info; // unused
   struct gpuinfo_dynamic_info *dynamic_info = &gpu_info->base.dynamic_info;
 
-  refresh_tpu_cache();
-
+  RESET_ALL(dynamic_info->valid);
+  gpu_info->has_usage_data = false;
   if (gpu_info->device_id >= tpu_chip_count) return;
-  struct tpu_chip_usage_data usage_data = latest_chips_usage_data[gpu_info->device_id];
+  nvtop_time sampled_at;
+  if (!tpu_poller_read(tpu_poller, gpu_info->device_id, &gpu_info->usage_data, &sampled_at)) return;
+  gpu_info->has_usage_data = true;
+
+  struct tpu_chip_usage_data usage_data = gpu_info->usage_data;
   double mem_util = round(1e2 * (double)(usage_data.memory_usage) / (double)MAX(1, usage_data.total_memory));
   double tpu_util = round(usage_data.duty_cycle_pct);
   SET_GPUINFO_DYNAMIC(dynamic_info, gpu_util_rate, (int)tpu_util);
@@ -277,13 +422,19 @@ void gpuinfo_tpu_refresh_dynamic_info(struct gpu_info *_gpu_info) {
   SET_GPUINFO_DYNAMIC(dynamic_info, used_memory, usage_data.memory_usage);
   SET_GPUINFO_DYNAMIC(dynamic_info, free_memory, usage_data.total_memory - usage_data.memory_usage);
 
+  nvtop_time current_time;
+  nvtop_get_current_time(&current_time);
+  uint64_t data_age_ns = nvtop_difftime_u64(sampled_at, current_time);
+  if (data_age_ns > TPU_STALE_AFTER_PERIODS * tpu_poller->period_ns)
+    SET_GPUINFO_DYNAMIC(dynamic_info, stale_data_age, (data_age_ns + UINT64_C(999999999)) / UINT64_C(1000000000));
+
   return;
 }
 
 void gpuinfo_tpu_get_running_processes(struct gpu_info *_gpu_info) {
   struct gpu_info_tpu *gpu_info = container_of(_gpu_info, struct gpu_info_tpu, base);
   if (gpu_info->device_id >= tpu_chip_count) return;
-  if (tpu_chip_count <= 0 || latest_chips_usage_data[gpu_info->device_id].pid < 0) {
+  if (!gpu_info->has_usage_data || gpu_info->usage_data.pid < 0) {
     _gpu_info->processes_count = 0;
     return;
   }
@@ -294,7 +445,7 @@ void gpuinfo_tpu_get_running_processes(struct gpu_info *_gpu_info) {
     memset(_gpu_info->processes, 0, _gpu_info->processes_count * sizeof(*_gpu_info->processes));
   }
   _gpu_info->processes[0].type = gpu_process_compute;
-  _gpu_info->processes[0].pid = latest_chips_usage_data[gpu_info->device_id].pid;
+  _gpu_info->processes[0].pid = gpu_info->usage_data.pid;
   _gpu_info->processes[0].gpu_memory_usage = _gpu_info->dynamic_info.used_memory;
 
   SET_VALID(gpuinfo_process_gpu_memory_usage_valid, _gpu_info->processes[0].valid);
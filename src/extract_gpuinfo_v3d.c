@@ -26,8 +26,8 @@
 
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
-#include <uthash.h>
 
 int mbox_open(void);
 void mbox_close(int mb);
@@ -36,28 +36,6 @@ void set_gpuinfo_from_vcio(struct gpuinfo_dynamic_info *dynamic_info, int mb);
 void set_memory_gpuinfo(struct gpuinfo_dynamic_info *dynamic_info);
 void set_init_max_memory(int mb);
 
-#define HASH_FIND_CLIENT(head, key_ptr, out_ptr) HASH_FIND(hh, head, key_ptr, sizeof(struct unique_cache_id), out_ptr)
-#define HASH_ADD_CLIENT(head, in_ptr) HASH_ADD(hh, head, client_id, sizeof(struct unique_cache_id), in_ptr)
-
-#define SET_V3D_CACHE(cachePtr, field, value) SET_VALUE(cachePtr, field, value, v3d_cache_)
-#define RESET_V3D_CACHE(cachePtr, field) INVALIDATE_VALUE(cachePtr, field, v3d_cache_)
-#define V3D_CACHE_FIELD_VALID(cachePtr, field) VALUE_IS_VALID(cachePtr, field, v3d_cache_)
-
-enum v3d_process_info_cache_valid { v3d_cache_engine_render_valid = 0, v3d_cache_process_info_cache_valid_count };
-
-struct __attribute__((__packed__)) unique_cache_id {
-  unsigned client_id;
-  pid_t pid;
-};
-
-struct v3d_process_info_cache {
-  struct unique_cache_id client_id;
-  uint64_t engine_render;
-  nvtop_time last_measurement_tstamp;
-  unsigned char valid[(v3d_cache_process_info_cache_valid_count + CHAR_BIT - 1) / CHAR_BIT];
-  UT_hash_handle hh;
-};
-
 struct gpu_info_v3d {
   struct gpu_info base;
   int mb;
@@ -65,7 +43,6 @@ struct gpu_info_v3d {
 
   struct nvtop_device *card_device;
   struct nvtop_device *driver_device;
-  struct v3d_process_info_cache *last_update_process_cache, *current_update_process_cache; // Cached processes info
 };
 
 static bool gpuinfo_v3d_init(void);
@@ -116,8 +93,6 @@ static bool parse_drm_fdinfo_v3d(struct gpu_info *info, FILE *fdinfo_file, struc
 
   bool client_id_set = false;
   unsigned cid;
-  nvtop_time current_time;
-  nvtop_get_current_time(&current_time);
 
   while ((count = getline(&line, &line_buf_size, fdinfo_file)) != -1) {
     char *key, *val;
@@ -156,36 +131,12 @@ static bool parse_drm_fdinfo_v3d(struct gpu_info *info, FILE *fdinfo_file, struc
 
   process_info->type |= gpu_process_graphical;
 
-  struct unique_cache_id ucid = {.client_id = cid, .pid = process_info->pid};
-  struct v3d_process_info_cache *cache_entry;
-  HASH_FIND_CLIENT(gpu_info->last_update_process_cache, &ucid, cache_entry);
-  if (cache_entry) {
-    uint64_t time_elapsed = nvtop_difftime_u64(cache_entry->last_measurement_tstamp, current_time);
-    HASH_DEL(gpu_info->last_update_process_cache, cache_entry);
-    if (GPUINFO_PROCESS_FIELD_VALID(process_info, gfx_engine_used) &&
-        V3D_CACHE_FIELD_VALID(cache_entry, engine_render) &&
-        process_info->gfx_engine_used >= cache_entry->engine_render &&
-        process_info->gfx_engine_used - cache_entry->engine_render <= time_elapsed) {
-      SET_GPUINFO_PROCESS(
-          process_info, gpu_usage,
-          busy_usage_from_time_usage_round(process_info->gfx_engine_used, cache_entry->engine_render, time_elapsed));
-    }
-  } else {
-    cache_entry = calloc(1, sizeof(*cache_entry));
-    if (!cache_entry)
-      goto parse_fdinfo_exit;
-    cache_entry->client_id.client_id = cid;
-    cache_entry->client_id.pid = process_info->pid;
-  }
+  struct gpuinfo_client_counters counters = {0};
+  struct gpuinfo_client_delta delta;
+  gpuinfo_client_counters_from_process(process_info, &counters);
+  if (gpuinfo_client_counters_update(&gpu_info->base, process_info->pid, cid, &counters, &delta))
+    gpuinfo_process_usage_from_client_delta(process_info, &delta);
 
-  RESET_ALL(cache_entry->valid);
-  if (GPUINFO_PROCESS_FIELD_VALID(process_info, gfx_engine_used))
-    SET_V3D_CACHE(cache_entry, engine_render, process_info->gfx_engine_used);
-
-  cache_entry->last_measurement_tstamp = current_time;
-  HASH_ADD_CLIENT(gpu_info->current_update_process_cache, cache_entry);
-
-parse_fdinfo_exit:
   return true;
 }
 
@@ -272,33 +223,12 @@ void gpuinfo_v3d_refresh_dynamic_info(struct gpu_info *_gpu_info) {
 
   RESET_ALL(dynamic_info->valid);
 
-  nvtop_device *card_dev_copy;
-  const char *syspath;
-  nvtop_device_get_syspath(gpu_info->card_device, &syspath);
-  nvtop_device_new_from_syspath(&card_dev_copy, syspath);
-
   set_memory_gpuinfo(dynamic_info);
   if (gpu_info->mb >= 0)
     set_gpuinfo_from_vcio(dynamic_info, gpu_info->mb);
-  nvtop_device_unref(card_dev_copy);
-}
-
-static void swap_process_cache_for_next_update(struct gpu_info_v3d *gpu_info) {
-  // Free old cache data and set the cache for the next update
-  if (gpu_info->last_update_process_cache) {
-    struct v3d_process_info_cache *cache_entry, *tmp;
-    HASH_ITER(hh, gpu_info->last_update_process_cache, cache_entry, tmp) {
-      HASH_DEL(gpu_info->last_update_process_cache, cache_entry);
-      free(cache_entry);
-    }
-  }
-  gpu_info->last_update_process_cache = gpu_info->current_update_process_cache;
-  gpu_info->current_update_process_cache = NULL;
 }
 
 void gpuinfo_v3d_get_running_processes(struct gpu_info *_gpu_info) {
   // For v3d, we register a fdinfo callback that will fill the gpu_process datastructure of the gpu_info structure
   // for us. This avoids going through /proc multiple times per update for multiple GPUs.
-  struct gpu_info_v3d *gpu_info = container_of(_gpu_info, struct gpu_info_v3d, base);
-  swap_process_cache_for_next_update(gpu_info);
 }
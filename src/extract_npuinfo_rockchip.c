@@ -19,6 +19,7 @@
  *
  */
 
+#include "nvtop/device_discovery.h"
 #include "nvtop/extract_gpuinfo_common.h"
 #include "nvtop/time.h"
 
@@ -30,6 +31,11 @@
 
 struct gpu_info_rknpu {
   struct gpu_info base;
+  // Polled at each refresh, opened once at initialization
+  nvtop_sysfs_attr *cur_freq;
+  nvtop_sysfs_attr *max_freq;
+  nvtop_sysfs_attr *load;
+  nvtop_sysfs_attr *temp;
 };
 
 static struct gpu_info_rknpu *rknpu_info = NULL;
@@ -43,6 +49,10 @@ static bool gpuinfo_rknpu_init(void) {
 
 static void gpuinfo_rknpu_shutdown(void) {
   if (rknpu_info) {
+    nvtop_sysfs_attr_close(rknpu_info->cur_freq);
+    nvtop_sysfs_attr_close(rknpu_info->max_freq);
+    nvtop_sysfs_attr_close(rknpu_info->load);
+    nvtop_sysfs_attr_close(rknpu_info->temp);
     free(rknpu_info);
     rknpu_info = NULL;
   }
@@ -63,6 +73,11 @@ static void add_rknpu_chip(struct list_head *devices, unsigned *count) {
   this_npu->base.processes = NULL;
   this_npu->base.processes_array_size = 0;
 
+  this_npu->cur_freq = nvtop_sysfs_attr_open("/sys/class/devfreq/fdab0000.npu/cur_freq");
+  this_npu->max_freq = nvtop_sysfs_attr_open("/sys/class/devfreq/fdab0000.npu/max_freq");
+  this_npu->load = nvtop_sysfs_attr_open("/sys/kernel/debug/rknpu/load");
+  this_npu->temp = nvtop_sysfs_attr_open("/sys/class/thermal/thermal_zone6/temp");
+
   *count += 1;
 }
 
@@ -86,29 +101,24 @@ static void gpuinfo_rknpu_populate_static_info(struct gpu_info *_gpu_info) {
   SET_VALID(gpuinfo_device_name_valid, static_info->valid);
 }
 
-static int read_int_from_file(const char *path) {
-  int value = 0;
-  FILE *fp = fopen(path, "r");
-  if (fp) {
-    fscanf(fp, "%d", &value);
-    fclose(fp);
-  }
+static uint64_t read_uint_from_attr(nvtop_sysfs_attr *attr) {
+  uint64_t value = 0;
+  if (nvtop_sysfs_attr_read_uint64(attr, &value) < 0)
+    return 0;
   return value;
 }
 
-static int read_npu_load(const char *file) {
-  FILE *fp = fopen(file, "r");
-  if (!fp) return -1;
+static int read_npu_load(nvtop_sysfs_attr *attr) {
+  const char *line = nvtop_sysfs_attr_read(attr);
+  if (!line) return -1;
 
-  char line[256]; int sum = 0, load=0, count = 0;
-  if (fgets(line, sizeof(line), fp))
-      for (char *p = line; (p = strstr(p, "Core")); p++)
-          if (sscanf(p, "Core%*d: %d%%", &load) == 1) {
-            sum += load;
-            count++;
-          }
+  int sum = 0, load=0, count = 0;
+  for (const char *p = line; (p = strstr(p, "Core")); p++)
+      if (sscanf(p, "Core%*d: %d%%", &load) == 1) {
+        sum += load;
+        count++;
+      }
 
-  fclose(fp);
   return count ? sum / count : -1;
 }
 
@@ -139,16 +149,16 @@ static void gpuinfo_rknpu_refresh_dynamic_info(struct gpu_info *_gpu_info) {
   struct gpu_info_rknpu *gpu_info = container_of(_gpu_info, struct gpu_info_rknpu, base);
   struct gpuinfo_dynamic_info *dynamic_info = &gpu_info->base.dynamic_info;
 
-  int gpu_clock_speed = read_int_from_file("/sys/class/devfreq/fdab0000.npu/cur_freq") / 1000000;
-  int gpu_clock_speed_max = read_int_from_file("/sys/class/devfreq/fdab0000.npu/max_freq") / 1000000;
-  int gpu_util_rate = read_npu_load("/sys/kernel/debug/rknpu/load");
+  int gpu_clock_speed = read_uint_from_attr(gpu_info->cur_freq) / 1000000;
+  int gpu_clock_speed_max = read_uint_from_attr(gpu_info->max_freq) / 1000000;
+  int gpu_util_rate = read_npu_load(gpu_info->load);
   if (gpu_util_rate >= 0) 
     SET_GPUINFO_DYNAMIC(dynamic_info, gpu_util_rate, gpu_util_rate);
 
   SET_GPUINFO_DYNAMIC(dynamic_info, gpu_clock_speed, gpu_clock_speed);
   SET_GPUINFO_DYNAMIC(dynamic_info, gpu_clock_speed_max, gpu_clock_speed_max);
 
-  int gpu_temp = read_int_from_file("/sys/class/thermal/thermal_zone6/temp") / 1000;
+  int gpu_temp = read_uint_from_attr(gpu_info->temp) / 1000;
   SET_GPUINFO_DYNAMIC(dynamic_info, gpu_temp, gpu_temp);
 
   set_gpuinfo_dynamic_memory(dynamic_info);
@@ -284,6 +284,13 @@ void processinfo_sweep_fdinfos(void) {
         SET_GPUINFO_PROCESS(process_info, sample_delta,
                             process_info->sample_delta + processes_info_local.sample_delta);
       }
+      for (enum gpuinfo_engine_class engine = 0; engine < gpuinfo_engine_class_count; ++engine) {
+        if (GPUINFO_PROCESS_ENGINE_VALID(&processes_info_local, engine)) {
+          unsigned engine_usage =
+              GPUINFO_PROCESS_ENGINE_VALID(process_info, engine) ? process_info->engine_usage[engine] : 0;
+          SET_GPUINFO_PROCESS_ENGINE(process_info, engine, engine_usage + processes_info_local.engine_usage[engine]);
+        }
+      }
     }
 
   next:
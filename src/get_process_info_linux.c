@@ -20,7 +20,11 @@
  */
 
 #include "nvtop/get_process_info.h"
+#include "nvtop/common.h"
+#include "process_cpus.h"
 
+#include <ctype.h>
+#include <dirent.h>
 #include <inttypes.h>
 #include <pwd.h>
 #include <stdbool.h>
@@ -206,3 +210,122 @@ bool get_process_info(pid_t pid, struct process_cpu_usage *usage) {
   usage->resident_memory = (size_t)resident_memory * page_size;
   return true;
 }
+
+// Reads the first line of the file, the returned line must be freed
+static char *read_first_line(const char *path) {
+  FILE *file = fopen(path, "r");
+  if (!file)
+    return NULL;
+  char *line = NULL;
+  size_t size = 0;
+  if (getline(&line, &size, file) < 0) {
+    free(line);
+    line = NULL;
+  }
+  fclose(file);
+  return line;
+}
+
+static bool read_cpu_list(const char *path, struct nvtop_cpu_set *cpus) {
+  char *line = read_first_line(path);
+  if (!line)
+    return false;
+  bool parsed = parse_cpu_list(line, cpus);
+  free(line);
+  return parsed;
+}
+
+bool get_pci_device_local_cpus(const char *pdev, struct nvtop_cpu_set *cpus) {
+  // The sysfs names are in lower case, NVML gives them in upper case
+  char device[32];
+  size_t length = 0;
+  for (; pdev[length] && length < sizeof(device) - 1; ++length)
+    device[length] = tolower((unsigned char)pdev[length]);
+  device[length] = '\0';
+
+  int written = snprintf(pid_path, pid_path_size, "/sys/bus/pci/devices/%s/numa_node", device);
+  if (written >= pid_path_size)
+    return false;
+  char *line = read_first_line(pid_path);
+  if (!line)
+    return false;
+  int numa_node = atoi(line);
+  free(line);
+  if (numa_node < 0)
+    return false;
+
+  snprintf(pid_path, pid_path_size, "/sys/bus/pci/devices/%s/local_cpulist", device);
+  struct nvtop_cpu_set online;
+  if (!read_cpu_list(pid_path, cpus) || !read_cpu_list("/sys/devices/system/cpu/online", &online))
+    return false;
+  for (size_t i = 0; i < NVTOP_MAX_CPUS / 64; ++i) {
+    if (online.bits[i] & ~cpus->bits[i])
+      return true;
+  }
+  return false;
+}
+
+bool get_process_allowed_cpus(pid_t pid, struct nvtop_cpu_set *cpus) {
+  int written = snprintf(pid_path, pid_path_size, "/proc/%" PRIdMAX "/status", (intmax_t)pid);
+  if (written >= pid_path_size)
+    return false;
+  FILE *status_file = fopen(pid_path, "r");
+  if (!status_file)
+    return false;
+  static const char allowed_key[] = "Cpus_allowed_list:";
+  char *line = NULL;
+  size_t size = 0;
+  bool parsed = false;
+  while (getline(&line, &size, status_file) >= 0) {
+    if (strncmp(line, allowed_key, sizeof(allowed_key) - 1) == 0) {
+      char *list = &line[sizeof(allowed_key) - 1];
+      while (isspace((unsigned char)*list))
+        list++;
+      parsed = parse_cpu_list(list, cpus);
+      break;
+    }
+  }
+  free(line);
+  fclose(status_file);
+  return parsed;
+}
+
+bool get_process_thread_cpus(pid_t pid, unsigned **cpus, unsigned *count, unsigned *size) {
+  int written = snprintf(pid_path, pid_path_size, "/proc/%" PRIdMAX "/task", (intmax_t)pid);
+  if (written >= pid_path_size)
+    return false;
+  DIR *task_dir = opendir(pid_path);
+  if (!task_dir)
+    return false;
+  *count = 0;
+  char stat_path[64];
+  char stat_buffer[1024];
+  struct dirent *task;
+  while ((task = readdir(task_dir)) != NULL) {
+    if (!isdigit((unsigned char)task->d_name[0]))
+      continue;
+    snprintf(stat_path, sizeof(stat_path), "/proc/%" PRIdMAX "/task/%.16s/stat", (intmax_t)pid, task->d_name);
+    FILE *stat_file = fopen(stat_path, "r");
+    if (!stat_file)
+      continue;
+    size_t num_read = fread(stat_buffer, 1, sizeof(stat_buffer) - 1, stat_file);
+    fclose(stat_file);
+    stat_buffer[num_read] = '\0';
+    unsigned cpu;
+    if (!parse_stat_processor(stat_buffer, &cpu))
+      continue;
+    if (*count == *size) {
+      unsigned new_size = *size ? *size * 2 : 8;
+      unsigned *new_cpus = reallocarray(*cpus, new_size, sizeof(**cpus));
+      if (!new_cpus) {
+        perror("Cannot allocate memory: ");
+        exit(EXIT_FAILURE);
+      }
+      *cpus = new_cpus;
+      *size = new_size;
+    }
+    (*cpus)[(*count)++] = cpu;
+  }
+  closedir(task_dir);
+  return *count > 0;
+}
@@ -135,3 +135,23 @@ bool get_process_info(pid_t pid, struct process_cpu_usage *usage) {
   usage->resident_memory = proc.pti_resident_size;
   return true;
 }
+
+bool get_pci_device_local_cpus(const char *pdev, struct nvtop_cpu_set *cpus) {
+  (void)pdev;
+  (void)cpus;
+  return false;
+}
+
+bool get_process_allowed_cpus(pid_t pid, struct nvtop_cpu_set *cpus) {
+  (void)pid;
+  (void)cpus;
+  return false;
+}
+
+bool get_process_thread_cpus(pid_t pid, unsigned **cpus, unsigned *count, unsigned *size) {
+  (void)pid;
+  (void)cpus;
+  (void)count;
+  (void)size;
+  return false;
+}
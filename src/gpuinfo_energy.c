@@ -0,0 +1,278 @@
+/*
+ *
+ * Copyright (C) 2025 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "nvtop/gpuinfo_energy.h"
+#include "nvtop/common.h"
+#include "nvtop/extract_gpuinfo.h"
+#include "nvtop/extract_gpuinfo_common.h"
+#include "nvtop/time.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ENERGY_REALLOC_INC 16
+
+// The energies are accumulated in microjoules so that the short intervals at low power are not rounded away
+struct energy_device {
+  const struct gpu_info *device;
+  bool integrated;     // The power draw was available at least once
+  bool has_power;      // The previous sample had the power draw
+  unsigned power;      // Power draw of the previous sample, milliwatts
+  uint64_t power_time; // Time of the previous sample
+  uint64_t energy;
+  uint64_t unshared;       // Energy drawn since the processes were last refreshed
+  uint64_t shared_time;    // Time of the last refresh of the processes, 0 before the first one
+  uint64_t shared_refresh; // Number of the last refresh that had the processes of the device
+};
+
+struct energy_process {
+  pid_t pid;
+  const struct gpu_info *device;
+  unsigned device_index;
+  char cmdline[GPUINFO_ENERGY_CMDLINE_SIZE];
+  bool has_engine_time;
+  uint64_t engine_time; // Engine counters in the previous refresh
+  uint64_t weight;      // Nanoseconds the process kept the engines busy since the previous refresh
+  uint64_t energy;
+  uint64_t seen_refresh; // Number of the last refresh that listed the process
+};
+
+static struct {
+  uint64_t refreshes;
+  unsigned devices_count;
+  unsigned devices_capacity;
+  struct energy_device *devices;
+  unsigned processes_count;
+  unsigned processes_capacity;
+  struct energy_process *processes;
+  unsigned lookup_hint; // Entry following the last process found, the processes come in the same order every refresh
+  struct gpuinfo_energy_exited_process exited[GPUINFO_ENERGY_EXITED_PROCESSES];
+  unsigned exited_next; // Slot of the next exit
+  unsigned exited_count;
+  uint64_t exits;
+} energy;
+
+static void *grow_array(void *array, unsigned *capacity, size_t element_size) {
+  unsigned new_capacity = *capacity + ENERGY_REALLOC_INC;
+  void *new_array = reallocarray(array, new_capacity, element_size);
+  if (!new_array) {
+    perror("Cannot allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+  *capacity = new_capacity;
+  return new_array;
+}
+
+static struct energy_device *device_account(const struct gpu_info *device) {
+  for (unsigned i = 0; i < energy.devices_count; ++i) {
+    if (energy.devices[i].device == device)
+      return &energy.devices[i];
+  }
+  if (energy.devices_count == energy.devices_capacity)
+    energy.devices = grow_array(energy.devices, &energy.devices_capacity, sizeof(*energy.devices));
+  struct energy_device *account = &energy.devices[energy.devices_count++];
+  memset(account, 0, sizeof(*account));
+  account->device = device;
+  return account;
+}
+
+static struct energy_process *find_process(pid_t pid, const struct gpu_info *device) {
+  for (unsigned i = 0; i < energy.processes_count; ++i) {
+    unsigned index = (energy.lookup_hint + i) % energy.processes_count;
+    struct energy_process *process = &energy.processes[index];
+    if (process->pid == pid && process->device == device) {
+      energy.lookup_hint = index + 1;
+      return process;
+    }
+  }
+  return NULL;
+}
+
+static struct energy_process *process_account(const struct gpu_process *gpu_process, const struct gpu_info *device,
+                                              unsigned device_index) {
+  struct energy_process *process = find_process(gpu_process->pid, device);
+  if (process)
+    return process;
+  if (energy.processes_count == energy.processes_capacity)
+    energy.processes = grow_array(energy.processes, &energy.processes_capacity, sizeof(*energy.processes));
+  process = &energy.processes[energy.processes_count++];
+  memset(process, 0, sizeof(*process));
+  process->pid = gpu_process->pid;
+  process->device = device;
+  process->device_index = device_index;
+  return process;
+}
+
+static void integrate_power(struct energy_device *account, const struct gpu_info *device, uint64_t now) {
+  bool has_power = GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, power_draw);
+  if (has_power && account->has_power && now > account->power_time) {
+    // Trapezoid between the two samples: milliwatts times nanoseconds are picojoules
+    uint64_t drawn =
+        ((uint64_t)account->power + device->dynamic_info.power_draw) * (now - account->power_time) / UINT64_C(2000000);
+    account->energy += drawn;
+    account->unshared += drawn;
+  }
+  account->has_power = has_power;
+  account->integrated = account->integrated || has_power;
+  account->power = device->dynamic_info.power_draw;
+  account->power_time = now;
+}
+
+// Time the process kept the device busy since the previous refresh
+static uint64_t process_weight(struct energy_process *process, const struct gpu_process *gpu_process,
+                               uint64_t elapsed) {
+  bool has_engine_time = false;
+  uint64_t engine_time = 0;
+  if (GPUINFO_PROCESS_FIELD_VALID(gpu_process, gfx_engine_used)) {
+    engine_time += gpu_process->gfx_engine_used;
+    has_engine_time = true;
+  }
+  if (GPUINFO_PROCESS_FIELD_VALID(gpu_process, compute_engine_used)) {
+    engine_time += gpu_process->compute_engine_used;
+    has_engine_time = true;
+  }
+  if (GPUINFO_PROCESS_FIELD_VALID(gpu_process, enc_engine_used)) {
+    engine_time += gpu_process->enc_engine_used;
+    has_engine_time = true;
+  }
+  if (GPUINFO_PROCESS_FIELD_VALID(gpu_process, dec_engine_used)) {
+    engine_time += gpu_process->dec_engine_used;
+    has_engine_time = true;
+  }
+  bool has_delta = has_engine_time && process->has_engine_time && engine_time >= process->engine_time;
+  uint64_t delta = has_delta ? engine_time - process->engine_time : 0;
+  process->has_engine_time = has_engine_time;
+  process->engine_time = engine_time;
+  if (has_delta)
+    return delta;
+  // The utilization rate for the drivers without counters (NVML) and when the counters just appeared
+  if (GPUINFO_PROCESS_FIELD_VALID(gpu_process, gpu_usage))
+    return gpu_process->gpu_usage * elapsed / 100;
+  return 0;
+}
+
+// Shares the energy drawn since the previous refresh between the processes of the device
+static void share_energy(struct energy_device *account, struct gpu_info *device, unsigned device_index,
+                         uint64_t now) {
+  uint64_t elapsed = account->shared_time ? now - account->shared_time : 0;
+  account->shared_time = now;
+  account->shared_refresh = energy.refreshes;
+
+  uint64_t total_weight = 0;
+  for (unsigned i = 0; i < device->processes_count; ++i) {
+    const struct gpu_process *gpu_process = &device->processes[i];
+    struct energy_process *process = process_account(gpu_process, device, device_index);
+    process->weight = process->seen_refresh == energy.refreshes ? 0 : process_weight(process, gpu_process, elapsed);
+    process->seen_refresh = energy.refreshes;
+    process->device_index = device_index;
+    if (!process->cmdline[0] && GPUINFO_PROCESS_FIELD_VALID(gpu_process, cmdline))
+      strncpy(process->cmdline, gpu_process->cmdline, sizeof(process->cmdline) - 1);
+    total_weight += process->weight;
+  }
+
+  // Each share is taken from what is left so that the shares add up to the energy drawn
+  uint64_t unshared = total_weight ? account->unshared : 0;
+  account->unshared = 0;
+  for (unsigned i = 0; i < device->processes_count; ++i) {
+    struct gpu_process *gpu_process = &device->processes[i];
+    struct energy_process *process = find_process(gpu_process->pid, device);
+    if (process->weight) {
+      uint64_t share = process->weight == total_weight
+                           ? unshared
+                           : (uint64_t)((double)unshared * (double)process->weight / (double)total_weight);
+      process->energy += share;
+      unshared -= share;
+      total_weight -= process->weight;
+      process->weight = 0;
+    }
+    if (account->integrated)
+      SET_GPUINFO_PROCESS(gpu_process, energy_consumed, process->energy / 1000);
+  }
+}
+
+static void remember_exit(const struct energy_process *process) {
+  struct gpuinfo_energy_exited_process *exited = &energy.exited[energy.exited_next];
+  exited->sequence = ++energy.exits;
+  exited->pid = process->pid;
+  exited->device = process->device_index;
+  memcpy(exited->cmdline, process->cmdline, sizeof(exited->cmdline));
+  exited->energy = process->energy / 1000;
+  energy.exited_next = (energy.exited_next + 1) % GPUINFO_ENERGY_EXITED_PROCESSES;
+  if (energy.exited_count < GPUINFO_ENERGY_EXITED_PROCESSES)
+    energy.exited_count++;
+}
+
+// The processes missing from this refresh exited, the ones that consumed nothing are not remembered. The processes of
+// the devices whose processes are not collected anymore are kept until they are again.
+static void retire_processes(void) {
+  for (unsigned i = 0; i < energy.processes_count;) {
+    struct energy_process *process = &energy.processes[i];
+    if (process->seen_refresh == energy.refreshes ||
+        device_account(process->device)->shared_refresh != energy.refreshes) {
+      i++;
+      continue;
+    }
+    if (process->energy >= 1000)
+      remember_exit(process);
+    *process = energy.processes[--energy.processes_count];
+  }
+}
+
+void gpuinfo_energy_account(struct list_head *devices, bool processes_refreshed) {
+  nvtop_time time;
+  nvtop_get_current_time(&time);
+  gpuinfo_energy_account_at(devices, processes_refreshed, nvtop_time_u64(time));
+}
+
+void gpuinfo_energy_account_at(struct list_head *devices, bool processes_refreshed, uint64_t now) {
+  // The energy of the devices is integrated from their power at every update
+  gpuinfo_add_consumer_needs(GPUINFO_SUBSCRIPTION(gpuinfo_subscribe_power));
+  if (processes_refreshed)
+    energy.refreshes++;
+
+  struct gpu_info *device;
+  unsigned device_index = 0;
+  list_for_each_entry(device, devices, list) {
+    struct energy_device *account = device_account(device);
+    integrate_power(account, device, now);
+    if (account->integrated)
+      SET_GPUINFO_DYNAMIC(&device->dynamic_info, energy_consumed, account->energy / 1000);
+    if (processes_refreshed && (device->subscription & GPUINFO_SUBSCRIPTION(gpuinfo_subscribe_processes)))
+      share_energy(account, device, device_index, now);
+    device_index++;
+  }
+  if (processes_refreshed)
+    retire_processes();
+}
+
+unsigned gpuinfo_energy_exited_count(void) { return energy.exited_count; }
+
+const struct gpuinfo_energy_exited_process *gpuinfo_energy_exited(unsigned index) {
+  unsigned slot = (energy.exited_next + GPUINFO_ENERGY_EXITED_PROCESSES - 1 - index) % GPUINFO_ENERGY_EXITED_PROCESSES;
+  return &energy.exited[slot];
+}
+
+void gpuinfo_energy_clear(void) {
+  free(energy.devices);
+  free(energy.processes);
+  memset(&energy, 0, sizeof(energy));
+}
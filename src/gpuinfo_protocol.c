@@ -0,0 +1,668 @@
+/*
+ *
+ * Copyright (C) 2025 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "nvtop/gpuinfo_protocol.h"
+#include "nvtop/common.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
+
+// The structures are not sent as is: each field has an index in one of the tables below and a sample only carries
+// the (index, value) pairs of the fields whose value or validity changed. The fields are thus independent from the
+// memory layout, and a new field only needs a new entry at the end of its table.
+
+static const unsigned char protocol_magic[4] = {'N', 'V', 'T', 'P'};
+
+// Messages larger than this are considered corrupted
+#define PROTOCOL_MAX_MESSAGE_SIZE (64u << 20)
+#define PROTOCOL_HEADER_SIZE 4
+#define PROTOCOL_SAMPLE_KEYFRAME 1u
+#define PROTOCOL_PROCESS_NEW 1u
+#define PROTOCOL_PROCESS_CMDLINE 2u
+#define PROTOCOL_PROCESS_USER_NAME 4u
+#define NO_VALID_BIT (-1)
+
+struct protocol_field {
+  int valid_bit; // NO_VALID_BIT if the field is always valid
+  unsigned offset;
+  unsigned size;
+};
+
+#define FIELD(type, name, valid) {(valid), offsetof(struct type, name), sizeof(((struct type *)0)->name)}
+#define DYNAMIC_FIELD(name) FIELD(gpuinfo_dynamic_info, name, gpuinfo_##name##_valid)
+#define STATIC_FIELD(name) FIELD(gpuinfo_static_info, name, gpuinfo_##name##_valid)
+#define PROCESS_FIELD(name) FIELD(gpu_process, name, gpuinfo_process_##name##_valid)
+
+static const struct protocol_field static_fields[] = {
+    STATIC_FIELD(max_pcie_gen),
+    STATIC_FIELD(max_pcie_link_width),
+    STATIC_FIELD(temperature_shutdown_threshold),
+    STATIC_FIELD(temperature_slowdown_threshold),
+    STATIC_FIELD(n_shared_cores),
+    STATIC_FIELD(l2cache_size),
+    STATIC_FIELD(n_exec_engines),
+    STATIC_FIELD(engine_count),
+    FIELD(gpuinfo_static_info, integrated_graphics, NO_VALID_BIT),
+    FIELD(gpuinfo_static_info, encode_decode_shared, NO_VALID_BIT),
+};
+
+static const struct protocol_field dynamic_fields[] = {
+    DYNAMIC_FIELD(gpu_clock_speed),
+    DYNAMIC_FIELD(gpu_clock_speed_max),
+    DYNAMIC_FIELD(mem_clock_speed),
+    DYNAMIC_FIELD(mem_clock_speed_max),
+    DYNAMIC_FIELD(gpu_util_rate),
+    DYNAMIC_FIELD(mem_util_rate),
+    DYNAMIC_FIELD(encoder_rate),
+    DYNAMIC_FIELD(decoder_rate),
+    DYNAMIC_FIELD(total_memory),
+    DYNAMIC_FIELD(free_memory),
+    DYNAMIC_FIELD(used_memory),
+    DYNAMIC_FIELD(pcie_link_gen),
+    DYNAMIC_FIELD(pcie_link_width),
+    DYNAMIC_FIELD(pcie_rx),
+    DYNAMIC_FIELD(pcie_tx),
+    DYNAMIC_FIELD(fan_speed),
+    DYNAMIC_FIELD(fan_rpm),
+    DYNAMIC_FIELD(gpu_temp),
+    DYNAMIC_FIELD(power_draw),
+    DYNAMIC_FIELD(power_draw_max),
+    DYNAMIC_FIELD(multi_instance_mode),
+    DYNAMIC_FIELD(stale_data_age),
+    DYNAMIC_FIELD(energy_consumed),
+    DYNAMIC_FIELD(power_draw_peak),
+    DYNAMIC_FIELD(power_draw_p99),
+    DYNAMIC_FIELD(throttle_reasons),
+    FIELD(gpuinfo_dynamic_info, engine_util_rate[gpuinfo_engine_render],
+          gpuinfo_engine_util_rate_valid + gpuinfo_engine_render),
+    FIELD(gpuinfo_dynamic_info, engine_util_rate[gpuinfo_engine_compute],
+          gpuinfo_engine_util_rate_valid + gpuinfo_engine_compute),
+    FIELD(gpuinfo_dynamic_info, engine_util_rate[gpuinfo_engine_copy],
+          gpuinfo_engine_util_rate_valid + gpuinfo_engine_copy),
+    FIELD(gpuinfo_dynamic_info, engine_util_rate[gpuinfo_engine_decode],
+          gpuinfo_engine_util_rate_valid + gpuinfo_engine_decode),
+    FIELD(gpuinfo_dynamic_info, engine_util_rate[gpuinfo_engine_encode],
+          gpuinfo_engine_util_rate_valid + gpuinfo_engine_encode),
+};
+
+static const struct protocol_field process_fields[] = {
+    FIELD(gpu_process, type, NO_VALID_BIT),
+    PROCESS_FIELD(sample_delta),
+    PROCESS_FIELD(gfx_engine_used),
+    PROCESS_FIELD(compute_engine_used),
+    PROCESS_FIELD(enc_engine_used),
+    PROCESS_FIELD(dec_engine_used),
+    PROCESS_FIELD(gpu_cycles),
+    PROCESS_FIELD(gpu_usage),
+    PROCESS_FIELD(encode_usage),
+    PROCESS_FIELD(decode_usage),
+    FIELD(gpu_process, engine_usage[gpuinfo_engine_render], gpuinfo_process_engine_usage_valid + gpuinfo_engine_render),
+    FIELD(gpu_process, engine_usage[gpuinfo_engine_compute],
+          gpuinfo_process_engine_usage_valid + gpuinfo_engine_compute),
+    FIELD(gpu_process, engine_usage[gpuinfo_engine_copy], gpuinfo_process_engine_usage_valid + gpuinfo_engine_copy),
+    FIELD(gpu_process, engine_usage[gpuinfo_engine_decode], gpuinfo_process_engine_usage_valid + gpuinfo_engine_decode),
+    FIELD(gpu_process, engine_usage[gpuinfo_engine_encode], gpuinfo_process_engine_usage_valid + gpuinfo_engine_encode),
+    PROCESS_FIELD(gpu_memory_usage),
+    PROCESS_FIELD(gpu_memory_percentage),
+    PROCESS_FIELD(cpu_usage),
+    PROCESS_FIELD(cpu_memory_virt),
+    PROCESS_FIELD(cpu_memory_res),
+    PROCESS_FIELD(energy_consumed),
+    PROCESS_FIELD(cpu_locality),
+};
+
+_Static_assert(ARRAY_SIZE(dynamic_fields) == gpuinfo_dynamic_info_count,
+               "A dynamic field is missing from the protocol");
+_Static_assert(ARRAY_SIZE(process_fields) == gpuinfo_process_info_count - 1,
+               "A process field is missing from the protocol");
+
+static uint64_t field_load(const void *structure, const struct protocol_field *field) {
+  const unsigned char *address = (const unsigned char *)structure + field->offset;
+  switch (field->size) {
+  case 1: {
+    uint8_t value;
+    memcpy(&value, address, sizeof(value));
+    return value;
+  }
+  case 2: {
+    uint16_t value;
+    memcpy(&value, address, sizeof(value));
+    return value;
+  }
+  case 4: {
+    uint32_t value;
+    memcpy(&value, address, sizeof(value));
+    return value;
+  }
+  default: {
+    uint64_t value;
+    memcpy(&value, address, sizeof(value));
+    return value;
+  }
+  }
+}
+
+static void field_store(void *structure, const struct protocol_field *field, uint64_t value) {
+  unsigned char *address = (unsigned char *)structure + field->offset;
+  switch (field->size) {
+  case 1: {
+    uint8_t narrow = value;
+    memcpy(address, &narrow, sizeof(narrow));
+    break;
+  }
+  case 2: {
+    uint16_t narrow = value;
+    memcpy(address, &narrow, sizeof(narrow));
+    break;
+  }
+  case 4: {
+    uint32_t narrow = value;
+    memcpy(address, &narrow, sizeof(narrow));
+    break;
+  }
+  default:
+    memcpy(address, &value, sizeof(value));
+    break;
+  }
+}
+
+static bool field_valid(const struct protocol_field *field, const unsigned char *valid) {
+  return field->valid_bit == NO_VALID_BIT || IS_VALID(field->valid_bit, valid);
+}
+
+static void buffer_reserve(struct gpuinfo_protocol_buffer *buffer, size_t extra) {
+  if (buffer->size + extra <= buffer->capacity)
+    return;
+  size_t capacity = buffer->capacity ? buffer->capacity : 256;
+  while (capacity < buffer->size + extra)
+    capacity *= 2;
+  buffer->data = realloc(buffer->data, capacity);
+  if (!buffer->data) {
+    perror("Cannot allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+  buffer->capacity = capacity;
+}
+
+static void write_bytes(struct gpuinfo_protocol_buffer *buffer, const void *bytes, size_t size) {
+  buffer_reserve(buffer, size);
+  memcpy(buffer->data + buffer->size, bytes, size);
+  buffer->size += size;
+}
+
+static void write_varint(struct gpuinfo_protocol_buffer *buffer, uint64_t value) {
+  buffer_reserve(buffer, 10);
+  do {
+    unsigned char byte = value & 0x7f;
+    value >>= 7;
+    buffer->data[buffer->size++] = byte | (value ? 0x80 : 0);
+  } while (value);
+}
+
+// A NULL string is sent as invalid
+static void write_string(struct gpuinfo_protocol_buffer *buffer, const char *string) {
+  if (!string) {
+    write_varint(buffer, 0);
+    return;
+  }
+  size_t length = strlen(string);
+  write_varint(buffer, length + 1);
+  write_bytes(buffer, string, length);
+}
+
+static size_t message_begin(struct gpuinfo_protocol_buffer *buffer, enum gpuinfo_protocol_message type) {
+  size_t start = buffer->size;
+  buffer_reserve(buffer, PROTOCOL_HEADER_SIZE + 1);
+  buffer->size += PROTOCOL_HEADER_SIZE;
+  buffer->data[buffer->size++] = type;
+  return start;
+}
+
+static void message_end(struct gpuinfo_protocol_buffer *buffer, size_t start) {
+  uint32_t length = buffer->size - start - PROTOCOL_HEADER_SIZE;
+  for (unsigned i = 0; i < PROTOCOL_HEADER_SIZE; ++i)
+    buffer->data[start + i] = (length >> (8 * i)) & 0xff;
+}
+
+// Writes the fields whose value or validity differ between previous and current
+static void write_fields(struct gpuinfo_protocol_buffer *buffer, const struct protocol_field *fields,
+                         unsigned fields_count, const void *previous, const unsigned char *previous_valid,
+                         const void *current, const unsigned char *current_valid) {
+  unsigned changed[64];
+  unsigned changed_count = 0;
+  for (unsigned i = 0; i < fields_count; ++i) {
+    bool was_valid = field_valid(&fields[i], previous_valid);
+    bool is_valid = field_valid(&fields[i], current_valid);
+    if (was_valid != is_valid || (is_valid && field_load(previous, &fields[i]) != field_load(current, &fields[i])))
+      changed[changed_count++] = i;
+  }
+  write_varint(buffer, changed_count);
+  for (unsigned i = 0; i < changed_count; ++i) {
+    const struct protocol_field *field = &fields[changed[i]];
+    bool is_valid = field_valid(field, current_valid);
+    write_varint(buffer, (uint64_t)changed[i] << 1 | is_valid);
+    if (is_valid)
+      write_varint(buffer, field_load(current, field));
+  }
+}
+
+struct protocol_reader {
+  const unsigned char *data;
+  size_t size;
+  size_t position;
+  bool failed;
+};
+
+static uint64_t read_varint(struct protocol_reader *reader) {
+  uint64_t value = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    if (reader->position >= reader->size)
+      break;
+    unsigned char byte = reader->data[reader->position++];
+    value |= (uint64_t)(byte & 0x7f) << shift;
+    if (!(byte & 0x80))
+      return value;
+  }
+  reader->failed = true;
+  return 0;
+}
+
+// Returns a NULL pointer for an invalid string, which is not terminated otherwise
+static const char *read_string(struct protocol_reader *reader, size_t *length) {
+  uint64_t encoded = read_varint(reader);
+  *length = 0;
+  if (reader->failed || encoded == 0)
+    return NULL;
+  if (encoded - 1 > reader->size - reader->position) {
+    reader->failed = true;
+    return NULL;
+  }
+  const char *string = (const char *)reader->data + reader->position;
+  *length = encoded - 1;
+  reader->position += *length;
+  return string;
+}
+
+static char *read_string_copy(struct protocol_reader *reader) {
+  size_t length;
+  const char *string = read_string(reader, &length);
+  if (!string)
+    return NULL;
+  char *copy = malloc(length + 1);
+  if (!copy) {
+    perror("Cannot allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+  memcpy(copy, string, length);
+  copy[length] = '\0';
+  return copy;
+}
+
+static void read_fields(struct protocol_reader *reader, const struct protocol_field *fields, unsigned fields_count,
+                        void *structure, unsigned char *valid) {
+  uint64_t changed_count = read_varint(reader);
+  if (changed_count > fields_count) {
+    reader->failed = true;
+    return;
+  }
+  for (uint64_t i = 0; i < changed_count && !reader->failed; ++i) {
+    uint64_t key = read_varint(reader);
+    if ((key >> 1) >= fields_count) {
+      reader->failed = true;
+      return;
+    }
+    const struct protocol_field *field = &fields[key >> 1];
+    if (key & 1) {
+      field_store(structure, field, read_varint(reader));
+      if (field->valid_bit != NO_VALID_BIT)
+        SET_VALID(field->valid_bit, valid);
+    } else if (field->valid_bit != NO_VALID_BIT) {
+      RESET_VALID(field->valid_bit, valid);
+    }
+  }
+}
+
+bool gpuinfo_protocol_user_socket_path(char *path, size_t size) {
+  const char *runtime_dir = getenv("XDG_RUNTIME_DIR");
+  if (!runtime_dir || runtime_dir[0] == '\0')
+    return false;
+  int written = snprintf(path, size, "%s/nvtopd.sock", runtime_dir);
+  return written > 0 && (size_t)written < size;
+}
+
+void gpuinfo_protocol_split_address(char *address, char **host, char **port) {
+  *host = address;
+  *port = NULL;
+  char *separator;
+  if (address[0] == '[' && (separator = strchr(address, ']'))) {
+    *host = address + 1;
+    *separator = '\0';
+    if (separator[1] == ':')
+      *port = separator + 2;
+  } else if ((separator = strrchr(address, ':')) && separator == strchr(address, ':')) {
+    // A single colon separates the port, several are an IPv6 address
+    *separator = '\0';
+    *port = separator + 1;
+  }
+  if (**host == '\0')
+    *host = NULL;
+  if (*port && **port == '\0')
+    *port = NULL;
+}
+
+static void free_processes(struct gpu_process *processes, unsigned processes_count) {
+  for (unsigned i = 0; i < processes_count; ++i) {
+    free(processes[i].cmdline);
+    free(processes[i].user_name);
+  }
+  free(processes);
+}
+
+static struct gpu_process *alloc_processes(unsigned processes_count) {
+  if (!processes_count)
+    return NULL;
+  struct gpu_process *processes = calloc(processes_count, sizeof(*processes));
+  if (!processes) {
+    perror("Cannot allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+  return processes;
+}
+
+static char *string_copy(const char *string) {
+  char *copy = strdup(string);
+  if (!copy) {
+    perror("Cannot allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+  return copy;
+}
+
+void gpuinfo_protocol_state_clear(struct gpuinfo_protocol_state *state) {
+  for (unsigned i = 0; i < state->devices_count; ++i)
+    free_processes(state->devices[i].processes, state->devices[i].processes_count);
+  free(state->devices);
+  state->devices = NULL;
+  state->devices_count = 0;
+}
+
+static void state_resize(struct gpuinfo_protocol_state *state, unsigned devices_count) {
+  gpuinfo_protocol_state_clear(state);
+  if (!devices_count)
+    return;
+  state->devices = calloc(devices_count, sizeof(*state->devices));
+  if (!state->devices) {
+    perror("Cannot allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+  state->devices_count = devices_count;
+}
+
+void gpuinfo_protocol_state_from_devices(struct gpuinfo_protocol_state *state, struct list_head *devices) {
+  unsigned devices_count = 0;
+  struct gpu_info *device;
+  list_for_each_entry(device, devices, list) { devices_count++; }
+  state_resize(state, devices_count);
+
+  struct gpuinfo_protocol_device *copy = state->devices;
+  list_for_each_entry(device, devices, list) {
+    memcpy(copy->pdev, device->pdev, PDEV_LEN);
+    copy->pdev[PDEV_LEN - 1] = '\0';
+    copy->static_info = device->static_info;
+    copy->dynamic_info = device->dynamic_info;
+    copy->processes_count = device->processes_count;
+    copy->processes = alloc_processes(device->processes_count);
+    for (unsigned i = 0; i < device->processes_count; ++i) {
+      struct gpu_process *process = &copy->processes[i];
+      *process = device->processes[i];
+      process->cmdline = NULL;
+      process->user_name = NULL;
+      if (GPUINFO_PROCESS_FIELD_VALID(&device->processes[i], cmdline))
+        process->cmdline = string_copy(device->processes[i].cmdline);
+      else
+        RESET_GPUINFO_PROCESS(process, cmdline);
+      if (GPUINFO_PROCESS_FIELD_VALID(&device->processes[i], user_name))
+        process->user_name = string_copy(device->processes[i].user_name);
+      else
+        RESET_GPUINFO_PROCESS(process, user_name);
+    }
+    copy++;
+  }
+}
+
+void gpuinfo_protocol_encode_hello(struct gpuinfo_protocol_buffer *buffer, const struct gpuinfo_protocol_state *state) {
+  static const struct gpuinfo_static_info no_static_info;
+  size_t start = message_begin(buffer, gpuinfo_protocol_hello);
+  write_bytes(buffer, protocol_magic, sizeof(protocol_magic));
+  write_varint(buffer, GPUINFO_PROTOCOL_VERSION);
+  write_varint(buffer, state->devices_count);
+  for (unsigned i = 0; i < state->devices_count; ++i) {
+    const struct gpuinfo_static_info *static_info = &state->devices[i].static_info;
+    write_string(buffer, state->devices[i].pdev);
+    write_string(buffer, GPUINFO_STATIC_FIELD_VALID(static_info, device_name) ? static_info->device_name : NULL);
+    write_fields(buffer, static_fields, ARRAY_SIZE(static_fields), &no_static_info, no_static_info.valid, static_info,
+                 static_info->valid);
+  }
+  message_end(buffer, start);
+}
+
+// The process of the previous sample a process is compared with: the one at the same position if it has the same
+// pid, the first one with this pid otherwise. Both ends must agree on this choice.
+static const struct gpu_process *previous_process(const struct gpu_process *processes, unsigned processes_count,
+                                                  unsigned position, pid_t pid) {
+  if (position < processes_count && processes[position].pid == pid)
+    return &processes[position];
+  for (unsigned i = 0; i < processes_count; ++i) {
+    if (processes[i].pid == pid)
+      return &processes[i];
+  }
+  return NULL;
+}
+
+static bool string_changed(const char *previous, const char *current) {
+  if (!previous || !current)
+    return previous != current;
+  return strcmp(previous, current) != 0;
+}
+
+static void write_processes(struct gpuinfo_protocol_buffer *buffer, const struct gpuinfo_protocol_device *previous,
+                            const struct gpuinfo_protocol_device *current) {
+  static const struct gpu_process no_process;
+  write_varint(buffer, current->processes_count);
+  for (unsigned i = 0; i < current->processes_count; ++i) {
+    const struct gpu_process *process = &current->processes[i];
+    const struct gpu_process *base = NULL;
+    if (previous)
+      base = previous_process(previous->processes, previous->processes_count, i, process->pid);
+    unsigned flags = 0;
+    if (!base) {
+      flags |= PROTOCOL_PROCESS_NEW;
+      base = &no_process;
+    }
+    if (string_changed(base->cmdline, process->cmdline))
+      flags |= PROTOCOL_PROCESS_CMDLINE;
+    if (string_changed(base->user_name, process->user_name))
+      flags |= PROTOCOL_PROCESS_USER_NAME;
+    write_varint(buffer, (uint32_t)process->pid);
+    write_varint(buffer, flags);
+    if (flags & PROTOCOL_PROCESS_CMDLINE)
+      write_string(buffer, process->cmdline);
+    if (flags & PROTOCOL_PROCESS_USER_NAME)
+      write_string(buffer, process->user_name);
+    write_fields(buffer, process_fields, ARRAY_SIZE(process_fields), base, base->valid, process, process->valid);
+  }
+}
+
+void gpuinfo_protocol_encode_sample(struct gpuinfo_protocol_buffer *buffer,
+                                    const struct gpuinfo_protocol_state *previous,
+                                    const struct gpuinfo_protocol_state *current) {
+  static const struct gpuinfo_dynamic_info no_dynamic_info;
+  // The devices never change while the daemon runs
+  if (previous && previous->devices_count != current->devices_count)
+    previous = NULL;
+  size_t start = message_begin(buffer, gpuinfo_protocol_sample);
+  write_varint(buffer, previous ? 0 : PROTOCOL_SAMPLE_KEYFRAME);
+  write_varint(buffer, current->devices_count);
+  for (unsigned i = 0; i < current->devices_count; ++i) {
+    const struct gpuinfo_protocol_device *previous_device = previous ? &previous->devices[i] : NULL;
+    const struct gpuinfo_dynamic_info *base = previous_device ? &previous_device->dynamic_info : &no_dynamic_info;
+    const struct gpuinfo_dynamic_info *dynamic_info = &current->devices[i].dynamic_info;
+    write_fields(buffer, dynamic_fields, ARRAY_SIZE(dynamic_fields), base, base->valid, dynamic_info,
+                 dynamic_info->valid);
+    write_processes(buffer, previous_device, &current->devices[i]);
+  }
+  message_end(buffer, start);
+}
+
+size_t gpuinfo_protocol_message_length(const unsigned char *data, size_t size) {
+  if (size < PROTOCOL_HEADER_SIZE)
+    return 0;
+  uint32_t length = 0;
+  for (unsigned i = 0; i < PROTOCOL_HEADER_SIZE; ++i)
+    length |= (uint32_t)data[i] << (8 * i);
+  // Let the decoder reject it
+  if (length > PROTOCOL_MAX_MESSAGE_SIZE)
+    return PROTOCOL_HEADER_SIZE;
+  if (size - PROTOCOL_HEADER_SIZE < length)
+    return 0;
+  return PROTOCOL_HEADER_SIZE + length;
+}
+
+static bool decode_hello(struct protocol_reader *reader, struct gpuinfo_protocol_state *state) {
+  if (reader->size - reader->position < sizeof(protocol_magic) ||
+      memcmp(reader->data + reader->position, protocol_magic, sizeof(protocol_magic)))
+    return false;
+  reader->position += sizeof(protocol_magic);
+  if (read_varint(reader) != GPUINFO_PROTOCOL_VERSION)
+    return false;
+  uint64_t devices_count = read_varint(reader);
+  // Each device takes a few bytes at least
+  if (reader->failed || devices_count > reader->size - reader->position)
+    return false;
+  state_resize(state, devices_count);
+  for (unsigned i = 0; i < state->devices_count && !reader->failed; ++i) {
+    struct gpuinfo_protocol_device *device = &state->devices[i];
+    size_t length;
+    const char *pdev = read_string(reader, &length);
+    if (pdev)
+      memcpy(device->pdev, pdev, length < PDEV_LEN - 1 ? length : PDEV_LEN - 1);
+    const char *device_name = read_string(reader, &length);
+    if (device_name) {
+      memcpy(device->static_info.device_name, device_name, length < MAX_DEVICE_NAME - 1 ? length : MAX_DEVICE_NAME - 1);
+      SET_VALID(gpuinfo_device_name_valid, device->static_info.valid);
+    }
+    read_fields(reader, static_fields, ARRAY_SIZE(static_fields), &device->static_info, device->static_info.valid);
+  }
+  return !reader->failed;
+}
+
+static bool decode_processes(struct protocol_reader *reader, struct gpuinfo_protocol_device *device, bool keyframe) {
+  uint64_t processes_count = read_varint(reader);
+  if (reader->failed || processes_count > reader->size - reader->position)
+    return false;
+  struct gpu_process *processes = alloc_processes(processes_count);
+  for (unsigned i = 0; i < processes_count && !reader->failed; ++i) {
+    struct gpu_process *process = &processes[i];
+    pid_t pid = (pid_t)(uint32_t)read_varint(reader);
+    unsigned flags = read_varint(reader);
+    const struct gpu_process *base = NULL;
+    if (!(flags & PROTOCOL_PROCESS_NEW) && !keyframe) {
+      base = previous_process(device->processes, device->processes_count, i, pid);
+      if (!base) {
+        reader->failed = true;
+        break;
+      }
+      *process = *base;
+    }
+    process->pid = pid;
+    if (flags & PROTOCOL_PROCESS_CMDLINE)
+      process->cmdline = read_string_copy(reader);
+    else
+      process->cmdline = base && base->cmdline ? string_copy(base->cmdline) : NULL;
+    if (flags & PROTOCOL_PROCESS_USER_NAME)
+      process->user_name = read_string_copy(reader);
+    else
+      process->user_name = base && base->user_name ? string_copy(base->user_name) : NULL;
+    if (process->cmdline)
+      SET_VALID(gpuinfo_process_cmdline_valid, process->valid);
+    else
+      RESET_VALID(gpuinfo_process_cmdline_valid, process->valid);
+    if (process->user_name)
+      SET_VALID(gpuinfo_process_user_name_valid, process->valid);
+    else
+      RESET_VALID(gpuinfo_process_user_name_valid, process->valid);
+    read_fields(reader, process_fields, ARRAY_SIZE(process_fields), process, process->valid);
+  }
+  if (reader->failed) {
+    free_processes(processes, processes_count);
+    return false;
+  }
+  free_processes(device->processes, device->processes_count);
+  device->processes = processes;
+  device->processes_count = processes_count;
+  return true;
+}
+
+static bool decode_sample(struct protocol_reader *reader, struct gpuinfo_protocol_state *state) {
+  bool keyframe = read_varint(reader) & PROTOCOL_SAMPLE_KEYFRAME;
+  uint64_t devices_count = read_varint(reader);
+  if (reader->failed || devices_count != state->devices_count)
+    return false;
+  for (unsigned i = 0; i < state->devices_count; ++i) {
+    struct gpuinfo_protocol_device *device = &state->devices[i];
+    if (keyframe)
+      memset(&device->dynamic_info, 0, sizeof(device->dynamic_info));
+    read_fields(reader, dynamic_fields, ARRAY_SIZE(dynamic_fields), &device->dynamic_info,
+                device->dynamic_info.valid);
+    if (reader->failed || !decode_processes(reader, device, keyframe))
+      return false;
+  }
+  return true;
+}
+
+bool gpuinfo_protocol_decode(const unsigned char *message, size_t length, struct gpuinfo_protocol_state *state,
+                             enum gpuinfo_protocol_message *type) {
+  if (length < PROTOCOL_HEADER_SIZE + 1 || length - PROTOCOL_HEADER_SIZE > PROTOCOL_MAX_MESSAGE_SIZE)
+    return false;
+  struct protocol_reader reader = {.data = message, .size = length, .position = PROTOCOL_HEADER_SIZE};
+  *type = reader.data[reader.position++];
+  switch (*type) {
+  case gpuinfo_protocol_hello:
+    return decode_hello(&reader, state);
+  case gpuinfo_protocol_sample:
+    return decode_sample(&reader, state);
+  default:
+    // Unknown messages of newer daemons are skipped
+    return true;
+  }
+}
+
+void gpuinfo_protocol_buffer_free(struct gpuinfo_protocol_buffer *buffer) {
+  free(buffer->data);
+  buffer->data = NULL;
+  buffer->size = 0;
+  buffer->capacity = 0;
+}
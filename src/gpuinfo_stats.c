@@ -0,0 +1,564 @@
+/*
+ *
+ * Copyright (C) 2025 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "nvtop/gpuinfo_stats.h"
+#include "nvtop/common.h"
+#include "nvtop/extract_gpuinfo.h"
+#include "nvtop/extract_gpuinfo_common.h"
+#include "nvtop/time.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Log-linear histogram: the values below 2^(STATS_SUB_BUCKET_BITS + 1) have their own bucket, then each power of two
+// is split into 2^STATS_SUB_BUCKET_BITS buckets, up to 2^32. A bucket spans at most 1/32 of its values.
+#define STATS_SUB_BUCKET_BITS 5
+#define STATS_SUB_BUCKETS (1u << STATS_SUB_BUCKET_BITS)
+#define STATS_VALUE_BITS 32
+#define STATS_HISTOGRAM_BUCKETS ((STATS_VALUE_BITS - STATS_SUB_BUCKET_BITS + 1) * STATS_SUB_BUCKETS)
+// About 1.8MiB when full
+#define STATS_MAX_PROCESSES 256
+#define STATS_PROCESSES_REALLOC_INC 16
+#define STATS_CMDLINE_SIZE 64
+// A device is at its maximum clock or at its power limit within this percentage
+#define STATS_LIMIT_PERCENT 95
+
+struct stats_metric {
+  uint64_t count;
+  uint32_t min;
+  uint32_t max;
+  double sum;
+  uint32_t buckets[STATS_HISTOGRAM_BUCKETS];
+};
+
+struct stats_device {
+  char name[MAX_DEVICE_NAME];
+  bool has_name;
+  bool has_energy;
+  uint64_t energy; // Millijoules
+  struct stats_metric metrics[gpuinfo_stats_device_metric_count];
+  unsigned observable;   // Conditions that could be evaluated in the previous sample
+  unsigned in_condition; // Conditions met in the previous sample
+  uint64_t observed[gpuinfo_stats_residency_count];  // Nanoseconds
+  uint64_t residency[gpuinfo_stats_residency_count]; // Nanoseconds
+};
+
+struct stats_process {
+  pid_t pid;
+  unsigned device;
+  char cmdline[STATS_CMDLINE_SIZE];
+  uint64_t first_seen;
+  uint64_t last_seen;
+  uint64_t seen_sample; // Sample number of the last time the process was seen
+  bool has_engine_time;
+  uint64_t engine_time; // Engine counter in the previous sample
+  uint64_t busy_time;   // Accumulated engine time
+  bool has_energy;
+  uint64_t energy; // Millijoules
+  struct stats_metric metrics[gpuinfo_stats_process_metric_count];
+};
+
+struct stats_metric_name {
+  const char *name;
+  const char *unit;
+};
+
+static const struct stats_metric_name device_metrics[gpuinfo_stats_device_metric_count] = {
+    [gpuinfo_stats_gpu_util] = {"gpu_util", "%"},
+    [gpuinfo_stats_mem_util] = {"mem_util", "%"},
+    [gpuinfo_stats_power] = {"power", "mW"},
+    [gpuinfo_stats_memory_used] = {"memory_used", "MiB"},
+    [gpuinfo_stats_temperature] = {"temperature", "C"},
+    [gpuinfo_stats_gpu_clock] = {"gpu_clock", "MHz"},
+};
+
+static const char *residency_names[gpuinfo_stats_residency_count] = {
+    [gpuinfo_stats_throttled] = "throttled",
+    [gpuinfo_stats_throttled_power] = "throttled_power",
+    [gpuinfo_stats_throttled_thermal] = "throttled_thermal",
+    [gpuinfo_stats_throttled_hardware] = "throttled_hardware",
+    [gpuinfo_stats_throttled_other] = "throttled_other",
+    [gpuinfo_stats_below_max_clock] = "below_max_clock",
+    [gpuinfo_stats_hot] = "hot",
+    [gpuinfo_stats_power_capped] = "power_capped",
+};
+
+static const struct stats_metric_name process_metrics[gpuinfo_stats_process_metric_count] = {
+    [gpuinfo_stats_process_gpu_usage] = {"gpu_usage", "%"},
+    [gpuinfo_stats_process_gpu_memory] = {"gpu_memory", "MiB"},
+};
+
+static struct {
+  uint64_t samples;
+  uint64_t first_sample;
+  uint64_t last_sample;
+  unsigned devices_count;
+  struct stats_device *devices;
+  unsigned processes_count;
+  unsigned processes_capacity;
+  struct stats_process *processes;
+  unsigned lookup_hint; // Entry following the last process found, the processes come in the same order every sample
+  const char *dump_path;
+} stats;
+
+static volatile sig_atomic_t stats_dump_requested = 0;
+
+const char *gpuinfo_stats_device_metric_name(enum gpuinfo_stats_device_metric metric) {
+  return device_metrics[metric].name;
+}
+
+const char *gpuinfo_stats_device_metric_unit(enum gpuinfo_stats_device_metric metric) {
+  return device_metrics[metric].unit;
+}
+
+const char *gpuinfo_stats_residency_name(enum gpuinfo_stats_residency residency) {
+  return residency_names[residency];
+}
+
+const char *gpuinfo_stats_process_metric_name(enum gpuinfo_stats_process_metric metric) {
+  return process_metrics[metric].name;
+}
+
+const char *gpuinfo_stats_process_metric_unit(enum gpuinfo_stats_process_metric metric) {
+  return process_metrics[metric].unit;
+}
+
+static unsigned histogram_bucket(uint32_t value) {
+  if (value < 2 * STATS_SUB_BUCKETS)
+    return value;
+  unsigned exponent = 31 - __builtin_clz(value);
+  unsigned shift = exponent - STATS_SUB_BUCKET_BITS;
+  return shift * STATS_SUB_BUCKETS + (value >> shift);
+}
+
+// Middle of the values falling in the bucket
+static double histogram_bucket_value(unsigned bucket) {
+  if (bucket < 2 * STATS_SUB_BUCKETS)
+    return bucket;
+  unsigned shift = bucket / STATS_SUB_BUCKETS - 1;
+  uint64_t lowest = (uint64_t)(bucket % STATS_SUB_BUCKETS + STATS_SUB_BUCKETS) << shift;
+  return (double)lowest + (double)((UINT64_C(1) << shift) - 1) / 2.;
+}
+
+static void metric_add(struct stats_metric *metric, uint64_t value) {
+  uint32_t clamped = value > UINT32_MAX ? UINT32_MAX : (uint32_t)value;
+  if (!metric->count || clamped < metric->min)
+    metric->min = clamped;
+  if (!metric->count || clamped > metric->max)
+    metric->max = clamped;
+  metric->count++;
+  metric->sum += clamped;
+  metric->buckets[histogram_bucket(clamped)]++;
+}
+
+static double metric_percentile(const struct stats_metric *metric, double percentile) {
+  uint64_t rank = (uint64_t)(percentile * (double)metric->count + 0.999999);
+  if (rank == 0)
+    rank = 1;
+  uint64_t seen = 0;
+  for (unsigned bucket = 0; bucket < STATS_HISTOGRAM_BUCKETS; ++bucket) {
+    seen += metric->buckets[bucket];
+    if (seen >= rank) {
+      double value = histogram_bucket_value(bucket);
+      // The extremes are exact
+      if (value < metric->min)
+        return metric->min;
+      if (value > metric->max)
+        return metric->max;
+      return value;
+    }
+  }
+  return metric->max;
+}
+
+static void metric_summary(const struct stats_metric *metric, struct gpuinfo_stats_summary *summary) {
+  *summary = (struct gpuinfo_stats_summary){.count = metric->count};
+  if (!metric->count)
+    return;
+  summary->min = metric->min;
+  summary->max = metric->max;
+  summary->mean = metric->sum / (double)metric->count;
+  summary->p50 = metric_percentile(metric, 0.50);
+  summary->p95 = metric_percentile(metric, 0.95);
+  summary->p99 = metric_percentile(metric, 0.99);
+}
+
+#define RESIDENCY_BIT(residency) (1u << (residency))
+
+static void set_condition(struct stats_device *stats_device, enum gpuinfo_stats_residency residency, bool met) {
+  stats_device->observable |= RESIDENCY_BIT(residency);
+  if (met)
+    stats_device->in_condition |= RESIDENCY_BIT(residency);
+}
+
+static void record_residency(struct stats_device *stats_device, const struct gpu_info *device, uint64_t elapsed) {
+  for (enum gpuinfo_stats_residency residency = 0; residency < gpuinfo_stats_residency_count; ++residency) {
+    if (stats_device->observable & RESIDENCY_BIT(residency))
+      stats_device->observed[residency] += elapsed;
+    if (stats_device->in_condition & RESIDENCY_BIT(residency))
+      stats_device->residency[residency] += elapsed;
+  }
+
+  stats_device->observable = 0;
+  stats_device->in_condition = 0;
+  const struct gpuinfo_dynamic_info *info = &device->dynamic_info;
+  if (GPUINFO_DYNAMIC_FIELD_VALID(info, throttle_reasons)) {
+    set_condition(stats_device, gpuinfo_stats_throttled, info->throttle_reasons != 0);
+    static const enum gpuinfo_stats_residency by_reason[gpuinfo_throttle_reason_count] = {
+        [gpuinfo_throttle_power] = gpuinfo_stats_throttled_power,
+        [gpuinfo_throttle_thermal] = gpuinfo_stats_throttled_thermal,
+        [gpuinfo_throttle_hardware] = gpuinfo_stats_throttled_hardware,
+        [gpuinfo_throttle_other] = gpuinfo_stats_throttled_other,
+    };
+    for (enum gpuinfo_throttle_reason reason = 0; reason < gpuinfo_throttle_reason_count; ++reason)
+      set_condition(stats_device, by_reason[reason], info->throttle_reasons & GPUINFO_THROTTLE_REASON(reason));
+  }
+  // An idle device lowers its clock on purpose
+  if (GPUINFO_DYNAMIC_FIELD_VALID(info, gpu_clock_speed) && GPUINFO_DYNAMIC_FIELD_VALID(info, gpu_clock_speed_max) &&
+      info->gpu_clock_speed_max && GPUINFO_DYNAMIC_FIELD_VALID(info, gpu_util_rate) && info->gpu_util_rate)
+    set_condition(stats_device, gpuinfo_stats_below_max_clock,
+                  info->gpu_clock_speed * 100 < info->gpu_clock_speed_max * STATS_LIMIT_PERCENT);
+  const struct gpuinfo_static_info *static_info = &device->static_info;
+  if (GPUINFO_DYNAMIC_FIELD_VALID(info, gpu_temp) &&
+      GPUINFO_STATIC_FIELD_VALID(static_info, temperature_slowdown_threshold) &&
+      static_info->temperature_slowdown_threshold)
+    set_condition(stats_device, gpuinfo_stats_hot, info->gpu_temp >= static_info->temperature_slowdown_threshold);
+  if (GPUINFO_DYNAMIC_FIELD_VALID(info, power_draw) && GPUINFO_DYNAMIC_FIELD_VALID(info, power_draw_max) &&
+      info->power_draw_max)
+    set_condition(stats_device, gpuinfo_stats_power_capped,
+                  (uint64_t)info->power_draw * 100 >= (uint64_t)info->power_draw_max * STATS_LIMIT_PERCENT);
+}
+
+static void record_device(struct stats_device *stats_device, const struct gpu_info *device, uint64_t elapsed) {
+  record_residency(stats_device, device, elapsed);
+  if (!stats_device->has_name && GPUINFO_STATIC_FIELD_VALID(&device->static_info, device_name)) {
+    strncpy(stats_device->name, device->static_info.device_name, sizeof(stats_device->name) - 1);
+    stats_device->has_name = true;
+  }
+  const struct gpuinfo_dynamic_info *info = &device->dynamic_info;
+  struct stats_metric *metrics = stats_device->metrics;
+  if (GPUINFO_DYNAMIC_FIELD_VALID(info, gpu_util_rate))
+    metric_add(&metrics[gpuinfo_stats_gpu_util], info->gpu_util_rate);
+  if (GPUINFO_DYNAMIC_FIELD_VALID(info, mem_util_rate))
+    metric_add(&metrics[gpuinfo_stats_mem_util], info->mem_util_rate);
+  if (GPUINFO_DYNAMIC_FIELD_VALID(info, power_draw))
+    metric_add(&metrics[gpuinfo_stats_power], info->power_draw);
+  if (GPUINFO_DYNAMIC_FIELD_VALID(info, used_memory))
+    metric_add(&metrics[gpuinfo_stats_memory_used], info->used_memory >> 20);
+  if (GPUINFO_DYNAMIC_FIELD_VALID(info, gpu_temp))
+    metric_add(&metrics[gpuinfo_stats_temperature], info->gpu_temp);
+  if (GPUINFO_DYNAMIC_FIELD_VALID(info, gpu_clock_speed))
+    metric_add(&metrics[gpuinfo_stats_gpu_clock], info->gpu_clock_speed);
+  if (GPUINFO_DYNAMIC_FIELD_VALID(info, energy_consumed)) {
+    stats_device->energy = info->energy_consumed;
+    stats_device->has_energy = true;
+  }
+}
+
+static struct stats_process *find_process(pid_t pid, unsigned device) {
+  for (unsigned i = 0; i < stats.processes_count; ++i) {
+    unsigned index = (stats.lookup_hint + i) % stats.processes_count;
+    struct stats_process *process = &stats.processes[index];
+    if (process->pid == pid && process->device == device) {
+      stats.lookup_hint = index + 1;
+      return process;
+    }
+  }
+  return NULL;
+}
+
+static struct stats_process *new_process(pid_t pid, unsigned device) {
+  struct stats_process *process;
+  if (stats.processes_count < STATS_MAX_PROCESSES) {
+    if (stats.processes_count == stats.processes_capacity) {
+      unsigned capacity = stats.processes_capacity + STATS_PROCESSES_REALLOC_INC;
+      struct stats_process *processes = reallocarray(stats.processes, capacity, sizeof(*processes));
+      if (!processes) {
+        perror("Cannot allocate memory: ");
+        exit(EXIT_FAILURE);
+      }
+      stats.processes = processes;
+      stats.processes_capacity = capacity;
+    }
+    process = &stats.processes[stats.processes_count++];
+  } else {
+    // Replace the process gone for the longest time, unless they are all running
+    process = &stats.processes[0];
+    for (unsigned i = 1; i < stats.processes_count; ++i) {
+      if (stats.processes[i].seen_sample < process->seen_sample)
+        process = &stats.processes[i];
+    }
+    if (process->seen_sample == stats.samples)
+      return NULL;
+  }
+  memset(process, 0, sizeof(*process));
+  process->pid = pid;
+  process->device = device;
+  process->first_seen = stats.last_sample;
+  return process;
+}
+
+static void record_process(const struct gpu_process *gpu_process, unsigned device) {
+  struct stats_process *process = find_process(gpu_process->pid, device);
+  if (!process) {
+    process = new_process(gpu_process->pid, device);
+    if (!process)
+      return;
+  }
+  process->last_seen = stats.last_sample;
+  process->seen_sample = stats.samples;
+  if (!process->cmdline[0] && GPUINFO_PROCESS_FIELD_VALID(gpu_process, cmdline))
+    strncpy(process->cmdline, gpu_process->cmdline, sizeof(process->cmdline) - 1);
+
+  // The engine counters give the exact time spent on the device, whatever the sampling rate
+  if (GPUINFO_PROCESS_FIELD_VALID(gpu_process, gfx_engine_used) ||
+      GPUINFO_PROCESS_FIELD_VALID(gpu_process, compute_engine_used)) {
+    uint64_t engine_time = 0;
+    if (GPUINFO_PROCESS_FIELD_VALID(gpu_process, gfx_engine_used))
+      engine_time += gpu_process->gfx_engine_used;
+    if (GPUINFO_PROCESS_FIELD_VALID(gpu_process, compute_engine_used))
+      engine_time += gpu_process->compute_engine_used;
+    if (process->has_engine_time && engine_time >= process->engine_time)
+      process->busy_time += engine_time - process->engine_time;
+    process->engine_time = engine_time;
+    process->has_engine_time = true;
+  }
+  if (GPUINFO_PROCESS_FIELD_VALID(gpu_process, energy_consumed)) {
+    process->energy = gpu_process->energy_consumed;
+    process->has_energy = true;
+  }
+  if (GPUINFO_PROCESS_FIELD_VALID(gpu_process, gpu_usage))
+    metric_add(&process->metrics[gpuinfo_stats_process_gpu_usage], gpu_process->gpu_usage);
+  if (GPUINFO_PROCESS_FIELD_VALID(gpu_process, gpu_memory_usage))
+    metric_add(&process->metrics[gpuinfo_stats_process_gpu_memory], gpu_process->gpu_memory_usage >> 20);
+}
+
+void gpuinfo_stats_record(struct list_head *devices, bool processes_refreshed) {
+  if (stats_dump_requested) {
+    stats_dump_requested = 0;
+    if (stats.dump_path)
+      gpuinfo_stats_write_json(stats.dump_path);
+  }
+
+  nvtop_time now;
+  nvtop_get_current_time(&now);
+  uint64_t elapsed = stats.samples ? nvtop_time_u64(now) - stats.last_sample : 0;
+  stats.last_sample = nvtop_time_u64(now);
+  if (!stats.samples)
+    stats.first_sample = stats.last_sample;
+  stats.samples++;
+
+  unsigned devices_count = 0;
+  const struct gpu_info *device;
+  list_for_each_entry(device, devices, list) { devices_count++; }
+  if (devices_count > stats.devices_count) {
+    struct stats_device *new_devices = reallocarray(stats.devices, devices_count, sizeof(*new_devices));
+    if (!new_devices) {
+      perror("Cannot allocate memory: ");
+      exit(EXIT_FAILURE);
+    }
+    memset(new_devices + stats.devices_count, 0, (devices_count - stats.devices_count) * sizeof(*new_devices));
+    stats.devices = new_devices;
+    stats.devices_count = devices_count;
+  }
+
+  unsigned device_index = 0;
+  list_for_each_entry(device, devices, list) {
+    record_device(&stats.devices[device_index], device, elapsed);
+    if (processes_refreshed) {
+      for (unsigned i = 0; i < device->processes_count; ++i)
+        record_process(&device->processes[i], device_index);
+    }
+    device_index++;
+  }
+}
+
+double gpuinfo_stats_duration(void) { return (double)(stats.last_sample - stats.first_sample) / 1e9; }
+
+uint64_t gpuinfo_stats_samples(void) { return stats.samples; }
+
+unsigned gpuinfo_stats_devices_count(void) { return stats.devices_count; }
+
+const char *gpuinfo_stats_device_name(unsigned device) {
+  return stats.devices[device].has_name ? stats.devices[device].name : NULL;
+}
+
+void gpuinfo_stats_device_summary(unsigned device, enum gpuinfo_stats_device_metric metric,
+                                  struct gpuinfo_stats_summary *summary) {
+  metric_summary(&stats.devices[device].metrics[metric], summary);
+}
+
+bool gpuinfo_stats_device_energy(unsigned device, double *energy) {
+  *energy = (double)stats.devices[device].energy / 1e3;
+  return stats.devices[device].has_energy;
+}
+
+void gpuinfo_stats_device_residency(unsigned device, enum gpuinfo_stats_residency residency,
+                                    struct gpuinfo_stats_residency_time *time) {
+  time->observed = (double)stats.devices[device].observed[residency] / 1e9;
+  time->time = (double)stats.devices[device].residency[residency] / 1e9;
+}
+
+unsigned gpuinfo_stats_processes_count(void) { return stats.processes_count; }
+
+void gpuinfo_stats_process_summary(unsigned index, struct gpuinfo_stats_process *summary) {
+  const struct stats_process *process = &stats.processes[index];
+  summary->pid = process->pid;
+  summary->device = process->device;
+  summary->cmdline = process->cmdline;
+  summary->lifetime = (double)(process->last_seen - process->first_seen) / 1e9;
+  summary->has_busy_time = process->has_engine_time;
+  summary->busy_time = (double)process->busy_time / 1e9;
+  summary->has_energy = process->has_energy;
+  summary->energy = (double)process->energy / 1e3;
+  summary->running = process->seen_sample == stats.samples;
+  for (enum gpuinfo_stats_process_metric metric = 0; metric < gpuinfo_stats_process_metric_count; ++metric)
+    metric_summary(&process->metrics[metric], &summary->metrics[metric]);
+}
+
+static void write_json_string(FILE *file, const char *str) {
+  fputc('"', file);
+  for (; *str; ++str) {
+    unsigned char c = *str;
+    if (c == '"' || c == '\\')
+      fprintf(file, "\\%c", c);
+    else if (c < 0x20)
+      fprintf(file, "\\u%04x", c);
+    else
+      fputc(c, file);
+  }
+  fputc('"', file);
+}
+
+static void write_json_summary(FILE *file, const char *name, const char *unit,
+                               const struct gpuinfo_stats_summary *summary) {
+  fprintf(file, "\"%s\": {\"unit\": \"%s\", \"samples\": %llu", name, unit, (unsigned long long)summary->count);
+  if (summary->count)
+    fprintf(file, ", \"min\": %.2f, \"mean\": %.2f, \"p50\": %.2f, \"p95\": %.2f, \"p99\": %.2f, \"max\": %.2f",
+            summary->min, summary->mean, summary->p50, summary->p95, summary->p99, summary->max);
+  fputc('}', file);
+}
+
+static void write_json(FILE *file) {
+  fprintf(file, "{\n  \"duration\": %.3f,\n  \"samples\": %llu,\n  \"devices\": [", gpuinfo_stats_duration(),
+          (unsigned long long)stats.samples);
+  for (unsigned device = 0; device < stats.devices_count; ++device) {
+    fprintf(file, "%s\n    {\"index\": %u, \"name\": ", device ? "," : "", device);
+    const char *name = gpuinfo_stats_device_name(device);
+    if (name)
+      write_json_string(file, name);
+    else
+      fputs("null", file);
+    double energy;
+    if (gpuinfo_stats_device_energy(device, &energy))
+      fprintf(file, ", \"energy\": %.3f", energy);
+    else
+      fputs(", \"energy\": null", file);
+    for (enum gpuinfo_stats_device_metric metric = 0; metric < gpuinfo_stats_device_metric_count; ++metric) {
+      struct gpuinfo_stats_summary summary;
+      gpuinfo_stats_device_summary(device, metric, &summary);
+      fputs(",\n     ", file);
+      write_json_summary(file, device_metrics[metric].name, device_metrics[metric].unit, &summary);
+    }
+    fputs(",\n     \"residency\": {", file);
+    for (enum gpuinfo_stats_residency residency = 0; residency < gpuinfo_stats_residency_count; ++residency) {
+      struct gpuinfo_stats_residency_time time;
+      gpuinfo_stats_device_residency(device, residency, &time);
+      fprintf(file, "%s\"%s\": {\"observed\": %.3f, \"time\": %.3f}", residency ? ", " : "",
+              residency_names[residency], time.observed, time.time);
+    }
+    fputs("}}", file);
+  }
+  fputs("\n  ],\n  \"processes\": [", file);
+  for (unsigned i = 0; i < stats.processes_count; ++i) {
+    struct gpuinfo_stats_process process;
+    gpuinfo_stats_process_summary(i, &process);
+    fprintf(file, "%s\n    {\"pid\": %d, \"device\": %u, \"cmdline\": ", i ? "," : "", (int)process.pid,
+            process.device);
+    write_json_string(file, process.cmdline);
+    fprintf(file, ", \"running\": %s, \"lifetime\": %.3f, \"busy_time\": ", process.running ? "true" : "false",
+            process.lifetime);
+    if (process.has_busy_time)
+      fprintf(file, "%.3f", process.busy_time);
+    else
+      fputs("null", file);
+    if (process.has_energy)
+      fprintf(file, ", \"energy\": %.3f", process.energy);
+    else
+      fputs(", \"energy\": null", file);
+    for (enum gpuinfo_stats_process_metric metric = 0; metric < gpuinfo_stats_process_metric_count; ++metric) {
+      fputs(",\n     ", file);
+      write_json_summary(file, process_metrics[metric].name, process_metrics[metric].unit, &process.metrics[metric]);
+    }
+    fputc('}', file);
+  }
+  fputs("\n  ]\n}\n", file);
+}
+
+bool gpuinfo_stats_write_json(const char *path) {
+  if (!strcmp(path, "-")) {
+    write_json(stdout);
+    return fflush(stdout) == 0;
+  }
+  // Readers never see a partial file
+  size_t size = strlen(path) + sizeof(".tmp");
+  char *temporary = malloc(size);
+  if (!temporary) {
+    perror("Cannot allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+  snprintf(temporary, size, "%s.tmp", path);
+  FILE *file = fopen(temporary, "w");
+  bool written = false;
+  if (file) {
+    write_json(file);
+    written = !ferror(file);
+    written = fclose(file) == 0 && written;
+    if (written)
+      written = rename(temporary, path) == 0;
+    else
+      unlink(temporary);
+  }
+  free(temporary);
+  return written;
+}
+
+void gpuinfo_stats_request_dump(void) { stats_dump_requested = 1; }
+
+void gpuinfo_stats_set_dump_path(const char *path) {
+  stats.dump_path = path;
+  // The dumped statistics cover the device metrics, the residencies and the processes, whatever the interface shows
+  gpuinfo_add_consumer_needs(GPUINFO_SUBSCRIPTION(gpuinfo_subscribe_clocks) |
+                             GPUINFO_SUBSCRIPTION(gpuinfo_subscribe_utilisation) |
+                             GPUINFO_SUBSCRIPTION(gpuinfo_subscribe_memory) |
+                             GPUINFO_SUBSCRIPTION(gpuinfo_subscribe_thermal) |
+                             GPUINFO_SUBSCRIPTION(gpuinfo_subscribe_power) |
+                             GPUINFO_SUBSCRIPTION(gpuinfo_subscribe_processes));
+}
+
+void gpuinfo_stats_clear(void) {
+  free(stats.devices);
+  free(stats.processes);
+  memset(&stats, 0, sizeof(stats));
+}
@@ -20,19 +20,23 @@
  */
 
 #include "nvtop/common.h"
+#include "nvtop/extract_gpuinfo.h"
 #include "nvtop/extract_gpuinfo_common.h"
+#include "nvtop/gpuinfo_stats.h"
 #include "nvtop/interface.h"
 #include "nvtop/interface_common.h"
+#include "nvtop/interface_history.h"
 #include "nvtop/interface_internal_common.h"
 #include "nvtop/interface_layout_selection.h"
 #include "nvtop/interface_options.h"
-#include "nvtop/interface_ring_buffer.h"
 #include "nvtop/interface_setup_win.h"
 #include "nvtop/plot.h"
 #include "nvtop/time.h"
 
 #include <assert.h>
+#include <fcntl.h>
 #include <inttypes.h>
+#include <limits.h>
 #include <ncurses.h>
 #include <signal.h>
 #include <stdbool.h>
@@ -45,16 +49,25 @@
 static unsigned int sizeof_device_field[device_field_count] = {
     [device_name] = 11,       [device_fan_speed] = 11,   [device_temperature] = 10, [device_power] = 15,
     [device_clock] = 11,      [device_mem_clock] = 12,   [device_pcie] = 46,        [device_shadercores] = 7,
-    [device_l2features] = 11, [device_execengines] = 11,
+    [device_l2features] = 11, [device_execengines] = 11, [device_throttle] = 35,
 };
 
 static unsigned int sizeof_process_field[process_field_count] = {
     [process_pid] = 7,       [process_user] = 4,          [process_gpu_id] = 3,   [process_type] = 8,
-    [process_gpu_rate] = 4,  [process_enc_rate] = 4,      [process_dec_rate] = 4,
+    [process_gpu_rate] = 4,  [process_enc_rate] = 4,      [process_dec_rate] = 4,  [process_render_rate] = 4,
+    [process_compute_rate] = 4, [process_copy_rate] = 4,
     [process_memory] = 14, // 9 for mem 5 for %
-    [process_cpu_usage] = 6, [process_cpu_mem_usage] = 9, [process_command] = 0,
+    [process_cpu_usage] = 6, [process_cpu_mem_usage] = 9, [process_energy] = 8, [process_locality] = 5,
+    [process_command] = 0,
 };
 
+// Processes with a smaller share of their threads on the NUMA node of their device are remote to it
+#define PROCESS_LOCALITY_REMOTE_PERCENT 50
+
+static bool process_is_remote(const struct gpu_process *process) {
+  return GPUINFO_PROCESS_FIELD_VALID(process, cpu_locality) && process->cpu_locality < PROCESS_LOCALITY_REMOTE_PERCENT;
+}
+
 static void alloc_device_window(unsigned int start_row, unsigned int start_col, unsigned int totalcol,
                                 struct device_window *dwin) {
 
@@ -177,6 +190,12 @@ static void alloc_device_window(unsigned int start_row, unsigned int start_col,
              start_col + spacer * 2 + sizeof_device_field[device_shadercores] + sizeof_device_field[device_l2features]);
   if (dwin->exec_engines == NULL)
     goto alloc_error;
+  dwin->throttle_info =
+      newwin(1, sizeof_device_field[device_throttle], start_row + 3,
+             start_col + spacer * 3 + sizeof_device_field[device_shadercores] + sizeof_device_field[device_l2features] +
+                 sizeof_device_field[device_execengines]);
+  if (dwin->throttle_info == NULL)
+    goto alloc_error;
 
   return;
 alloc_error:
@@ -202,6 +221,10 @@ static void free_device_windows(struct device_window *dwin) {
   delwin(dwin->temperature);
   delwin(dwin->fan_speed);
   delwin(dwin->pcie_info);
+  delwin(dwin->shader_cores);
+  delwin(dwin->l2_cache_size);
+  delwin(dwin->exec_engines);
+  delwin(dwin->throttle_info);
 }
 
 static void alloc_process_with_option(struct nvtop_interface *interface, unsigned posX, unsigned posY, unsigned sizeX,
@@ -216,6 +239,7 @@ static void alloc_process_with_option(struct nvtop_interface *interface, unsigne
   }
   interface->process.selected_row = 0;
   interface->process.selected_pid = -1;
+  interface->process.selected_pid_foreign = false;
   interface->process.offset_column = 0;
   interface->process.offset = 0;
 
@@ -227,21 +251,52 @@ static void alloc_process_with_option(struct nvtop_interface *interface, unsigne
   interface->process.option_window.selected_row = 0;
 }
 
-static void initialize_gpu_mem_plot(struct plot_window *plot, struct window_position *position,
-                                    nvtop_interface_option *options) {
-  unsigned rows = position->sizeY;
-  unsigned cols = position->sizeX;
-  cols -= 5;
-  rows -= 2;
-  plot->plot_window = newwin(rows, cols, position->posY + 1, position->posX + 4);
+// Time span of a plot column, zooming out reads the coarser tiers of the history
+static const struct plot_zoom_level {
+  enum interface_history_tier tier;
+  unsigned slots_per_column;
+} plot_zoom_levels[] = {
+    {history_tier_sample, 1}, {history_tier_10s, 1}, {history_tier_1min, 1}, {history_tier_1min, 10},
+    {history_tier_1min, 60},
+};
+
+static unsigned plot_slots_per_column(const struct nvtop_interface *interface) {
+  return plot_zoom_levels[interface->plot_zoom].slots_per_column * interface->output.plot_coarseness;
+}
+
+// Time in milliseconds covered by each value of a plot line
+static unsigned plot_column_period(const struct nvtop_interface *interface) {
+  enum interface_history_tier tier = plot_zoom_levels[interface->plot_zoom].tier;
+  unsigned slot_period =
+      tier == history_tier_sample ? (unsigned)interface->options.update_interval : interface->history.tier_period[tier];
+  return slot_period * plot_slots_per_column(interface);
+}
+
+// Formats the time of an axis label using the largest unit that keeps it readable
+static int plot_time_label(char label[5], unsigned long long milliseconds) {
+  unsigned long long seconds = milliseconds / 1000;
+  if (seconds < 1000)
+    return snprintf(label, 5, "%llus", seconds);
+  if (seconds / 60 < 1000)
+    return snprintf(label, 5, "%llum", seconds / 60);
+  if (seconds / 3600 < 1000)
+    return snprintf(label, 5, "%lluh", seconds / 3600);
+  return snprintf(label, 5, "%llud", seconds / 86400);
+}
+
+// Draws the border and the axes of a plot, sample_interval being the time in milliseconds between two values of a line
+static void draw_plot_frame(struct plot_window *plot, nvtop_interface_option *options, unsigned sample_interval) {
+  int sizeY, sizeX;
+  getmaxyx(plot->win, sizeY, sizeX);
+  unsigned rows = sizeY - 2;
+  unsigned cols = sizeX - 5;
+  werase(plot->win);
   draw_rectangle(plot->win, 3, 0, cols + 2, rows + 2);
   mvwprintw(plot->win, 1 + rows * 3 / 4, 0, " 25");
   mvwprintw(plot->win, 1 + rows / 4, 0, " 75");
   mvwprintw(plot->win, 1 + rows / 2, 0, " 50");
   mvwprintw(plot->win, 1, 0, "100");
   mvwprintw(plot->win, rows, 0, "  0");
-  plot->data = calloc(cols, sizeof(*plot->data));
-  plot->num_data = cols;
 
   unsigned column_divisor = 0;
   for (unsigned i = 0; i < plot->num_devices_to_plot; ++i) {
@@ -255,71 +310,85 @@ static void initialize_gpu_mem_plot(struct plot_window *plot, struct window_posi
   char *zeroSec = "0s";
   if (options->plot_left_to_right) {
     char *toPrint = zeroSec;
-    mvwprintw(plot->win, position->sizeY - 1, 4, "%s", toPrint);
+    mvwprintw(plot->win, sizeY - 1, 4, "%s", toPrint);
 
-    int retval = snprintf(elapsedSeconds, 5, "%ds", options->update_interval * cols / 4 / column_divisor / 1000);
+    int retval = plot_time_label(elapsedSeconds, (unsigned long long)sample_interval * cols / 4 / column_divisor);
     if (retval > 4)
       toPrint = err;
     else
       toPrint = elapsedSeconds;
-    mvwprintw(plot->win, position->sizeY - 1, 4 + cols / 4 - strlen(toPrint) / 2, "%s", toPrint);
+    mvwprintw(plot->win, sizeY - 1, 4 + cols / 4 - strlen(toPrint) / 2, "%s", toPrint);
 
-    retval = snprintf(elapsedSeconds, 5, "%ds", options->update_interval * cols / 2 / column_divisor / 1000);
+    retval = plot_time_label(elapsedSeconds, (unsigned long long)sample_interval * cols / 2 / column_divisor);
     if (retval > 4)
       toPrint = err;
     else
       toPrint = elapsedSeconds;
-    mvwprintw(plot->win, position->sizeY - 1, 4 + cols / 2 - strlen(toPrint) / 2, "%s", toPrint);
+    mvwprintw(plot->win, sizeY - 1, 4 + cols / 2 - strlen(toPrint) / 2, "%s", toPrint);
 
-    retval = snprintf(elapsedSeconds, 5, "%ds", options->update_interval * cols * 3 / 4 / column_divisor / 1000);
+    retval = plot_time_label(elapsedSeconds, (unsigned long long)sample_interval * cols * 3 / 4 / column_divisor);
     if (retval > 4)
       toPrint = err;
     else
       toPrint = elapsedSeconds;
-    mvwprintw(plot->win, position->sizeY - 1, 4 + cols * 3 / 4 - strlen(toPrint) / 2, "%s", toPrint);
+    mvwprintw(plot->win, sizeY - 1, 4 + cols * 3 / 4 - strlen(toPrint) / 2, "%s", toPrint);
 
-    retval = snprintf(elapsedSeconds, 5, "%ds", options->update_interval * cols / column_divisor / 1000);
+    retval = plot_time_label(elapsedSeconds, (unsigned long long)sample_interval * cols / column_divisor);
     if (retval > 4)
       toPrint = err;
     else
       toPrint = elapsedSeconds;
-    mvwprintw(plot->win, position->sizeY - 1, 4 + cols - strlen(toPrint), "%s", toPrint);
+    mvwprintw(plot->win, sizeY - 1, 4 + cols - strlen(toPrint), "%s", toPrint);
   } else {
     char *toPrint;
-    int retval = snprintf(elapsedSeconds, 5, "%ds", options->update_interval * cols / column_divisor / 1000);
+    int retval = plot_time_label(elapsedSeconds, (unsigned long long)sample_interval * cols / column_divisor);
     if (retval > 4)
       toPrint = err;
     else
       toPrint = elapsedSeconds;
-    mvwprintw(plot->win, position->sizeY - 1, 4, "%s", toPrint);
+    mvwprintw(plot->win, sizeY - 1, 4, "%s", toPrint);
 
-    retval = snprintf(elapsedSeconds, 5, "%ds", options->update_interval * cols * 3 / 4 / column_divisor / 1000);
+    retval = plot_time_label(elapsedSeconds, (unsigned long long)sample_interval * cols * 3 / 4 / column_divisor);
     if (retval > 4)
       toPrint = err;
     else
       toPrint = elapsedSeconds;
-    mvwprintw(plot->win, position->sizeY - 1, 4 + cols / 4 - strlen(toPrint) / 2, "%s", toPrint);
+    mvwprintw(plot->win, sizeY - 1, 4 + cols / 4 - strlen(toPrint) / 2, "%s", toPrint);
 
-    retval = snprintf(elapsedSeconds, 5, "%ds", options->update_interval * cols / 2 / column_divisor / 1000);
+    retval = plot_time_label(elapsedSeconds, (unsigned long long)sample_interval * cols / 2 / column_divisor);
     if (retval > 4)
       toPrint = err;
     else
       toPrint = elapsedSeconds;
-    mvwprintw(plot->win, position->sizeY - 1, 4 + cols / 2 - strlen(toPrint) / 2, "%s", toPrint);
+    mvwprintw(plot->win, sizeY - 1, 4 + cols / 2 - strlen(toPrint) / 2, "%s", toPrint);
 
-    retval = snprintf(elapsedSeconds, 5, "%ds", options->update_interval * cols / 4 / column_divisor / 1000);
+    retval = plot_time_label(elapsedSeconds, (unsigned long long)sample_interval * cols / 4 / column_divisor);
     if (retval > 4)
       toPrint = err;
     else
       toPrint = elapsedSeconds;
-    mvwprintw(plot->win, position->sizeY - 1, 4 + cols * 3 / 4 - strlen(toPrint) / 2, "%s", toPrint);
+    mvwprintw(plot->win, sizeY - 1, 4 + cols * 3 / 4 - strlen(toPrint) / 2, "%s", toPrint);
 
     toPrint = zeroSec;
-    mvwprintw(plot->win, position->sizeY - 1, 4 + cols - strlen(toPrint), "%s", toPrint);
+    mvwprintw(plot->win, sizeY - 1, 4 + cols - strlen(toPrint), "%s", toPrint);
   }
   wnoutrefresh(plot->win);
 }
 
+static void initialize_gpu_mem_plot(struct plot_window *plot, struct window_position *position,
+                                    nvtop_interface_option *options, unsigned sample_interval) {
+  unsigned rows = position->sizeY;
+  unsigned cols = position->sizeX;
+  cols -= 5;
+  rows -= 2;
+  plot->plot_window = newwin(rows, cols, position->posY + 1, position->posX + 4);
+  plot->data = calloc(cols, sizeof(*plot->data));
+  plot->data_min = calloc(cols, sizeof(*plot->data_min));
+  plot->data_max = calloc(cols, sizeof(*plot->data_max));
+  plot->num_data = cols;
+  draw_plot_frame(plot, options, sample_interval);
+}
+
 static void alloc_plot_window(unsigned devices_count, struct window_position *plot_positions,
                               unsigned map_device_to_plot[devices_count], struct nvtop_interface *interface) {
   if (!interface->num_plots) {
@@ -337,19 +406,51 @@ static void alloc_plot_window(unsigned devices_count, struct window_position *pl
     }
     interface->plots[i].win =
         newwin(plot_positions[i].sizeY, plot_positions[i].sizeX, plot_positions[i].posY, plot_positions[i].posX);
-    initialize_gpu_mem_plot(&interface->plots[i], &plot_positions[i], &interface->options);
+    interface->plots[i].data_sample = 0;
+    initialize_gpu_mem_plot(&interface->plots[i], &plot_positions[i], &interface->options,
+                            plot_column_period(interface));
   }
 }
 
-static unsigned device_length(void) {
-  return max(sizeof_device_field[device_name] + sizeof_device_field[device_pcie] + 1,
-             sizeof_device_field[device_clock] + sizeof_device_field[device_mem_clock] +
-                 sizeof_device_field[device_temperature] + sizeof_device_field[device_fan_speed] +
-                 sizeof_device_field[device_power] + 4);
+static unsigned device_length(const struct nvtop_interface *interface) {
+  unsigned length = max(sizeof_device_field[device_name] + sizeof_device_field[device_pcie] + 1,
+                        sizeof_device_field[device_clock] + sizeof_device_field[device_mem_clock] +
+                            sizeof_device_field[device_temperature] + sizeof_device_field[device_fan_speed] +
+                            sizeof_device_field[device_power] + 4);
+  if (interface->options.has_gpu_info_bar)
+    length = max(length, sizeof_device_field[device_shadercores] + sizeof_device_field[device_l2features] +
+                             sizeof_device_field[device_execengines] + sizeof_device_field[device_throttle] + 3);
+  return length;
 }
 
 static pid_t nvtop_pid;
 
+// The devices that cannot all be plotted keep a shorter history of the metrics they plot only, bounding it to about
+// 15KB per device with the two metrics plotted by default
+static bool fleet_history(const struct nvtop_interface *interface) {
+  return interface->monitored_dev_count > MAX_CHARTS;
+}
+
+static const char *heatmap_metric_names[heatmap_metric_count] = {
+    [heatmap_gpu_rate] = "GPU",     [heatmap_mem_rate] = "MEM",    [heatmap_encode_rate] = "ENC",
+    [heatmap_decode_rate] = "DEC",  [heatmap_temperature] = "TEMP", [heatmap_power_rate] = "POW",
+    [heatmap_fan_speed] = "FAN",
+};
+
+// Columns on the left of the heatmap holding the metric names
+static const unsigned heatmap_label_cols = 5;
+
+static unsigned heatmap_devices_per_block(unsigned cols) {
+  return cols > heatmap_label_cols ? cols - heatmap_label_cols : 1;
+}
+
+// A block of the heatmap is a line of device indices followed by a line per metric
+static unsigned heatmap_rows(unsigned devices_count, unsigned cols) {
+  unsigned devices_per_block = heatmap_devices_per_block(cols);
+  unsigned blocks = (devices_count + devices_per_block - 1) / devices_per_block;
+  return blocks * (heatmap_metric_count + 1);
+}
+
 static void initialize_all_windows(struct nvtop_interface *dwin) {
   int rows, cols;
   getmaxyx(stdscr, rows, cols);
@@ -362,14 +463,29 @@ static void initialize_all_windows(struct nvtop_interface *dwin) {
   struct window_position plot_positions[MAX_CHARTS];
   struct window_position setup_position;
 
-  compute_sizes_from_layout(devices_count, dwin->options.has_gpu_info_bar ? 4 : 3, device_length(), rows - 1, cols,
-                            dwin->options.gpu_specific_opts, dwin->options.process_fields_displayed, device_positions,
-                            &dwin->num_plots, plot_positions, map_device_to_plot, &process_position, &setup_position,
-                            dwin->options.hide_processes_list);
+  unsigned header_rows = dwin->options.has_gpu_info_bar ? 4 : 3;
+  struct heatmap_window *heatmap = &dwin->heatmap;
+  heatmap->enabled = heatmap_layout_selected(devices_count, dwin->options.dense_device_view);
+  if (heatmap->enabled) {
+    struct window_position heatmap_position;
+    compute_sizes_from_heatmap_layout(devices_count, heatmap->selected_device, heatmap_rows(devices_count, cols),
+                                      header_rows, device_length(dwin), rows - 1, cols, dwin->options.gpu_specific_opts,
+                                      dwin->options.process_fields_displayed, &heatmap_position, device_positions,
+                                      &dwin->num_plots, plot_positions, map_device_to_plot, &process_position,
+                                      &setup_position, dwin->options.hide_processes_list);
+    heatmap->win = newwin(heatmap_position.sizeY, heatmap_position.sizeX, heatmap_position.posY, heatmap_position.posX);
+  } else {
+    compute_sizes_from_layout(devices_count, header_rows, device_length(dwin), rows - 1, cols,
+                              dwin->options.gpu_specific_opts, dwin->options.process_fields_displayed,
+                              device_positions, &dwin->num_plots, plot_positions, map_device_to_plot,
+                              &process_position, &setup_position, dwin->options.hide_processes_list);
+  }
 
   alloc_plot_window(devices_count, plot_positions, map_device_to_plot, dwin);
 
   for (unsigned int i = 0; i < devices_count; ++i) {
+    if (heatmap->enabled && i != heatmap->selected_device)
+      continue;
     alloc_device_window(device_positions[i].posY, device_positions[i].posX, device_positions[i].sizeX,
                         &dwin->devices_win[i]);
   }
@@ -381,12 +497,17 @@ static void initialize_all_windows(struct nvtop_interface *dwin) {
 
   alloc_setup_window(&setup_position, &dwin->setup_win);
   nvtop_pid = getpid();
+  dwin->generation.layout++;
 }
 
 static void delete_all_windows(struct nvtop_interface *dwin) {
   for (unsigned int i = 0; i < dwin->monitored_dev_count; ++i) {
+    if (dwin->heatmap.enabled && i != dwin->heatmap.selected_device)
+      continue;
     free_device_windows(&dwin->devices_win[i]);
   }
+  delwin(dwin->heatmap.win);
+  dwin->heatmap.win = NULL;
   delwin(dwin->process.process_win);
   delwin(dwin->process.process_with_option_win);
   dwin->process.process_win = NULL;
@@ -396,6 +517,8 @@ static void delete_all_windows(struct nvtop_interface *dwin) {
   for (size_t i = 0; i < dwin->num_plots; ++i) {
     delwin(dwin->plots[i].win);
     free(dwin->plots[i].data);
+    free(dwin->plots[i].data_min);
+    free(dwin->plots[i].data_max);
   }
   free_setup_window(&dwin->setup_win);
   free(dwin->plots);
@@ -420,6 +543,44 @@ static void initialize_colors(void) {
   init_pair(magenta_color, COLOR_MAGENTA, background_color);
 }
 
+// In low bandwidth mode, the bytes sent to the terminal are tracked through the write counter of the main thread.
+// The counter also includes the other writes of nvtop (configuration saves, -j snapshots, metrics exporter), so only
+// its increase during the doupdate calls, where ncurses flushes its output, is counted.
+static void initialize_output_accounting(struct interface_output *output) {
+  output->plot_coarseness = 1;
+  output->io_stats_fd = -1;
+#ifdef __linux__
+  // The threads of the remote devices write their requests, the counter of the process would count them
+  output->io_stats_fd = open("/proc/thread-self/io", O_RDONLY | O_CLOEXEC);
+  if (output->io_stats_fd < 0)
+    output->io_stats_fd = open("/proc/self/io", O_RDONLY | O_CLOEXEC);
+#endif
+  nvtop_get_current_time(&output->rate_since);
+}
+
+static unsigned long long written_bytes(const struct interface_output *output) {
+  char buffer[512];
+  ssize_t size = pread(output->io_stats_fd, buffer, sizeof(buffer) - 1, 0);
+  if (size <= 0)
+    return 0;
+  buffer[size] = '\0';
+  const char *wchar = strstr(buffer, "wchar:");
+  return wchar ? strtoull(wchar + strlen("wchar:"), NULL, 10) : 0;
+}
+
+// Sends the frame to the terminal and counts its bytes
+static void output_doupdate(struct interface_output *output) {
+  if (output->io_stats_fd < 0) {
+    doupdate();
+    return;
+  }
+  unsigned long long before = written_bytes(output);
+  doupdate();
+  unsigned long long after = written_bytes(output);
+  if (after > before)
+    output->bytes += after - before;
+}
+
 struct nvtop_interface *initialize_curses(unsigned total_devices, unsigned devices_count, unsigned largest_device_name,
                                           nvtop_interface_option options) {
   struct nvtop_interface *interface = calloc(1, sizeof(*interface));
@@ -428,7 +589,11 @@ struct nvtop_interface *initialize_curses(unsigned total_devices, unsigned devic
   interface->total_dev_count = total_devices;
   interface->monitored_dev_count = devices_count;
   sizeof_device_field[device_name] = largest_device_name + 11;
+  // Room for the peak and 99th percentile of the sampled power
+  if (options.power_sampling_rate)
+    sizeof_device_field[device_power] = 30;
   initscr();
+  initialize_output_accounting(&interface->output);
   refresh();
   if (interface->options.use_color && has_colors() == TRUE) {
     initialize_colors();
@@ -452,18 +617,30 @@ struct nvtop_interface *initialize_curses(unsigned total_devices, unsigned devic
     }
   }
 
-  interface_alloc_ring_buffer(devices_count, 4, 10 * 60 * 1000, &interface->saved_data_ring);
+  interface_alloc_history(devices_count, plot_information_count, interface->options.update_interval,
+                          fleet_history(interface), &interface->history);
+  interface->heatmap.values = malloc(heatmap_metric_count * devices_count * sizeof(*interface->heatmap.values));
+  if (!interface->heatmap.values && devices_count) {
+    perror("Cannot allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
   initialize_all_windows(interface);
   return interface;
 }
 
+static void process_row_cache_clear(void);
+
 void clean_ncurses(struct nvtop_interface *interface) {
   endwin();
   delete_all_windows(interface);
+  if (interface->output.io_stats_fd >= 0)
+    close(interface->output.io_stats_fd);
   free(interface->options.gpu_specific_opts);
   free(interface->options.config_file_location);
   free(interface->devices_win);
-  interface_free_ring_buffer(&interface->saved_data_ring);
+  interface_free_history(&interface->history);
+  free(interface->heatmap.values);
+  process_row_cache_clear();
   free(interface);
 }
 
@@ -623,16 +800,143 @@ static void encode_decode_show_select(struct device_window *dev, bool encode_val
   }
 }
 
+static uint8_t heatmap_value(const struct gpuinfo_dynamic_info *dynamic_info, enum heatmap_metric metric) {
+  switch (metric) {
+  case heatmap_gpu_rate:
+    if (GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, gpu_util_rate))
+      return min(dynamic_info->gpu_util_rate, 100);
+    break;
+  case heatmap_mem_rate:
+    if (GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, used_memory) &&
+        GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, total_memory) && dynamic_info->total_memory)
+      return min(dynamic_info->used_memory * 100 / dynamic_info->total_memory, 100);
+    break;
+  case heatmap_encode_rate:
+    if (GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, encoder_rate))
+      return min(dynamic_info->encoder_rate, 100);
+    break;
+  case heatmap_decode_rate:
+    if (GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, decoder_rate))
+      return min(dynamic_info->decoder_rate, 100);
+    break;
+  case heatmap_temperature:
+    if (GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, gpu_temp))
+      return min(dynamic_info->gpu_temp, 100);
+    break;
+  case heatmap_power_rate:
+    if (GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, power_draw) &&
+        GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, power_draw_max) && dynamic_info->power_draw_max)
+      return min(dynamic_info->power_draw * 100 / dynamic_info->power_draw_max, 100);
+    break;
+  case heatmap_fan_speed:
+    if (GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, fan_speed))
+      return min(dynamic_info->fan_speed, 100);
+    break;
+  case heatmap_metric_count:
+    break;
+  }
+  return HEATMAP_NO_DATA;
+}
+
+static void draw_heatmap(struct list_head *devices, struct nvtop_interface *interface) {
+  struct heatmap_window *heatmap = &interface->heatmap;
+  unsigned devices_count = interface->monitored_dev_count;
+  struct gpu_info *device;
+  unsigned dev_id = 0;
+
+  list_for_each_entry(device, devices, list) {
+    for (enum heatmap_metric metric = 0; metric < heatmap_metric_count; ++metric)
+      heatmap->values[metric * devices_count + dev_id] = heatmap_value(&device->dynamic_info, metric);
+    dev_id++;
+  }
+
+  WINDOW *win = heatmap->win;
+  int rows, cols;
+  getmaxyx(win, rows, cols);
+  unsigned devices_per_block = heatmap_devices_per_block(cols);
+  werase(win);
+  for (unsigned first = 0, row = 0; first < devices_count && row < (unsigned)rows;
+       first += devices_per_block, row += heatmap_metric_count + 1) {
+    unsigned last = min(first + devices_per_block, devices_count);
+    // Device index ruler, labeled every ten devices
+    wcolor_set(win, cyan_color, NULL);
+    mvwprintw(win, row, 0, "DEV");
+    for (unsigned dev = first; dev < last; dev += 10 - dev % 10)
+      mvwprintw(win, row, heatmap_label_cols + dev - first, "%u", dev);
+    wstandend(win);
+    if (heatmap->selected_device >= first && heatmap->selected_device < last)
+      mvwchgat(win, row, heatmap_label_cols + heatmap->selected_device - first, 1, A_STANDOUT, cyan_color, NULL);
+    for (enum heatmap_metric metric = 0; metric < heatmap_metric_count && row + 1 + metric < (unsigned)rows;
+         ++metric) {
+      const uint8_t *values = &heatmap->values[metric * devices_count];
+      wcolor_set(win, cyan_color, NULL);
+      mvwprintw(win, row + 1 + metric, 0, "%s", heatmap_metric_names[metric]);
+      wstandend(win);
+      wmove(win, row + 1 + metric, heatmap_label_cols);
+      for (unsigned dev = first; dev < last; ++dev) {
+        uint8_t value = values[dev];
+        if (value == HEATMAP_NO_DATA) {
+          waddch(win, '-');
+          continue;
+        }
+        // The digit gives the tens of the percentage, the color its quarter
+        enum interface_color color;
+        if (value < 25)
+          color = cyan_color;
+        else if (value < 50)
+          color = green_color;
+        else if (value < 75)
+          color = yellow_color;
+        else
+          color = red_color;
+        waddch(win, (value == 100 ? '#' : '0' + value / 10) | A_REVERSE | COLOR_PAIR(color));
+      }
+    }
+  }
+  wnoutrefresh(win);
+}
+
+// Percentage of the observed time the device spent in the condition, nothing when it could not be observed
+static void draw_residency(WINDOW *win, unsigned dev_id, enum gpuinfo_stats_residency residency, const char *label) {
+  struct gpuinfo_stats_residency_time time = {0};
+  if (dev_id < gpuinfo_stats_devices_count())
+    gpuinfo_stats_device_residency(dev_id, residency, &time);
+  if (time.observed <= 0.) {
+    if (!label)
+      wprintw(win, "N/A");
+    return;
+  }
+  if (label) {
+    wprintw(win, " ");
+    wcolor_set(win, cyan_color, NULL);
+    wprintw(win, "%s ", label);
+    wstandend(win);
+  }
+  wprintw(win, "%.0f%%", time.time * 100. / time.observed);
+}
+
 static void draw_devices(struct list_head *devices, struct nvtop_interface *interface) {
   struct gpu_info *device;
   unsigned dev_id = 0;
 
+  if (interface->heatmap.enabled)
+    draw_heatmap(devices, interface);
+
   list_for_each_entry(device, devices, list) {
+    // With the heatmap, only the selected device has its full header
+    if (interface->heatmap.enabled && dev_id != interface->heatmap.selected_device) {
+      dev_id++;
+      continue;
+    }
     struct device_window *dev = &interface->devices_win[dev_id];
 
     wcolor_set(dev->name_win, cyan_color, NULL);
     mvwprintw(dev->name_win, 0, 0, "Device %-2u", dev_id);
     wstandend(dev->name_win);
+    // The backend could not refresh its data in time, the values shown are from an older sample
+    bool stale_data = GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, stale_data_age);
+    if (stale_data)
+      wcolor_set(dev->name_win, red_color, NULL);
     if (GPUINFO_STATIC_FIELD_VALID(&device->static_info, device_name)) {
       wprintw(dev->name_win, "[%s]", device->static_info.device_name);
       wnoutrefresh(dev->name_win);
@@ -640,6 +944,7 @@ static void draw_devices(struct list_head *devices, struct nvtop_interface *inte
       wprintw(dev->name_win, "[N/A]");
       wnoutrefresh(dev->name_win);
     }
+    wstandend(dev->name_win);
     bool display_encode = false;
     bool display_decode = false;
     encode_decode_show_select(dev, GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, encoder_rate),
@@ -684,7 +989,10 @@ static void draw_devices(struct list_head *devices, struct nvtop_interface *inte
       else
         draw_percentage_meter(decode_win, "DEC", rate, buff);
     }
-    if (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, gpu_util_rate)) {
+    if (stale_data && GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, gpu_util_rate)) {
+      snprintf(buff, 1024, "stale %us %u%%", device->dynamic_info.stale_data_age, device->dynamic_info.gpu_util_rate);
+      draw_percentage_meter(gpu_util_win, "GPU", device->dynamic_info.gpu_util_rate, buff);
+    } else if (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, gpu_util_rate)) {
       snprintf(buff, 1024, "%u%%", device->dynamic_info.gpu_util_rate);
       draw_percentage_meter(gpu_util_win, "GPU", device->dynamic_info.gpu_util_rate, buff);
     } else {
@@ -760,7 +1068,10 @@ static void draw_devices(struct list_head *devices, struct nvtop_interface *inte
     else
       mvwprintw(dev->gpu_clock_info, 0, 0, "GPU N/A MHz");
 
-    mvwchgat(dev->gpu_clock_info, 0, 0, 3, 0, cyan_color, NULL);
+    // The label turns red while the device reports a throttle reason
+    bool throttled = GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, throttle_reasons) &&
+                     device->dynamic_info.throttle_reasons;
+    mvwchgat(dev->gpu_clock_info, 0, 0, 3, 0, throttled ? red_color : cyan_color, NULL);
     wnoutrefresh(dev->gpu_clock_info);
 
     // MEM CLOCK
@@ -786,6 +1097,11 @@ static void draw_devices(struct list_head *devices, struct nvtop_interface *inte
       mvwprintw(dev->power_info, 0, 0, "POW N/A / %3u W", device->dynamic_info.power_draw_max / 1000);
     else
       mvwprintw(dev->power_info, 0, 0, "POW N/A W");
+    if (interface->options.power_sampling_rate &&
+        GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, power_draw_peak) &&
+        GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, power_draw_p99))
+      wprintw(dev->power_info, " pk %3u p99 %3u", device->dynamic_info.power_draw_peak / 1000,
+              device->dynamic_info.power_draw_p99 / 1000);
     mvwchgat(dev->power_info, 0, 0, 3, 0, cyan_color, NULL);
     wnoutrefresh(dev->power_info);
 
@@ -860,6 +1176,17 @@ static void draw_devices(struct list_head *devices, struct nvtop_interface *inte
         wprintw(dev->exec_engines, "N/A");
 
       wnoutrefresh(dev->exec_engines);
+
+      // Share of the time spent throttled, below the maximum clock, hot and at the power limit
+      werase(dev->throttle_info);
+      wcolor_set(dev->throttle_info, cyan_color, NULL);
+      mvwprintw(dev->throttle_info, 0, 0, "THR ");
+      wstandend(dev->throttle_info);
+      draw_residency(dev->throttle_info, dev_id, gpuinfo_stats_throttled, NULL);
+      draw_residency(dev->throttle_info, dev_id, gpuinfo_stats_below_max_clock, "CLK");
+      draw_residency(dev->throttle_info, dev_id, gpuinfo_stats_hot, "HOT");
+      draw_residency(dev->throttle_info, dev_id, gpuinfo_stats_power_capped, "CAP");
+      wnoutrefresh(dev->throttle_info);
     }
 
     dev_id++;
@@ -870,7 +1197,9 @@ typedef struct {
   unsigned processes_count;
   struct gpuid_and_process {
     unsigned gpu_id;
+    bool foreign_pid; // See gpu_vendor.foreign_pids
     struct gpu_process *process;
+    uint64_t sort_key; // See process_sort_key
   } *processes;
 } all_processes;
 
@@ -897,6 +1226,7 @@ static all_processes all_processes_array(struct list_head *devices) {
   list_for_each_entry(device, devices, list) {
     for (unsigned int j = 0; j < device->processes_count; ++j) {
       merged_devices_processes.processes[offset].gpu_id = dev_id;
+      merged_devices_processes.processes[offset].foreign_pid = device->vendor->foreign_pids;
       merged_devices_processes.processes[offset++].process = &device->processes[j];
     }
 
@@ -906,229 +1236,192 @@ static all_processes all_processes_array(struct list_head *devices) {
   return merged_devices_processes;
 }
 
-static int compare_pid_desc(const void *pp1, const void *pp2) {
-  const struct gpuid_and_process *p1 = (const struct gpuid_and_process *)pp1;
-  const struct gpuid_and_process *p2 = (const struct gpuid_and_process *)pp2;
-  return p1->process->pid >= p2->process->pid ? -1 : 1;
-}
-
-static int compare_pid_asc(const void *pp1, const void *pp2) { return compare_pid_desc(pp2, pp1); }
-
-static int compare_username_desc(const void *pp1, const void *pp2) {
-  const struct gpuid_and_process *p1 = (const struct gpuid_and_process *)pp1;
-  const struct gpuid_and_process *p2 = (const struct gpuid_and_process *)pp2;
-  if (GPUINFO_PROCESS_FIELD_VALID(p1->process, user_name) && GPUINFO_PROCESS_FIELD_VALID(p2->process, user_name))
-    return -strcmp(p1->process->user_name, p2->process->user_name);
-  else
-    return 0;
+// Packs the first bytes of a string so that the integer order matches the strcmp order of the prefixes
+static uint64_t string_prefix_key(const char *string) {
+  uint64_t key = 0;
+  unsigned i = 0;
+  for (; i < sizeof(key) && string[i]; ++i)
+    key = key << CHAR_BIT | (unsigned char)string[i];
+  return i ? key << (CHAR_BIT * (sizeof(key) - i)) : 0;
 }
 
-static int compare_username_asc(const void *pp1, const void *pp2) { return compare_username_desc(pp2, pp1); }
-
-static int compare_process_name_desc(const void *pp1, const void *pp2) {
-  const struct gpuid_and_process *p1 = (const struct gpuid_and_process *)pp1;
-  const struct gpuid_and_process *p2 = (const struct gpuid_and_process *)pp2;
-  if (GPUINFO_PROCESS_FIELD_VALID(p1->process, cmdline) && GPUINFO_PROCESS_FIELD_VALID(p2->process, cmdline))
-    return -strcmp(p1->process->cmdline, p2->process->cmdline);
-  else
-    return 0;
-}
-
-static int compare_process_name_asc(const void *pp1, const void *pp2) { return compare_process_name_desc(pp2, pp1); }
-
-static int compare_mem_usage_desc(const void *pp1, const void *pp2) {
-  const struct gpuid_and_process *p1 = (const struct gpuid_and_process *)pp1;
-  const struct gpuid_and_process *p2 = (const struct gpuid_and_process *)pp2;
-  if (GPUINFO_PROCESS_FIELD_VALID(p1->process, gpu_memory_usage) &&
-      GPUINFO_PROCESS_FIELD_VALID(p2->process, gpu_memory_usage))
-    return p1->process->gpu_memory_usage >= p2->process->gpu_memory_usage ? -1 : 1;
-  else
-    return 0;
-}
-
-static int compare_mem_usage_asc(const void *pp1, const void *pp2) { return compare_mem_usage_desc(pp2, pp1); }
-
-static int compare_cpu_usage_desc(const void *pp1, const void *pp2) {
-  const struct gpuid_and_process *p1 = (const struct gpuid_and_process *)pp1;
-  const struct gpuid_and_process *p2 = (const struct gpuid_and_process *)pp2;
-  if (GPUINFO_PROCESS_FIELD_VALID(p1->process, cpu_usage) && GPUINFO_PROCESS_FIELD_VALID(p2->process, cpu_usage))
-    return p1->process->cpu_usage >= p2->process->cpu_usage ? -1 : 1;
-  else
-    return 0;
+// Integer key ordering the processes increasingly for the criterion. The unavailable fields sort as zero. The text
+// fields only store their prefix, process_precedes compares the whole strings when the keys are equal.
+static uint64_t process_sort_key(const struct gpuid_and_process *entry, enum process_field criterion) {
+  const struct gpu_process *process = entry->process;
+  switch (criterion) {
+  case process_pid:
+    return (uint64_t)process->pid;
+  case process_user:
+    return GPUINFO_PROCESS_FIELD_VALID(process, user_name) ? string_prefix_key(process->user_name) : 0;
+  case process_gpu_id:
+    return entry->gpu_id;
+  case process_type:
+    return process->type;
+  case process_gpu_rate:
+    return GPUINFO_PROCESS_FIELD_VALID(process, gpu_usage) ? process->gpu_usage : 0;
+  case process_enc_rate:
+    return GPUINFO_PROCESS_FIELD_VALID(process, encode_usage) ? process->encode_usage : 0;
+  case process_dec_rate:
+    return GPUINFO_PROCESS_FIELD_VALID(process, decode_usage) ? process->decode_usage : 0;
+  case process_render_rate:
+    return GPUINFO_PROCESS_ENGINE_VALID(process, gpuinfo_engine_render) ? process->engine_usage[gpuinfo_engine_render]
+                                                                        : 0;
+  case process_compute_rate:
+    return GPUINFO_PROCESS_ENGINE_VALID(process, gpuinfo_engine_compute) ? process->engine_usage[gpuinfo_engine_compute]
+                                                                         : 0;
+  case process_copy_rate:
+    return GPUINFO_PROCESS_ENGINE_VALID(process, gpuinfo_engine_copy) ? process->engine_usage[gpuinfo_engine_copy] : 0;
+  case process_memory:
+    return GPUINFO_PROCESS_FIELD_VALID(process, gpu_memory_usage) ? process->gpu_memory_usage : 0;
+  case process_cpu_usage:
+    return GPUINFO_PROCESS_FIELD_VALID(process, cpu_usage) ? process->cpu_usage : 0;
+  case process_cpu_mem_usage:
+    return GPUINFO_PROCESS_FIELD_VALID(process, cpu_memory_res) ? process->cpu_memory_res : 0;
+  case process_energy:
+    return GPUINFO_PROCESS_FIELD_VALID(process, energy_consumed) ? process->energy_consumed : 0;
+  case process_locality:
+    // Without a NUMA node, the processes are as local as can be
+    return GPUINFO_PROCESS_FIELD_VALID(process, cpu_locality) ? process->cpu_locality : 101;
+  case process_command:
+    return GPUINFO_PROCESS_FIELD_VALID(process, cmdline) ? string_prefix_key(process->cmdline) : 0;
+  case process_field_count:
+    break;
+  }
+  return 0;
 }
 
-static int compare_cpu_usage_asc(const void *pp1, const void *pp2) { return compare_cpu_usage_desc(pp2, pp1); }
+struct process_sort_order {
+  enum process_field criterion;
+  bool descending;
+};
 
-static int compare_cpu_mem_usage_desc(const void *pp1, const void *pp2) {
-  const struct gpuid_and_process *p1 = (const struct gpuid_and_process *)pp1;
-  const struct gpuid_and_process *p2 = (const struct gpuid_and_process *)pp2;
-  if (GPUINFO_PROCESS_FIELD_VALID(p1->process, cpu_memory_res) &&
-      GPUINFO_PROCESS_FIELD_VALID(p2->process, cpu_memory_res))
-    return p1->process->cpu_memory_res >= p2->process->cpu_memory_res ? -1 : 1;
-  else
-    return 0;
+static const char *process_sort_text(const struct gpu_process *process, enum process_field criterion) {
+  if (criterion == process_user && GPUINFO_PROCESS_FIELD_VALID(process, user_name))
+    return process->user_name;
+  if (criterion == process_command && GPUINFO_PROCESS_FIELD_VALID(process, cmdline))
+    return process->cmdline;
+  return "";
 }
 
-static int compare_cpu_mem_usage_asc(const void *pp1, const void *pp2) { return compare_cpu_mem_usage_desc(pp2, pp1); }
-
-static int compare_gpu_desc(const void *pp1, const void *pp2) {
-  const struct gpuid_and_process *p1 = (const struct gpuid_and_process *)pp1;
-  const struct gpuid_and_process *p2 = (const struct gpuid_and_process *)pp2;
-  return p1->gpu_id >= p2->gpu_id ? -1 : 1;
+// Strict total order of the process list. The ties are broken by pid then device so that equal rows keep their place
+// from one frame to the next.
+static inline bool process_precedes(const struct gpuid_and_process *p1, const struct gpuid_and_process *p2,
+                                    struct process_sort_order order) {
+  if (p1->sort_key != p2->sort_key)
+    return (p1->sort_key < p2->sort_key) != order.descending;
+  if (order.criterion == process_user || order.criterion == process_command) {
+    int text_order =
+        strcmp(process_sort_text(p1->process, order.criterion), process_sort_text(p2->process, order.criterion));
+    if (text_order)
+      return (text_order < 0) != order.descending;
+  }
+  if (p1->process->pid != p2->process->pid)
+    return p1->process->pid < p2->process->pid;
+  return p1->gpu_id < p2->gpu_id;
 }
 
-static int compare_gpu_asc(const void *pp1, const void *pp2) { return -compare_gpu_desc(pp1, pp2); }
-
-static int compare_process_type_desc(const void *pp1, const void *pp2) {
-  const struct gpuid_and_process *p1 = (const struct gpuid_and_process *)pp1;
-  const struct gpuid_and_process *p2 = (const struct gpuid_and_process *)pp2;
-  return (p1->process->type == gpu_process_graphical) != (p2->process->type == gpu_process_graphical);
+static void swap_processes(struct gpuid_and_process *p1, struct gpuid_and_process *p2) {
+  struct gpuid_and_process tmp = *p1;
+  *p1 = *p2;
+  *p2 = tmp;
 }
 
-static int compare_process_type_asc(const void *pp1, const void *pp2) { return -compare_process_name_desc(pp1, pp2); }
-
-static int compare_process_gpu_rate_desc(const void *pp1, const void *pp2) {
-  const struct gpuid_and_process *p1 = (const struct gpuid_and_process *)pp1;
-  const struct gpuid_and_process *p2 = (const struct gpuid_and_process *)pp2;
-  if (GPUINFO_PROCESS_FIELD_VALID(p1->process, gpu_usage) && GPUINFO_PROCESS_FIELD_VALID(p2->process, gpu_usage)) {
-    return p1->process->gpu_usage > p2->process->gpu_usage ? -1 : 1;
-  } else {
-    if (GPUINFO_PROCESS_FIELD_VALID(p1->process, gpu_usage)) {
-      return p1->process->gpu_usage > 0 ? -1 : 0;
-    } else if (GPUINFO_PROCESS_FIELD_VALID(p2->process, gpu_usage)) {
-      return p2->process->gpu_usage > 0 ? 1 : 0;
-    } else {
-      return 0;
-    }
+static void insertion_sort_processes(struct gpuid_and_process *procs, unsigned count,
+                                     struct process_sort_order order) {
+  for (unsigned i = 1; i < count; ++i) {
+    struct gpuid_and_process moving = procs[i];
+    unsigned j = i;
+    for (; j > 0 && process_precedes(&moving, &procs[j - 1], order); --j)
+      procs[j] = procs[j - 1];
+    procs[j] = moving;
   }
 }
 
-static int compare_process_gpu_rate_asc(const void *pp1, const void *pp2) {
-  return -compare_process_gpu_rate_desc(pp1, pp2);
-}
-
-static int compare_process_enc_rate_desc(const void *pp1, const void *pp2) {
-  const struct gpuid_and_process *p1 = (const struct gpuid_and_process *)pp1;
-  const struct gpuid_and_process *p2 = (const struct gpuid_and_process *)pp2;
-  if (GPUINFO_PROCESS_FIELD_VALID(p1->process, encode_usage) &&
-      GPUINFO_PROCESS_FIELD_VALID(p2->process, encode_usage)) {
-    return p1->process->encode_usage >= p2->process->encode_usage ? -1 : 1;
-  } else {
-    if (GPUINFO_PROCESS_FIELD_VALID(p1->process, encode_usage)) {
-      return p1->process->encode_usage > 0 ? -1 : 0;
-    } else if (GPUINFO_PROCESS_FIELD_VALID(p2->process, encode_usage)) {
-      return p2->process->encode_usage > 0 ? 1 : 0;
+// Quicksort that only orders the first sorted_count positions: the partitions lying after them are left as they are.
+static void partial_sort_processes(struct gpuid_and_process *procs, unsigned count, unsigned sorted_count,
+                                   struct process_sort_order order) {
+  while (count > 16) {
+    // Median of three pivot, placed in the middle
+    unsigned mid = count / 2;
+    if (process_precedes(&procs[mid], &procs[0], order))
+      swap_processes(&procs[mid], &procs[0]);
+    if (process_precedes(&procs[count - 1], &procs[mid], order)) {
+      swap_processes(&procs[count - 1], &procs[mid]);
+      if (process_precedes(&procs[mid], &procs[0], order))
+        swap_processes(&procs[mid], &procs[0]);
+    }
+    struct gpuid_and_process pivot = procs[mid];
+    // Hoare partition, the order being strict the scans stop on the pivot at the latest
+    unsigned i = 0, j = count - 1;
+    while (true) {
+      while (process_precedes(&procs[i], &pivot, order))
+        i++;
+      while (process_precedes(&pivot, &procs[j], order))
+        j--;
+      if (i >= j)
+        break;
+      swap_processes(&procs[i], &procs[j]);
+      i++;
+      j--;
+    }
+    unsigned split = j + 1;
+    if (split >= sorted_count) {
+      count = split;
     } else {
-      return 0;
+      partial_sort_processes(procs, split, split, order);
+      procs += split;
+      count -= split;
+      sorted_count -= split;
     }
   }
+  insertion_sort_processes(procs, count, order);
 }
 
-static int compare_process_enc_rate_asc(const void *pp1, const void *pp2) {
-  return -compare_process_enc_rate_desc(pp1, pp2);
-}
-
-static int compare_process_dec_rate_desc(const void *pp1, const void *pp2) {
-  const struct gpuid_and_process *p1 = (const struct gpuid_and_process *)pp1;
-  const struct gpuid_and_process *p2 = (const struct gpuid_and_process *)pp2;
-  if (GPUINFO_PROCESS_FIELD_VALID(p1->process, decode_usage) &&
-      GPUINFO_PROCESS_FIELD_VALID(p2->process, decode_usage)) {
-    return p1->process->decode_usage >= p2->process->decode_usage ? -1 : 1;
-  } else {
-    if (GPUINFO_PROCESS_FIELD_VALID(p1->process, decode_usage)) {
-      return p1->process->decode_usage > 0 ? -1 : 0;
-    } else if (GPUINFO_PROCESS_FIELD_VALID(p2->process, decode_usage)) {
-      return p2->process->decode_usage > 0 ? 1 : 0;
-    } else {
-      return 0;
-    }
+// Moves the processes whose key is at least as good as the cutoff to the front and returns their count
+static unsigned processes_within_cutoff(all_processes all_procs, uint64_t cutoff_key, bool descending) {
+  unsigned count = 0;
+  for (unsigned i = 0; i < all_procs.processes_count; ++i) {
+    uint64_t key = all_procs.processes[i].sort_key;
+    if (descending ? key >= cutoff_key : key <= cutoff_key)
+      swap_processes(&all_procs.processes[count++], &all_procs.processes[i]);
   }
-}
-static int compare_process_dec_rate_asc(const void *pp1, const void *pp2) {
-  return -compare_process_dec_rate_desc(pp1, pp2);
+  return count;
 }
 
-static void sort_process(all_processes all_procs, enum process_field criterion, bool asc_sort) {
-  if (all_procs.processes_count == 0 || !all_procs.processes)
+// Sorts the first sorted_count processes, which cover the rows that can be seen. The top of the list barely moves from
+// one frame to the next: when the sort criterion did not change, the processes comparing worse than the last sorted
+// row of the previous frame are set aside first, and the sort only runs on the others if they fill the sorted rows.
+static void sort_process(all_processes all_procs, enum process_field criterion, bool asc_sort, unsigned sorted_count,
+                         struct process_sort_cache *cache) {
+  if (all_procs.processes_count == 0 || !all_procs.processes || criterion == process_field_count)
     return;
-  int (*sort_fun)(const void *, const void *);
-  switch (criterion) {
-  case process_pid:
-    if (asc_sort)
-      sort_fun = compare_pid_asc;
-    else
-      sort_fun = compare_pid_desc;
-    break;
-  case process_user:
-    if (asc_sort)
-      sort_fun = compare_username_asc;
-    else
-      sort_fun = compare_username_desc;
-    break;
-  case process_gpu_id:
-    if (asc_sort)
-      sort_fun = compare_gpu_asc;
-    else
-      sort_fun = compare_gpu_desc;
-    break;
-  case process_type:
-    if (asc_sort)
-      sort_fun = compare_process_type_asc;
-    else
-      sort_fun = compare_process_type_desc;
-    break;
-  case process_memory:
-    if (asc_sort)
-      sort_fun = compare_mem_usage_asc;
-    else
-      sort_fun = compare_mem_usage_desc;
-    break;
-  case process_command:
-    if (asc_sort)
-      sort_fun = compare_process_name_asc;
-    else
-      sort_fun = compare_process_name_desc;
-    break;
-  case process_cpu_usage:
-    if (asc_sort)
-      sort_fun = compare_cpu_usage_asc;
-    else
-      sort_fun = compare_cpu_usage_desc;
-    break;
-  case process_cpu_mem_usage:
-    if (asc_sort)
-      sort_fun = compare_cpu_mem_usage_asc;
-    else
-      sort_fun = compare_cpu_mem_usage_desc;
-    break;
-  case process_gpu_rate:
-    if (asc_sort)
-      sort_fun = compare_process_gpu_rate_asc;
-    else
-      sort_fun = compare_process_gpu_rate_desc;
-    break;
-  case process_enc_rate:
-    if (asc_sort)
-      sort_fun = compare_process_enc_rate_asc;
-    else
-      sort_fun = compare_process_enc_rate_desc;
-    break;
-  case process_dec_rate:
-    if (asc_sort)
-      sort_fun = compare_process_dec_rate_asc;
-    else
-      sort_fun = compare_process_dec_rate_desc;
-    break;
-  case process_field_count:
+  struct process_sort_order order = {.criterion = criterion, .descending = !asc_sort};
+  for (unsigned i = 0; i < all_procs.processes_count; ++i)
+    all_procs.processes[i].sort_key = process_sort_key(&all_procs.processes[i], criterion);
+  if (sorted_count > all_procs.processes_count)
+    sorted_count = all_procs.processes_count;
+  if (sorted_count == 0)
     return;
+
+  unsigned candidates = all_procs.processes_count;
+  if (cache->valid && cache->criterion == criterion && cache->descending == order.descending) {
+    unsigned within_cutoff = processes_within_cutoff(all_procs, cache->cutoff_key, order.descending);
+    // Every process set aside compares worse than those kept
+    if (within_cutoff >= sorted_count)
+      candidates = within_cutoff;
   }
-  qsort(all_procs.processes, all_procs.processes_count, sizeof(*all_procs.processes), sort_fun);
+  partial_sort_processes(all_procs.processes, candidates, sorted_count, order);
+  cache->valid = true;
+  cache->criterion = criterion;
+  cache->descending = order.descending;
+  cache->cutoff_key = all_procs.processes[sorted_count - 1].sort_key;
 }
 
 static void filter_out_nvtop_pid(all_processes *all_procs, struct nvtop_interface *interface) {
   if (interface->options.filter_nvtop_pid) {
     for (unsigned procId = 0; procId < all_procs->processes_count; ++procId) {
-      if (all_procs->processes[procId].process->pid == nvtop_pid) {
+      if (!all_procs->processes[procId].foreign_pid && all_procs->processes[procId].process->pid == nvtop_pid) {
         memmove(&all_procs->processes[procId], &all_procs->processes[procId + 1],
                 (all_procs->processes_count - procId - 1) * sizeof(*all_procs->processes));
         all_procs->processes_count = all_procs->processes_count - 1;
@@ -1138,8 +1431,23 @@ static void filter_out_nvtop_pid(all_processes *all_procs, struct nvtop_interfac
   }
 }
 
+// Only keeps the processes remote to their device when asked. Returns the number of remote processes.
+static unsigned filter_local_processes(all_processes *all_procs, struct nvtop_interface *interface) {
+  unsigned remote_count = 0;
+  unsigned kept = 0;
+  for (unsigned procId = 0; procId < all_procs->processes_count; ++procId) {
+    bool remote = process_is_remote(all_procs->processes[procId].process);
+    remote_count += remote;
+    if (remote || !interface->options.filter_local_processes)
+      all_procs->processes[kept++] = all_procs->processes[procId];
+  }
+  all_procs->processes_count = kept;
+  return remote_count;
+}
+
 static const char *columnName[process_field_count] = {
-    "PID", "USER", "DEV", "TYPE", "GPU", "ENC", "DEC", "GPU MEM", "CPU", "HOST MEM", "Command",
+    "PID", "USER", "DEV", "TYPE", "GPU", "ENC", "DEC", "REND", "COMP", "COPY", "GPU MEM", "CPU", "HOST MEM", "ENERGY",
+    "NUMA", "Command",
 };
 
 static void update_selected_offset_with_window_size(unsigned int *selected_row, unsigned int *offset,
@@ -1164,8 +1472,351 @@ static void update_selected_offset_with_window_size(unsigned int *selected_row,
 #define process_buffer_line_size 8192
 static char process_print_buffer[process_buffer_line_size];
 
+// Energy given in millijoules, with the largest unit keeping a digit before the point
+static void format_energy(char *buffer, size_t size, unsigned long long energy) {
+  static const char *units[] = {"J", "kJ", "MJ", "GJ"};
+  double value = energy / 1000.;
+  unsigned unit = 0;
+  while (value >= 1000. && unit + 1 < ARRAY_SIZE(units)) {
+    value /= 1000.;
+    unit++;
+  }
+  snprintf(buffer, size, "%.1f%s", value, units[unit]);
+}
+
+// Formats the line of a process in buffer and returns its length
+static unsigned format_process_row(const struct gpuid_and_process *entry, process_field_displayed fields_to_display,
+                                   char *buffer, size_t buffer_size) {
+  const struct gpu_process *process = entry->process;
+  char pid_str[sizeof_process_field[process_pid] + 1];
+  char guid_str[sizeof_process_field[process_gpu_id] + 1];
+  char memory[sizeof_process_field[process_memory] + 1];
+  char cpu_percent[sizeof_process_field[process_cpu_usage] + 1];
+  char cpu_mem[sizeof_process_field[process_cpu_mem_usage] + 1];
+  char energy[sizeof_process_field[process_energy] + 1];
+  char locality[sizeof_process_field[process_locality] + 1];
+
+  buffer[0] = '\0';
+  int printed = 0;
+  if (process_is_field_displayed(process_pid, fields_to_display)) {
+    size_t size = snprintf(pid_str, sizeof_process_field[process_pid] + 1, "%" PRIdMAX, (intmax_t)process->pid);
+    if (size == sizeof_process_field[process_pid] + 1)
+      pid_str[sizeof_process_field[process_pid]] = '\0';
+    printed += snprintf(&buffer[printed], buffer_size - printed, "%*s ", sizeof_process_field[process_pid], pid_str);
+  }
+
+  if (process_is_field_displayed(process_user, fields_to_display)) {
+    const char *username;
+    if (GPUINFO_PROCESS_FIELD_VALID(process, user_name)) {
+      username = process->user_name;
+    } else {
+      username = "N/A";
+    }
+
+    printed += snprintf(&buffer[printed], buffer_size - printed, "%*s ", sizeof_process_field[process_user], username);
+  }
+
+  if (process_is_field_displayed(process_gpu_id, fields_to_display)) {
+    size_t size = snprintf(guid_str, sizeof_process_field[process_gpu_id] + 1, "%u", entry->gpu_id);
+    if (size >= sizeof_process_field[process_gpu_id] + 1)
+      pid_str[sizeof_process_field[process_gpu_id]] = '\0';
+    printed += snprintf(&buffer[printed], buffer_size - printed, "%*s ",
+                        sizeof_process_field[process_gpu_id], guid_str);
+  }
+
+  if (process_is_field_displayed(process_type, fields_to_display)) {
+    if (process->type == gpu_process_graphical_compute) {
+      printed += snprintf(&buffer[printed], buffer_size - printed, "%*s ",
+                          sizeof_process_field[process_type], "Both G+C");
+    } else if (process->type == gpu_process_graphical) {
+      printed += snprintf(&buffer[printed], buffer_size - printed, "%*s ",
+                          sizeof_process_field[process_type], "Graphic");
+    } else {
+      printed += snprintf(&buffer[printed], buffer_size - printed, "%*s ",
+                          sizeof_process_field[process_type], "Compute");
+    }
+  }
+
+  if (process_is_field_displayed(process_gpu_rate, fields_to_display)) {
+    unsigned gpu_usage = 0;
+    if (GPUINFO_PROCESS_FIELD_VALID(process, gpu_usage)) {
+      gpu_usage = process->gpu_usage;
+      printed += snprintf(&buffer[printed], buffer_size - printed, "%3u%% ", gpu_usage);
+    } else {
+      printed += snprintf(&buffer[printed], buffer_size - printed, "N/A  ");
+    }
+  }
+
+  if (process_is_field_displayed(process_enc_rate, fields_to_display)) {
+    unsigned encoder_rate = 0;
+    if (GPUINFO_PROCESS_FIELD_VALID(process, encode_usage)) {
+      encoder_rate = process->encode_usage;
+      printed += snprintf(&buffer[printed], buffer_size - printed, "%3u%% ", encoder_rate);
+    } else {
+      printed += snprintf(&buffer[printed], buffer_size - printed, "N/A  ");
+    }
+  }
+
+  if (process_is_field_displayed(process_dec_rate, fields_to_display)) {
+    unsigned decode_rate = 0;
+    if (GPUINFO_PROCESS_FIELD_VALID(process, decode_usage)) {
+      decode_rate = process->decode_usage;
+      printed += snprintf(&buffer[printed], buffer_size - printed, "%3u%% ", decode_rate);
+    } else {
+      printed += snprintf(&buffer[printed], buffer_size - printed, "N/A  ");
+    }
+  }
+
+  static const struct {
+    enum process_field field;
+    enum gpuinfo_engine_class engine;
+  } engine_columns[] = {
+      {process_render_rate, gpuinfo_engine_render},
+      {process_compute_rate, gpuinfo_engine_compute},
+      {process_copy_rate, gpuinfo_engine_copy},
+  };
+  for (unsigned col = 0; col < ARRAY_SIZE(engine_columns); ++col) {
+    if (!process_is_field_displayed(engine_columns[col].field, fields_to_display))
+      continue;
+    enum gpuinfo_engine_class engine = engine_columns[col].engine;
+    if (GPUINFO_PROCESS_ENGINE_VALID(process, engine)) {
+      printed += snprintf(&buffer[printed], buffer_size - printed, "%3u%% ", process->engine_usage[engine]);
+    } else {
+      printed += snprintf(&buffer[printed], buffer_size - printed, "N/A  ");
+    }
+  }
+
+  if (process_is_field_displayed(process_memory, fields_to_display)) {
+    if (GPUINFO_PROCESS_FIELD_VALID(process, gpu_memory_usage)) {
+      if (GPUINFO_PROCESS_FIELD_VALID(process, gpu_memory_percentage)) {
+        snprintf(memory, 9 + 1, "%6uMiB", (unsigned)(process->gpu_memory_usage / 1048576));
+        snprintf(memory + 9, sizeof_process_field[process_memory] - 9 + 1, " %3u%%", process->gpu_memory_percentage);
+      } else {
+        snprintf(memory, sizeof_process_field[process_memory], "%6uMiB",
+                 (unsigned)(process->gpu_memory_usage / 1048576));
+      }
+    } else {
+      snprintf(memory, sizeof_process_field[process_memory], "%s", "N/A");
+    }
+    printed += snprintf(&buffer[printed], buffer_size - printed, "%*s ", sizeof_process_field[process_memory], memory);
+  }
+
+  if (process_is_field_displayed(process_cpu_usage, fields_to_display)) {
+    if (GPUINFO_PROCESS_FIELD_VALID(process, cpu_usage))
+      snprintf(cpu_percent, sizeof_process_field[process_cpu_usage] + 1, "%u%%", process->cpu_usage);
+    else
+      snprintf(cpu_percent, sizeof_process_field[process_cpu_usage] + 1, "   N/A");
+    printed += snprintf(&buffer[printed], buffer_size - printed, "%*s ",
+                        sizeof_process_field[process_cpu_usage], cpu_percent);
+  }
+
+  if (process_is_field_displayed(process_cpu_mem_usage, fields_to_display)) {
+    if (GPUINFO_PROCESS_FIELD_VALID(process, cpu_memory_res))
+      snprintf(cpu_mem, sizeof_process_field[process_cpu_mem_usage] + 1, "%zuMiB", process->cpu_memory_res / 1048576);
+    else
+      snprintf(cpu_mem, sizeof_process_field[process_cpu_mem_usage] + 1, "N/A");
+    printed += snprintf(&buffer[printed], buffer_size - printed, "%*s ",
+                        sizeof_process_field[process_cpu_mem_usage], cpu_mem);
+  }
+
+  if (process_is_field_displayed(process_energy, fields_to_display)) {
+    if (GPUINFO_PROCESS_FIELD_VALID(process, energy_consumed))
+      format_energy(energy, sizeof(energy), process->energy_consumed);
+    else
+      snprintf(energy, sizeof(energy), "N/A");
+    printed +=
+        snprintf(&buffer[printed], buffer_size - printed, "%*s ", sizeof_process_field[process_energy], energy);
+  }
+
+  if (process_is_field_displayed(process_locality, fields_to_display)) {
+    if (GPUINFO_PROCESS_FIELD_VALID(process, cpu_locality))
+      snprintf(locality, sizeof(locality), "%u%%%s", process->cpu_locality, process_is_remote(process) ? "!" : "");
+    else
+      snprintf(locality, sizeof(locality), "N/A");
+    printed +=
+        snprintf(&buffer[printed], buffer_size - printed, "%*s ", sizeof_process_field[process_locality], locality);
+  }
+
+  if (process_is_field_displayed(process_command, fields_to_display)) {
+    if (GPUINFO_PROCESS_FIELD_VALID(process, cmdline))
+      printed += snprintf(&buffer[printed], buffer_size - printed, "%.*s", (int)(buffer_size - printed),
+                          process->cmdline);
+  }
+  return (size_t)printed < buffer_size ? (unsigned)printed : (unsigned)buffer_size - 1;
+}
+
+// Formatted process lines, stored in a flat open-addressing table (linear probing) keyed by (pid, device). A line is
+// formatted again only when the values it was built from or the column layout changed. An entry is written with the
+// generation of the draw that last used it. Entries older than the previous generation are stale: their slot is reused
+// by new rows and dropped when the table is rebuilt.
+struct process_row_values {
+  const char *user_name; // The strings of a process are kept as long as the process lives
+  const char *cmdline;
+  unsigned long long gpu_memory_usage;
+  unsigned long cpu_memory_res;
+  unsigned long long energy_consumed;
+  unsigned cpu_locality;
+  enum gpu_process_type type;
+  unsigned gpu_usage;
+  unsigned encode_usage;
+  unsigned decode_usage;
+  unsigned engine_usage[gpuinfo_engine_class_count];
+  unsigned gpu_memory_percentage;
+  unsigned cpu_usage;
+  unsigned char valid[(gpuinfo_process_info_count + CHAR_BIT - 1) / CHAR_BIT];
+};
+
+struct process_row_entry {
+  pid_t pid;
+  unsigned gpu_id;
+  unsigned generation; // 0 for a slot that was never used
+  unsigned layout;
+  struct process_row_values values;
+  unsigned line_length;
+  char *line;
+};
+
+static struct {
+  struct process_row_entry *entries;
+  size_t capacity; // Power of two
+  size_t used;     // Slots with a generation, stale ones included
+  unsigned generation;
+  unsigned layout; // Incremented each time the displayed fields or the width of the user column change
+  process_field_displayed layout_fields;
+  unsigned layout_user_width;
+} process_row_cache = {.generation = 1, .layout = 1};
+
+#define PROCESS_ROW_CACHE_MIN_CAPACITY 64
+
+static void process_row_values_of(const struct gpu_process *process, struct process_row_values *values) {
+  // The whole struct is compared with memcmp, padding included
+  memset(values, 0, sizeof(*values));
+  values->user_name = process->user_name;
+  values->cmdline = process->cmdline;
+  values->gpu_memory_usage = process->gpu_memory_usage;
+  values->cpu_memory_res = process->cpu_memory_res;
+  values->energy_consumed = process->energy_consumed;
+  values->cpu_locality = process->cpu_locality;
+  values->type = process->type;
+  values->gpu_usage = process->gpu_usage;
+  values->encode_usage = process->encode_usage;
+  values->decode_usage = process->decode_usage;
+  memcpy(values->engine_usage, process->engine_usage, sizeof(values->engine_usage));
+  values->gpu_memory_percentage = process->gpu_memory_percentage;
+  values->cpu_usage = process->cpu_usage;
+  memcpy(values->valid, process->valid, sizeof(values->valid));
+}
+
+static size_t process_row_hash(pid_t pid, unsigned gpu_id) {
+  uint64_t hash = (uint64_t)(uint32_t)pid << 32 | gpu_id;
+  // splitmix64 finalizer
+  hash = (hash ^ (hash >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+  hash = (hash ^ (hash >> 27)) * UINT64_C(0x94d049bb133111eb);
+  return (size_t)(hash ^ (hash >> 31));
+}
+
+static bool process_row_entry_is_stale(const struct process_row_entry *entry) {
+  unsigned previous_generation = process_row_cache.generation - 1;
+  if (!previous_generation)
+    previous_generation = UINT_MAX;
+  return entry->generation != process_row_cache.generation && entry->generation != previous_generation;
+}
+
+// Returns the entry of the row, or the slot where it should be inserted if it is not in the table
+static struct process_row_entry *process_row_lookup(pid_t pid, unsigned gpu_id) {
+  size_t mask = process_row_cache.capacity - 1;
+  struct process_row_entry *reusable = NULL;
+  for (size_t idx = process_row_hash(pid, gpu_id) & mask;; idx = (idx + 1) & mask) {
+    struct process_row_entry *entry = &process_row_cache.entries[idx];
+    if (!entry->generation)
+      return reusable ? reusable : entry;
+    if (entry->pid == pid && entry->gpu_id == gpu_id)
+      return entry;
+    if (!reusable && process_row_entry_is_stale(entry))
+      reusable = entry;
+  }
+}
+
+// Rebuilds the table without its stale entries, growing it if needed
+static void process_row_rehash(void) {
+  struct process_row_entry *old_entries = process_row_cache.entries;
+  size_t old_capacity = process_row_cache.capacity;
+  size_t live = 0;
+  for (size_t i = 0; i < old_capacity; ++i) {
+    if (old_entries[i].generation && !process_row_entry_is_stale(&old_entries[i]))
+      live++;
+  }
+  size_t capacity = PROCESS_ROW_CACHE_MIN_CAPACITY;
+  while (capacity < 2 * (live + 1))
+    capacity *= 2;
+
+  struct process_row_entry *entries = calloc(capacity, sizeof(*entries));
+  if (!entries) {
+    perror("Cannot allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+  process_row_cache.entries = entries;
+  process_row_cache.capacity = capacity;
+  process_row_cache.used = 0;
+  for (size_t i = 0; i < old_capacity; ++i) {
+    if (!old_entries[i].generation)
+      continue;
+    if (process_row_entry_is_stale(&old_entries[i])) {
+      free(old_entries[i].line);
+    } else {
+      *process_row_lookup(old_entries[i].pid, old_entries[i].gpu_id) = old_entries[i];
+      process_row_cache.used++;
+    }
+  }
+  free(old_entries);
+}
+
+static void process_row_cache_clear(void) {
+  for (size_t i = 0; i < process_row_cache.capacity; ++i)
+    free(process_row_cache.entries[i].line);
+  free(process_row_cache.entries);
+  process_row_cache.entries = NULL;
+  process_row_cache.capacity = 0;
+  process_row_cache.used = 0;
+}
+
+// Returns the line of the process, only formatting it when it is not up to date in the cache
+static const struct process_row_entry *process_row(const struct gpuid_and_process *process,
+                                                   process_field_displayed fields_to_display) {
+  // Keep at least a quarter of the slots empty so that the probing stays short
+  if (4 * (process_row_cache.used + 1) > 3 * process_row_cache.capacity)
+    process_row_rehash();
+
+  struct process_row_values values;
+  process_row_values_of(process->process, &values);
+  struct process_row_entry *entry = process_row_lookup(process->process->pid, process->gpu_id);
+  bool same_row = entry->generation && entry->pid == process->process->pid && entry->gpu_id == process->gpu_id;
+  if (!entry->generation)
+    process_row_cache.used++;
+  if (!same_row || entry->layout != process_row_cache.layout || memcmp(&entry->values, &values, sizeof(values))) {
+    unsigned length = format_process_row(process, fields_to_display, process_print_buffer, process_buffer_line_size);
+    if (!entry->line || length > entry->line_length) {
+      free(entry->line);
+      entry->line = malloc(length + 1);
+      if (!entry->line) {
+        perror("Cannot allocate memory: ");
+        exit(EXIT_FAILURE);
+      }
+    }
+    memcpy(entry->line, process_print_buffer, length + 1);
+    entry->line_length = length;
+    entry->pid = process->process->pid;
+    entry->gpu_id = process->gpu_id;
+    entry->layout = process_row_cache.layout;
+    entry->values = values;
+  }
+  entry->generation = process_row_cache.generation;
+  return entry;
+}
+
 static void print_processes_on_screen(all_processes all_procs, struct process_window *process,
-                                      enum process_field sort_criterion, process_field_displayed fields_to_display) {
+                                      enum process_field sort_criterion, process_field_displayed fields_to_display,
+                                      unsigned remote_count) {
   WINDOW *win = process->option_window.state == nvtop_option_state_hidden ? process->process_win
                                                                           : process->process_with_option_win;
   struct gpuid_and_process *processes = all_procs.processes;
@@ -1180,11 +1831,14 @@ static void print_processes_on_screen(all_processes all_procs, struct process_wi
 
   size_t special_row = process->selected_row;
 
-  char pid_str[sizeof_process_field[process_pid] + 1];
-  char guid_str[sizeof_process_field[process_gpu_id] + 1];
-  char memory[sizeof_process_field[process_memory] + 1];
-  char cpu_percent[sizeof_process_field[process_cpu_usage] + 1];
-  char cpu_mem[sizeof_process_field[process_cpu_mem_usage] + 1];
+  if (++process_row_cache.generation == 0)
+    process_row_cache.generation = 1;
+  if (process_row_cache.layout_fields != fields_to_display ||
+      process_row_cache.layout_user_width != sizeof_process_field[process_user]) {
+    process_row_cache.layout_fields = fields_to_display;
+    process_row_cache.layout_user_width = sizeof_process_field[process_user];
+    process_row_cache.layout++;
+  }
 
   unsigned int start_at_process = process->offset;
   unsigned int end_at_process = start_at_process + rows;
@@ -1208,6 +1862,16 @@ static void print_processes_on_screen(all_processes all_procs, struct process_wi
   mvwchgat(win, 0, 0, -1, A_STANDOUT, green_color, NULL);
   set_attribute_between(win, 0, column_sort_start - (int)process->offset_column,
                         column_sort_end - (int)process->offset_column, A_STANDOUT, cyan_color);
+  // Warn about the processes running on CPUs remote to their device, where the header leaves room
+  if (remote_count) {
+    char warning[64];
+    int warning_length = snprintf(warning, sizeof(warning), " %u remote to their GPU ", remote_count);
+    if ((int)cols - warning_length >= printed - (int)process->offset_column) {
+      wattr_set(win, A_STANDOUT, red_color, NULL);
+      mvwprintw(win, 0, cols - warning_length, "%s", warning);
+      wstandend(win);
+    }
+  }
 
   int start_col_process_type = 0;
   for (enum process_field i = process_pid; i < process_type; ++i) {
@@ -1215,129 +1879,21 @@ static void print_processes_on_screen(all_processes all_procs, struct process_wi
       start_col_process_type += sizeof_process_field[i] + 1;
   }
   int end_col_process_type = start_col_process_type + sizeof_process_field[process_type];
+  int start_col_process_locality = 0;
+  for (enum process_field i = process_pid; i < process_locality; ++i) {
+    if (process_is_field_displayed(i, fields_to_display))
+      start_col_process_locality += sizeof_process_field[i] + 1;
+  }
+  int end_col_process_locality = start_col_process_locality + sizeof_process_field[process_locality];
 
   static unsigned printed_last_call = 0;
   unsigned last_line_printed = 0;
   for (unsigned int i = start_at_process; i < end_at_process && i < all_procs.processes_count; ++i) {
-    memset(process_print_buffer, 0, sizeof(process_print_buffer));
-
-    printed = 0;
-    if (process_is_field_displayed(process_pid, fields_to_display)) {
-      size_t size =
-          snprintf(pid_str, sizeof_process_field[process_pid] + 1, "%" PRIdMAX, (intmax_t)processes[i].process->pid);
-      if (size == sizeof_process_field[process_pid] + 1)
-        pid_str[sizeof_process_field[process_pid]] = '\0';
-      printed += snprintf(&process_print_buffer[printed], process_buffer_line_size, "%*s ",
-                          sizeof_process_field[process_pid], pid_str);
-    }
-
-    if (process_is_field_displayed(process_user, fields_to_display)) {
-      const char *username;
-      if (GPUINFO_PROCESS_FIELD_VALID(processes[i].process, user_name)) {
-        username = processes[i].process->user_name;
-      } else {
-        username = "N/A";
-      }
-
-      printed += snprintf(&process_print_buffer[printed], process_buffer_line_size - printed, "%*s ",
-                          sizeof_process_field[process_user], username);
-    }
-
-    if (process_is_field_displayed(process_gpu_id, fields_to_display)) {
-      size_t size = snprintf(guid_str, sizeof_process_field[process_gpu_id] + 1, "%u", processes[i].gpu_id);
-      if (size >= sizeof_process_field[process_gpu_id] + 1)
-        pid_str[sizeof_process_field[process_gpu_id]] = '\0';
-      printed += snprintf(&process_print_buffer[printed], process_buffer_line_size - printed, "%*s ",
-                          sizeof_process_field[process_gpu_id], guid_str);
-    }
-
-    if (process_is_field_displayed(process_type, fields_to_display)) {
-      if (processes[i].process->type == gpu_process_graphical_compute) {
-        printed += snprintf(&process_print_buffer[printed], process_buffer_line_size - printed, "%*s ",
-                            sizeof_process_field[process_type], "Both G+C");
-      } else if (processes[i].process->type == gpu_process_graphical) {
-        printed += snprintf(&process_print_buffer[printed], process_buffer_line_size - printed, "%*s ",
-                            sizeof_process_field[process_type], "Graphic");
-      } else {
-        printed += snprintf(&process_print_buffer[printed], process_buffer_line_size - printed, "%*s ",
-                            sizeof_process_field[process_type], "Compute");
-      }
-    }
-
-    if (process_is_field_displayed(process_gpu_rate, fields_to_display)) {
-      unsigned gpu_usage = 0;
-      if (GPUINFO_PROCESS_FIELD_VALID(processes[i].process, gpu_usage)) {
-        gpu_usage = processes[i].process->gpu_usage;
-        printed += snprintf(&process_print_buffer[printed], process_buffer_line_size - printed, "%3u%% ", gpu_usage);
-      } else {
-        printed += snprintf(&process_print_buffer[printed], process_buffer_line_size - printed, "N/A  ");
-      }
-    }
-
-    if (process_is_field_displayed(process_enc_rate, fields_to_display)) {
-      unsigned encoder_rate = 0;
-      if (GPUINFO_PROCESS_FIELD_VALID(processes[i].process, encode_usage)) {
-        encoder_rate = processes[i].process->encode_usage;
-        printed += snprintf(&process_print_buffer[printed], process_buffer_line_size - printed, "%3u%% ", encoder_rate);
-      } else {
-        printed += snprintf(&process_print_buffer[printed], process_buffer_line_size - printed, "N/A  ");
-      }
-    }
-
-    if (process_is_field_displayed(process_dec_rate, fields_to_display)) {
-      unsigned decode_rate = 0;
-      if (GPUINFO_PROCESS_FIELD_VALID(processes[i].process, decode_usage)) {
-        decode_rate = processes[i].process->decode_usage;
-        printed += snprintf(&process_print_buffer[printed], process_buffer_line_size - printed, "%3u%% ", decode_rate);
-      } else {
-        printed += snprintf(&process_print_buffer[printed], process_buffer_line_size - printed, "N/A  ");
-      }
-    }
-
-    if (process_is_field_displayed(process_memory, fields_to_display)) {
-      if (GPUINFO_PROCESS_FIELD_VALID(processes[i].process, gpu_memory_usage)) {
-        if (GPUINFO_PROCESS_FIELD_VALID(processes[i].process, gpu_memory_percentage)) {
-          snprintf(memory, 9 + 1, "%6uMiB", (unsigned)(processes[i].process->gpu_memory_usage / 1048576));
-          snprintf(memory + 9, sizeof_process_field[process_memory] - 9 + 1, " %3u%%",
-                   processes[i].process->gpu_memory_percentage);
-        } else {
-          snprintf(memory, sizeof_process_field[process_memory], "%6uMiB",
-                   (unsigned)(processes[i].process->gpu_memory_usage / 1048576));
-        }
-      } else {
-        snprintf(memory, sizeof_process_field[process_memory], "%s", "N/A");
-      }
-      printed += snprintf(&process_print_buffer[printed], process_buffer_line_size - printed, "%*s ",
-                          sizeof_process_field[process_memory], memory);
-    }
-
-    if (process_is_field_displayed(process_cpu_usage, fields_to_display)) {
-      if (GPUINFO_PROCESS_FIELD_VALID(processes[i].process, cpu_usage))
-        snprintf(cpu_percent, sizeof_process_field[process_cpu_usage] + 1, "%u%%", processes[i].process->cpu_usage);
-      else
-        snprintf(cpu_percent, sizeof_process_field[process_cpu_usage] + 1, "   N/A");
-      printed += snprintf(&process_print_buffer[printed], process_buffer_line_size - printed, "%*s ",
-                          sizeof_process_field[process_cpu_usage], cpu_percent);
-    }
-
-    if (process_is_field_displayed(process_cpu_mem_usage, fields_to_display)) {
-      if (GPUINFO_PROCESS_FIELD_VALID(processes[i].process, cpu_memory_res))
-        snprintf(cpu_mem, sizeof_process_field[process_cpu_mem_usage] + 1, "%zuMiB",
-                 processes[i].process->cpu_memory_res / 1048576);
-      else
-        snprintf(cpu_mem, sizeof_process_field[process_cpu_mem_usage] + 1, "N/A");
-      printed += snprintf(&process_print_buffer[printed], process_buffer_line_size - printed, "%*s ",
-                          sizeof_process_field[process_cpu_mem_usage], cpu_mem);
-    }
-
-    if (process_is_field_displayed(process_command, fields_to_display)) {
-      if (GPUINFO_PROCESS_FIELD_VALID(processes[i].process, cmdline))
-        printed += snprintf(&process_print_buffer[printed], process_buffer_line_size - printed, "%.*s",
-                            process_buffer_line_size - printed, processes[i].process->cmdline);
-    }
+    const struct process_row_entry *cached = process_row(&processes[i], fields_to_display);
+    const char *line = process->offset_column < cached->line_length ? &cached->line[process->offset_column] : "";
 
     unsigned int write_at = i - start_at_process + 1;
-    mvwprintw(win, write_at, 0, "%.*s", cols, &process_print_buffer[process->offset_column]);
+    mvwprintw(win, write_at, 0, "%.*s", cols, line);
     unsigned row, col;
     getyx(win, row, col);
     (void)col;
@@ -1363,6 +1919,11 @@ static void print_processes_on_screen(all_processes all_procs, struct process_wi
                                 end_col_process_type - (int)process->offset_column, 0, magenta_color);
         }
       }
+      if (process_is_field_displayed(process_locality, fields_to_display) &&
+          process_is_remote(processes[i].process)) {
+        set_attribute_between(win, write_at, start_col_process_locality - (int)process->offset_column,
+                              end_col_process_locality - (int)process->offset_column, 0, red_color);
+      }
     }
   }
   if (printed_last_call > last_line_printed) {
@@ -1377,6 +1938,110 @@ static void print_processes_on_screen(all_processes all_procs, struct process_wi
 
 static void update_process_option_win(struct nvtop_interface *interface);
 
+// Prints the line at row of the statistics when the window shows it
+static void stats_pane_line(WINDOW *win, unsigned *row, unsigned offset, const char *line) {
+  unsigned rows = getmaxy(win);
+  if (*row >= offset && *row - offset + 1 < rows) {
+    mvwprintw(win, *row - offset + 1, 0, "%.*s", getmaxx(win), line);
+    wclrtoeol(win);
+  }
+  (*row)++;
+}
+
+static void format_stats_line(char *line, size_t size, const char *label, const char *name, const char *unit,
+                              const struct gpuinfo_stats_summary *summary) {
+  char metric[24];
+  snprintf(metric, sizeof(metric), "%s (%s)", name, unit);
+  snprintf(line, size, "%-30.30s %-18s %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f", label, metric, summary->min,
+           summary->mean, summary->p50, summary->p95, summary->p99, summary->max);
+}
+
+// Lifetime statistics of the devices and processes in place of the process list
+static void draw_stats_pane(struct nvtop_interface *interface) {
+  WINDOW *win = interface->process.process_win;
+  unsigned rows = getmaxy(win);
+  char line[160];
+  snprintf(line, sizeof(line), "%-30s %-18s %9s %9s %9s %9s %9s %9s", "STATISTICS", "METRIC", "MIN", "MEAN", "P50",
+           "P95", "P99", "MAX");
+  mvwprintw(win, 0, 0, "%.*s", getmaxx(win), line);
+  wclrtoeol(win);
+  mvwchgat(win, 0, 0, -1, A_STANDOUT, green_color, NULL);
+
+  unsigned row = 0;
+  unsigned offset = interface->process.stats_offset;
+  double duration = gpuinfo_stats_duration();
+  snprintf(line, sizeof(line), "Over %.0fh%02.0fm%02.0fs, %llu samples", floor(duration / 3600.),
+           floor(fmod(duration, 3600.) / 60.), floor(fmod(duration, 60.)), (unsigned long long)gpuinfo_stats_samples());
+  stats_pane_line(win, &row, offset, line);
+  for (unsigned device = 0; device < gpuinfo_stats_devices_count(); ++device) {
+    const char *name = gpuinfo_stats_device_name(device);
+    char label[64];
+    snprintf(label, sizeof(label), "GPU%u %s", device, name ? name : "");
+    double energy;
+    if (gpuinfo_stats_device_energy(device, &energy)) {
+      snprintf(line, sizeof(line), "%-30.30s %-18s %.1fJ", label, "energy", energy);
+      stats_pane_line(win, &row, offset, line);
+      label[0] = '\0';
+    }
+    for (enum gpuinfo_stats_device_metric metric = 0; metric < gpuinfo_stats_device_metric_count; ++metric) {
+      struct gpuinfo_stats_summary summary;
+      gpuinfo_stats_device_summary(device, metric, &summary);
+      if (!summary.count)
+        continue;
+      format_stats_line(line, sizeof(line), label, gpuinfo_stats_device_metric_name(metric),
+                        gpuinfo_stats_device_metric_unit(metric), &summary);
+      stats_pane_line(win, &row, offset, line);
+      label[0] = '\0';
+    }
+    for (enum gpuinfo_stats_residency residency = 0; residency < gpuinfo_stats_residency_count; ++residency) {
+      struct gpuinfo_stats_residency_time time;
+      gpuinfo_stats_device_residency(device, residency, &time);
+      if (time.observed <= 0.)
+        continue;
+      snprintf(line, sizeof(line), "%-30.30s %-18s %.1fs over %.1fs (%.1f%%)", label,
+               gpuinfo_stats_residency_name(residency), time.time, time.observed, time.time * 100. / time.observed);
+      stats_pane_line(win, &row, offset, line);
+      label[0] = '\0';
+    }
+  }
+  for (unsigned i = 0; i < gpuinfo_stats_processes_count(); ++i) {
+    struct gpuinfo_stats_process process;
+    gpuinfo_stats_process_summary(i, &process);
+    char label[64];
+    snprintf(label, sizeof(label), "%c%d GPU%u %s", process.running ? ' ' : '-', (int)process.pid, process.device,
+             process.cmdline);
+    if (process.has_busy_time) {
+      snprintf(line, sizeof(line), "%-30.30s %-18s %.1fs over %.1fs", label, "busy time", process.busy_time,
+               process.lifetime);
+      stats_pane_line(win, &row, offset, line);
+      label[0] = '\0';
+    }
+    if (process.has_energy) {
+      snprintf(line, sizeof(line), "%-30.30s %-18s %.1fJ", label, "energy", process.energy);
+      stats_pane_line(win, &row, offset, line);
+      label[0] = '\0';
+    }
+    for (enum gpuinfo_stats_process_metric metric = 0; metric < gpuinfo_stats_process_metric_count; ++metric) {
+      if (!process.metrics[metric].count)
+        continue;
+      format_stats_line(line, sizeof(line), label, gpuinfo_stats_process_metric_name(metric),
+                        gpuinfo_stats_process_metric_unit(metric), &process.metrics[metric]);
+      stats_pane_line(win, &row, offset, line);
+      label[0] = '\0';
+    }
+  }
+  // Keep the last page full when the rows went away or the window grew
+  if (offset && row < offset + rows - 1) {
+    interface->process.stats_offset = row > rows - 1 ? row - (rows - 1) : 0;
+    interface->generation.ui++;
+  }
+  for (unsigned i = row > offset ? row - offset + 1 : 1; i < rows; ++i) {
+    wmove(win, i, 0);
+    wclrtoeol(win);
+  }
+  wnoutrefresh(win);
+}
+
 static void draw_processes(struct list_head *devices, struct nvtop_interface *interface) {
   if (interface->options.hide_processes_list)
     return;
@@ -1384,6 +2049,11 @@ static void draw_processes(struct list_head *devices, struct nvtop_interface *in
   if (interface->process.process_win == NULL)
     return;
 
+  if (interface->process.show_stats) {
+    draw_stats_pane(interface);
+    return;
+  }
+
   if (interface->process.option_window.state != interface->process.option_window.previous_state) {
     werase(interface->process.option_window.option_win);
     wclear(interface->process.process_win);
@@ -1395,29 +2065,31 @@ static void draw_processes(struct list_head *devices, struct nvtop_interface *in
 
   all_processes all_procs = all_processes_array(devices);
   filter_out_nvtop_pid(&all_procs, interface);
-  sort_process(all_procs, interface->options.sort_processes_by, !interface->options.sort_descending_order);
+  unsigned remote_count = filter_local_processes(&all_procs, interface);
+  // Only the rows up to the bottom of the window (or the selected one) need to be in order
+  WINDOW *process_win = interface->process.option_window.state == nvtop_option_state_hidden
+                            ? interface->process.process_win
+                            : interface->process.process_with_option_win;
+  unsigned window_rows = getmaxy(process_win);
+  unsigned sorted_count = max(interface->process.offset + window_rows, interface->process.selected_row + 1);
+  sort_process(all_procs, interface->options.sort_processes_by, !interface->options.sort_descending_order,
+               sorted_count, &interface->process.sort_cache);
 
   if (all_procs.processes_count > 0) {
     if (interface->process.selected_row >= all_procs.processes_count)
       interface->process.selected_row = all_procs.processes_count - 1;
     interface->process.selected_pid = all_procs.processes[interface->process.selected_row].process->pid;
+    interface->process.selected_pid_foreign = all_procs.processes[interface->process.selected_row].foreign_pid;
   } else {
     interface->process.selected_row = 0;
     interface->process.selected_pid = -1;
+    interface->process.selected_pid_foreign = false;
   }
 
-  unsigned largest_username = 4;
-  for (unsigned i = 0; i < all_procs.processes_count; ++i) {
-    if (GPUINFO_PROCESS_FIELD_VALID(all_procs.processes[i].process, user_name)) {
-      unsigned length = strlen(all_procs.processes[i].process->user_name);
-      if (length > largest_username)
-        largest_username = length;
-    }
-  }
-  sizeof_process_field[process_user] = largest_username;
+  sizeof_process_field[process_user] = max(4, gpuinfo_largest_user_name_length());
 
   print_processes_on_screen(all_procs, &interface->process, interface->options.sort_processes_by,
-                            interface->options.process_fields_displayed);
+                            interface->options.process_fields_displayed, remote_count);
   free(all_procs.processes);
 }
 
@@ -1555,10 +2227,10 @@ static void update_process_option_win(struct nvtop_interface *interface) {
 }
 
 static const char *option_selection_hidden[] = {
-    "Setup", "Sort", "Kill", "Quit", "Save Config",
+    "Setup", "Sort", "Stats", "Kill", "Quit", "Save Config",
 };
 static const char *option_selection_hidden_num[] = {
-    "2", "6", "9", "10", "12",
+    "2", "6", "7", "9", "10", "12",
 };
 
 static const char *option_selection_sort[][2] = {
@@ -1585,10 +2257,11 @@ static void draw_process_shortcuts(struct nvtop_interface *interface) {
   case nvtop_option_state_hidden:
     for (size_t i = 0; i < ARRAY_SIZE(option_selection_hidden); ++i) {
       if (interface->options.hide_processes_list &&
-          (strcmp(option_selection_hidden_num[i], "6") == 0 || strcmp(option_selection_hidden_num[i], "9") == 0))
+          (strcmp(option_selection_hidden_num[i], "6") == 0 || strcmp(option_selection_hidden_num[i], "9") == 0 ||
+           strcmp(option_selection_hidden_num[i], "7") == 0))
         continue;
 
-      if (process_field_displayed_count(interface->options.process_fields_displayed) > 0 || (i != 1 && i != 2)) {
+      if (process_field_displayed_count(interface->options.process_fields_displayed) > 0 || (i != 1 && i != 3)) {
         wprintw(win, "F%s", option_selection_hidden_num[i]);
         wattr_set(win, A_STANDOUT, cyan_color, NULL);
         wprintw(win, "%-*s", option_selection_width, option_selection_hidden[i]);
@@ -1632,82 +2305,156 @@ static void draw_shortcuts(struct nvtop_interface *interface) {
   }
 }
 
+// Shows the measured terminal output rate at the end of the shortcut bar
+static void draw_output_rate(struct nvtop_interface *interface) {
+  WINDOW *win = interface->shortcut_window;
+  char rate[32];
+  double bytes_per_sec = interface->output.rate;
+  // Without the write counter, the frames are only limited by the frame rate
+  if (interface->output.io_stats_fd < 0)
+    snprintf(rate, sizeof(rate), " No byte budget ");
+  else if (bytes_per_sec < 1024.)
+    snprintf(rate, sizeof(rate), " %4.0fB/s ", bytes_per_sec);
+  else if (bytes_per_sec < 1024. * 1024.)
+    snprintf(rate, sizeof(rate), " %5.1fKiB/s ", bytes_per_sec / 1024.);
+  else
+    snprintf(rate, sizeof(rate), " %5.1fMiB/s ", bytes_per_sec / (1024. * 1024.));
+  int cols = getmaxx(win);
+  int len = strlen(rate);
+  if (cols <= len)
+    return;
+  wattr_set(win, A_STANDOUT, cyan_color, NULL);
+  mvwprintw(win, 0, cols - len, "%s", rate);
+  wstandend(win);
+  wnoutrefresh(win);
+}
+
 void save_current_data_to_ring(struct list_head *devices, struct nvtop_interface *interface) {
   struct gpu_info *device;
   unsigned dev_id = 0;
+  nvtop_time now;
+  nvtop_get_current_time(&now);
+  unsigned long long now_ms = (unsigned long long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
 
+  bool fleet = fleet_history(interface);
   list_for_each_entry(device, devices, list) {
-    unsigned data_index = 0;
+    // Every metric is recorded so that its history is available as soon as it gets plotted, except for the fleets
+    // where the metrics that were never plotted take no memory
+    plot_info_to_draw plotted = interface->options.gpu_specific_opts[dev_id].to_draw;
     for (enum plot_information info = plot_gpu_rate; info < plot_information_count; ++info) {
-      if (plot_isset_draw_info(info, interface->options.gpu_specific_opts[dev_id].to_draw)) {
-        unsigned data_val = 0;
-        switch (info) {
-        case plot_gpu_rate:
-          if (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, gpu_util_rate))
-            data_val = device->dynamic_info.gpu_util_rate;
-          break;
-        case plot_gpu_mem_rate:
-          if (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, mem_util_rate))
-            data_val = device->dynamic_info.mem_util_rate;
-          break;
-        case plot_encoder_rate:
-          if (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, encoder_rate))
-            data_val = device->dynamic_info.encoder_rate;
-          break;
-        case plot_decoder_rate:
-          if (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, decoder_rate))
-            data_val = device->dynamic_info.decoder_rate;
-          break;
-        case plot_gpu_temperature:
-          if (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, gpu_temp)) {
-            data_val = device->dynamic_info.gpu_temp;
-            if (data_val > 100)
-              data_val = 100u;
-          }
-          break;
-        case plot_gpu_power_draw_rate:
-          if (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, power_draw) &&
-              GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, power_draw_max)) {
-            data_val = device->dynamic_info.power_draw * 100 / device->dynamic_info.power_draw_max;
-            if (data_val > 100)
-              data_val = 100u;
-          }
-          break;
-        case plot_fan_speed:
-          if (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, fan_speed)) {
-            data_val = device->dynamic_info.fan_speed;
-          }
-          break;
-        case plot_gpu_clock_rate:
-          if (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, gpu_clock_speed) &&
-              GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, gpu_clock_speed_max)) {
-            data_val = device->dynamic_info.gpu_clock_speed * 100 / device->dynamic_info.gpu_clock_speed_max;
-          }
-          break;
-        case plot_gpu_mem_clock_rate:
-          if (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, mem_clock_speed) &&
-              GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, mem_clock_speed_max)) {
-            data_val = device->dynamic_info.mem_clock_speed * 100 / device->dynamic_info.mem_clock_speed_max;
-          }
-          break;
-        case plot_information_count:
-          break;
+      unsigned data_val = HISTORY_UNAVAILABLE;
+      if (fleet && !plot_isset_draw_info(info, plotted)) {
+        interface_history_push(&interface->history, dev_id, info, data_val, now_ms);
+        continue;
+      }
+      switch (info) {
+      case plot_gpu_rate:
+        if (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, gpu_util_rate))
+          data_val = device->dynamic_info.gpu_util_rate;
+        break;
+      case plot_gpu_mem_rate:
+        if (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, mem_util_rate))
+          data_val = device->dynamic_info.mem_util_rate;
+        break;
+      case plot_encoder_rate:
+        if (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, encoder_rate))
+          data_val = device->dynamic_info.encoder_rate;
+        break;
+      case plot_decoder_rate:
+        if (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, decoder_rate))
+          data_val = device->dynamic_info.decoder_rate;
+        break;
+      case plot_gpu_temperature:
+        if (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, gpu_temp)) {
+          data_val = device->dynamic_info.gpu_temp;
+          if (data_val > 100)
+            data_val = 100u;
+        }
+        break;
+      case plot_gpu_power_draw_rate:
+        if (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, power_draw) &&
+            GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, power_draw_max) &&
+            device->dynamic_info.power_draw_max) {
+          data_val = min((uint64_t)device->dynamic_info.power_draw * 100 / device->dynamic_info.power_draw_max, 100);
+        }
+        break;
+      case plot_fan_speed:
+        if (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, fan_speed)) {
+          data_val = device->dynamic_info.fan_speed;
+        }
+        break;
+      case plot_gpu_clock_rate:
+        if (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, gpu_clock_speed) &&
+            GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, gpu_clock_speed_max) &&
+            device->dynamic_info.gpu_clock_speed_max) {
+          data_val =
+              min((uint64_t)device->dynamic_info.gpu_clock_speed * 100 / device->dynamic_info.gpu_clock_speed_max, 100);
         }
-        interface_ring_buffer_push(&interface->saved_data_ring, dev_id, data_index, data_val);
-        data_index++;
+        break;
+      case plot_gpu_mem_clock_rate:
+        if (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, mem_clock_speed) &&
+            GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, mem_clock_speed_max) &&
+            device->dynamic_info.mem_clock_speed_max) {
+          data_val =
+              min((uint64_t)device->dynamic_info.mem_clock_speed * 100 / device->dynamic_info.mem_clock_speed_max, 100);
+        }
+        break;
+      case plot_render_engine_rate:
+        if (GPUINFO_DYNAMIC_ENGINE_VALID(&device->dynamic_info, gpuinfo_engine_render))
+          data_val = device->dynamic_info.engine_util_rate[gpuinfo_engine_render];
+        break;
+      case plot_compute_engine_rate:
+        if (GPUINFO_DYNAMIC_ENGINE_VALID(&device->dynamic_info, gpuinfo_engine_compute))
+          data_val = device->dynamic_info.engine_util_rate[gpuinfo_engine_compute];
+        break;
+      case plot_copy_engine_rate:
+        if (GPUINFO_DYNAMIC_ENGINE_VALID(&device->dynamic_info, gpuinfo_engine_copy))
+          data_val = device->dynamic_info.engine_util_rate[gpuinfo_engine_copy];
+        break;
+      case plot_information_count:
+        break;
       }
+      interface_history_push(&interface->history, dev_id, info, data_val, now_ms);
     }
 
     dev_id++;
   }
+  interface->generation.sample++;
 }
 
-static unsigned populate_plot_data_from_ring_buffer(const struct nvtop_interface *interface,
-                                                    struct plot_window *plot_win, unsigned size_data_buff,
-                                                    double data[size_data_buff],
-                                                    char plot_legend[MAX_LINES_PER_PLOT][PLOT_MAX_LEGEND_SIZE]) {
+// Reduces the slots shown by the column-th column, counting from the most recent one. Returns the mean of the slots
+// with data and sets the range they cover.
+static double history_column_reduce(const interface_history *history, unsigned dev_id, enum plot_information info,
+                                    enum interface_history_tier tier, unsigned stored, unsigned column,
+                                    unsigned slots_per_column, double *low, double *high) {
+  unsigned first = column * slots_per_column;
+  unsigned last = min(first + slots_per_column, stored);
+  struct interface_history_reduction reduction;
+  interface_history_reduce(history, dev_id, info, tier, stored - last, last - first, &reduction);
+  if (!reduction.values) {
+    *low = *high = 0.;
+    return 0.;
+  }
+  *low = reduction.min;
+  *high = reduction.max;
+  return (double)reduction.sum / reduction.values;
+}
 
-  memset(data, 0, size_data_buff * sizeof(*data));
+// Fills the mean of each column in data and the range of the values aggregated by the column in data_min and data_max.
+// When scroll_by_one is set, data already holds the previous sample: it is shifted by one column and only the newest
+// value of each line is copied from the history.
+static unsigned populate_plot_data_from_history(const struct nvtop_interface *interface,
+                                                    struct plot_window *plot_win, unsigned size_data_buff,
+                                                    double data[size_data_buff], double data_min[size_data_buff],
+                                                    double data_max[size_data_buff],
+                                                    char plot_legend[MAX_LINES_PER_PLOT][PLOT_MAX_LEGEND_SIZE],
+                                                    bool scroll_by_one) {
+
+  if (!scroll_by_one) {
+    memset(data, 0, size_data_buff * sizeof(*data));
+    memset(data_min, 0, size_data_buff * sizeof(*data_min));
+    memset(data_max, 0, size_data_buff * sizeof(*data_max));
+  }
   unsigned total_to_draw = 0;
   for (unsigned i = 0; i < plot_win->num_devices_to_plot; ++i) {
     unsigned dev_id = plot_win->devices_ids[i];
@@ -1718,13 +2465,28 @@ static unsigned populate_plot_data_from_ring_buffer(const struct nvtop_interface
   assert(total_to_draw > 0);
   assert(size_data_buff % total_to_draw == 0);
   unsigned max_data_to_copy = size_data_buff / total_to_draw;
+  enum interface_history_tier tier = plot_zoom_levels[interface->plot_zoom].tier;
+  unsigned slots_per_column = plot_slots_per_column(interface);
   double (*data_split)[total_to_draw] = (double (*)[total_to_draw])data;
+  double (*min_split)[total_to_draw] = (double (*)[total_to_draw])data_min;
+  double (*max_split)[total_to_draw] = (double (*)[total_to_draw])data_max;
+  if (scroll_by_one && max_data_to_copy > 1) {
+    size_t shifted = (max_data_to_copy - 1) * sizeof(*data_split);
+    if (interface->options.plot_left_to_right) {
+      memmove(data_split[1], data_split[0], shifted);
+      memmove(min_split[1], min_split[0], shifted);
+      memmove(max_split[1], max_split[0], shifted);
+    } else {
+      memmove(data_split[0], data_split[1], shifted);
+      memmove(min_split[0], min_split[1], shifted);
+      memmove(max_split[0], max_split[1], shifted);
+    }
+  }
 
   unsigned in_processing = 0;
   for (unsigned i = 0; i < plot_win->num_devices_to_plot; ++i) {
     unsigned dev_id = plot_win->devices_ids[i];
     plot_info_to_draw to_draw = interface->options.gpu_specific_opts[dev_id].to_draw;
-    unsigned data_ring_index = 0;
     for (enum plot_information info = plot_gpu_rate; info < plot_information_count; ++info) {
       if (plot_isset_draw_info(info, to_draw)) {
         // Populate the legend
@@ -1756,23 +2518,40 @@ static unsigned populate_plot_data_from_ring_buffer(const struct nvtop_interface
         case plot_gpu_mem_clock_rate:
           snprintf(plot_legend[in_processing], PLOT_MAX_LEGEND_SIZE, "GPU%u mem clock%%", dev_id);
           break;
+        case plot_render_engine_rate:
+          snprintf(plot_legend[in_processing], PLOT_MAX_LEGEND_SIZE, "GPU%u render%%", dev_id);
+          break;
+        case plot_compute_engine_rate:
+          snprintf(plot_legend[in_processing], PLOT_MAX_LEGEND_SIZE, "GPU%u compute%%", dev_id);
+          break;
+        case plot_copy_engine_rate:
+          snprintf(plot_legend[in_processing], PLOT_MAX_LEGEND_SIZE, "GPU%u copy%%", dev_id);
+          break;
         case plot_information_count:
           break;
         }
         // Copy the data
-        unsigned data_in_ring = interface_ring_buffer_data_stored(&interface->saved_data_ring, dev_id, data_ring_index);
-        if (interface->options.plot_left_to_right) {
-          for (unsigned j = 0; j < data_in_ring && j < max_data_to_copy; ++j) {
-            data_split[j][in_processing] =
-                interface_ring_buffer_get(&interface->saved_data_ring, dev_id, data_ring_index, data_in_ring - j - 1);
+        unsigned stored = interface_history_stored(&interface->history, dev_id, info, tier);
+        if (scroll_by_one) {
+          unsigned newest = interface->options.plot_left_to_right ? 0 : max_data_to_copy - 1;
+          data_split[newest][in_processing] =
+              history_column_reduce(&interface->history, dev_id, info, tier, stored, 0, slots_per_column,
+                                    &min_split[newest][in_processing], &max_split[newest][in_processing]);
+          // The value shifted past the oldest one kept in the history
+          if (stored < max_data_to_copy) {
+            unsigned dropped = interface->options.plot_left_to_right ? stored : max_data_to_copy - stored - 1;
+            data_split[dropped][in_processing] = 0.;
+            min_split[dropped][in_processing] = 0.;
+            max_split[dropped][in_processing] = 0.;
           }
         } else {
-          for (unsigned j = 0; j < data_in_ring && j < max_data_to_copy; ++j) {
-            data_split[max_data_to_copy - j - 1][in_processing] =
-                interface_ring_buffer_get(&interface->saved_data_ring, dev_id, data_ring_index, data_in_ring - j - 1);
+          for (unsigned j = 0; j * slots_per_column < stored && j < max_data_to_copy; ++j) {
+            unsigned column = interface->options.plot_left_to_right ? j : max_data_to_copy - j - 1;
+            data_split[column][in_processing] =
+                history_column_reduce(&interface->history, dev_id, info, tier, stored, j, slots_per_column,
+                                      &min_split[column][in_processing], &max_split[column][in_processing]);
           }
         }
-        data_ring_index++;
         in_processing++;
       }
     }
@@ -1782,34 +2561,161 @@ static unsigned populate_plot_data_from_ring_buffer(const struct nvtop_interface
 
 static void draw_plots(struct nvtop_interface *interface) {
   for (unsigned plot_id = 0; plot_id < interface->num_plots; ++plot_id) {
-    werase(interface->plots[plot_id].plot_window);
+    struct plot_window *plot = &interface->plots[plot_id];
+    werase(plot->plot_window);
 
     char plot_legend[MAX_LINES_PER_PLOT][PLOT_MAX_LEGEND_SIZE];
 
-    unsigned num_lines =
-        populate_plot_data_from_ring_buffer(interface, &interface->plots[plot_id], interface->plots[plot_id].num_data,
-                                            interface->plots[plot_id].data, plot_legend);
+    // Only one new sample since the last time: scroll the data instead of copying it all again
+    bool scroll_by_one = plot->data_sample && plot->data_sample + 1 == interface->generation.sample &&
+                         plot_slots_per_column(interface) == 1 &&
+                         plot_zoom_levels[interface->plot_zoom].tier == history_tier_sample;
+    unsigned num_lines = populate_plot_data_from_history(interface, plot, plot->num_data, plot->data, plot->data_min,
+                                                         plot->data_max, plot_legend, scroll_by_one);
+    plot->data_sample = interface->generation.sample;
+
+    // The range of the values is only worth showing when the columns aggregate several of them
+    bool aggregated = plot_slots_per_column(interface) > 1 ||
+                      plot_zoom_levels[interface->plot_zoom].tier != history_tier_sample;
+    nvtop_line_plot(plot->plot_window, plot->num_data, plot->data, aggregated ? plot->data_min : NULL,
+                    aggregated ? plot->data_max : NULL, num_lines, !interface->options.plot_left_to_right,
+                    plot_legend);
+
+    wnoutrefresh(plot->plot_window);
+  }
+}
+
+// Updates the time axis of the plots, their data has to be read again from the history
+static void update_plot_time_scale(struct nvtop_interface *interface) {
+  for (unsigned plot_id = 0; plot_id < interface->num_plots; ++plot_id) {
+    draw_plot_frame(&interface->plots[plot_id], &interface->options, plot_column_period(interface));
+    interface->plots[plot_id].data_sample = 0;
+  }
+}
+
+// Returns true if the window has to be drawn, that is if one of the generations it depends on moved since the last
+// time it was drawn
+static bool interface_window_outdated(struct interface_generation *drawn, const struct interface_generation *current,
+                                      bool depends_on_sample, bool depends_on_ui) {
+  bool outdated = drawn->layout != current->layout || (depends_on_sample && drawn->sample != current->sample) ||
+                  (depends_on_ui && drawn->ui != current->ui);
+  *drawn = *current;
+  return outdated;
+}
+
+#define MAX_PLOT_COARSENESS 16
+
+// Low bandwidth mode: at most low_bandwidth_max_fps frames per second. The windows are flushed one after the other,
+// from the device header to the process list, and the frame stops once it wrote more than its byte budget. The
+// windows left out are drawn by the next frame, and the plots aggregate more samples per column while they do not fit.
+static void draw_gpu_info_low_bandwidth(unsigned devices_count, struct list_head *devices,
+                                        struct nvtop_interface *interface) {
+  struct interface_generation *current = &interface->generation;
+  struct interface_drawn_generations *drawn = &interface->drawn;
+  struct interface_output *output = &interface->output;
+
+  nvtop_time now;
+  nvtop_get_current_time(&now);
+  if (output->last_frame.tv_sec || output->last_frame.tv_nsec) {
+    double since_last_frame = nvtop_difftime(output->last_frame, now);
+    if (since_last_frame * interface->options.low_bandwidth_max_fps < 1.) {
+      output->frame_pending = true;
+      return;
+    }
+  }
+  output->last_frame = now;
+  output->frame_pending = false;
 
-    nvtop_line_plot(interface->plots[plot_id].plot_window, interface->plots[plot_id].num_data,
-                    interface->plots[plot_id].data, num_lines, !interface->options.plot_left_to_right, plot_legend);
+  unsigned long long frame_start = output->bytes;
+  unsigned budget = interface->options.low_bandwidth_frame_budget;
+#define FRAME_OVER_BUDGET() (output->bytes - frame_start >= budget)
 
-    wnoutrefresh(interface->plots[plot_id].plot_window);
+  if (interface_window_outdated(&drawn->devices, current, true, interface->setup_win.visible)) {
+    draw_devices(devices, interface);
+    output_doupdate(output);
   }
+  bool processes_deferred = false;
+  if (!interface->setup_win.visible) {
+    bool plot_layout_changed = drawn->plots.layout != current->layout;
+    if (FRAME_OVER_BUDGET()) {
+      output->frame_pending |= drawn->plots.layout != current->layout || drawn->plots.sample != current->sample;
+    } else if (interface_window_outdated(&drawn->plots, current, true, false) &&
+               (plot_layout_changed || current->sample % output->plot_coarseness == 0)) {
+      unsigned long long plots_start = output->bytes;
+      draw_plots(interface);
+      output_doupdate(output);
+      unsigned long long plot_bytes = output->bytes - plots_start;
+      unsigned coarseness = output->plot_coarseness;
+      if (plot_bytes > budget / 2 && coarseness < MAX_PLOT_COARSENESS)
+        coarseness *= 2;
+      else if (plot_bytes < budget / 8 && coarseness > 1)
+        coarseness /= 2;
+      if (coarseness != output->plot_coarseness) {
+        output->plot_coarseness = coarseness;
+        update_plot_time_scale(interface);
+        draw_plots(interface);
+      }
+    }
+    if (FRAME_OVER_BUDGET()) {
+      processes_deferred = drawn->processes.layout != current->layout || drawn->processes.sample != current->sample ||
+                           drawn->processes.ui != current->ui;
+      output->frame_pending |= processes_deferred;
+    } else if (interface_window_outdated(&drawn->processes, current, true, true)) {
+      draw_processes(devices, interface);
+    }
+  } else {
+    draw_setup_window(devices_count, devices, interface);
+  }
+#undef FRAME_OVER_BUDGET
+  // The process shortcuts track the option window state together with the process list
+  if (!processes_deferred && interface_window_outdated(&drawn->shortcuts, current, false, true))
+    draw_shortcuts(interface);
+
+  double rate_period = nvtop_difftime(output->rate_since, now);
+  if (rate_period >= 1.) {
+    output->rate = (output->bytes - output->rate_bytes) / rate_period;
+    output->rate_bytes = output->bytes;
+    output->rate_since = now;
+  }
+  draw_output_rate(interface);
+  output_doupdate(output);
 }
 
 void draw_gpu_info_ncurses(unsigned devices_count, struct list_head *devices, struct nvtop_interface *interface) {
+  struct interface_generation *current = &interface->generation;
+  struct interface_drawn_generations *drawn = &interface->drawn;
 
-  draw_devices(devices, interface);
+  if (interface->options.low_bandwidth_mode) {
+    draw_gpu_info_low_bandwidth(devices_count, devices, interface);
+    return;
+  }
+
+  // The header options can be changed live from the setup window
+  if (interface_window_outdated(&drawn->devices, current, true, interface->setup_win.visible))
+    draw_devices(devices, interface);
   if (!interface->setup_win.visible) {
-    draw_plots(interface);
-    draw_processes(devices, interface);
+    if (interface_window_outdated(&drawn->plots, current, true, false))
+      draw_plots(interface);
+    if (interface_window_outdated(&drawn->processes, current, true, true))
+      draw_processes(devices, interface);
   } else {
     draw_setup_window(devices_count, devices, interface);
   }
-  draw_shortcuts(interface);
+  if (interface_window_outdated(&drawn->shortcuts, current, false, true))
+    draw_shortcuts(interface);
   doupdate();
 }
 
+int interface_frame_delay(const struct nvtop_interface *interface) {
+  if (!interface->options.low_bandwidth_mode || !interface->output.frame_pending)
+    return -1;
+  nvtop_time now;
+  nvtop_get_current_time(&now);
+  int elapsed = (int)(nvtop_difftime(interface->output.last_frame, now) * 1000.);
+  int frame_period = 1000 / interface->options.low_bandwidth_max_fps;
+  return elapsed < frame_period ? frame_period - elapsed : 0;
+}
+
 void update_window_size_to_terminal_size(struct nvtop_interface *inter) {
   endwin();
   erase();
@@ -1831,7 +2737,8 @@ static void option_do_kill(struct nvtop_interface *interface) {
     return;
   pid_t pid = interface->process.selected_pid;
   int sig = signalValues[interface->process.option_window.selected_row];
-  if (pid > 0) {
+  // The same pid would be another process of this host
+  if (pid > 0 && !interface->process.selected_pid_foreign) {
     kill(pid, sig);
   }
 }
@@ -1852,6 +2759,7 @@ static void option_change_sort(struct nvtop_interface *interface) {
 }
 
 void interface_key(int keyId, struct nvtop_interface *interface) {
+  interface->generation.ui++;
   if (interface->setup_win.visible) {
     handle_setup_win_keypress(keyId, interface);
     return;
@@ -1865,8 +2773,17 @@ void interface_key(int keyId, struct nvtop_interface *interface) {
   case KEY_F(12):
     save_interface_options_to_config_file(interface->total_dev_count, &interface->options);
     break;
+  case KEY_F(7):
+    if (!interface->options.hide_processes_list &&
+        interface->process.option_window.state == nvtop_option_state_hidden) {
+      interface->process.show_stats = !interface->process.show_stats;
+      interface->process.stats_offset = 0;
+      werase(interface->process.process_win);
+    }
+    break;
   case KEY_F(9):
     if (process_field_displayed_count(interface->options.process_fields_displayed) > 0 &&
+        !interface->process.show_stats && !interface->process.selected_pid_foreign &&
         interface->process.option_window.state == nvtop_option_state_hidden) {
       interface->process.option_window.state = nvtop_option_state_kill;
       interface->process.option_window.selected_row = 0;
@@ -1874,7 +2791,7 @@ void interface_key(int keyId, struct nvtop_interface *interface) {
     break;
   case KEY_F(6):
     if (process_field_displayed_count(interface->options.process_fields_displayed) > 0 &&
-        interface->process.option_window.state == nvtop_option_state_hidden) {
+        !interface->process.show_stats && interface->process.option_window.state == nvtop_option_state_hidden) {
       interface->process.option_window.state = nvtop_option_state_sort_by;
       interface->process.option_window.selected_row = 0;
     }
@@ -1898,7 +2815,9 @@ void interface_key(int keyId, struct nvtop_interface *interface) {
         interface->process.option_window.selected_row--;
       break;
     case nvtop_option_state_hidden:
-      if (interface->process.selected_row != 0)
+      if (interface->process.show_stats && interface->process.stats_offset != 0)
+        interface->process.stats_offset--;
+      else if (!interface->process.show_stats && interface->process.selected_row != 0)
         interface->process.selected_row--;
       break;
     default:
@@ -1913,12 +2832,44 @@ void interface_key(int keyId, struct nvtop_interface *interface) {
       interface->process.option_window.selected_row++;
       break;
     case nvtop_option_state_hidden:
-      interface->process.selected_row++;
+      if (interface->process.show_stats)
+        interface->process.stats_offset++;
+      else
+        interface->process.selected_row++;
       break;
     default:
       break;
     }
     break;
+  case '<':
+  case '>':
+    if (keyId == '<' && interface->plot_zoom > 0)
+      interface->plot_zoom--;
+    else if (keyId == '>' && interface->plot_zoom + 1 < ARRAY_SIZE(plot_zoom_levels))
+      interface->plot_zoom++;
+    else
+      break;
+    update_plot_time_scale(interface);
+    // The plots only follow the samples, force them out of date
+    interface->drawn.plots = (struct interface_generation){0};
+    break;
+  case 'd':
+    interface->options.dense_device_view = !interface->options.dense_device_view;
+    update_window_size_to_terminal_size(interface);
+    break;
+  case '[':
+  case ']':
+    if (!interface->heatmap.enabled)
+      break;
+    // The windows of the previous selection are freed before the selection changes
+    delete_all_windows(interface);
+    if (keyId == '[')
+      interface->heatmap.selected_device =
+          (interface->heatmap.selected_device + interface->monitored_dev_count - 1) % interface->monitored_dev_count;
+    else
+      interface->heatmap.selected_device = (interface->heatmap.selected_device + 1) % interface->monitored_dev_count;
+    initialize_all_windows(interface);
+    break;
   case '+':
     interface->options.sort_descending_order = false;
     break;
@@ -1957,6 +2908,57 @@ bool interface_freeze_processes(struct nvtop_interface *interface) {
   return interface->process.option_window.state == nvtop_option_state_kill;
 }
 
+static gpuinfo_subscription subscription_from_plots(plot_info_to_draw to_draw) {
+  static const enum gpuinfo_subscription_group plot_group[plot_information_count] = {
+      [plot_gpu_rate] = gpuinfo_subscribe_utilisation,
+      [plot_gpu_mem_rate] = gpuinfo_subscribe_memory,
+      [plot_encoder_rate] = gpuinfo_subscribe_encode_decode,
+      [plot_decoder_rate] = gpuinfo_subscribe_encode_decode,
+      [plot_gpu_temperature] = gpuinfo_subscribe_thermal,
+      [plot_gpu_power_draw_rate] = gpuinfo_subscribe_power,
+      [plot_fan_speed] = gpuinfo_subscribe_thermal,
+      [plot_gpu_clock_rate] = gpuinfo_subscribe_clocks,
+      [plot_gpu_mem_clock_rate] = gpuinfo_subscribe_clocks,
+      [plot_render_engine_rate] = gpuinfo_subscribe_processes,
+      [plot_compute_engine_rate] = gpuinfo_subscribe_processes,
+      [plot_copy_engine_rate] = gpuinfo_subscribe_processes,
+  };
+  gpuinfo_subscription subscription = 0;
+  for (enum plot_information info = 0; info < plot_information_count; ++info) {
+    if (plot_isset_draw_info(info, to_draw))
+      subscription |= GPUINFO_SUBSCRIPTION(plot_group[info]);
+  }
+  return subscription;
+}
+
+void interface_update_subscriptions(const struct nvtop_interface *interface, struct list_head *devices) {
+  // The heatmap and the device headers
+  const gpuinfo_subscription heatmap_subscription =
+      GPUINFO_SUBSCRIPTION(gpuinfo_subscribe_utilisation) | GPUINFO_SUBSCRIPTION(gpuinfo_subscribe_encode_decode) |
+      GPUINFO_SUBSCRIPTION(gpuinfo_subscribe_memory) | GPUINFO_SUBSCRIPTION(gpuinfo_subscribe_thermal) |
+      GPUINFO_SUBSCRIPTION(gpuinfo_subscribe_power);
+  const gpuinfo_subscription header_subscription = heatmap_subscription |
+                                                   GPUINFO_SUBSCRIPTION(gpuinfo_subscribe_clocks) |
+                                                   GPUINFO_SUBSCRIPTION(gpuinfo_subscribe_pcie);
+  bool process_list_shown = !interface->options.hide_processes_list &&
+                            process_field_displayed_count(interface->options.process_fields_displayed) > 0;
+
+  const gpuinfo_subscription consumer_needs = gpuinfo_consumer_needs();
+
+  struct gpu_info *device;
+  unsigned dev_id = 0;
+  list_for_each_entry(device, devices, list) {
+    bool full_header = !interface->heatmap.enabled || dev_id == interface->heatmap.selected_device;
+    // The plotted metrics are always collected to keep the history of every device complete
+    device->subscription = (full_header ? header_subscription : heatmap_subscription) |
+                           subscription_from_plots(interface->options.gpu_specific_opts[dev_id].to_draw);
+    if (process_list_shown)
+      device->subscription |= GPUINFO_SUBSCRIPTION(gpuinfo_subscribe_processes);
+    device->subscription |= consumer_needs;
+    dev_id++;
+  }
+}
+
 extern inline void set_attribute_between(WINDOW *win, int startY, int startX, int endX, attr_t attr, short pair);
 
 int interface_update_interval(const struct nvtop_interface *interface) { return interface->options.update_interval; }
@@ -1989,6 +2991,44 @@ void interface_check_monitored_gpu_change(struct nvtop_interface **interface, un
   }
 }
 
+void interface_add_joined_gpus(struct nvtop_interface **interface, unsigned *allDevCount, unsigned *num_monitored_gpus,
+                               struct list_head *monitoredGpus, struct list_head *nonMonitoredGpus,
+                               struct list_head *joinedGpus) {
+  if (list_empty(joinedGpus) || (*interface)->setup_win.visible)
+    return;
+  unsigned joined = 0;
+  struct gpu_info *device;
+  list_for_each_entry(device, joinedGpus, list) { joined++; }
+  nvtop_interface_option options_copy = (*interface)->options;
+  memset(&(*interface)->options, 0, sizeof(options_copy));
+  options_copy.gpu_specific_opts =
+      reallocarray(options_copy.gpu_specific_opts, *allDevCount + joined, sizeof(*options_copy.gpu_specific_opts));
+  if (!options_copy.gpu_specific_opts) {
+    perror("Cannot allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+  // The options of the monitored devices come first, followed by the ones of the devices not monitored
+  memmove(&options_copy.gpu_specific_opts[*num_monitored_gpus + joined],
+          &options_copy.gpu_specific_opts[*num_monitored_gpus],
+          (*allDevCount - *num_monitored_gpus) * sizeof(*options_copy.gpu_specific_opts));
+  unsigned idx = *num_monitored_gpus;
+  struct gpu_info *list_tmp;
+  list_for_each_entry_safe(device, list_tmp, joinedGpus, list) {
+    options_copy.gpu_specific_opts[idx++] = (nvtop_interface_gpu_opts){
+        .linkedGpu = device, .to_draw = plot_default_draw_info(), .doNotMonitor = false};
+    list_move_tail(&device->list, monitoredGpus);
+  }
+  *allDevCount += joined;
+  *num_monitored_gpus =
+      interface_check_and_fix_monitored_gpus(*allDevCount, monitoredGpus, nonMonitoredGpus, &options_copy);
+  clean_ncurses(*interface);
+  // The windows are laid out anew, nothing of the previous layout may stay on screen
+  clear();
+  *interface =
+      initialize_curses(*allDevCount, *num_monitored_gpus, interface_largest_gpu_name(monitoredGpus), options_copy);
+  timeout(interface_update_interval(*interface));
+}
+
 static char dontShowAgain[] = "<Don't Show Again>";
 static char okay[] = "<Ok>";
 static char interactKeys[] = "Press Enter to select, arrows \">\" and \"<\" to switch options";
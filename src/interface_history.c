@@ -0,0 +1,375 @@
+
+#include "nvtop/interface_history.h"
+#include "nvtop/common.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#if defined(__SSE2__)
+#define HISTORY_REDUCE_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(__GNUC__) && defined(__x86_64__)
+#define HISTORY_REDUCE_AVX2
+#include <immintrin.h>
+#endif
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define HISTORY_REDUCE_NEON
+#include <arm_neon.h>
+#endif
+
+#define HISTORY_SAMPLE_TIER_DURATION (10 * 60 * 1000)
+#define HISTORY_INITIAL_CAPACITY 64
+
+void interface_alloc_history(unsigned monitored_dev_count, unsigned metrics_per_device, unsigned update_interval,
+                             bool short_tiers, interface_history *history) {
+  history->series = calloc(monitored_dev_count * metrics_per_device, sizeof(*history->series));
+  if (!history->series) {
+    perror("Cannot allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+  history->monitored_dev_count = monitored_dev_count;
+  history->metrics_per_device = metrics_per_device;
+  history->tier_period[history_tier_sample] = update_interval;
+  history->tier_size[history_tier_sample] = (HISTORY_SAMPLE_TIER_DURATION + update_interval - 1) / update_interval;
+  history->tier_period[history_tier_10s] = 10 * 1000;
+  history->tier_size[history_tier_10s] = short_tiers ? 6 * 60 : 6 * 60 * 6;
+  history->tier_period[history_tier_1min] = 60 * 1000;
+  history->tier_size[history_tier_1min] = short_tiers ? 24 * 60 : 7 * 24 * 60;
+}
+
+void interface_free_history(interface_history *history) {
+  for (unsigned i = 0; i < history->monitored_dev_count * history->metrics_per_device; ++i) {
+    for (enum interface_history_tier tier = history_tier_sample; tier < history_tier_count; ++tier) {
+      for (enum interface_history_aggregate aggregate = history_min; aggregate < history_aggregate_count; ++aggregate)
+        free(history->series[i].tiers[tier].values[aggregate]);
+    }
+  }
+  free(history->series);
+}
+
+// The ring only wraps around once it reached the size of the tier, so growing it keeps the slots in order
+static void history_slots_push(struct interface_history_slots *slots, unsigned tier_size, bool single_value,
+                               const uint8_t values[history_aggregate_count]) {
+  // Nothing to remember until the first value of the metric
+  if (slots->count == 0 && values[history_avg] == HISTORY_NO_DATA)
+    return;
+  if (slots->count == slots->capacity && slots->capacity < tier_size) {
+    unsigned capacity = slots->capacity ? slots->capacity * 2 : HISTORY_INITIAL_CAPACITY;
+    if (capacity > tier_size)
+      capacity = tier_size;
+    for (enum interface_history_aggregate aggregate = history_min; aggregate < history_aggregate_count; ++aggregate) {
+      if (single_value && aggregate != history_avg)
+        continue;
+      uint8_t *grown = reallocarray(slots->values[aggregate], capacity, sizeof(*grown));
+      if (!grown) {
+        perror("Cannot allocate memory: ");
+        exit(EXIT_FAILURE);
+      }
+      slots->values[aggregate] = grown;
+    }
+    slots->capacity = capacity;
+  }
+  unsigned location = slots->start + slots->count;
+  if (location >= slots->capacity)
+    location -= slots->capacity;
+  for (enum interface_history_aggregate aggregate = history_min; aggregate < history_aggregate_count; ++aggregate) {
+    if (!single_value || aggregate == history_avg)
+      slots->values[aggregate][location] = values[aggregate];
+  }
+  if (slots->count < slots->capacity) {
+    slots->count++;
+  } else {
+    slots->start++;
+    if (slots->start == slots->capacity)
+      slots->start = 0;
+  }
+}
+
+static void history_slots_push_no_data(struct interface_history_slots *slots, unsigned tier_size) {
+  const uint8_t no_data[history_aggregate_count] = {HISTORY_NO_DATA, HISTORY_NO_DATA, HISTORY_NO_DATA};
+  history_slots_push(slots, tier_size, false, no_data);
+}
+
+// Closes the pending slot of an aggregating tier when the sample belongs to a later one. The slots during which no
+// sample was taken (e.g., the process was stopped) are recorded without data.
+static void history_aggregate_push(struct interface_history_slots *slots, struct interface_history_pending *pending,
+                                   unsigned tier_size, unsigned tier_period, uint8_t value,
+                                   unsigned long long time_ms) {
+  unsigned long long slot = time_ms / tier_period;
+  if (slot != pending->slot) {
+    if (pending->samples) {
+      uint8_t aggregates[history_aggregate_count] = {
+          [history_min] = pending->min,
+          [history_avg] = (pending->sum + pending->samples / 2) / pending->samples,
+          [history_max] = pending->max,
+      };
+      history_slots_push(slots, tier_size, false, aggregates);
+    } else {
+      history_slots_push_no_data(slots, tier_size);
+    }
+    unsigned long long missing = slot > pending->slot ? slot - pending->slot - 1 : 0;
+    if (missing >= tier_size) {
+      slots->start = 0;
+      slots->count = 0;
+    } else {
+      for (unsigned long long i = 0; i < missing; ++i)
+        history_slots_push_no_data(slots, tier_size);
+    }
+    pending->slot = slot;
+    pending->samples = 0;
+  }
+  if (value != HISTORY_NO_DATA) {
+    if (pending->samples == 0) {
+      pending->sum = 0;
+      pending->min = value;
+      pending->max = value;
+    }
+    pending->samples++;
+    pending->sum += value;
+    if (value < pending->min)
+      pending->min = value;
+    if (value > pending->max)
+      pending->max = value;
+  }
+}
+
+void interface_history_push(interface_history *history, unsigned device, unsigned metric, unsigned value,
+                            unsigned long long time_ms) {
+  assert(device < history->monitored_dev_count && metric < history->metrics_per_device);
+  struct interface_history_series *series = &history->series[device * history->metrics_per_device + metric];
+  // Values are percentages, only the out of range ones need clamping, below the marker of the slots without data
+  uint8_t stored_value = HISTORY_NO_DATA;
+  if (value != HISTORY_UNAVAILABLE)
+    stored_value = value >= HISTORY_NO_DATA ? HISTORY_NO_DATA - 1 : value;
+
+  const uint8_t sample[history_aggregate_count] = {stored_value, stored_value, stored_value};
+  history_slots_push(&series->tiers[history_tier_sample], history->tier_size[history_tier_sample], true, sample);
+  for (enum interface_history_tier tier = history_tier_10s; tier < history_tier_count; ++tier) {
+    history_aggregate_push(&series->tiers[tier], &series->pending[tier], history->tier_size[tier],
+                           history->tier_period[tier], stored_value, time_ms);
+  }
+}
+
+// The reductions skip the slots without data. HISTORY_NO_DATA is the largest uint8_t so the minimum ignores it
+// naturally, while the maximum is taken over the values plus one (wrapping HISTORY_NO_DATA to 0) and shifted back.
+
+static void history_reduce_merge(struct interface_history_reduction *reduction, uint8_t min, uint8_t max_plus_one,
+                                 unsigned sum, unsigned values) {
+  if (min < reduction->min)
+    reduction->min = min;
+  uint8_t max = max_plus_one - 1;
+  if (max != HISTORY_NO_DATA && (reduction->max == HISTORY_NO_DATA || max > reduction->max))
+    reduction->max = max;
+  reduction->sum += sum;
+  reduction->values += values;
+}
+
+static void history_reduce_scalar(const uint8_t *min, const uint8_t *avg, const uint8_t *max, unsigned count,
+                                  struct interface_history_reduction *reduction) {
+  uint8_t span_min = HISTORY_NO_DATA, span_max_plus_one = 0;
+  unsigned sum = 0, values = 0;
+  for (unsigned i = 0; i < count; ++i) {
+    if (min[i] < span_min)
+      span_min = min[i];
+    uint8_t max_plus_one = max[i] + 1;
+    if (max_plus_one > span_max_plus_one)
+      span_max_plus_one = max_plus_one;
+    if (avg[i] != HISTORY_NO_DATA) {
+      sum += avg[i];
+      values++;
+    }
+  }
+  history_reduce_merge(reduction, span_min, span_max_plus_one, sum, values);
+}
+
+#ifdef HISTORY_REDUCE_SSE2
+struct history_reduce_sse2_state {
+  __m128i min;
+  __m128i max_plus_one;
+  __m128i sum;
+  __m128i missing;
+};
+
+// Always inlined so that the AVX2 kernel reuses them with the VEX encoding, avoiding the SSE/AVX transition penalties
+static inline __attribute__((always_inline)) void history_reduce_sse2_step(struct history_reduce_sse2_state *state,
+                                                                           const uint8_t *min, const uint8_t *avg,
+                                                                           const uint8_t *max) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i one = _mm_set1_epi8(1);
+  state->min = _mm_min_epu8(state->min, _mm_loadu_si128((const __m128i *)min));
+  state->max_plus_one = _mm_max_epu8(state->max_plus_one, _mm_add_epi8(_mm_loadu_si128((const __m128i *)max), one));
+  __m128i values = _mm_loadu_si128((const __m128i *)avg);
+  __m128i is_missing = _mm_cmpeq_epi8(values, _mm_set1_epi8((char)HISTORY_NO_DATA));
+  state->sum = _mm_add_epi64(state->sum, _mm_sad_epu8(_mm_andnot_si128(is_missing, values), zero));
+  state->missing = _mm_add_epi64(state->missing, _mm_sad_epu8(_mm_and_si128(is_missing, one), zero));
+}
+
+static inline __attribute__((always_inline)) void
+history_reduce_sse2_finish(const struct history_reduce_sse2_state *state, unsigned reduced,
+                           struct interface_history_reduction *reduction) {
+  uint8_t lanes_min[16], lanes_max[16];
+  uint64_t lanes_sum[2], lanes_missing[2];
+  _mm_storeu_si128((__m128i *)lanes_min, state->min);
+  _mm_storeu_si128((__m128i *)lanes_max, state->max_plus_one);
+  _mm_storeu_si128((__m128i *)lanes_sum, state->sum);
+  _mm_storeu_si128((__m128i *)lanes_missing, state->missing);
+  uint8_t vector_min = HISTORY_NO_DATA, vector_max_plus_one = 0;
+  for (unsigned lane = 0; lane < 16; ++lane) {
+    vector_min = lanes_min[lane] < vector_min ? lanes_min[lane] : vector_min;
+    vector_max_plus_one = lanes_max[lane] > vector_max_plus_one ? lanes_max[lane] : vector_max_plus_one;
+  }
+  history_reduce_merge(reduction, vector_min, vector_max_plus_one, lanes_sum[0] + lanes_sum[1],
+                       reduced - (lanes_missing[0] + lanes_missing[1]));
+}
+
+static void history_reduce_sse2(const uint8_t *min, const uint8_t *avg, const uint8_t *max, unsigned count,
+                                struct interface_history_reduction *reduction) {
+  struct history_reduce_sse2_state state = {
+      .min = _mm_set1_epi8((char)HISTORY_NO_DATA),
+      .max_plus_one = _mm_setzero_si128(),
+      .sum = _mm_setzero_si128(),
+      .missing = _mm_setzero_si128(),
+  };
+  unsigned i = 0;
+  for (; i + 16 <= count; i += 16)
+    history_reduce_sse2_step(&state, min + i, avg + i, max + i);
+  history_reduce_sse2_finish(&state, i, reduction);
+  history_reduce_scalar(min + i, avg + i, max + i, count - i, reduction);
+}
+#endif
+
+#if defined(HISTORY_REDUCE_AVX2) && defined(HISTORY_REDUCE_SSE2)
+__attribute__((target("avx2"))) static void history_reduce_avx2(const uint8_t *min, const uint8_t *avg,
+                                                                const uint8_t *max, unsigned count,
+                                                                struct interface_history_reduction *reduction) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i one = _mm256_set1_epi8(1);
+  const __m256i no_data = _mm256_set1_epi8((char)HISTORY_NO_DATA);
+  __m256i span_min = no_data, span_max_plus_one = zero, sum = zero, missing = zero;
+  unsigned i = 0;
+  for (; i + 32 <= count; i += 32) {
+    span_min = _mm256_min_epu8(span_min, _mm256_loadu_si256((const __m256i *)(min + i)));
+    span_max_plus_one =
+        _mm256_max_epu8(span_max_plus_one, _mm256_add_epi8(_mm256_loadu_si256((const __m256i *)(max + i)), one));
+    __m256i values = _mm256_loadu_si256((const __m256i *)(avg + i));
+    __m256i is_missing = _mm256_cmpeq_epi8(values, no_data);
+    sum = _mm256_add_epi64(sum, _mm256_sad_epu8(_mm256_andnot_si256(is_missing, values), zero));
+    missing = _mm256_add_epi64(missing, _mm256_sad_epu8(_mm256_and_si256(is_missing, one), zero));
+  }
+  // Fold the two halves and finish with 16 bytes wide steps
+  struct history_reduce_sse2_state state = {
+      .min = _mm_min_epu8(_mm256_castsi256_si128(span_min), _mm256_extracti128_si256(span_min, 1)),
+      .max_plus_one =
+          _mm_max_epu8(_mm256_castsi256_si128(span_max_plus_one), _mm256_extracti128_si256(span_max_plus_one, 1)),
+      .sum = _mm_add_epi64(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1)),
+      .missing = _mm_add_epi64(_mm256_castsi256_si128(missing), _mm256_extracti128_si256(missing, 1)),
+  };
+  for (; i + 16 <= count; i += 16)
+    history_reduce_sse2_step(&state, min + i, avg + i, max + i);
+  history_reduce_sse2_finish(&state, i, reduction);
+  history_reduce_scalar(min + i, avg + i, max + i, count - i, reduction);
+}
+#endif
+
+#ifdef HISTORY_REDUCE_NEON
+static void history_reduce_neon(const uint8_t *min, const uint8_t *avg, const uint8_t *max, unsigned count,
+                                struct interface_history_reduction *reduction) {
+  const uint8x16_t one = vdupq_n_u8(1);
+  const uint8x16_t no_data = vdupq_n_u8(HISTORY_NO_DATA);
+  uint8x16_t span_min = no_data, span_max_plus_one = vdupq_n_u8(0);
+  uint32x4_t sum = vdupq_n_u32(0), missing = vdupq_n_u32(0);
+  unsigned i = 0;
+  for (; i + 16 <= count; i += 16) {
+    span_min = vminq_u8(span_min, vld1q_u8(min + i));
+    span_max_plus_one = vmaxq_u8(span_max_plus_one, vaddq_u8(vld1q_u8(max + i), one));
+    uint8x16_t values = vld1q_u8(avg + i);
+    uint8x16_t is_missing = vceqq_u8(values, no_data);
+    sum = vpadalq_u16(sum, vpaddlq_u8(vbicq_u8(values, is_missing)));
+    missing = vpadalq_u16(missing, vpaddlq_u8(vandq_u8(is_missing, one)));
+  }
+  history_reduce_merge(reduction, vminvq_u8(span_min), vmaxvq_u8(span_max_plus_one), vaddvq_u32(sum),
+                       i - vaddvq_u32(missing));
+  history_reduce_scalar(min + i, avg + i, max + i, count - i, reduction);
+}
+#endif
+
+#define HISTORY_REDUCE_MAX_KERNELS 3
+
+unsigned interface_history_reduce_kernels(const struct interface_history_reduce_kernel **kernels) {
+  static struct interface_history_reduce_kernel supported[HISTORY_REDUCE_MAX_KERNELS];
+  static unsigned supported_count = 0;
+  if (!supported_count) {
+    supported[supported_count++] = (struct interface_history_reduce_kernel){"scalar", history_reduce_scalar};
+#if defined(HISTORY_REDUCE_SSE2)
+    supported[supported_count++] = (struct interface_history_reduce_kernel){"sse2", history_reduce_sse2};
+#endif
+#if defined(HISTORY_REDUCE_AVX2) && defined(HISTORY_REDUCE_SSE2)
+    if (__builtin_cpu_supports("avx2"))
+      supported[supported_count++] = (struct interface_history_reduce_kernel){"avx2", history_reduce_avx2};
+#endif
+#if defined(HISTORY_REDUCE_NEON)
+    supported[supported_count++] = (struct interface_history_reduce_kernel){"neon", history_reduce_neon};
+#endif
+  }
+  *kernels = supported;
+  return supported_count;
+}
+
+static interface_history_reduce_fn history_reduce_kernel(void) {
+  static interface_history_reduce_fn kernel = NULL;
+  if (!kernel) {
+    const struct interface_history_reduce_kernel *kernels;
+    unsigned count = interface_history_reduce_kernels(&kernels);
+    kernel = kernels[count - 1].reduce;
+  }
+  return kernel;
+}
+
+void interface_history_reduce(const interface_history *history, unsigned device, unsigned metric,
+                              enum interface_history_tier tier, unsigned first, unsigned count,
+                              struct interface_history_reduction *reduction) {
+  assert(first + count <= interface_history_stored(history, device, metric, tier));
+  reduction->min = HISTORY_NO_DATA;
+  reduction->max = HISTORY_NO_DATA;
+  reduction->sum = 0;
+  reduction->values = 0;
+  const struct interface_history_series *series = interface_history_get_series(history, device, metric);
+  const struct interface_history_slots *slots = &series->tiers[tier];
+  // The slot still aggregating samples comes after the ring
+  if (first + count > slots->count) {
+    const struct interface_history_pending *pending = &series->pending[tier];
+    history_reduce_merge(reduction, pending->min, pending->max + 1,
+                         (pending->sum + pending->samples / 2) / pending->samples, 1);
+    count--;
+  }
+  if (count == 0)
+    return;
+  // The sample tier stores each value once
+  const uint8_t *min = slots->values[tier == history_tier_sample ? history_avg : history_min];
+  const uint8_t *avg = slots->values[history_avg];
+  const uint8_t *max = slots->values[tier == history_tier_sample ? history_avg : history_max];
+  interface_history_reduce_fn reduce = history_reduce_kernel();
+  // The range is contiguous in the ring unless it wraps around the end of the buffer
+  unsigned location = slots->start + first;
+  if (location >= slots->capacity)
+    location -= slots->capacity;
+  unsigned contiguous = slots->capacity - location;
+  if (contiguous > count)
+    contiguous = count;
+  reduce(min + location, avg + location, max + location, contiguous, reduction);
+  if (contiguous < count)
+    reduce(min, avg, max, count - contiguous, reduction);
+}
+
+extern inline const struct interface_history_series *interface_history_get_series(const interface_history *history,
+                                                                                  unsigned device, unsigned metric);
+
+extern inline unsigned interface_history_stored(const interface_history *history, unsigned device, unsigned metric,
+                                                enum interface_history_tier tier);
+
+extern inline uint8_t interface_history_get(const interface_history *history, unsigned device, unsigned metric,
+                                            enum interface_history_tier tier,
+                                            enum interface_history_aggregate aggregate, unsigned index);
@@ -88,19 +88,24 @@ static unsigned cols_used_by_stack(unsigned stack_id, unsigned plot_count, const
   return sum;
 }
 
-static unsigned size_differences_between_stacks(unsigned plot_count, unsigned stack_count,
-                                                unsigned cols_allocated_in_stacks[plot_count]) {
-  unsigned sum = 0;
+static long long abs_difference(unsigned a, unsigned b) { return a > b ? (long long)a - b : (long long)b - a; }
+
+// Change of the sum of the column differences between each pair of stacks when moving a plot taking cols_moved
+// columns from one stack to another. Only the pairs involving these two stacks change.
+static long long size_differences_change_after_move(unsigned stack_count,
+                                                    const unsigned cols_allocated_in_stacks[stack_count],
+                                                    unsigned from_stack, unsigned to_stack, unsigned cols_moved) {
+  unsigned from_before = cols_allocated_in_stacks[from_stack], to_before = cols_allocated_in_stacks[to_stack];
+  unsigned from_after = from_before - cols_moved, to_after = to_before + cols_moved;
+  long long change = abs_difference(from_after, to_after) - abs_difference(from_before, to_before);
   for (unsigned i = 0; i < stack_count; ++i) {
-    for (unsigned j = i + 1; j < stack_count; ++j) {
-      if (cols_allocated_in_stacks[i] > cols_allocated_in_stacks[j]) {
-        sum += cols_allocated_in_stacks[i] - cols_allocated_in_stacks[j];
-      } else {
-        sum += cols_allocated_in_stacks[j] - cols_allocated_in_stacks[i];
-      }
-    }
+    if (i == from_stack || i == to_stack)
+      continue;
+    unsigned cols = cols_allocated_in_stacks[i];
+    change += abs_difference(from_after, cols) - abs_difference(from_before, cols);
+    change += abs_difference(to_after, cols) - abs_difference(to_before, cols);
   }
-  return sum;
+  return change;
 }
 
 static void preliminary_plot_positioning(unsigned rows_for_plots, unsigned plot_total_cols, unsigned devices_count,
@@ -213,29 +218,26 @@ static void balance_info_on_stacks_preserving_plot_order(unsigned stack_max_cols
   while (moving_plot_id < plot_count) {
     unsigned to_stack = plot_in_stack[moving_plot_id] + 1;
     if (to_stack < stack_count) {
-      unsigned diff_sum_before = size_differences_between_stacks(plot_count, stack_count, cols_allocated_in_stacks);
-      unsigned stack_before = plot_in_stack[moving_plot_id];
-      if (move_plot_to_stack(stack_max_cols, moving_plot_id, to_stack, plot_count, stack_count, num_info_per_plot,
-                             cols_allocated_in_stacks, plot_in_stack)) {
-        unsigned diff_sum_after = size_differences_between_stacks(plot_count, stack_count, cols_allocated_in_stacks);
-        if (diff_sum_after <= diff_sum_before) {
-          moving_plot_id = plot_count;
-        } else {
-          // Move back
-          move_plot_to_stack(stack_max_cols, moving_plot_id, stack_before, plot_count, stack_count, num_info_per_plot,
-                             cols_allocated_in_stacks, plot_in_stack);
-        }
+      // Only move if the plot fits and the stacks get more balanced
+      unsigned cols_moved = min_plot_cols(num_info_per_plot[moving_plot_id]);
+      if (cols_allocated_in_stacks[to_stack] + cols_moved <= stack_max_cols &&
+          size_differences_change_after_move(stack_count, cols_allocated_in_stacks, plot_in_stack[moving_plot_id],
+                                             to_stack, cols_moved) <= 0) {
+        move_plot_to_stack(stack_max_cols, moving_plot_id, to_stack, plot_count, stack_count, num_info_per_plot,
+                           cols_allocated_in_stacks, plot_in_stack);
+        moving_plot_id = plot_count;
       }
     }
     moving_plot_id--;
   }
 }
-void compute_sizes_from_layout(unsigned devices_count, unsigned device_header_rows, unsigned device_header_cols,
-                               unsigned rows, unsigned cols, const nvtop_interface_gpu_opts *gpuOpts,
-                               process_field_displayed process_displayed, struct window_position *device_positions,
-                               unsigned *num_plots, struct window_position plot_positions[MAX_CHARTS],
-                               unsigned *map_device_to_plot, struct window_position *process_position,
-                               struct window_position *setup_position, bool process_win_hide) {
+
+static void solve_layout(unsigned devices_count, unsigned device_header_rows, unsigned device_header_cols,
+                         unsigned rows, unsigned cols, const nvtop_interface_gpu_opts *gpuOpts,
+                         process_field_displayed process_displayed, struct window_position *device_positions,
+                         unsigned *num_plots, struct window_position plot_positions[MAX_CHARTS],
+                         unsigned *map_device_to_plot, struct window_position *process_position,
+                         struct window_position *setup_position, bool process_win_hide) {
 
   unsigned min_rows_for_header = 0, header_stacks = 0, num_device_per_row = 0;
   num_device_per_row = max(1, cols / device_header_cols);
@@ -380,3 +382,113 @@ void compute_sizes_from_layout(unsigned devices_count, unsigned device_header_ro
   setup_position->sizeY = rows - rows_for_header;
   setup_position->sizeX = cols;
 }
+
+// The solved layouts are kept for the last few terminal geometries and plot selections, so that resizing back and
+// forth or toggling an option does not search again.
+#define LAYOUT_CACHE_ENTRIES 4
+
+struct layout_key {
+  unsigned devices_count, device_header_rows, device_header_cols, rows, cols;
+  process_field_displayed process_displayed;
+  bool process_win_hide;
+  plot_info_to_draw to_draw[MAX_CHARTS];
+};
+
+static struct layout_cache_entry {
+  bool valid;
+  unsigned long long last_use;
+  struct layout_key key;
+  unsigned num_plots;
+  struct window_position device_positions[MAX_CHARTS];
+  struct window_position plot_positions[MAX_CHARTS];
+  unsigned map_device_to_plot[MAX_CHARTS];
+  struct window_position process_position, setup_position;
+} layout_cache[LAYOUT_CACHE_ENTRIES];
+static unsigned long long layout_cache_clock;
+
+void compute_sizes_from_layout(unsigned devices_count, unsigned device_header_rows, unsigned device_header_cols,
+                               unsigned rows, unsigned cols, const nvtop_interface_gpu_opts *gpuOpts,
+                               process_field_displayed process_displayed, struct window_position *device_positions,
+                               unsigned *num_plots, struct window_position plot_positions[MAX_CHARTS],
+                               unsigned *map_device_to_plot, struct window_position *process_position,
+                               struct window_position *setup_position, bool process_win_hide) {
+  if (devices_count > MAX_CHARTS) {
+    solve_layout(devices_count, device_header_rows, device_header_cols, rows, cols, gpuOpts, process_displayed,
+                 device_positions, num_plots, plot_positions, map_device_to_plot, process_position, setup_position,
+                 process_win_hide);
+    return;
+  }
+
+  // Zeroed so that the padding and the unused devices compare equal
+  struct layout_key key;
+  memset(&key, 0, sizeof(key));
+  key.devices_count = devices_count;
+  key.device_header_rows = device_header_rows;
+  key.device_header_cols = device_header_cols;
+  key.rows = rows;
+  key.cols = cols;
+  key.process_displayed = process_displayed;
+  key.process_win_hide = process_win_hide;
+  for (unsigned i = 0; i < devices_count; ++i)
+    key.to_draw[i] = gpuOpts[i].to_draw;
+
+  struct layout_cache_entry *entry = NULL;
+  for (unsigned i = 0; i < LAYOUT_CACHE_ENTRIES; ++i) {
+    if (layout_cache[i].valid && memcmp(&layout_cache[i].key, &key, sizeof(key)) == 0) {
+      entry = &layout_cache[i];
+      break;
+    }
+  }
+  if (!entry) {
+    // Replace the least recently used layout
+    entry = &layout_cache[0];
+    for (unsigned i = 1; i < LAYOUT_CACHE_ENTRIES && entry->valid; ++i) {
+      if (!layout_cache[i].valid || layout_cache[i].last_use < entry->last_use)
+        entry = &layout_cache[i];
+    }
+    solve_layout(devices_count, device_header_rows, device_header_cols, rows, cols, gpuOpts, process_displayed,
+                 entry->device_positions, &entry->num_plots, entry->plot_positions, entry->map_device_to_plot,
+                 &entry->process_position, &entry->setup_position, process_win_hide);
+    entry->key = key;
+    entry->valid = true;
+  }
+  entry->last_use = ++layout_cache_clock;
+
+  memcpy(device_positions, entry->device_positions, devices_count * sizeof(*device_positions));
+  *num_plots = entry->num_plots;
+  memcpy(plot_positions, entry->plot_positions, entry->num_plots * sizeof(*plot_positions));
+  memcpy(map_device_to_plot, entry->map_device_to_plot, devices_count * sizeof(*map_device_to_plot));
+  *process_position = entry->process_position;
+  *setup_position = entry->setup_position;
+}
+
+bool heatmap_layout_selected(unsigned devices_count, bool dense_device_view) {
+  return devices_count > 1 && (dense_device_view || devices_count > MAX_CHARTS);
+}
+
+void compute_sizes_from_heatmap_layout(unsigned devices_count, unsigned selected, unsigned heatmap_rows,
+                                       unsigned device_header_rows, unsigned device_header_cols, unsigned rows,
+                                       unsigned cols, const nvtop_interface_gpu_opts *gpuOpts,
+                                       process_field_displayed process_displayed,
+                                       struct window_position *heatmap_position,
+                                       struct window_position *device_positions, unsigned *num_plots,
+                                       struct window_position plot_positions[MAX_CHARTS], unsigned *map_device_to_plot,
+                                       struct window_position *process_position, struct window_position *setup_position,
+                                       bool process_win_hide) {
+  // Signed so that a terminal shorter than a device header leaves the heatmap a single row instead of wrapping
+  int heatmap_room = max((int)rows - (int)device_header_rows, 1);
+  unsigned heatmap_height = min(heatmap_rows, (unsigned)heatmap_room);
+  unsigned layout_rows = (unsigned)max((int)rows - (int)heatmap_height, 0);
+  unsigned map_selected_to_plot;
+  compute_sizes_from_layout(1, device_header_rows, device_header_cols, layout_rows, cols, &gpuOpts[selected],
+                            process_displayed, &device_positions[selected], num_plots, plot_positions,
+                            &map_selected_to_plot, process_position, setup_position, process_win_hide);
+  for (unsigned i = 0; i < devices_count; ++i)
+    map_device_to_plot[i] = i == selected && *num_plots ? map_selected_to_plot : UINT_MAX;
+  device_positions[selected].posY += heatmap_height;
+  for (unsigned i = 0; i < *num_plots; ++i)
+    plot_positions[i].posY += heatmap_height;
+  process_position->posY += heatmap_height;
+  setup_position->posY += heatmap_height;
+  *heatmap_position = (struct window_position){.posX = 0, .posY = 0, .sizeX = cols, .sizeY = heatmap_height};
+}
@@ -128,7 +128,22 @@ void alloc_interface_options_internals(char *config_location, unsigned num_devic
   options->has_monitored_set_changed = false;
   options->show_startup_messages = true;
   options->filter_nvtop_pid = true;
+  options->filter_local_processes = false;
   options->has_gpu_info_bar = false;
+  options->dense_device_view = false;
+  options->low_bandwidth_mode = false;
+  options->low_bandwidth_max_fps = 2;
+  options->low_bandwidth_frame_budget = 4096;
+  options->power_sampling_rate = 0;
+  // The slow changing fields are carried over between updates
+  for (unsigned field = 0; field < gpuinfo_dynamic_info_count; ++field)
+    options->dynamic_refresh_period[field] = 1;
+  options->dynamic_refresh_period[gpuinfo_gpu_clock_speed_max_valid] = 0;
+  options->dynamic_refresh_period[gpuinfo_mem_clock_speed_max_valid] = 0;
+  options->dynamic_refresh_period[gpuinfo_pcie_link_gen_valid] = 5;
+  options->dynamic_refresh_period[gpuinfo_pcie_link_width_valid] = 5;
+  options->dynamic_refresh_period[gpuinfo_power_draw_max_valid] = 30;
+  options->dynamic_refresh_period[gpuinfo_multi_instance_mode_valid] = 30;
   if (config_location) {
     options->config_file_location = malloc(strlen(config_location) + 1);
     if (!options->config_file_location) {
@@ -166,11 +181,15 @@ static const char general_section[] = "GeneralOption";
 static const char general_value_use_color[] = "UseColor";
 static const char general_value_update_interval[] = "UpdateInterval";
 static const char general_show_messages[] = "ShowInfoMessages";
+static const char general_low_bandwidth[] = "LowBandwidthMode";
+static const char general_low_bandwidth_max_fps[] = "LowBandwidthMaxFPS";
+static const char general_low_bandwidth_frame_budget[] = "LowBandwidthFrameBudget";
 
 static const char header_section[] = "HeaderOption";
 static const char header_value_use_fahrenheit[] = "UseFahrenheit";
 static const char header_value_encode_decode_timer[] = "EncodeHideTimer";
 static const char header_value_gpu_info_bar[] = "GPUInfoBar";
+static const char header_value_dense_view[] = "DenseDeviceView";
 
 static const char chart_section[] = "ChartOption";
 static const char chart_value_reverse[] = "ReverseChart";
@@ -178,10 +197,13 @@ static const char chart_value_reverse[] = "ReverseChart";
 static const char process_list_section[] = "ProcessListOption";
 static const char process_hide_nvtop_process_list[] = "HideNvtopProcessList";
 static const char process_hide_nvtop_process[] = "HideNvtopProcess";
+static const char process_only_remote_processes[] = "OnlyRemoteProcesses";
 static const char process_value_sortby[] = "SortBy";
 static const char process_value_display_field[] = "DisplayField";
 static const char *process_sortby_vals[process_field_count + 1] = {
-    "pId", "user", "gpuId", "type", "gpuRate", "encRate", "decRate", "memory", "cpuUsage", "cpuMem", "cmdline", "none"};
+    "pId",         "user",     "gpuId",  "type",     "gpuRate", "encRate",     "decRate", "renderRate",
+    "computeRate", "copyRate", "memory", "cpuUsage", "cpuMem",  "energy",      "cpuLocality", "cmdline",
+    "none"};
 static const char process_value_sort_order[] = "SortOrder";
 static const char process_sort_descending[] = "descending";
 static const char process_sort_ascending[] = "ascending";
@@ -191,8 +213,37 @@ static const char device_pdev[] = "Pdev";
 static const char device_monitor[] = "Monitor";
 static const char device_shown_value[] = "ShownInfo";
 static const char *device_draw_vals[plot_information_count + 1] = {
-    "gpuRate",       "gpuMemRate", "encodeRate",   "decodeRate",      "temperature",
-    "powerDrawRate", "fanSpeed",   "gpuClockRate", "gpuMemClockRate", "none"};
+    "gpuRate",           "gpuMemRate",     "encodeRate",   "decodeRate",      "temperature",
+    "powerDrawRate",     "fanSpeed",       "gpuClockRate", "gpuMemClockRate", "renderEngineRate",
+    "computeEngineRate", "copyEngineRate", "none"};
+
+static const char refresh_section[] = "RefreshSchedule";
+static const char refresh_always[] = "always";
+static const char refresh_once[] = "once";
+// The fields without a name are always refreshed
+static const char *refresh_field_vals[gpuinfo_dynamic_info_count] = {
+    [gpuinfo_gpu_clock_speed_valid] = "gpuClock",
+    [gpuinfo_gpu_clock_speed_max_valid] = "gpuClockMax",
+    [gpuinfo_mem_clock_speed_valid] = "memClock",
+    [gpuinfo_mem_clock_speed_max_valid] = "memClockMax",
+    [gpuinfo_gpu_util_rate_valid] = "gpuRate",
+    [gpuinfo_mem_util_rate_valid] = "memRate",
+    [gpuinfo_encoder_rate_valid] = "encodeRate",
+    [gpuinfo_decoder_rate_valid] = "decodeRate",
+    [gpuinfo_total_memory_valid] = "totalMemory",
+    [gpuinfo_free_memory_valid] = "freeMemory",
+    [gpuinfo_used_memory_valid] = "usedMemory",
+    [gpuinfo_pcie_link_gen_valid] = "pcieLinkGen",
+    [gpuinfo_pcie_link_width_valid] = "pcieLinkWidth",
+    [gpuinfo_pcie_rx_valid] = "pcieRx",
+    [gpuinfo_pcie_tx_valid] = "pcieTx",
+    [gpuinfo_fan_speed_valid] = "fanSpeed",
+    [gpuinfo_fan_rpm_valid] = "fanRPM",
+    [gpuinfo_gpu_temp_valid] = "temperature",
+    [gpuinfo_power_draw_valid] = "powerDraw",
+    [gpuinfo_power_draw_max_valid] = "powerDrawMax",
+    [gpuinfo_multi_instance_mode_valid] = "multiInstanceMode",
+};
 
 static int nvtop_option_ini_handler(void *user, const char *section, const char *name, const char *value) {
   struct nvtop_option_ini_data *ini_data = (struct nvtop_option_ini_data *)user;
@@ -219,6 +270,24 @@ static int nvtop_option_ini_handler(void *user, const char *section, const char
         ini_data->options->show_startup_messages = false;
       }
     }
+    if (strcmp(name, general_low_bandwidth) == 0) {
+      if (strcmp(value, "true") == 0) {
+        ini_data->options->low_bandwidth_mode = true;
+      }
+      if (strcmp(value, "false") == 0) {
+        ini_data->options->low_bandwidth_mode = false;
+      }
+    }
+    if (strcmp(name, general_low_bandwidth_max_fps) == 0) {
+      unsigned max_fps;
+      if (sscanf(value, "%u", &max_fps) == 1 && max_fps > 0)
+        ini_data->options->low_bandwidth_max_fps = max_fps;
+    }
+    if (strcmp(name, general_low_bandwidth_frame_budget) == 0) {
+      unsigned frame_budget;
+      if (sscanf(value, "%u", &frame_budget) == 1 && frame_budget > 0)
+        ini_data->options->low_bandwidth_frame_budget = frame_budget;
+    }
   }
   // Header Options
   if (strcmp(section, header_section) == 0) {
@@ -243,6 +312,14 @@ static int nvtop_option_ini_handler(void *user, const char *section, const char
         ini_data->options->has_gpu_info_bar = false;
       }
     }
+    if (strcmp(name, header_value_dense_view) == 0) {
+      if (strcmp(value, "true") == 0) {
+        ini_data->options->dense_device_view = true;
+      }
+      if (strcmp(value, "false") == 0) {
+        ini_data->options->dense_device_view = false;
+      }
+    }
   }
   // Chart Options
   if (strcmp(section, chart_section) == 0) {
@@ -273,6 +350,14 @@ static int nvtop_option_ini_handler(void *user, const char *section, const char
         ini_data->options->filter_nvtop_pid = false;
       }
     }
+    if (strcmp(name, process_only_remote_processes) == 0) {
+      if (strcmp(value, "true") == 0) {
+        ini_data->options->filter_local_processes = true;
+      }
+      if (strcmp(value, "false") == 0) {
+        ini_data->options->filter_local_processes = false;
+      }
+    }
     if (strcmp(name, process_value_sortby) == 0) {
       for (enum process_field i = process_pid; i < process_field_count; ++i) {
         if (strcmp(value, process_sortby_vals[i]) == 0) {
@@ -299,6 +384,23 @@ static int nvtop_option_ini_handler(void *user, const char *section, const char
       }
     }
   }
+  // Refresh Schedule
+  if (strcmp(section, refresh_section) == 0) {
+    for (unsigned field = 0; field < gpuinfo_dynamic_info_count; ++field) {
+      if (refresh_field_vals[field] && strcmp(name, refresh_field_vals[field]) == 0) {
+        unsigned period;
+        if (strcmp(value, refresh_always) == 0) {
+          ini_data->options->dynamic_refresh_period[field] = 1;
+        }
+        if (strcmp(value, refresh_once) == 0) {
+          ini_data->options->dynamic_refresh_period[field] = 0;
+        }
+        if (sscanf(value, "%u", &period) == 1 && period > 0) {
+          ini_data->options->dynamic_refresh_period[field] = period;
+        }
+      }
+    }
+  }
   // Per-Device Sections
   if (strcmp(section, device_section) == 0) {
     if (strcmp(name, device_pdev) == 0) {
@@ -394,12 +496,16 @@ bool save_interface_options_to_config_file(unsigned total_dev_count, const nvtop
   fprintf(config_file, "%s = %s\n", general_value_use_color, boolean_string(options->use_color));
   fprintf(config_file, "%s = %d\n", general_value_update_interval, options->update_interval);
   fprintf(config_file, "%s = %s\n", general_show_messages, boolean_string(options->show_startup_messages));
+  fprintf(config_file, "%s = %s\n", general_low_bandwidth, boolean_string(options->low_bandwidth_mode));
+  fprintf(config_file, "%s = %u\n", general_low_bandwidth_max_fps, options->low_bandwidth_max_fps);
+  fprintf(config_file, "%s = %u\n", general_low_bandwidth_frame_budget, options->low_bandwidth_frame_budget);
 
   // Header Options
   fprintf(config_file, "\n[%s]\n", header_section);
   fprintf(config_file, "%s = %s\n", header_value_use_fahrenheit, boolean_string(options->temperature_in_fahrenheit));
   fprintf(config_file, "%s = %e\n", header_value_encode_decode_timer, options->encode_decode_hiding_timer);
   fprintf(config_file, "%s = %s\n", header_value_gpu_info_bar, boolean_string(options->has_gpu_info_bar));
+  fprintf(config_file, "%s = %s\n", header_value_dense_view, boolean_string(options->dense_device_view));
 
   // Chart Options
   fprintf(config_file, "\n[%s]\n", chart_section);
@@ -409,6 +515,7 @@ bool save_interface_options_to_config_file(unsigned total_dev_count, const nvtop
   fprintf(config_file, "\n[%s]\n", process_list_section);
   fprintf(config_file, "%s = %s\n", process_hide_nvtop_process_list, boolean_string(options->hide_processes_list));
   fprintf(config_file, "%s = %s\n", process_hide_nvtop_process, boolean_string(options->filter_nvtop_pid));
+  fprintf(config_file, "%s = %s\n", process_only_remote_processes, boolean_string(options->filter_local_processes));
   fprintf(config_file, "%s = %s\n", process_value_sort_order,
           options->sort_descending_order ? process_sort_descending : process_sort_ascending);
   fprintf(config_file, "%s = %s\n", process_value_sortby, process_sortby_vals[options->sort_processes_by]);
@@ -422,6 +529,20 @@ bool save_interface_options_to_config_file(unsigned total_dev_count, const nvtop
   if (!display_any_field)
     fprintf(config_file, "%s = %s\n", process_value_display_field, process_sortby_vals[process_field_count]);
 
+  // Refresh Schedule
+  fprintf(config_file, "\n[%s]\n", refresh_section);
+  for (unsigned field = 0; field < gpuinfo_dynamic_info_count; ++field) {
+    if (!refresh_field_vals[field])
+      continue;
+    unsigned period = options->dynamic_refresh_period[field];
+    if (period == 0)
+      fprintf(config_file, "%s = %s\n", refresh_field_vals[field], refresh_once);
+    else if (period == 1)
+      fprintf(config_file, "%s = %s\n", refresh_field_vals[field], refresh_always);
+    else
+      fprintf(config_file, "%s = %u\n", refresh_field_vals[field], period);
+  }
+
   // Per-Device Sections
   for (unsigned i = 0; i < total_dev_count; ++i) {
     fprintf(config_file, "\n[%s]\n", device_section);
@@ -482,6 +603,16 @@ enum process_field process_default_sort_by_from(process_field_displayed fields_d
     return process_enc_rate;
   if (process_is_field_displayed(process_dec_rate, fields_displayed))
     return process_dec_rate;
+  if (process_is_field_displayed(process_render_rate, fields_displayed))
+    return process_render_rate;
+  if (process_is_field_displayed(process_compute_rate, fields_displayed))
+    return process_compute_rate;
+  if (process_is_field_displayed(process_copy_rate, fields_displayed))
+    return process_copy_rate;
+  if (process_is_field_displayed(process_energy, fields_displayed))
+    return process_energy;
+  if (process_is_field_displayed(process_locality, fields_displayed))
+    return process_locality;
   if (process_is_field_displayed(process_user, fields_displayed))
     return process_user;
   if (process_is_field_displayed(process_gpu_id, fields_displayed))
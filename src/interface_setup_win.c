@@ -23,7 +23,6 @@
 #include "nvtop/interface.h"
 #include "nvtop/interface_internal_common.h"
 #include "nvtop/interface_options.h"
-#include "nvtop/interface_ring_buffer.h"
 
 #include <ncurses.h>
 
@@ -57,12 +56,13 @@ enum setup_header_options {
   setup_header_toggle_fahrenheit,
   setup_header_enc_dec_timer,
   setup_header_gpu_info_bar,
+  setup_header_dense_view,
   setup_header_options_count
 };
 
 static const char *setup_header_option_descriptions[setup_header_options_count] = {
     "Temperature in fahrenheit", "Keep displaying Encoder/Decoder rate (after reaching an idle state)",
-    "Display extra GPU info bar"};
+    "Display extra GPU info bar", "Show the devices as a heatmap (always on above 64 devices)"};
 
 // Chart Options
 
@@ -77,15 +77,16 @@ static const char *setup_chart_options_descriptions[setup_chart_options_count] =
     "Reverse plot direction", "Displayed all GPUs", "Displayed GPU"};
 
 static const char *setup_chart_gpu_value_descriptions[plot_information_count] = {
-    "GPU utilization rate", "GPU memory utilization rate",   "GPU encoder rate", "GPU decoder rate",
-    "GPU temperature",      "Power draw rate (current/max)", "Fan speed",        "GPU clock rate",
-    "GPU memory clock rate"};
+    "GPU utilization rate",  "GPU memory utilization rate",   "GPU encoder rate",    "GPU decoder rate",
+    "GPU temperature",       "Power draw rate (current/max)", "Fan speed",           "GPU clock rate",
+    "GPU memory clock rate", "Render engine rate",            "Compute engine rate", "Copy engine rate"};
 
 // Process List Options
 
 enum setup_proc_list_options {
   setup_proc_list_hide_process_list,
   setup_proc_list_hide_nvtop_process,
+  setup_proc_list_only_remote_processes,
   setup_proc_list_sort_ascending,
   setup_proc_list_sort_by,
   setup_proc_list_display,
@@ -93,11 +94,14 @@ enum setup_proc_list_options {
 };
 
 static const char *setup_proc_list_option_description[setup_proc_list_options_count] = {
-    "Don't display the process list", "Hide nvtop in the process list", "Sort Ascending", "Sort by", "Field Displayed"};
+    "Don't display the process list", "Hide nvtop in the process list", "Only show the processes remote to their GPU",
+    "Sort Ascending", "Sort by", "Field Displayed"};
 
 static const char *setup_proc_list_value_descriptions[process_field_count] = {
-    "Process Id",    "User name",        "Device Id", "Workload type",    "GPU usage", "Encoder usage",
-    "Decoder usage", "GPU memory usage", "CPU usage", "CPU memory usage", "Command"};
+    "Process Id",       "User name",     "Device Id",           "Workload type",        "GPU usage",
+    "Encoder usage",    "Decoder usage", "Render engine usage", "Compute engine usage", "Copy engine usage",
+    "GPU memory usage", "CPU usage",     "CPU memory usage",    "Energy consumed",      "CPU locality",
+    "Command"};
 
 static unsigned int sizeof_setup_windows[setup_window_type_count] = {[setup_window_type_setup] = 11,
                                                                      [setup_window_type_single] = 0,
@@ -290,6 +294,15 @@ static void draw_setup_window_header(struct nvtop_interface *interface) {
       interface->setup_win.options_selected[0] == setup_header_gpu_info_bar) {
     mvwchgat(options_win, setup_header_gpu_info_bar + 1, 0, 3, A_STANDOUT, cyan_color, NULL);
   }
+
+  // Dense device heatmap
+  option_state = interface->options.dense_device_view;
+  mvwprintw(options_win, setup_header_dense_view + 1, 0, "[%c] %s", option_state_char(option_state),
+            setup_header_option_descriptions[setup_header_dense_view]);
+  if (interface->setup_win.indentation_level == 1 &&
+      interface->setup_win.options_selected[0] == setup_header_dense_view) {
+    mvwchgat(options_win, setup_header_dense_view + 1, 0, 3, A_STANDOUT, cyan_color, NULL);
+  }
   wnoutrefresh(options_win);
 }
 
@@ -475,6 +488,13 @@ static void draw_setup_window_proc_list(struct nvtop_interface *interface) {
       interface->setup_win.options_selected[0] == setup_proc_list_hide_nvtop_process) {
     mvwchgat(option_list_win, setup_proc_list_hide_nvtop_process + 1, 0, 3, A_STANDOUT, cyan_color, NULL);
   }
+  option_state = interface->options.filter_local_processes;
+  mvwprintw(option_list_win, setup_proc_list_only_remote_processes + 1, 0, "[%c] %s", option_state_char(option_state),
+            setup_proc_list_option_description[setup_proc_list_only_remote_processes]);
+  if (interface->setup_win.indentation_level == 1 &&
+      interface->setup_win.options_selected[0] == setup_proc_list_only_remote_processes) {
+    mvwchgat(option_list_win, setup_proc_list_only_remote_processes + 1, 0, 3, A_STANDOUT, cyan_color, NULL);
+  }
   option_state = !interface->options.sort_descending_order;
   mvwprintw(option_list_win, setup_proc_list_sort_ascending + 1, 0, "[%c] %s", option_state_char(option_state),
             setup_proc_list_option_description[setup_proc_list_sort_ascending]);
@@ -753,6 +773,9 @@ void handle_setup_win_keypress(int keyId, struct nvtop_interface *interface) {
           if (interface->setup_win.options_selected[0] == setup_header_gpu_info_bar) {
             interface->options.has_gpu_info_bar = !interface->options.has_gpu_info_bar;
           }
+          if (interface->setup_win.options_selected[0] == setup_header_dense_view) {
+            interface->options.dense_device_view = !interface->options.dense_device_view;
+          }
         }
       }
       // Chart Options
@@ -774,13 +797,11 @@ void handle_setup_win_keypress(int keyId, struct nvtop_interface *interface) {
               for (unsigned i = 0; i < interface->monitored_dev_count; ++i) {
                 interface->options.gpu_specific_opts[i].to_draw = plot_remove_draw_info(
                     interface->setup_win.options_selected[1], interface->options.gpu_specific_opts[i].to_draw);
-                interface_ring_buffer_empty(&interface->saved_data_ring, i);
               }
             } else {
               for (unsigned i = 0; i < interface->monitored_dev_count; ++i) {
                 interface->options.gpu_specific_opts[i].to_draw = plot_add_draw_info(
                     interface->setup_win.options_selected[1], interface->options.gpu_specific_opts[i].to_draw);
-                interface_ring_buffer_empty(&interface->saved_data_ring, i);
               }
             }
           }
@@ -793,7 +814,6 @@ void handle_setup_win_keypress(int keyId, struct nvtop_interface *interface) {
             else
               interface->options.gpu_specific_opts[selected_gpu].to_draw = plot_add_draw_info(
                   interface->setup_win.options_selected[1], interface->options.gpu_specific_opts[selected_gpu].to_draw);
-            interface_ring_buffer_empty(&interface->saved_data_ring, selected_gpu);
           }
         }
       }
@@ -804,6 +824,8 @@ void handle_setup_win_keypress(int keyId, struct nvtop_interface *interface) {
             interface->options.sort_descending_order = !interface->options.sort_descending_order;
           } else if (interface->setup_win.options_selected[0] == setup_proc_list_hide_nvtop_process) {
             interface->options.filter_nvtop_pid = !interface->options.filter_nvtop_pid;
+          } else if (interface->setup_win.options_selected[0] == setup_proc_list_only_remote_processes) {
+            interface->options.filter_local_processes = !interface->options.filter_local_processes;
           } else if (interface->setup_win.options_selected[0] == setup_proc_list_hide_process_list) {
             interface->options.hide_processes_list = !interface->options.hide_processes_list;
           } else if (interface->setup_win.options_selected[0] == setup_proc_list_sort_by) {
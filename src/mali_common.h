@@ -23,7 +23,8 @@
 #include "nvtop/extract_gpuinfo_common.h"
 #include "nvtop/extract_processinfo_fdinfo.h"
 #include "nvtop/time.h"
-#include <uthash.h>
+#include <stdlib.h>
+#include <string.h>
 #include <xf86drm.h>
 
 #define MAX_ERR_STRING_LEN 256
@@ -51,8 +52,6 @@ enum mali_version {
 	MALI_VERSIONS,
 };
 
-struct mali_process_info_cache;
-
 struct panfrost_driver_data {
   bool original_profiling_state;
   bool profiler_enabled;
@@ -68,10 +67,6 @@ struct gpu_info_mali {
   struct gpu_info base;
   int fd;
 
-   // Cached processes info
-  struct mali_process_info_cache *last_update_process_cache;
-  struct mali_process_info_cache *current_update_process_cache;
-
   union {
     struct panfrost_driver_data panfrost;
     struct panthor_driver_data panthor;
@@ -101,13 +96,6 @@ struct fdinfo_data {
   unsigned cid;
 };
 
-#define HASH_FIND_CLIENT(head, key_ptr, out_ptr) HASH_FIND(hh, head, key_ptr, sizeof(struct unique_cache_id), out_ptr)
-#define HASH_ADD_CLIENT(head, in_ptr) HASH_ADD(hh, head, client_id, sizeof(struct unique_cache_id), in_ptr)
-
-#define SET_MALI_CACHE(cachePtr, field, value) SET_VALUE(cachePtr, field, value, mali_cache_)
-#define RESET_PANFROST_CACHE(cachePtr, field) INVALIDATE_VALUE(cachePtr, field, mali_cache_)
-#define MALI_CACHE_FIELD_VALID(cachePtr, field) VALUE_IS_VALID(cachePtr, field, mali_cache_)
-
 uint64_t parse_memory_multiplier(const char *str);
 
 bool mali_init_drm_funcs(struct drmFuncTable *drmFuncs, struct mali_gpu_state *state);
@@ -131,7 +119,6 @@ void mali_common_get_running_processes(struct gpu_info *_gpu_info, enum mali_ver
 
 void mali_common_parse_fdinfo_handle_cache(struct gpu_info_mali *gpu_info,
 					   struct gpu_process *process_info,
-					   nvtop_time current_time,
 					   uint64_t total_cycles,
 					   unsigned cid,
 					   bool engine_count);
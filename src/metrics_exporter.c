@@ -0,0 +1,444 @@
+/*
+ *
+ * Copyright (C) 2025 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "nvtop/metrics_exporter.h"
+#include "nvtop/extract_gpuinfo.h"
+#include "nvtop/extract_gpuinfo_common.h"
+#include "nvtop/gpuinfo_energy.h"
+#include "nvtop/gpuinfo_protocol.h"
+#include "nvtop/time.h"
+#include "metrics_lines.h"
+
+#include <errno.h>
+#include <netdb.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
+
+// A datagram that is not full is sent at the latest this long after its first line
+#define EXPORTER_FLUSH_DELAY (UINT64_C(2) * UINT64_C(1000000000))
+#define EXPORTER_INFLUX_PORT "8089"
+#define EXPORTER_STATSD_PORT "8125"
+// For the fields that are always valid
+#define NO_VALID_BIT (-1)
+
+struct exporter_field {
+  const char *name;
+  int valid_bit;
+  unsigned offset;
+  unsigned size;
+};
+
+#define FIELD(type, label, name, valid)                                                                              \
+  {(label), (valid), offsetof(struct type, name), sizeof(((struct type *)0)->name)}
+#define DYNAMIC_FIELD(name) FIELD(gpuinfo_dynamic_info, #name, name, gpuinfo_##name##_valid)
+#define ENGINE_FIELD(label, engine)                                                                                    \
+  FIELD(gpuinfo_dynamic_info, label, engine_util_rate[engine], gpuinfo_engine_util_rate_valid + (engine))
+#define PROCESS_FIELD(name) FIELD(gpu_process, #name, name, gpuinfo_process_##name##_valid)
+
+static const struct exporter_field dynamic_fields[] = {
+    DYNAMIC_FIELD(gpu_clock_speed),
+    DYNAMIC_FIELD(gpu_clock_speed_max),
+    DYNAMIC_FIELD(mem_clock_speed),
+    DYNAMIC_FIELD(mem_clock_speed_max),
+    DYNAMIC_FIELD(gpu_util_rate),
+    DYNAMIC_FIELD(mem_util_rate),
+    DYNAMIC_FIELD(encoder_rate),
+    DYNAMIC_FIELD(decoder_rate),
+    DYNAMIC_FIELD(total_memory),
+    DYNAMIC_FIELD(free_memory),
+    DYNAMIC_FIELD(used_memory),
+    DYNAMIC_FIELD(pcie_link_gen),
+    DYNAMIC_FIELD(pcie_link_width),
+    DYNAMIC_FIELD(pcie_rx),
+    DYNAMIC_FIELD(pcie_tx),
+    DYNAMIC_FIELD(fan_speed),
+    DYNAMIC_FIELD(fan_rpm),
+    DYNAMIC_FIELD(gpu_temp),
+    DYNAMIC_FIELD(power_draw),
+    DYNAMIC_FIELD(power_draw_max),
+    DYNAMIC_FIELD(energy_consumed),
+    DYNAMIC_FIELD(power_draw_peak),
+    DYNAMIC_FIELD(power_draw_p99),
+    DYNAMIC_FIELD(throttle_reasons),
+    ENGINE_FIELD("render_util_rate", gpuinfo_engine_render),
+    ENGINE_FIELD("compute_util_rate", gpuinfo_engine_compute),
+    ENGINE_FIELD("copy_util_rate", gpuinfo_engine_copy),
+    ENGINE_FIELD("decode_util_rate", gpuinfo_engine_decode),
+    ENGINE_FIELD("encode_util_rate", gpuinfo_engine_encode),
+};
+
+static const struct exporter_field process_fields[] = {
+    PROCESS_FIELD(gpu_usage),
+    PROCESS_FIELD(encode_usage),
+    PROCESS_FIELD(decode_usage),
+    PROCESS_FIELD(gpu_memory_usage),
+    PROCESS_FIELD(gpu_memory_percentage),
+    PROCESS_FIELD(cpu_usage),
+    PROCESS_FIELD(cpu_memory_virt),
+    PROCESS_FIELD(cpu_memory_res),
+    PROCESS_FIELD(energy_consumed),
+    PROCESS_FIELD(cpu_locality),
+};
+
+// Final energy of the processes that exited
+static const struct exporter_field exit_fields[] = {
+    FIELD(gpuinfo_energy_exited_process, "energy_consumed", energy, NO_VALID_BIT),
+};
+
+static struct {
+  bool open;
+  enum exporter_format format;
+  int fd;
+  struct sockaddr_storage address;
+  socklen_t address_length;
+  char host[EXPORTER_MAX_TAG_LENGTH * 2 + 1]; // Host name, escaped for the format
+  struct exporter_queue queue;
+  uint64_t exported_exits; // Sequence of the last exit exported
+} exporter;
+
+static bool field_value(const void *structure, const unsigned char *valid, const struct exporter_field *field,
+                        uint64_t *value) {
+  if (field->valid_bit != NO_VALID_BIT && !IS_VALID(field->valid_bit, valid))
+    return false;
+  const char *ptr = (const char *)structure + field->offset;
+  switch (field->size) {
+  case sizeof(uint8_t):
+    *value = *(const uint8_t *)ptr;
+    return true;
+  case sizeof(uint16_t):
+    *value = *(const uint16_t *)ptr;
+    return true;
+  case sizeof(uint32_t):
+    *value = *(const uint32_t *)ptr;
+    return true;
+  case sizeof(uint64_t):
+    *value = *(const uint64_t *)ptr;
+    return true;
+  default:
+    return false;
+  }
+}
+
+static void export_statsd_gauges(const struct exporter_field *fields, unsigned fields_count, const void *structure,
+                                 const unsigned char *valid, unsigned device_index, const struct gpu_process *process) {
+  char line[EXPORTER_DATAGRAM_SIZE];
+  for (unsigned i = 0; i < fields_count; ++i) {
+    uint64_t value;
+    if (!field_value(structure, valid, &fields[i], &value))
+      continue;
+    struct line_writer writer = {line, line + sizeof(line), false};
+    put_string(&writer, "nvtop.");
+    put_string(&writer, exporter.host);
+    put_string(&writer, ".gpu");
+    put_uint(&writer, device_index);
+    if (process) {
+      put_string(&writer, ".pid");
+      put_uint(&writer, (uint64_t)process->pid);
+    }
+    put_char(&writer, '.');
+    put_string(&writer, fields[i].name);
+    put_char(&writer, ':');
+    put_uint(&writer, value);
+    put_string(&writer, "|g\n");
+    exporter_add_line(&exporter.queue, &writer, line);
+  }
+}
+
+// Completes the point whose measurement and tags are in line with every valid field
+static void export_influx_point(char *line, struct line_writer writer, const struct exporter_field *fields,
+                                unsigned fields_count, const void *structure, const unsigned char *valid,
+                                uint64_t timestamp) {
+  bool has_field = false;
+  for (unsigned i = 0; i < fields_count; ++i) {
+    uint64_t value;
+    if (!field_value(structure, valid, &fields[i], &value))
+      continue;
+    put_char(&writer, has_field ? ',' : ' ');
+    put_string(&writer, fields[i].name);
+    put_char(&writer, '=');
+    put_uint(&writer, value);
+    put_char(&writer, 'i');
+    has_field = true;
+  }
+  // A point without field is invalid
+  if (!has_field)
+    return;
+  put_char(&writer, ' ');
+  put_uint(&writer, timestamp);
+  put_char(&writer, '\n');
+  exporter_add_line(&exporter.queue, &writer, line);
+}
+
+static void put_influx_tags(struct line_writer *writer, const char *measurement, unsigned device_index,
+                            const struct gpu_info *device) {
+  put_string(writer, measurement);
+  put_string(writer, ",host=");
+  put_string(writer, exporter.host);
+  put_string(writer, ",gpu=");
+  put_uint(writer, device_index);
+  if (device && GPUINFO_STATIC_FIELD_VALID(&device->static_info, device_name) && device->static_info.device_name[0]) {
+    put_string(writer, ",name=");
+    put_tag(writer, exporter.format, device->static_info.device_name);
+  }
+}
+
+static uint64_t process_rank(const struct gpu_process *process) {
+  uint64_t usage = GPUINFO_PROCESS_FIELD_VALID(process, gpu_usage) ? process->gpu_usage : 0;
+  uint64_t memory = GPUINFO_PROCESS_FIELD_VALID(process, gpu_memory_usage) ? process->gpu_memory_usage : 0;
+  // The usage first, the memory (below 2^56 bytes) breaks the ties
+  return (usage << 56) | (memory & ((UINT64_C(1) << 56) - 1));
+}
+
+// Indices of the processes using the device the most, in decreasing order
+static unsigned select_top_processes(const struct gpu_info *device, unsigned top[METRICS_EXPORTER_TOP_PROCESSES]) {
+  uint64_t ranks[METRICS_EXPORTER_TOP_PROCESSES];
+  unsigned count = 0;
+  for (unsigned i = 0; i < device->processes_count; ++i) {
+    uint64_t rank = process_rank(&device->processes[i]);
+    if (count == METRICS_EXPORTER_TOP_PROCESSES && rank <= ranks[count - 1])
+      continue;
+    unsigned position = count < METRICS_EXPORTER_TOP_PROCESSES ? count++ : count - 1;
+    for (; position > 0 && ranks[position - 1] < rank; --position) {
+      ranks[position] = ranks[position - 1];
+      top[position] = top[position - 1];
+    }
+    ranks[position] = rank;
+    top[position] = i;
+  }
+  return count;
+}
+
+static void export_device(const struct gpu_info *device, unsigned device_index, uint64_t timestamp) {
+  unsigned top[METRICS_EXPORTER_TOP_PROCESSES];
+  unsigned top_count = select_top_processes(device, top);
+  if (exporter.format == exporter_statsd) {
+    export_statsd_gauges(dynamic_fields, ARRAY_SIZE(dynamic_fields), &device->dynamic_info, device->dynamic_info.valid,
+                         device_index, NULL);
+    for (unsigned i = 0; i < top_count; ++i) {
+      const struct gpu_process *process = &device->processes[top[i]];
+      export_statsd_gauges(process_fields, ARRAY_SIZE(process_fields), process, process->valid, device_index, process);
+    }
+    return;
+  }
+
+  char line[EXPORTER_DATAGRAM_SIZE];
+  struct line_writer writer = {line, line + sizeof(line), false};
+  put_influx_tags(&writer, "nvtop_gpu", device_index, device);
+  export_influx_point(line, writer, dynamic_fields, ARRAY_SIZE(dynamic_fields), &device->dynamic_info,
+                      device->dynamic_info.valid, timestamp);
+  for (unsigned i = 0; i < top_count; ++i) {
+    const struct gpu_process *process = &device->processes[top[i]];
+    writer = (struct line_writer){line, line + sizeof(line), false};
+    put_influx_tags(&writer, "nvtop_process", device_index, device);
+    put_string(&writer, ",pid=");
+    put_uint(&writer, (uint64_t)process->pid);
+    if (GPUINFO_PROCESS_FIELD_VALID(process, user_name) && process->user_name[0]) {
+      put_string(&writer, ",user=");
+      put_tag(&writer, exporter.format, process->user_name);
+    }
+    if (GPUINFO_PROCESS_FIELD_VALID(process, cmdline) && process->cmdline[0]) {
+      put_string(&writer, ",command=");
+      put_tag(&writer, exporter.format, process->cmdline);
+    }
+    export_influx_point(line, writer, process_fields, ARRAY_SIZE(process_fields), process, process->valid, timestamp);
+  }
+}
+
+// Each process that exited since the previous push is reported once, with its final energy
+static void export_exits(uint64_t timestamp) {
+  unsigned new_exits = 0;
+  while (new_exits < gpuinfo_energy_exited_count() &&
+         gpuinfo_energy_exited(new_exits)->sequence > exporter.exported_exits)
+    new_exits++;
+  if (!new_exits)
+    return;
+  exporter.exported_exits = gpuinfo_energy_exited(0)->sequence;
+
+  char line[EXPORTER_DATAGRAM_SIZE];
+  for (unsigned i = new_exits; i-- > 0;) {
+    const struct gpuinfo_energy_exited_process *exited = gpuinfo_energy_exited(i);
+    struct gpu_process process = {.pid = exited->pid};
+    if (exporter.format == exporter_statsd) {
+      export_statsd_gauges(exit_fields, ARRAY_SIZE(exit_fields), exited, NULL, exited->device, &process);
+      continue;
+    }
+    struct line_writer writer = {line, line + sizeof(line), false};
+    put_influx_tags(&writer, "nvtop_process_exit", exited->device, NULL);
+    put_string(&writer, ",pid=");
+    put_uint(&writer, (uint64_t)exited->pid);
+    if (exited->cmdline[0]) {
+      put_string(&writer, ",command=");
+      put_tag(&writer, exporter.format, exited->cmdline);
+    }
+    export_influx_point(line, writer, exit_fields, ARRAY_SIZE(exit_fields), exited, NULL, timestamp);
+  }
+}
+
+// Sends the complete datagrams, oldest first, until the relay stops accepting them
+static void exporter_send_queue(void) {
+  while (exporter.queue.count) {
+    const struct exporter_datagram *datagram = &exporter.queue.datagrams[exporter.queue.head];
+    ssize_t sent = sendto(exporter.fd, datagram->data, datagram->size, MSG_DONTWAIT | MSG_NOSIGNAL,
+                          (const struct sockaddr *)&exporter.address, exporter.address_length);
+    // Keep the datagram for the next sample while the relay is busy or not listening
+    if (sent < 0 && (errno == EAGAIN || errno == ENOBUFS || errno == EINTR || errno == ECONNREFUSED ||
+                     errno == ENOENT))
+      return;
+    if (sent < 0)
+      exporter.queue.dropped++;
+    exporter.queue.head = (exporter.queue.head + 1) % EXPORTER_QUEUE_LENGTH;
+    exporter.queue.count--;
+  }
+}
+
+void metrics_exporter_push(struct list_head *devices) {
+  if (!exporter.open)
+    return;
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  uint64_t timestamp = (uint64_t)now.tv_sec * UINT64_C(1000000000) + (uint64_t)now.tv_nsec;
+  const struct gpu_info *device;
+  unsigned device_index = 0;
+  list_for_each_entry(device, devices, list) {
+    export_device(device, device_index, timestamp);
+    device_index++;
+  }
+  export_exits(timestamp);
+
+  if (exporter_filling_datagram(&exporter.queue)->size) {
+    nvtop_time current;
+    nvtop_get_current_time(&current);
+    if (nvtop_difftime_u64(exporter.queue.filling_since, current) >= EXPORTER_FLUSH_DELAY)
+      exporter_seal_datagram(&exporter.queue);
+  }
+  exporter_send_queue();
+}
+
+static bool exporter_resolve(char *address, const char *default_port) {
+  if (address[0] == '/') {
+    struct sockaddr_un *unix_address = (struct sockaddr_un *)&exporter.address;
+    if (strlen(address) >= sizeof(unix_address->sun_path)) {
+      fprintf(stderr, "The socket path %s is too long\n", address);
+      return false;
+    }
+    unix_address->sun_family = AF_UNIX;
+    strcpy(unix_address->sun_path, address);
+    exporter.address_length = sizeof(*unix_address);
+    return true;
+  }
+  char *host, *port;
+  gpuinfo_protocol_split_address(address, &host, &port);
+  struct addrinfo hints = {.ai_socktype = SOCK_DGRAM};
+  struct addrinfo *results;
+  int status = getaddrinfo(host ? host : "localhost", port ? port : default_port, &hints, &results);
+  if (status) {
+    fprintf(stderr, "Cannot resolve the metrics relay %s: %s\n", host ? host : "localhost", gai_strerror(status));
+    return false;
+  }
+  memcpy(&exporter.address, results->ai_addr, results->ai_addrlen);
+  exporter.address_length = results->ai_addrlen;
+  freeaddrinfo(results);
+  return true;
+}
+
+bool metrics_exporter_open(const char *destination) {
+  static const struct {
+    const char *prefix;
+    enum exporter_format format;
+    const char *default_port;
+  } formats[] = {
+      {"influx:", exporter_influx, EXPORTER_INFLUX_PORT},
+      {"statsd:", exporter_statsd, EXPORTER_STATSD_PORT},
+  };
+  exporter.format = exporter_influx;
+  const char *default_port = EXPORTER_INFLUX_PORT;
+  for (unsigned i = 0; i < ARRAY_SIZE(formats); ++i) {
+    size_t length = strlen(formats[i].prefix);
+    if (!strncmp(destination, formats[i].prefix, length)) {
+      exporter.format = formats[i].format;
+      default_port = formats[i].default_port;
+      destination += length;
+      break;
+    }
+  }
+
+  char *address = strdup(destination);
+  if (!address) {
+    perror("Cannot allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+  memset(&exporter.address, 0, sizeof(exporter.address));
+  bool resolved = exporter_resolve(address, default_port);
+  free(address);
+  if (!resolved)
+    return false;
+  exporter.fd = socket(exporter.address.ss_family, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+  if (exporter.fd < 0) {
+    perror("Cannot create the metrics exporter socket: ");
+    return false;
+  }
+
+  char host[256];
+  if (gethostname(host, sizeof(host)) != 0)
+    strcpy(host, "localhost");
+  host[sizeof(host) - 1] = '\0';
+  struct line_writer writer = {exporter.host, exporter.host + sizeof(exporter.host) - 1, false};
+  put_tag(&writer, exporter.format, host);
+  *writer.pos = '\0';
+
+  exporter.queue.datagrams = calloc(EXPORTER_QUEUE_LENGTH, sizeof(*exporter.queue.datagrams));
+  if (!exporter.queue.datagrams) {
+    perror("Cannot allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+  exporter.queue.head = 0;
+  exporter.queue.count = 0;
+  exporter.queue.dropped = 0;
+  exporter.exported_exits = 0;
+  exporter.open = true;
+  // Every metric is exported, whatever the interface shows
+  gpuinfo_add_consumer_needs(GPUINFO_SUBSCRIPTION_ALL);
+  return true;
+}
+
+void metrics_exporter_close(void) {
+  if (!exporter.open)
+    return;
+  if (exporter_filling_datagram(&exporter.queue)->size)
+    exporter_seal_datagram(&exporter.queue);
+  exporter_send_queue();
+  exporter.queue.dropped += exporter.queue.count;
+  if (exporter.queue.dropped)
+    fprintf(stderr, "The metrics relay missed %llu datagrams\n", exporter.queue.dropped);
+  close(exporter.fd);
+  free(exporter.queue.datagrams);
+  exporter.queue.datagrams = NULL;
+  exporter.open = false;
+}
@@ -0,0 +1,100 @@
+/*
+ *
+ * Copyright (C) 2025 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "metrics_lines.h"
+
+#include <string.h>
+
+void put_char(struct line_writer *writer, char c) {
+  if (writer->pos == writer->end) {
+    writer->overflow = true;
+    return;
+  }
+  *writer->pos++ = c;
+}
+
+void put_string(struct line_writer *writer, const char *str) {
+  size_t length = strlen(str);
+  if ((size_t)(writer->end - writer->pos) < length) {
+    writer->overflow = true;
+    return;
+  }
+  memcpy(writer->pos, str, length);
+  writer->pos += length;
+}
+
+void put_uint(struct line_writer *writer, uint64_t value) {
+  char digits[20];
+  unsigned count = 0;
+  do {
+    digits[count++] = '0' + value % 10;
+    value /= 10;
+  } while (value);
+  if ((size_t)(writer->end - writer->pos) < count) {
+    writer->overflow = true;
+    return;
+  }
+  while (count)
+    *writer->pos++ = digits[--count];
+}
+
+void put_tag(struct line_writer *writer, enum exporter_format format, const char *str) {
+  for (unsigned i = 0; str[i] && i < EXPORTER_MAX_TAG_LENGTH; ++i) {
+    char c = str[i];
+    if (format == exporter_influx) {
+      if (c == ',' || c == '=' || c == ' ' || c == '\\')
+        put_char(writer, '\\');
+      put_char(writer, c == '\n' || c == '\r' || c == '\t' ? '_' : c);
+    } else {
+      bool safe = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '-';
+      put_char(writer, safe ? c : '_');
+    }
+  }
+}
+
+void exporter_seal_datagram(struct exporter_queue *queue) {
+  if (queue->count == EXPORTER_QUEUE_LENGTH - 1) {
+    queue->head = (queue->head + 1) % EXPORTER_QUEUE_LENGTH;
+    queue->count--;
+    queue->dropped++;
+  }
+  queue->count++;
+  queue->datagrams[(queue->head + queue->count) % EXPORTER_QUEUE_LENGTH].size = 0;
+}
+
+struct exporter_datagram *exporter_filling_datagram(struct exporter_queue *queue) {
+  return &queue->datagrams[(queue->head + queue->count) % EXPORTER_QUEUE_LENGTH];
+}
+
+void exporter_add_line(struct exporter_queue *queue, const struct line_writer *writer, const char *line) {
+  if (writer->overflow)
+    return;
+  unsigned size = writer->pos - line;
+  struct exporter_datagram *datagram = exporter_filling_datagram(queue);
+  if (datagram->size + size > EXPORTER_DATAGRAM_SIZE) {
+    exporter_seal_datagram(queue);
+    datagram = exporter_filling_datagram(queue);
+  }
+  if (!datagram->size)
+    nvtop_get_current_time(&queue->filling_since);
+  memcpy(datagram->data + datagram->size, line, size);
+  datagram->size += size;
+}
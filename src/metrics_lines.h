@@ -0,0 +1,79 @@
+/*
+ *
+ * Copyright (C) 2025 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef METRICS_LINES_H_
+#define METRICS_LINES_H_
+
+#include "nvtop/time.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Fits in an Ethernet frame over IPv4 and IPv6, for the relays that are not local
+#define EXPORTER_DATAGRAM_SIZE 1432
+// Datagrams waiting for the relay, about 90KiB
+#define EXPORTER_QUEUE_LENGTH 64
+// The tags longer than this (device names, command lines) are truncated
+#define EXPORTER_MAX_TAG_LENGTH 64
+
+enum exporter_format {
+  exporter_influx,
+  exporter_statsd,
+};
+
+// Formats a line in a fixed buffer; the line is discarded when it does not fit
+struct line_writer {
+  char *pos;
+  char *end;
+  bool overflow;
+};
+
+void put_char(struct line_writer *writer, char c);
+void put_string(struct line_writer *writer, const char *str);
+void put_uint(struct line_writer *writer, uint64_t value);
+// InfluxDB tag values escape the separators, StatsD names only keep the characters that are safe for every relay
+void put_tag(struct line_writer *writer, enum exporter_format format, const char *str);
+
+struct exporter_datagram {
+  unsigned size;
+  char data[EXPORTER_DATAGRAM_SIZE];
+};
+
+// A ring of EXPORTER_QUEUE_LENGTH datagrams allocated once: the ones waiting to be sent, from the oldest at head,
+// followed by the one being filled.
+struct exporter_queue {
+  struct exporter_datagram *datagrams;
+  unsigned head;
+  unsigned count;
+  nvtop_time filling_since; // Time of the first line of the datagram being filled
+  unsigned long long dropped;
+};
+
+// Queues the datagram being filled, dropping the oldest one when the queue is full
+void exporter_seal_datagram(struct exporter_queue *queue);
+
+struct exporter_datagram *exporter_filling_datagram(struct exporter_queue *queue);
+
+// Appends the line written from line to the datagram being filled, sealed first if the line does not fit in it.
+// Nothing is added when the line overflowed its buffer.
+void exporter_add_line(struct exporter_queue *queue, const struct line_writer *writer, const char *line);
+
+#endif // METRICS_LINES_H_
@@ -5,11 +5,20 @@
  * License: GPLv3
  */
 
+#include "nvtop/daemon.h"
 #include "nvtop/extract_gpuinfo.h"
+#include "nvtop/extract_gpuinfo_remote.h"
+#include "nvtop/extract_gpuinfo_shm.h"
+#include "nvtop/gpuinfo_energy.h"
+#include "nvtop/gpuinfo_protocol.h"
+#include "nvtop/gpuinfo_stats.h"
 #include "nvtop/info_messages.h"
 #include "nvtop/interface.h"
 #include "nvtop/interface_common.h"
 #include "nvtop/interface_options.h"
+#include "nvtop/metrics_exporter.h"
+#include "nvtop/power_sampler.h"
+#include "nvtop/snapshot.h"
 #include "nvtop/time.h"
 #include "nvtop/version.h"
 
@@ -20,12 +29,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <unistd.h>      // Added for sleep
+#include <sys/un.h>
+#include <unistd.h>
 #include <locale.h>
 
-// Added for manual GPU field validation
-#include "nvtop/extract_gpuinfo_common.h"
-
 static volatile sig_atomic_t signal_exit = 0;
 static volatile sig_atomic_t signal_resize_win = 0;
 static volatile sig_atomic_t signal_cont_received = 0;
@@ -45,6 +52,11 @@ static void cont_handler(int signum) {
   signal_cont_received = 1;
 }
 
+static void stats_dump_handler(int signum) {
+  (void)signum;
+  gpuinfo_stats_request_dump();
+}
+
 static const char helpstring[] = "Available options:\n"
 "  -d --delay        : Select the refresh rate (1 == 0.1s)\n"
 "  -v --version      : Print the version and exit\n"
@@ -62,10 +74,42 @@ static const char helpstring[] = "Available options:\n"
 "(default 30s, negative = always on screen)\n"
 "  -h --help         : Print help and exit\n"
 "  -s --snapshot     : Output the current gpu stats without ncurses"
-"(useful for scripting)\n";
+"(useful for scripting)\n"
+"     --snapshot-duration : Seconds sampled by the snapshot (default 1)\n"
+"     --snapshot-interval : Seconds between the samples of the snapshot "
+"(default 0.1)\n"
+"  -b --low-bandwidth: Limit the frame rate and the output size of each frame "
+"for slow links\n"
+#ifdef HAS_LINUX_SERVICES
+"  -S --shared       : Share the collected data with the other nvtop instances "
+"of the user\n"
+"  -D --daemon       : Sample the devices for the nvtop clients, in the foreground "
+"(start it from systemd or with &)\n"
+"  -u --socket       : Socket of the daemon to serve or to connect to\n"
+"  -l --listen       : Also serve the clients on this TCP [address:]port, of "
+"this host only without address and of any host with *:port (daemon only)\n"
+"  -H --hosts        : Follow the daemons of these comma separated hosts, or of "
+"the hosts listed in the file after @\n"
+"  -x --export       : Push the samples in InfluxDB line protocol (statsd: prefix "
+"for StatsD) to this UDP host[:port] or Unix datagram socket\n"
+#endif
+"  -j --stats-json   : Write the statistics of the metrics as JSON to this file "
+"on exit and on SIGUSR1 (- for stdout on exit)\n"
+#ifdef HAS_LINUX_SERVICES
+"     --power-sampling : Sample the power this many times per second (50 to 200) "
+"in the background and show its peak and 99th percentile\n"
+#endif
+;
 
 static const char versionString[] = "nvtop version " NVTOP_VERSION_STRING;
 
+// Options without a short name
+enum {
+  snapshot_duration_opt = 256,
+  snapshot_interval_opt,
+  power_sampling_opt,
+};
+
 static const struct option long_opts[] = {
   {.name = "delay", .has_arg = required_argument, .flag = NULL, .val = 'd'},
   {.name = "version", .has_arg = no_argument, .flag = NULL, .val = 'v'},
@@ -80,10 +124,27 @@ static const struct option long_opts[] = {
   {.name = "no-processes", .has_arg = no_argument, .flag = NULL, .val = 'P'},
   {.name = "reverse-abs", .has_arg = no_argument, .flag = NULL, .val = 'r'},
   {.name = "snapshot", .has_arg = no_argument, .flag = NULL, .val = 's'},
+  {.name = "snapshot-duration", .has_arg = required_argument, .flag = NULL, .val = snapshot_duration_opt},
+  {.name = "snapshot-interval", .has_arg = required_argument, .flag = NULL, .val = snapshot_interval_opt},
+  {.name = "low-bandwidth", .has_arg = no_argument, .flag = NULL, .val = 'b'},
+#ifdef HAS_LINUX_SERVICES
+  {.name = "shared", .has_arg = no_argument, .flag = NULL, .val = 'S'},
+  {.name = "daemon", .has_arg = no_argument, .flag = NULL, .val = 'D'},
+  {.name = "socket", .has_arg = required_argument, .flag = NULL, .val = 'u'},
+  {.name = "listen", .has_arg = required_argument, .flag = NULL, .val = 'l'},
+  {.name = "hosts", .has_arg = required_argument, .flag = NULL, .val = 'H'},
+  {.name = "export", .has_arg = required_argument, .flag = NULL, .val = 'x'},
+  {.name = "power-sampling", .has_arg = required_argument, .flag = NULL, .val = power_sampling_opt},
+#endif
+  {.name = "stats-json", .has_arg = required_argument, .flag = NULL, .val = 'j'},
   {0, 0, 0, 0},
 };
 
-static const char opts[] = "hvd:c:CfE:pPris";
+static const char opts[] = "hvd:c:CfE:pPrisbj:"
+#ifdef HAS_LINUX_SERVICES
+                           "SDu:l:H:x:"
+#endif
+    ;
 
 int main(int argc, char **argv) {
   (void)setlocale(LC_CTYPE, "");
@@ -99,6 +160,19 @@ int main(int argc, char **argv) {
   bool encode_decode_timer_option_set = false;
   bool show_gpu_info_bar = false;
   bool show_snapshot = false;
+  double snapshot_duration = NVTOP_SNAPSHOT_DEFAULT_DURATION;
+  double snapshot_interval = NVTOP_SNAPSHOT_DEFAULT_INTERVAL;
+  bool low_bandwidth_option = false;
+  bool shared_option = false;
+  bool daemon_option = false;
+  const char *socket_path_option = NULL;
+#ifdef HAS_LINUX_SERVICES
+  const char *listen_address_option = NULL;
+#endif
+  const char *hosts_option = NULL;
+  const char *export_option = NULL;
+  const char *stats_json_option = NULL;
+  unsigned power_sampling_option = 0;
   double encode_decode_hide_time = -1.;
   char *custom_config_file_path = NULL;
   while (true) {
@@ -162,6 +236,57 @@ int main(int argc, char **argv) {
       case 's':
         show_snapshot = true;
         break;
+      case snapshot_duration_opt:
+      case snapshot_interval_opt: {
+        char *endptr = NULL;
+        double seconds = strtod(optarg, &endptr);
+        if (endptr == optarg || *endptr != '\0' || !(seconds > 0.) || seconds > 86400.) {
+          fprintf(stderr, "Error: The snapshot %s must be a positive number of seconds\n",
+                  optchar == snapshot_duration_opt ? "duration" : "interval");
+          exit(EXIT_FAILURE);
+        }
+        if (optchar == snapshot_duration_opt)
+          snapshot_duration = seconds;
+        else
+          snapshot_interval = seconds;
+        show_snapshot = true;
+      } break;
+      case 'b':
+        low_bandwidth_option = true;
+        break;
+#ifdef HAS_LINUX_SERVICES
+      case 'S':
+        shared_option = true;
+        break;
+      case 'D':
+        daemon_option = true;
+        break;
+      case 'u':
+        socket_path_option = optarg;
+        break;
+      case 'l':
+        listen_address_option = optarg;
+        break;
+      case 'H':
+        hosts_option = optarg;
+        break;
+      case 'x':
+        export_option = optarg;
+        break;
+      case power_sampling_opt: {
+        char *endptr = NULL;
+        long rate = strtol(optarg, &endptr, 10);
+        if (endptr == optarg || *endptr != '\0' || rate < POWER_SAMPLER_MIN_RATE || rate > POWER_SAMPLER_MAX_RATE) {
+          fprintf(stderr, "Error: The power sampling rate must be between %u and %u samples per second\n",
+                  POWER_SAMPLER_MIN_RATE, POWER_SAMPLER_MAX_RATE);
+          exit(EXIT_FAILURE);
+        }
+        power_sampling_option = rate;
+      } break;
+#endif // HAS_LINUX_SERVICES
+      case 'j':
+        stats_json_option = optarg;
+        break;
       case ':':
       case '?':
         switch (optopt) {
@@ -203,13 +328,48 @@ int main(int argc, char **argv) {
     perror("Impossible to set signal handler for SIGCONT: ");
     exit(EXIT_FAILURE);
   }
+  if (stats_json_option) {
+    gpuinfo_stats_set_dump_path(stats_json_option);
+    siga.sa_handler = stats_dump_handler;
+    if (strcmp(stats_json_option, "-") != 0 && sigaction(SIGUSR1, &siga, NULL) != 0) {
+      perror("Impossible to set signal handler for SIGUSR1: ");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  if (export_option && !show_snapshot && !metrics_exporter_open(export_option))
+    return EXIT_FAILURE;
 
   unsigned allDevCount = 0;
   LIST_HEAD(monitoredGpus);
   LIST_HEAD(nonMonitoredGpus);
-  if (!gpuinfo_init_info_extraction(&allDevCount, &monitoredGpus))
+  LIST_HEAD(joinedGpus); // Devices of the hosts that answered late, until the interface takes them
+  // A running daemon already initialized the backends and sampled the devices
+  bool remote_data = false;
+  if (hosts_option && !daemon_option) {
+    remote_data = gpuinfo_remote_attach_hosts(hosts_option, &allDevCount, &monitoredGpus);
+    if (!remote_data) {
+      fprintf(stderr, "No nvtop daemon answered on %s\n", hosts_option);
+      return EXIT_FAILURE;
+    }
+  } else if (!daemon_option && !show_snapshot) {
+    remote_data = gpuinfo_remote_attach(socket_path_option, &allDevCount, &monitoredGpus);
+    if (!remote_data && socket_path_option) {
+      fprintf(stderr, "No nvtop daemon answered on %s\n", socket_path_option);
+      return EXIT_FAILURE;
+    }
+  }
+  // The shared data is read from another instance, or collected by this one for the others
+  bool shared_data = !remote_data && !daemon_option && shared_option && !show_snapshot &&
+                     gpuinfo_shm_attach(&allDevCount, &monitoredGpus);
+  if (!remote_data && !shared_data && !gpuinfo_init_info_extraction(&allDevCount, &monitoredGpus))
     return EXIT_FAILURE;
   if (allDevCount == 0) {
+    if (remote_data)
+      gpuinfo_remote_detach();
+    if (shared_data)
+      gpuinfo_shm_detach();
+    metrics_exporter_close();
     fprintf(stdout, "No GPU to monitor.\n");
     return EXIT_SUCCESS;
   }
@@ -255,8 +415,51 @@ int main(int argc, char **argv) {
   if (update_interval_option_set)
     allDevicesOptions.update_interval = update_interval_option;
   allDevicesOptions.has_gpu_info_bar = allDevicesOptions.has_gpu_info_bar || show_gpu_info_bar;
+  allDevicesOptions.low_bandwidth_mode = allDevicesOptions.low_bandwidth_mode || low_bandwidth_option;
+  allDevicesOptions.power_sampling_rate = power_sampling_option;
+
+  for (unsigned field = 0; field < gpuinfo_dynamic_info_count; ++field)
+    gpuinfo_set_dynamic_refresh_period(field, allDevicesOptions.dynamic_refresh_period[field]);
 
   gpuinfo_populate_static_infos(&monitoredGpus);
+  // The devices followed through a daemon or another instance are sampled there
+  if (power_sampling_option && !remote_data && !shared_data &&
+      !power_sampler_start(&monitoredGpus, power_sampling_option))
+    fprintf(stderr, "The power of the devices cannot be sampled in the background\n");
+
+#ifdef HAS_LINUX_SERVICES
+  if (daemon_option) {
+    char user_socket_path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+    const char *socket_path = socket_path_option;
+    if (!socket_path && getuid() == 0) {
+      socket_path = GPUINFO_PROTOCOL_SYSTEM_SOCKET;
+    } else if (!socket_path) {
+      if (!gpuinfo_protocol_user_socket_path(user_socket_path, sizeof(user_socket_path))) {
+        fprintf(stderr, "XDG_RUNTIME_DIR is not set, provide the socket path with --socket\n");
+        gpuinfo_shutdown_info_extraction(&monitoredGpus);
+        return EXIT_FAILURE;
+      }
+      socket_path = user_socket_path;
+    }
+    siga.sa_handler = exit_handler;
+    if (sigaction(SIGTERM, &siga, NULL) != 0) {
+      perror("Impossible to set signal handler for SIGTERM: ");
+      exit(EXIT_FAILURE);
+    }
+    int status = nvtop_daemon_run(&monitoredGpus, socket_path, listen_address_option,
+                                  allDevicesOptions.update_interval, &signal_exit);
+    metrics_exporter_close();
+    if (stats_json_option && !gpuinfo_stats_write_json(stats_json_option))
+      fprintf(stderr, "Cannot write the statistics to %s\n", stats_json_option);
+    gpuinfo_stats_clear();
+    gpuinfo_energy_clear();
+    gpuinfo_shutdown_info_extraction(&monitoredGpus);
+    free(allDevicesOptions.gpu_specific_opts);
+    free(allDevicesOptions.config_file_location);
+    return status;
+  }
+#endif // HAS_LINUX_SERVICES
+
   unsigned numMonitoredGpus =
   interface_check_and_fix_monitored_gpus(allDevCount, &monitoredGpus, &nonMonitoredGpus, &allDevicesOptions);
 
@@ -268,110 +471,21 @@ int main(int argc, char **argv) {
     }
   }
 
-  // ====================================================================================
-  // CUSTOM FIX: Manual JSON Snapshot Printer
-  // ====================================================================================
   if (show_snapshot) {
-    // 1. Warm-up Pass
-    gpuinfo_refresh_dynamic_info(&monitoredGpus);
-    gpuinfo_refresh_processes(&monitoredGpus);
-    usleep(250000);
-
-    // 2. Start Pass
-    gpuinfo_refresh_dynamic_info(&monitoredGpus);
-    gpuinfo_refresh_processes(&monitoredGpus);
-
-    // 3. Work Interval (1 Second)
-    usleep(1000000);
-
-    // 4. Finish Pass
-    gpuinfo_refresh_dynamic_info(&monitoredGpus);
-    gpuinfo_refresh_processes(&monitoredGpus);
-
-    // 5. Calculate Rates (Standard)
-    gpuinfo_utilisation_rate(&monitoredGpus);
-
-    // 6. MANUAL JSON OUTPUT
-    printf("[\n");
-
-    struct list_head *ptr;
-    int is_first = 1;
-    list_for_each(ptr, &monitoredGpus) {
-      struct gpu_info *device = list_entry(ptr, struct gpu_info, list);
-
-      if (!is_first) printf(",\n");
-      is_first = 0;
-
-      // --- Calculate True Usage (Summing Processes) ---
-      unsigned total_usage = 0;
-      for (unsigned i = 0; i < device->processes_count; ++i) {
-        if (GPUINFO_PROCESS_FIELD_VALID(&device->processes[i], gpu_usage)) {
-          total_usage += device->processes[i].gpu_usage;
-        }
-      }
-      if (total_usage > 100) total_usage = 100;
-
-      // --- Print JSON ---
-      printf("  {\n");
-      printf("   \"device_name\": \"%s\",\n", device->static_info.device_name);
-
-      // Clock
-      if (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, gpu_clock_speed))
-        printf("   \"gpu_clock\": \"%uMHz\",\n", device->dynamic_info.gpu_clock_speed);
-      else
-        printf("   \"gpu_clock\": null,\n");
-
-      // Temp
-      if (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, gpu_temp))
-        printf("   \"temp\": \"%uC\",\n", device->dynamic_info.gpu_temp);
-      else
-        printf("   \"temp\": null,\n");
-
-      // Fan
-      if (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, fan_rpm))
-        printf("   \"fan_speed\": \"%uRPM\",\n", device->dynamic_info.fan_rpm);
-      else
-        printf("   \"fan_speed\": null,\n");
-
-      // Power
-      if (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, power_draw))
-        // CHANGE THIS LINE BELOW: Add " / 1000"
-        printf("   \"power_draw\": \"%uW\",\n", device->dynamic_info.power_draw / 1000);
-      else
-        printf("   \"power_draw\": null,\n");
-
-      // GPU Util (THE FIXED VALUE)
-      printf("   \"gpu_util\": \"%u%%\",\n", total_usage);
-
-      // Mem Util
-      if (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, mem_util_rate))
-        printf("   \"mem_util\": \"%u%%\",\n", device->dynamic_info.mem_util_rate);
-      else
-        printf("   \"mem_util\": null,\n");
-
-      // Memory Details
-      if (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, total_memory)) {
-        printf("   \"mem_total\": \"%lu\",\n", device->dynamic_info.total_memory);
-        printf("   \"mem_used\": \"%lu\",\n", device->dynamic_info.used_memory);
-        printf("   \"mem_free\": \"%lu\"\n", device->dynamic_info.free_memory);
-      } else {
-        printf("   \"mem_total\": null\n");
-      }
-
-      printf("  }");
-    }
-    printf("\n]\n");
-
+    int status = nvtop_snapshot_run(&monitoredGpus, snapshot_duration, snapshot_interval, stdout, &signal_exit);
+    gpuinfo_energy_clear();
     gpuinfo_shutdown_info_extraction(&monitoredGpus);
-    return EXIT_SUCCESS;
+    free(allDevicesOptions.gpu_specific_opts);
+    free(allDevicesOptions.config_file_location);
+    return status;
   }
-  // ====================================================================================
 
   struct nvtop_interface *interface =
   initialize_curses(allDevCount, numMonitoredGpus, interface_largest_gpu_name(&monitoredGpus), allDevicesOptions);
   timeout(interface_update_interval(interface));
 
   double time_slept = interface_update_interval(interface);
+  int next_sleep;
   while (!signal_exit) {
     if (signal_resize_win) {
       signal_resize_win = 0;
@@ -382,21 +496,39 @@ int main(int argc, char **argv) {
       update_window_size_to_terminal_size(interface);
     }
     interface_check_monitored_gpu_change(&interface, allDevCount, &numMonitoredGpus, &monitoredGpus, &nonMonitoredGpus);
+    if (remote_data)
+      gpuinfo_remote_join_hosts(&joinedGpus);
+    interface_add_joined_gpus(&interface, &allDevCount, &numMonitoredGpus, &monitoredGpus, &nonMonitoredGpus,
+                              &joinedGpus);
     if (time_slept >= interface_update_interval(interface)) {
-      gpuinfo_refresh_dynamic_info(&monitoredGpus);
-      if (!interface_freeze_processes(interface)) {
-        gpuinfo_refresh_processes(&monitoredGpus);
-        gpuinfo_utilisation_rate(&monitoredGpus);
-        gpuinfo_fix_dynamic_info_from_process_info(&monitoredGpus);
+      if (remote_data) {
+        gpuinfo_remote_refresh(&monitoredGpus, !interface_freeze_processes(interface));
+      } else if (shared_data) {
+        gpuinfo_shm_refresh(&monitoredGpus, !interface_freeze_processes(interface));
+      } else {
+        interface_update_subscriptions(interface, &monitoredGpus);
+        gpuinfo_refresh_dynamic_info(&monitoredGpus);
+        if (!interface_freeze_processes(interface)) {
+          gpuinfo_refresh_processes(&monitoredGpus);
+          gpuinfo_utilisation_rate(&monitoredGpus);
+          gpuinfo_fix_dynamic_info_from_process_info(&monitoredGpus);
+        }
+        gpuinfo_energy_account(&monitoredGpus, !interface_freeze_processes(interface));
       }
       save_current_data_to_ring(&monitoredGpus, interface);
-      timeout(interface_update_interval(interface));
+      gpuinfo_stats_record(&monitoredGpus, !interface_freeze_processes(interface));
+      metrics_exporter_push(&monitoredGpus);
+      next_sleep = interface_update_interval(interface);
       time_slept = 0.;
     } else {
-      int next_sleep = interface_update_interval(interface) - (int)time_slept;
-      timeout(next_sleep);
+      next_sleep = interface_update_interval(interface) - (int)time_slept;
     }
     draw_gpu_info_ncurses(numMonitoredGpus, &monitoredGpus, interface);
+    // Wake up in time for the frame held back by the low bandwidth mode
+    int frame_delay = interface_frame_delay(interface);
+    if (frame_delay >= 0 && frame_delay < next_sleep)
+      next_sleep = frame_delay;
+    timeout(next_sleep);
 
     nvtop_time time_before_sleep, time_after_sleep;
     nvtop_get_current_time(&time_before_sleep);
@@ -429,9 +561,15 @@ int main(int argc, char **argv) {
       case KEY_F(5):
       case KEY_F(9):
       case KEY_F(6):
+      case KEY_F(7):
       case KEY_F(12):
       case '+':
       case '-':
+      case '<':
+      case '>':
+      case 'd':
+      case '[':
+      case ']':
       case 12: // Ctrl+L
         interface_key(input_char, interface);
         break;
@@ -454,7 +592,17 @@ int main(int argc, char **argv) {
   }
 
   clean_ncurses(interface);
-  gpuinfo_shutdown_info_extraction(&monitoredGpus);
+  metrics_exporter_close();
+  if (stats_json_option && !gpuinfo_stats_write_json(stats_json_option))
+    fprintf(stderr, "Cannot write the statistics to %s\n", stats_json_option);
+  gpuinfo_stats_clear();
+  gpuinfo_energy_clear();
+  if (remote_data)
+    gpuinfo_remote_detach();
+  else if (shared_data)
+    gpuinfo_shm_detach();
+  else
+    gpuinfo_shutdown_info_extraction(&monitoredGpus);
 
   return EXIT_SUCCESS;
 }
@@ -32,8 +32,8 @@ static inline int data_level(double rows, double data, double increment) {
   return (int)(rows - round(data / increment));
 }
 
-void nvtop_line_plot(WINDOW *win, size_t num_data, const double *data, unsigned num_lines, bool legend_left,
-                     char legend[MAX_LINES_PER_PLOT][PLOT_MAX_LEGEND_SIZE]) {
+void nvtop_line_plot(WINDOW *win, size_t num_data, const double *data, const double *data_min, const double *data_max,
+                     unsigned num_lines, bool legend_left, char legend[MAX_LINES_PER_PLOT][PLOT_MAX_LEGEND_SIZE]) {
   if (num_data == 0)
     return;
   int rows, cols;
@@ -42,6 +42,19 @@ void nvtop_line_plot(WINDOW *win, size_t num_data, const double *data, unsigned
   double increment = 100. / (double)(rows);
 
   assert(num_lines <= MAX_LINES_PER_PLOT && "Cannot plot more than " EXPAND_AND_QUOTE(MAX_LINES_PER_PLOT) " lines");
+  // The envelopes go first so that the lines are drawn over them
+  if (data_min && data_max) {
+    for (size_t i = 0; i < num_data; ++i) {
+      int lvl_low = data_level(rows, data_min[i], increment);
+      int lvl_high = data_level(rows, data_max[i], increment);
+      if (lvl_high < lvl_low) {
+        wattr_set(win, A_DIM, i % num_lines + 1, NULL);
+        mvwvline(win, lvl_high, i, 0, lvl_low - lvl_high + 1);
+      }
+    }
+    wattr_set(win, A_NORMAL, 0, NULL);
+  }
+
   unsigned lvl_before[MAX_LINES_PER_PLOT];
   for (size_t k = 0; k < num_lines; ++k)
     lvl_before[k] = data_level(rows, data[k], increment);
@@ -0,0 +1,229 @@
+/*
+ *
+ * Copyright (C) 2025 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "nvtop/power_sampler.h"
+#include "nvtop/extract_gpuinfo_common.h"
+#include "nvtop/time.h"
+#include "power_samples.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Power of two, ten seconds of samples at the highest rate
+#define POWER_SAMPLER_RING_SIZE 2048u
+
+struct sampled_device {
+  struct gpu_info *device;
+
+  // Previous reading of the energy counter, only used by the sampling thread
+  bool has_energy;
+  uint64_t energy;      // Microjoules
+  uint64_t energy_time; // Time of the reading
+
+  // Single producer single consumer ring of the power samples in milliwatts. The slots between tail and head belong to
+  // the refresh, the other ones to the sampling thread.
+  _Atomic unsigned head;
+  _Atomic unsigned tail;
+  unsigned samples[POWER_SAMPLER_RING_SIZE];
+
+  // Summary of the last interval that had samples, only used by the refresh
+  bool has_summary;
+  struct power_samples_summary summary;
+};
+
+static struct {
+  bool running;
+  uint64_t period; // Nanoseconds between two samples
+  unsigned devices_count;
+  struct sampled_device *devices;
+  unsigned scratch[POWER_SAMPLER_RING_SIZE]; // Samples of the interval being summarized
+
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t wakeup;
+  bool stop;
+} sampler;
+
+static void push_sample(struct sampled_device *sampled, unsigned power) {
+  unsigned head = atomic_load_explicit(&sampled->head, memory_order_relaxed);
+  unsigned tail = atomic_load_explicit(&sampled->tail, memory_order_acquire);
+  // The refresh is late, the newest samples are dropped rather than overwriting the ones it may be reading
+  if (head - tail == POWER_SAMPLER_RING_SIZE)
+    return;
+  sampled->samples[head % POWER_SAMPLER_RING_SIZE] = power;
+  atomic_store_explicit(&sampled->head, head + 1, memory_order_release);
+}
+
+static void sample_device(struct sampled_device *sampled) {
+  struct gpuinfo_power_reading reading;
+  nvtop_time before, after;
+  nvtop_get_current_time(&before);
+  if (!sampled->device->vendor->sample_power(sampled->device, &reading))
+    return;
+  if (!reading.is_energy) {
+    push_sample(sampled, reading.value < UINT_MAX ? reading.value : UINT_MAX);
+    return;
+  }
+
+  // The reading is dated in the middle of the query, which can be slow
+  nvtop_get_current_time(&after);
+  uint64_t now = nvtop_time_u64(before) + nvtop_difftime_u64(before, after) / 2;
+  // The counters are updated less often than they are sampled: the power is computed between two updates
+  if (sampled->has_energy && reading.value == sampled->energy)
+    return;
+  bool had_energy = sampled->has_energy;
+  uint64_t previous = sampled->energy;
+  uint64_t previous_time = sampled->energy_time;
+  sampled->has_energy = true;
+  sampled->energy = reading.value;
+  sampled->energy_time = now;
+  if (!had_energy || now <= previous_time)
+    return;
+
+  unsigned power;
+  if (power_samples_from_energy(previous, reading.value, reading.counter_bits, now - previous_time, &power))
+    push_sample(sampled, power);
+}
+
+static void *power_sampler_loop(void *arg) {
+  (void)arg;
+  struct timespec deadline;
+  clock_gettime(CLOCK_MONOTONIC, &deadline);
+  pthread_mutex_lock(&sampler.lock);
+  while (!sampler.stop) {
+    pthread_mutex_unlock(&sampler.lock);
+    for (unsigned i = 0; i < sampler.devices_count; ++i)
+      sample_device(&sampler.devices[i]);
+
+    // Absolute deadlines so that the rate does not drift with the time spent reading the devices
+    uint64_t next = nvtop_time_u64(deadline) + sampler.period;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (next < nvtop_time_u64(now))
+      next = nvtop_time_u64(now) + sampler.period; // The missed samples are skipped
+    deadline.tv_sec = next / 1000000000;
+    deadline.tv_nsec = next % 1000000000;
+    pthread_mutex_lock(&sampler.lock);
+    while (!sampler.stop && pthread_cond_timedwait(&sampler.wakeup, &sampler.lock, &deadline) != ETIMEDOUT) {
+    }
+  }
+  pthread_mutex_unlock(&sampler.lock);
+  return NULL;
+}
+
+bool power_sampler_start(struct list_head *devices, unsigned rate) {
+  if (sampler.running)
+    return true;
+  struct gpu_info *device;
+  unsigned count = 0;
+  list_for_each_entry(device, devices, list) { count += device->vendor->sample_power != NULL; }
+  if (!count)
+    return false;
+
+  sampler.devices = calloc(count, sizeof(*sampler.devices));
+  if (!sampler.devices) {
+    perror("Cannot allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+  list_for_each_entry(device, devices, list) {
+    if (!device->vendor->sample_power)
+      continue;
+    struct sampled_device *sampled = &sampler.devices[sampler.devices_count++];
+    sampled->device = device;
+    atomic_init(&sampled->head, 0);
+    atomic_init(&sampled->tail, 0);
+  }
+  sampler.period = UINT64_C(1000000000) / rate;
+  sampler.stop = false;
+
+  pthread_condattr_t cond_attr;
+  pthread_condattr_init(&cond_attr);
+  pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+  pthread_mutex_init(&sampler.lock, NULL);
+  pthread_cond_init(&sampler.wakeup, &cond_attr);
+  pthread_condattr_destroy(&cond_attr);
+  if (pthread_create(&sampler.thread, NULL, power_sampler_loop, NULL) != 0) {
+    pthread_cond_destroy(&sampler.wakeup);
+    pthread_mutex_destroy(&sampler.lock);
+    free(sampler.devices);
+    sampler.devices = NULL;
+    sampler.devices_count = 0;
+    return false;
+  }
+  sampler.running = true;
+  return true;
+}
+
+void power_sampler_apply(struct gpu_info *device) {
+  if (!sampler.running)
+    return;
+  struct sampled_device *sampled = NULL;
+  for (unsigned i = 0; !sampled && i < sampler.devices_count; ++i) {
+    if (sampler.devices[i].device == device)
+      sampled = &sampler.devices[i];
+  }
+  if (!sampled)
+    return;
+
+  // The ring is drained even when the power is not needed so that it is fresh when it is again
+  unsigned tail = atomic_load_explicit(&sampled->tail, memory_order_relaxed);
+  unsigned head = atomic_load_explicit(&sampled->head, memory_order_acquire);
+  unsigned count = head - tail;
+  for (unsigned i = 0; i < count; ++i)
+    sampler.scratch[i] = sampled->samples[(tail + i) % POWER_SAMPLER_RING_SIZE];
+  atomic_store_explicit(&sampled->tail, head, memory_order_release);
+  if (!GPUINFO_SUBSCRIBED(device, gpuinfo_subscribe_power)) {
+    sampled->has_summary = false;
+    return;
+  }
+
+  // Without new samples, the refresh was faster than the counters: the previous interval still holds
+  if (count) {
+    power_samples_summarize(sampler.scratch, count, &sampled->summary);
+    sampled->has_summary = true;
+  }
+  if (sampled->has_summary) {
+    SET_GPUINFO_DYNAMIC(&device->dynamic_info, power_draw, sampled->summary.average);
+    SET_GPUINFO_DYNAMIC(&device->dynamic_info, power_draw_peak, sampled->summary.peak);
+    SET_GPUINFO_DYNAMIC(&device->dynamic_info, power_draw_p99, sampled->summary.p99);
+  }
+}
+
+void power_sampler_stop(void) {
+  if (!sampler.running)
+    return;
+  pthread_mutex_lock(&sampler.lock);
+  sampler.stop = true;
+  pthread_cond_signal(&sampler.wakeup);
+  pthread_mutex_unlock(&sampler.lock);
+  pthread_join(sampler.thread, NULL);
+  pthread_cond_destroy(&sampler.wakeup);
+  pthread_mutex_destroy(&sampler.lock);
+  free(sampler.devices);
+  sampler.devices = NULL;
+  sampler.devices_count = 0;
+  sampler.running = false;
+}
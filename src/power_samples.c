@@ -0,0 +1,57 @@
+/*
+ *
+ * Copyright (C) 2025 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "power_samples.h"
+
+#include <limits.h>
+#include <stdlib.h>
+
+bool power_samples_from_energy(uint64_t previous, uint64_t value, unsigned counter_bits, uint64_t elapsed,
+                               unsigned *power) {
+  uint64_t drawn;
+  if (value > previous)
+    drawn = value - previous;
+  else if (counter_bits < 64)
+    drawn = (value - previous) & ((UINT64_C(1) << counter_bits) - 1); // The counter wrapped around
+  else
+    return false; // The counter was reset
+  // Microjoules per nanosecond are millions of milliwatts, kept in range of the samples
+  if (drawn > UINT64_MAX / UINT64_C(1000000) || drawn * UINT64_C(1000000) / elapsed >= UINT_MAX)
+    *power = UINT_MAX;
+  else
+    *power = drawn * UINT64_C(1000000) / elapsed;
+  return true;
+}
+
+static int compare_power(const void *a, const void *b) {
+  unsigned power_a = *(const unsigned *)a, power_b = *(const unsigned *)b;
+  return (power_a > power_b) - (power_a < power_b);
+}
+
+void power_samples_summarize(unsigned *samples, unsigned count, struct power_samples_summary *summary) {
+  uint64_t sum = 0;
+  for (unsigned i = 0; i < count; ++i)
+    sum += samples[i];
+  qsort(samples, count, sizeof(*samples), compare_power);
+  summary->average = sum / count;
+  summary->peak = samples[count - 1];
+  summary->p99 = samples[(99 * count + 99) / 100 - 1];
+}
@@ -0,0 +1,42 @@
+/*
+ *
+ * Copyright (C) 2025 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef POWER_SAMPLES_H_
+#define POWER_SAMPLES_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct power_samples_summary {
+  unsigned average;
+  unsigned peak;
+  unsigned p99; // Nearest rank
+};
+
+// Power in milliwatts drawn between two different readings of an energy counter in microjoules, elapsed nanoseconds
+// apart, up to UINT_MAX. Returns false if the counter was reset.
+bool power_samples_from_energy(uint64_t previous, uint64_t value, unsigned counter_bits, uint64_t elapsed,
+                               unsigned *power);
+
+// Summarizes count samples in milliwatts, count must not be 0. The samples are sorted.
+void power_samples_summarize(unsigned *samples, unsigned count, struct power_samples_summary *summary);
+
+#endif // POWER_SAMPLES_H_
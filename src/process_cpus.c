@@ -0,0 +1,67 @@
+/*
+ *
+ * Copyright (C) 2025 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "process_cpus.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// The processor is the 39th field of the stat file, the 37th after the parenthesis closing the command name
+#define STAT_PROCESSOR_FIELD_AFTER_COMM 37
+
+bool parse_cpu_list(const char *list, struct nvtop_cpu_set *cpus) {
+  memset(cpus, 0, sizeof(*cpus));
+  const char *current = list;
+  while (*current && *current != '\n') {
+    char *end;
+    unsigned long first = strtoul(current, &end, 10);
+    if (end == current)
+      return false;
+    unsigned long last = first;
+    if (*end == '-') {
+      current = end + 1;
+      last = strtoul(current, &end, 10);
+      if (end == current || last < first)
+        return false;
+    }
+    for (unsigned long cpu = first; cpu <= last && cpu < NVTOP_MAX_CPUS; ++cpu)
+      NVTOP_CPU_SET(cpu, cpus);
+    current = *end == ',' ? end + 1 : end;
+  }
+  return true;
+}
+
+bool parse_stat_processor(const char *stat, unsigned *cpu) {
+  // The command name may contain spaces and parentheses
+  const char *field = strrchr(stat, ')');
+  if (!field)
+    return false;
+  for (unsigned i = 0; field && i < STAT_PROCESSOR_FIELD_AFTER_COMM; ++i)
+    field = strchr(field + 1, ' ');
+  if (!field)
+    return false;
+  char *end;
+  unsigned long processor = strtoul(field + 1, &end, 10);
+  if (end == field + 1)
+    return false;
+  *cpu = processor;
+  return true;
+}
@@ -0,0 +1,35 @@
+/*
+ *
+ * Copyright (C) 2025 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef PROCESS_CPUS_H_
+#define PROCESS_CPUS_H_
+
+#include "nvtop/get_process_info.h"
+
+#include <stdbool.h>
+
+// Parses a CPU list of the kernel such as "0-3,8,10-11", up to the end of the line
+bool parse_cpu_list(const char *list, struct nvtop_cpu_set *cpus);
+
+// Parses the processor a task last ran on from the content of its stat file
+bool parse_stat_processor(const char *stat, unsigned *cpu);
+
+#endif // PROCESS_CPUS_H_
@@ -0,0 +1,447 @@
+/*
+ *
+ * Copyright (C) 2025 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "nvtop/snapshot.h"
+#include "nvtop/common.h"
+#include "nvtop/extract_gpuinfo.h"
+#include "nvtop/gpuinfo_energy.h"
+#include "nvtop/time.h"
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
+
+#define SNAPSHOT_PROCESSES_REALLOC_INC 8
+#define SNAPSHOT_OUTPUT_INITIAL_SIZE 4096
+
+// The JSON names carry the unit of the values
+struct snapshot_field {
+  const char *name;
+  int valid_bit;
+  unsigned offset;
+  unsigned size;
+};
+
+#define FIELD(type, label, name, valid)                                                                              \
+  {(label), (valid), offsetof(struct type, name), sizeof(((struct type *)0)->name)}
+#define DYNAMIC_FIELD(label, name) FIELD(gpuinfo_dynamic_info, label, name, gpuinfo_##name##_valid)
+#define ENGINE_FIELD(label, engine)                                                                                    \
+  FIELD(gpuinfo_dynamic_info, label, engine_util_rate[engine], gpuinfo_engine_util_rate_valid + (engine))
+#define PROCESS_FIELD(label, name) FIELD(gpu_process, label, name, gpuinfo_process_##name##_valid)
+
+static const struct snapshot_field device_fields[] = {
+    DYNAMIC_FIELD("gpu_clock_mhz", gpu_clock_speed),
+    DYNAMIC_FIELD("gpu_clock_max_mhz", gpu_clock_speed_max),
+    DYNAMIC_FIELD("mem_clock_mhz", mem_clock_speed),
+    DYNAMIC_FIELD("mem_clock_max_mhz", mem_clock_speed_max),
+    DYNAMIC_FIELD("gpu_util_percent", gpu_util_rate),
+    DYNAMIC_FIELD("mem_util_percent", mem_util_rate),
+    DYNAMIC_FIELD("encoder_util_percent", encoder_rate),
+    DYNAMIC_FIELD("decoder_util_percent", decoder_rate),
+    ENGINE_FIELD("render_util_percent", gpuinfo_engine_render),
+    ENGINE_FIELD("compute_util_percent", gpuinfo_engine_compute),
+    ENGINE_FIELD("copy_util_percent", gpuinfo_engine_copy),
+    ENGINE_FIELD("decode_util_percent", gpuinfo_engine_decode),
+    ENGINE_FIELD("encode_util_percent", gpuinfo_engine_encode),
+    DYNAMIC_FIELD("memory_total_bytes", total_memory),
+    DYNAMIC_FIELD("memory_used_bytes", used_memory),
+    DYNAMIC_FIELD("memory_free_bytes", free_memory),
+    DYNAMIC_FIELD("pcie_link_gen", pcie_link_gen),
+    DYNAMIC_FIELD("pcie_link_width", pcie_link_width),
+    DYNAMIC_FIELD("pcie_rx_kib_per_second", pcie_rx),
+    DYNAMIC_FIELD("pcie_tx_kib_per_second", pcie_tx),
+    DYNAMIC_FIELD("fan_speed_percent", fan_speed),
+    DYNAMIC_FIELD("fan_rpm", fan_rpm),
+    DYNAMIC_FIELD("temperature_celsius", gpu_temp),
+    DYNAMIC_FIELD("power_draw_milliwatts", power_draw),
+    DYNAMIC_FIELD("power_limit_milliwatts", power_draw_max),
+    DYNAMIC_FIELD("energy_millijoules", energy_consumed),
+    DYNAMIC_FIELD("power_peak_milliwatts", power_draw_peak),
+    DYNAMIC_FIELD("power_p99_milliwatts", power_draw_p99),
+};
+
+static const struct snapshot_field process_fields[] = {
+    PROCESS_FIELD("gpu_usage_percent", gpu_usage),
+    PROCESS_FIELD("encode_usage_percent", encode_usage),
+    PROCESS_FIELD("decode_usage_percent", decode_usage),
+    PROCESS_FIELD("gpu_memory_bytes", gpu_memory_usage),
+    PROCESS_FIELD("gpu_memory_percent", gpu_memory_percentage),
+    PROCESS_FIELD("cpu_usage_percent", cpu_usage),
+    PROCESS_FIELD("host_memory_resident_bytes", cpu_memory_res),
+    PROCESS_FIELD("host_memory_virtual_bytes", cpu_memory_virt),
+    PROCESS_FIELD("energy_millijoules", energy_consumed),
+};
+
+static const char *process_type_names[gpu_process_type_count] = {
+    [gpu_process_unknown] = "unknown",
+    [gpu_process_graphical] = "graphical",
+    [gpu_process_compute] = "compute",
+    [gpu_process_graphical_compute] = "graphical_compute",
+};
+
+struct snapshot_metric {
+  uint64_t count;
+  uint64_t min;
+  uint64_t max;
+  uint64_t last;
+  double sum;
+};
+
+struct snapshot_process {
+  pid_t pid;
+  enum gpu_process_type type;
+  char *cmdline;
+  char *user_name;
+  unsigned samples;
+  struct snapshot_metric metrics[ARRAY_SIZE(process_fields)];
+};
+
+struct snapshot_device {
+  struct snapshot_metric metrics[ARRAY_SIZE(device_fields)];
+  unsigned processes_count;
+  unsigned processes_capacity;
+  struct snapshot_process *processes;
+  unsigned lookup_hint; // Entry following the last process found, the processes come in the same order every sample
+};
+
+// The document is formatted in memory and written at once
+struct snapshot_writer {
+  char *data;
+  size_t size;
+  size_t capacity;
+};
+
+static bool field_value(const void *structure, const unsigned char *valid, const struct snapshot_field *field,
+                        uint64_t *value) {
+  if (!IS_VALID(field->valid_bit, valid))
+    return false;
+  const char *ptr = (const char *)structure + field->offset;
+  switch (field->size) {
+  case sizeof(uint8_t):
+    *value = *(const uint8_t *)ptr;
+    return true;
+  case sizeof(uint16_t):
+    *value = *(const uint16_t *)ptr;
+    return true;
+  case sizeof(uint32_t):
+    *value = *(const uint32_t *)ptr;
+    return true;
+  case sizeof(uint64_t):
+    *value = *(const uint64_t *)ptr;
+    return true;
+  default:
+    return false;
+  }
+}
+
+static void accumulate(struct snapshot_metric *metrics, const struct snapshot_field *fields, unsigned fields_count,
+                       const void *structure, const unsigned char *valid) {
+  for (unsigned i = 0; i < fields_count; ++i) {
+    uint64_t value;
+    if (!field_value(structure, valid, &fields[i], &value))
+      continue;
+    struct snapshot_metric *metric = &metrics[i];
+    if (!metric->count || value < metric->min)
+      metric->min = value;
+    if (!metric->count || value > metric->max)
+      metric->max = value;
+    metric->last = value;
+    metric->sum += (double)value;
+    metric->count++;
+  }
+}
+
+static char *strdup_or_die(const char *str) {
+  char *copy = strdup(str);
+  if (!copy) {
+    perror("Cannot allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+  return copy;
+}
+
+static struct snapshot_process *snapshot_process(struct snapshot_device *device, const struct gpu_process *process) {
+  for (unsigned i = 0; i < device->processes_count; ++i) {
+    unsigned index = (device->lookup_hint + i) % device->processes_count;
+    if (device->processes[index].pid == process->pid) {
+      device->lookup_hint = index + 1;
+      return &device->processes[index];
+    }
+  }
+  if (device->processes_count == device->processes_capacity) {
+    unsigned capacity = device->processes_capacity + SNAPSHOT_PROCESSES_REALLOC_INC;
+    struct snapshot_process *processes = reallocarray(device->processes, capacity, sizeof(*processes));
+    if (!processes) {
+      perror("Cannot allocate memory: ");
+      exit(EXIT_FAILURE);
+    }
+    device->processes = processes;
+    device->processes_capacity = capacity;
+  }
+  struct snapshot_process *new_process = &device->processes[device->processes_count++];
+  memset(new_process, 0, sizeof(*new_process));
+  new_process->pid = process->pid;
+  return new_process;
+}
+
+static void snapshot_sample(struct list_head *devices, struct snapshot_device *snapshot_devices) {
+  gpuinfo_refresh_dynamic_info(devices);
+  gpuinfo_refresh_processes(devices);
+  gpuinfo_utilisation_rate(devices);
+  gpuinfo_fix_dynamic_info_from_process_info(devices);
+  gpuinfo_energy_account(devices, true);
+
+  struct gpu_info *device;
+  unsigned index = 0;
+  list_for_each_entry(device, devices, list) {
+    struct snapshot_device *snapshot_device = &snapshot_devices[index++];
+    accumulate(snapshot_device->metrics, device_fields, ARRAY_SIZE(device_fields), &device->dynamic_info,
+               device->dynamic_info.valid);
+    for (unsigned i = 0; i < device->processes_count; ++i) {
+      const struct gpu_process *process = &device->processes[i];
+      struct snapshot_process *snapshot = snapshot_process(snapshot_device, process);
+      snapshot->samples++;
+      snapshot->type = process->type;
+      if (!snapshot->cmdline && GPUINFO_PROCESS_FIELD_VALID(process, cmdline))
+        snapshot->cmdline = strdup_or_die(process->cmdline);
+      if (!snapshot->user_name && GPUINFO_PROCESS_FIELD_VALID(process, user_name))
+        snapshot->user_name = strdup_or_die(process->user_name);
+      accumulate(snapshot->metrics, process_fields, ARRAY_SIZE(process_fields), process, process->valid);
+    }
+  }
+}
+
+static void writer_reserve(struct snapshot_writer *writer, size_t size) {
+  if (writer->size + size <= writer->capacity)
+    return;
+  size_t capacity = writer->capacity ? writer->capacity : SNAPSHOT_OUTPUT_INITIAL_SIZE;
+  while (capacity < writer->size + size)
+    capacity *= 2;
+  char *data = realloc(writer->data, capacity);
+  if (!data) {
+    perror("Cannot allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+  writer->data = data;
+  writer->capacity = capacity;
+}
+
+static void write_raw(struct snapshot_writer *writer, const char *str) {
+  size_t length = strlen(str);
+  writer_reserve(writer, length);
+  memcpy(writer->data + writer->size, str, length);
+  writer->size += length;
+}
+
+static void write_uint(struct snapshot_writer *writer, uint64_t value) {
+  char digits[20];
+  unsigned count = 0;
+  do {
+    digits[count++] = '0' + value % 10;
+    value /= 10;
+  } while (value);
+  writer_reserve(writer, count);
+  while (count)
+    writer->data[writer->size++] = digits[--count];
+}
+
+static void write_double(struct snapshot_writer *writer, double value) {
+  char number[32];
+  snprintf(number, sizeof(number), "%.3f", value);
+  write_raw(writer, number);
+}
+
+static void write_string(struct snapshot_writer *writer, const char *str) {
+  static const char hex[] = "0123456789abcdef";
+  writer_reserve(writer, 2 + 6 * strlen(str));
+  char *out = writer->data + writer->size;
+  *out++ = '"';
+  for (const unsigned char *c = (const unsigned char *)str; *c; ++c) {
+    if (*c == '"' || *c == '\\') {
+      *out++ = '\\';
+      *out++ = *c;
+    } else if (*c < 0x20) {
+      memcpy(out, "\\u00", 4);
+      out[4] = hex[*c >> 4];
+      out[5] = hex[*c & 0xf];
+      out += 6;
+    } else {
+      *out++ = *c;
+    }
+  }
+  *out++ = '"';
+  writer->size = out - writer->data;
+}
+
+static void write_metrics(struct snapshot_writer *writer, const struct snapshot_metric *metrics,
+                          const struct snapshot_field *fields, unsigned fields_count, const char *indent) {
+  write_raw(writer, "{");
+  for (unsigned i = 0; i < fields_count; ++i) {
+    write_raw(writer, i ? ",\n" : "\n");
+    write_raw(writer, indent);
+    write_string(writer, fields[i].name);
+    const struct snapshot_metric *metric = &metrics[i];
+    if (!metric->count) {
+      write_raw(writer, ": null");
+      continue;
+    }
+    write_raw(writer, ": {\"min\": ");
+    write_uint(writer, metric->min);
+    write_raw(writer, ", \"mean\": ");
+    write_double(writer, metric->sum / (double)metric->count);
+    write_raw(writer, ", \"max\": ");
+    write_uint(writer, metric->max);
+    write_raw(writer, ", \"last\": ");
+    write_uint(writer, metric->last);
+    write_raw(writer, ", \"samples\": ");
+    write_uint(writer, metric->count);
+    write_raw(writer, "}");
+  }
+  write_raw(writer, "}");
+}
+
+static void write_process(struct snapshot_writer *writer, const struct snapshot_process *process) {
+  write_raw(writer, "\n        {\"pid\": ");
+  write_uint(writer, (uint64_t)process->pid);
+  write_raw(writer, ", \"user\": ");
+  if (process->user_name)
+    write_string(writer, process->user_name);
+  else
+    write_raw(writer, "null");
+  write_raw(writer, ", \"cmdline\": ");
+  if (process->cmdline)
+    write_string(writer, process->cmdline);
+  else
+    write_raw(writer, "null");
+  write_raw(writer, ", \"type\": ");
+  write_string(writer, process_type_names[process->type < gpu_process_type_count ? process->type : 0]);
+  write_raw(writer, ", \"samples\": ");
+  write_uint(writer, process->samples);
+  write_raw(writer, ",\n         \"metrics\": ");
+  write_metrics(writer, process->metrics, process_fields, ARRAY_SIZE(process_fields), "           ");
+  write_raw(writer, "}");
+}
+
+static void write_snapshot(struct snapshot_writer *writer, struct list_head *devices,
+                           const struct snapshot_device *snapshot_devices, double duration, double interval,
+                           unsigned samples) {
+  write_raw(writer, "{\n  \"schema_version\": ");
+  write_uint(writer, NVTOP_SNAPSHOT_SCHEMA_VERSION);
+  write_raw(writer, ",\n  \"duration\": ");
+  write_double(writer, duration);
+  write_raw(writer, ",\n  \"interval\": ");
+  write_double(writer, interval);
+  write_raw(writer, ",\n  \"samples\": ");
+  write_uint(writer, samples);
+  write_raw(writer, ",\n  \"devices\": [");
+  const struct gpu_info *device;
+  unsigned index = 0;
+  list_for_each_entry(device, devices, list) {
+    const struct snapshot_device *snapshot_device = &snapshot_devices[index];
+    write_raw(writer, index ? ",\n    {\"index\": " : "\n    {\"index\": ");
+    write_uint(writer, index);
+    write_raw(writer, ", \"name\": ");
+    if (GPUINFO_STATIC_FIELD_VALID(&device->static_info, device_name))
+      write_string(writer, device->static_info.device_name);
+    else
+      write_raw(writer, "null");
+    write_raw(writer, ", \"pdev\": ");
+    if (device->pdev[0])
+      write_string(writer, device->pdev);
+    else
+      write_raw(writer, "null");
+    write_raw(writer, ",\n     \"metrics\": ");
+    write_metrics(writer, snapshot_device->metrics, device_fields, ARRAY_SIZE(device_fields), "       ");
+    write_raw(writer, ",\n     \"processes\": [");
+    for (unsigned i = 0; i < snapshot_device->processes_count; ++i) {
+      if (i)
+        write_raw(writer, ",");
+      write_process(writer, &snapshot_device->processes[i]);
+    }
+    write_raw(writer, snapshot_device->processes_count ? "\n     ]}" : "]}");
+    index++;
+  }
+  write_raw(writer, index ? "\n  ]\n}\n" : "]\n}\n");
+}
+
+int nvtop_snapshot_run(struct list_head *devices, double duration, double interval, FILE *output,
+                       volatile sig_atomic_t *stop) {
+  unsigned devices_count = 0;
+  struct gpu_info *device;
+  list_for_each_entry(device, devices, list) { devices_count++; }
+  struct snapshot_device *snapshot_devices = calloc(devices_count ? devices_count : 1, sizeof(*snapshot_devices));
+  if (!snapshot_devices) {
+    perror("Cannot allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+
+  // The usage rates are computed from the counters of the previous refresh, and the energy from the previous power draw
+  gpuinfo_refresh_dynamic_info(devices);
+  gpuinfo_refresh_processes(devices);
+  gpuinfo_energy_account(devices, true);
+
+  unsigned planned = (unsigned)(duration / interval + .5);
+  if (planned == 0)
+    planned = 1;
+  uint64_t interval_ns = (uint64_t)(interval * 1e9);
+  struct timespec start, deadline;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  uint64_t start_ns = nvtop_time_u64(start);
+  uint64_t last_sample_ns = start_ns;
+  unsigned samples = 0;
+  while (samples < planned && !*stop) {
+    uint64_t deadline_ns = start_ns + (samples + 1) * interval_ns;
+    deadline.tv_sec = deadline_ns / UINT64_C(1000000000);
+    deadline.tv_nsec = deadline_ns % UINT64_C(1000000000);
+    int status;
+    while ((status = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL)) == EINTR && !*stop)
+      ;
+    if (status)
+      break;
+    snapshot_sample(devices, snapshot_devices);
+    samples++;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    last_sample_ns = nvtop_time_u64(now);
+  }
+
+  struct snapshot_writer writer = {0};
+  write_snapshot(&writer, devices, snapshot_devices, (double)(last_sample_ns - start_ns) / 1e9, interval, samples);
+  bool written = fwrite(writer.data, 1, writer.size, output) == writer.size && fflush(output) == 0;
+  if (!written)
+    perror("Cannot write the snapshot: ");
+  free(writer.data);
+
+  for (unsigned i = 0; i < devices_count; ++i) {
+    for (unsigned j = 0; j < snapshot_devices[i].processes_count; ++j) {
+      free(snapshot_devices[i].processes[j].cmdline);
+      free(snapshot_devices[i].processes[j].user_name);
+    }
+    free(snapshot_devices[i].processes);
+  }
+  free(snapshot_devices);
+  return written ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,267 @@
+/*
+ *
+ * Copyright (C) 2025 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "amdgpu_metrics.h"
+#include "nvtop/extract_gpuinfo_common.h"
+}
+
+namespace {
+
+// The tables as laid out by the driver in include/uapi/linux/kgd_pp_interface.h (the fields after the throttle
+// status are omitted when no revision reads them)
+
+struct metrics_table_header {
+  uint16_t structure_size;
+  uint8_t format_revision;
+  uint8_t content_revision;
+};
+
+struct gpu_metrics_v1_3 {
+  struct metrics_table_header common_header;
+  uint16_t temperature_edge;
+  uint16_t temperature_hotspot;
+  uint16_t temperature_mem;
+  uint16_t temperature_vrgfx;
+  uint16_t temperature_vrsoc;
+  uint16_t temperature_vrmem;
+  uint16_t average_gfx_activity;
+  uint16_t average_umc_activity;
+  uint16_t average_mm_activity;
+  uint16_t average_socket_power;
+  uint64_t energy_accumulator;
+  uint64_t system_clock_counter;
+  uint16_t average_gfxclk_frequency;
+  uint16_t average_socclk_frequency;
+  uint16_t average_uclk_frequency;
+  uint16_t average_vclk0_frequency;
+  uint16_t average_dclk0_frequency;
+  uint16_t average_vclk1_frequency;
+  uint16_t average_dclk1_frequency;
+  uint16_t current_gfxclk;
+  uint16_t current_socclk;
+  uint16_t current_uclk;
+  uint16_t current_vclk0;
+  uint16_t current_dclk0;
+  uint16_t current_vclk1;
+  uint16_t current_dclk1;
+  uint32_t throttle_status;
+  uint16_t current_fan_speed;
+  uint16_t pcie_link_width;
+  uint16_t pcie_link_speed;
+  uint16_t padding;
+  uint32_t gfx_activity_acc;
+  uint32_t mem_activity_acc;
+  uint16_t temperature_hbm[4];
+  uint64_t firmware_timestamp;
+  uint16_t voltage_soc;
+  uint16_t voltage_gfx;
+  uint16_t voltage_mem;
+  uint16_t padding1;
+  uint64_t indep_throttle_status;
+};
+
+struct gpu_metrics_v2_0 {
+  struct metrics_table_header common_header;
+  uint64_t system_clock_counter;
+  uint16_t temperature_gfx;
+  uint16_t temperature_soc;
+  uint16_t temperature_core[8];
+  uint16_t temperature_l3[2];
+  uint16_t average_gfx_activity;
+  uint16_t average_mm_activity;
+  uint16_t average_socket_power;
+  uint16_t average_cpu_power;
+  uint16_t average_soc_power;
+  uint16_t average_gfx_power;
+  uint16_t average_core_power[8];
+  uint16_t average_gfxclk_frequency;
+  uint16_t average_socclk_frequency;
+  uint16_t average_uclk_frequency;
+  uint16_t average_fclk_frequency;
+  uint16_t average_vclk_frequency;
+  uint16_t average_dclk_frequency;
+  uint16_t current_gfxclk;
+  uint16_t current_socclk;
+  uint16_t current_uclk;
+  uint16_t current_fclk;
+  uint16_t current_vclk;
+  uint16_t current_dclk;
+  uint16_t current_coreclk[8];
+  uint16_t current_l3clk[2];
+  uint32_t throttle_status;
+  uint16_t fan_pwm;
+  uint16_t padding;
+};
+
+// Also the start of gpu_metrics_v2_1, which has no indep_throttle_status
+struct gpu_metrics_v2_2 {
+  struct metrics_table_header common_header;
+  uint16_t temperature_gfx;
+  uint16_t temperature_soc;
+  uint16_t temperature_core[8];
+  uint16_t temperature_l3[2];
+  uint16_t average_gfx_activity;
+  uint16_t average_mm_activity;
+  uint64_t system_clock_counter;
+  uint16_t average_socket_power;
+  uint16_t average_cpu_power;
+  uint16_t average_soc_power;
+  uint16_t average_gfx_power;
+  uint16_t average_core_power[8];
+  uint16_t average_gfxclk_frequency;
+  uint16_t average_socclk_frequency;
+  uint16_t average_uclk_frequency;
+  uint16_t average_fclk_frequency;
+  uint16_t average_vclk_frequency;
+  uint16_t average_dclk_frequency;
+  uint16_t current_gfxclk;
+  uint16_t current_socclk;
+  uint16_t current_uclk;
+  uint16_t current_fclk;
+  uint16_t current_vclk;
+  uint16_t current_dclk;
+  uint16_t current_coreclk[8];
+  uint16_t current_l3clk[2];
+  uint32_t throttle_status;
+  uint16_t fan_pwm;
+  uint16_t padding[3];
+  uint64_t indep_throttle_status;
+};
+
+// The layouts the decoder was written for
+static_assert(offsetof(gpu_metrics_v1_3, throttle_status) == 68, "Unexpected gpu_metrics_v1_3 layout");
+static_assert(offsetof(gpu_metrics_v1_3, indep_throttle_status) == 112, "Unexpected gpu_metrics_v1_3 layout");
+static_assert(offsetof(gpu_metrics_v2_0, throttle_status) == 112, "Unexpected gpu_metrics_v2_0 layout");
+static_assert(offsetof(gpu_metrics_v2_2, throttle_status) == 108, "Unexpected gpu_metrics_v2_2 layout");
+static_assert(offsetof(gpu_metrics_v2_2, indep_throttle_status) == 120, "Unexpected gpu_metrics_v2_2 layout");
+
+constexpr unsigned power = GPUINFO_THROTTLE_REASON(gpuinfo_throttle_power);
+constexpr unsigned thermal = GPUINFO_THROTTLE_REASON(gpuinfo_throttle_thermal);
+constexpr unsigned hardware = GPUINFO_THROTTLE_REASON(gpuinfo_throttle_hardware);
+constexpr unsigned other = GPUINFO_THROTTLE_REASON(gpuinfo_throttle_other);
+
+// The driver fills the fields the device does not support with ones
+template <typename Table> Table unsupported_table(uint8_t format_revision, uint8_t content_revision) {
+  Table table;
+  memset(&table, 0xff, sizeof(table));
+  table.common_header.structure_size = sizeof(table);
+  table.common_header.format_revision = format_revision;
+  table.common_header.content_revision = content_revision;
+  return table;
+}
+
+template <typename Table> bool throttle_reasons(const Table &table, unsigned *reasons, size_t size = sizeof(Table)) {
+  unsigned char metrics[GPU_METRICS_THROTTLE_READ_SIZE] = {};
+  memcpy(metrics, &table, std::min(size, sizeof(metrics)));
+  return amdgpu_metrics_throttle_reasons(metrics, std::min(size, sizeof(metrics)), reasons);
+}
+
+TEST(AmdgpuMetrics, Version1_3) {
+  auto table = unsupported_table<gpu_metrics_v1_3>(1, 3);
+  unsigned reasons = 0;
+  EXPECT_FALSE(throttle_reasons(table, &reasons));
+
+  // Only the ASIC specific status is available
+  table.throttle_status = 0;
+  ASSERT_TRUE(throttle_reasons(table, &reasons));
+  EXPECT_EQ(reasons, 0u);
+  table.throttle_status = 1u << 5;
+  ASSERT_TRUE(throttle_reasons(table, &reasons));
+  EXPECT_EQ(reasons, other);
+
+  // The ASIC independent status is split by reason
+  table.indep_throttle_status = 0;
+  ASSERT_TRUE(throttle_reasons(table, &reasons));
+  EXPECT_EQ(reasons, 0u);
+  table.indep_throttle_status = (UINT64_C(1) << 3) | (UINT64_C(1) << 33);
+  ASSERT_TRUE(throttle_reasons(table, &reasons));
+  EXPECT_EQ(reasons, power | thermal);
+  table.indep_throttle_status = (UINT64_C(1) << 44) | (UINT64_C(1) << 56);
+  ASSERT_TRUE(throttle_reasons(table, &reasons));
+  EXPECT_EQ(reasons, hardware | other);
+
+  // The earlier revisions of format 1 share the offset of the ASIC specific status
+  auto v1_0 = unsupported_table<gpu_metrics_v1_3>(1, 0);
+  v1_0.throttle_status = 0;
+  v1_0.indep_throttle_status = UINT64_C(1) << 3;
+  ASSERT_TRUE(throttle_reasons(v1_0, &reasons));
+  EXPECT_EQ(reasons, 0u);
+}
+
+TEST(AmdgpuMetrics, Version2_0) {
+  auto table = unsupported_table<gpu_metrics_v2_0>(2, 0);
+  unsigned reasons = 0;
+  EXPECT_FALSE(throttle_reasons(table, &reasons));
+  table.throttle_status = 0;
+  ASSERT_TRUE(throttle_reasons(table, &reasons));
+  EXPECT_EQ(reasons, 0u);
+  table.throttle_status = 1u << 2;
+  ASSERT_TRUE(throttle_reasons(table, &reasons));
+  EXPECT_EQ(reasons, other);
+}
+
+TEST(AmdgpuMetrics, Version2_1) {
+  // The fan speed right after the status must not be taken for it
+  auto table = unsupported_table<gpu_metrics_v2_2>(2, 1);
+  table.throttle_status = 0;
+  table.fan_pwm = 0x1234;
+  unsigned reasons = 0;
+  ASSERT_TRUE(throttle_reasons(table, &reasons, offsetof(gpu_metrics_v2_2, indep_throttle_status)));
+  EXPECT_EQ(reasons, 0u);
+  table.throttle_status = 1u << 7;
+  ASSERT_TRUE(throttle_reasons(table, &reasons, offsetof(gpu_metrics_v2_2, indep_throttle_status)));
+  EXPECT_EQ(reasons, other);
+}
+
+TEST(AmdgpuMetrics, Version2_2) {
+  auto table = unsupported_table<gpu_metrics_v2_2>(2, 2);
+  unsigned reasons = 0;
+  EXPECT_FALSE(throttle_reasons(table, &reasons));
+  table.throttle_status = 1u << 1;
+  ASSERT_TRUE(throttle_reasons(table, &reasons));
+  EXPECT_EQ(reasons, other);
+  table.indep_throttle_status = UINT64_C(1) << 40;
+  ASSERT_TRUE(throttle_reasons(table, &reasons));
+  EXPECT_EQ(reasons, thermal);
+}
+
+TEST(AmdgpuMetrics, UnknownOrShortTables) {
+  auto table = unsupported_table<gpu_metrics_v2_2>(2, 3);
+  table.throttle_status = 0;
+  table.indep_throttle_status = 0;
+  unsigned reasons = 0;
+  EXPECT_FALSE(throttle_reasons(table, &reasons));
+  table.common_header.format_revision = 3;
+  table.common_header.content_revision = 0;
+  EXPECT_FALSE(throttle_reasons(table, &reasons));
+
+  auto v2_0 = unsupported_table<gpu_metrics_v2_0>(2, 0);
+  v2_0.throttle_status = 0;
+  EXPECT_FALSE(throttle_reasons(v2_0, &reasons, offsetof(gpu_metrics_v2_0, throttle_status) + 2));
+  EXPECT_FALSE(throttle_reasons(v2_0, &reasons, 2));
+}
+
+} // namespace
@@ -0,0 +1,230 @@
+/*
+ *
+ * Copyright (C) 2025 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <vector>
+
+extern "C" {
+#include "nvtop/extract_gpuinfo.h"
+#include "nvtop/gpuinfo_energy.h"
+
+// The accounting only registers what it needs, the devices are not refreshed here
+void gpuinfo_add_consumer_needs(gpuinfo_subscription needs) { (void)needs; }
+}
+
+namespace {
+
+constexpr uint64_t second = UINT64_C(1000000000);
+constexpr uint64_t millisecond = UINT64_C(1000000);
+
+// One device whose power and processes are set by the tests before each sample
+class Device {
+public:
+  Device() {
+    gpuinfo_energy_clear();
+    info.subscription = GPUINFO_SUBSCRIPTION_ALL;
+    list_add_tail(&info.list, &devices);
+  }
+  ~Device() { gpuinfo_energy_clear(); }
+
+  void power(unsigned milliwatts) { SET_GPUINFO_DYNAMIC(&info.dynamic_info, power_draw, milliwatts); }
+
+  // A process busy for engine_time nanoseconds since it started
+  void engine_process(pid_t pid, uint64_t engine_time) {
+    struct gpu_process process = {};
+    process.pid = pid;
+    SET_GPUINFO_PROCESS(&process, gfx_engine_used, engine_time);
+    processes.push_back(process);
+  }
+
+  // A process of a driver without engine counters
+  void usage_process(pid_t pid, unsigned gpu_usage) {
+    struct gpu_process process = {};
+    process.pid = pid;
+    SET_GPUINFO_PROCESS(&process, gpu_usage, gpu_usage);
+    processes.push_back(process);
+  }
+
+  void sample(uint64_t now, bool processes_refreshed) {
+    info.processes = processes.data();
+    info.processes_count = processes.size();
+    gpuinfo_energy_account_at(&devices, processes_refreshed, now);
+  }
+
+  // The processes of the next refresh
+  void refresh(uint64_t now) {
+    sample(now, true);
+    processes.clear();
+  }
+
+  unsigned long long energy() const {
+    EXPECT_TRUE(GPUINFO_DYNAMIC_FIELD_VALID(&info.dynamic_info, energy_consumed));
+    return info.dynamic_info.energy_consumed;
+  }
+
+  unsigned long long process_energy(pid_t pid) const {
+    for (unsigned i = 0; i < info.processes_count; ++i) {
+      if (info.processes[i].pid == pid) {
+        EXPECT_TRUE(GPUINFO_PROCESS_FIELD_VALID(&info.processes[i], energy_consumed));
+        return info.processes[i].energy_consumed;
+      }
+    }
+    ADD_FAILURE() << "Process " << pid << " is not listed";
+    return 0;
+  }
+
+private:
+  struct gpu_info info = {};
+  LIST_HEAD(devices);
+  std::vector<struct gpu_process> processes;
+};
+
+TEST(GpuinfoEnergy, TrapezoidBetweenSamples) {
+  Device device;
+  device.power(100000);
+  device.sample(second, false);
+  EXPECT_EQ(device.energy(), 0u);
+  device.power(200000);
+  device.sample(2 * second, false);
+  // (100 W + 200 W) / 2 during one second
+  EXPECT_EQ(device.energy(), 150000u);
+}
+
+TEST(GpuinfoEnergy, ShortIntervalsAreNotRoundedAway) {
+  Device device;
+  device.power(1);
+  // 1 mW during 1 ms is 1 uJ: a thousand of them make the first millijoule
+  for (uint64_t sample = 0; sample <= 1000; ++sample) {
+    device.sample(second + sample * millisecond, false);
+    EXPECT_EQ(device.energy(), sample == 1000 ? 1u : 0u) << "Sample " << sample;
+  }
+}
+
+TEST(GpuinfoEnergy, NoEnergyWithoutPower) {
+  Device device;
+  device.sample(second, false);
+  device.power(100000);
+  device.sample(2 * second, false);
+  // The interval needs the power at both ends
+  EXPECT_EQ(device.energy(), 0u);
+  device.sample(3 * second, false);
+  EXPECT_EQ(device.energy(), 100000u);
+}
+
+TEST(GpuinfoEnergy, SharesInProportionOfTheEngineTime) {
+  Device device;
+  device.power(100000);
+  for (pid_t pid : {1, 2, 3})
+    device.engine_process(pid, 0);
+  device.refresh(second);
+  device.engine_process(1, 100 * millisecond);
+  device.engine_process(2, 100 * millisecond);
+  device.engine_process(3, 200 * millisecond);
+  device.sample(2 * second, true);
+  EXPECT_EQ(device.energy(), 100000u);
+  EXPECT_EQ(device.process_energy(1), 25000u);
+  EXPECT_EQ(device.process_energy(2), 25000u);
+  EXPECT_EQ(device.process_energy(3), 50000u);
+}
+
+TEST(GpuinfoEnergy, SharesSumToTheEnergyDrawn) {
+  Device device;
+  device.power(100000);
+  for (pid_t pid : {1, 2, 3})
+    device.engine_process(pid, 0);
+  device.refresh(second);
+  // Shares of a seventh, each one is rounded down to the microjoule except the last one which takes what is left
+  device.engine_process(1, 1 * millisecond);
+  device.engine_process(2, 2 * millisecond);
+  device.engine_process(3, 4 * millisecond);
+  device.sample(2 * second, true);
+  unsigned long long sum = device.process_energy(1) + device.process_energy(2) + device.process_energy(3);
+  EXPECT_LE(sum, device.energy());
+  // Less than a millijoule is lost by each process when reported in millijoules
+  EXPECT_GT(sum + 3, device.energy());
+  EXPECT_EQ(device.process_energy(1), 14285u);
+  EXPECT_EQ(device.process_energy(2), 28571u);
+}
+
+TEST(GpuinfoEnergy, EnergyDrawnBetweenRefreshesIsShared) {
+  Device device;
+  device.power(100000);
+  device.engine_process(1, 0);
+  device.refresh(second);
+  // The updates between two refreshes integrate the power, their energy goes to the next refresh
+  device.sample(2 * second, false);
+  device.sample(3 * second, false);
+  device.engine_process(1, 10 * millisecond);
+  device.sample(4 * second, true);
+  EXPECT_EQ(device.energy(), 300000u);
+  EXPECT_EQ(device.process_energy(1), 300000u);
+}
+
+TEST(GpuinfoEnergy, IdleEnergyIsNotShared) {
+  Device device;
+  device.power(100000);
+  device.engine_process(1, 10 * millisecond);
+  device.refresh(second);
+  device.engine_process(1, 10 * millisecond);
+  device.sample(2 * second, true);
+  EXPECT_EQ(device.energy(), 100000u);
+  EXPECT_EQ(device.process_energy(1), 0u);
+}
+
+TEST(GpuinfoEnergy, UtilizationRateWithoutEngineCounters) {
+  Device device;
+  device.power(80000);
+  device.usage_process(1, 30);
+  device.usage_process(2, 10);
+  device.refresh(second);
+  device.usage_process(1, 30);
+  device.usage_process(2, 10);
+  device.sample(2 * second, true);
+  EXPECT_EQ(device.energy(), 80000u);
+  EXPECT_EQ(device.process_energy(1), 60000u);
+  EXPECT_EQ(device.process_energy(2), 20000u);
+}
+
+TEST(GpuinfoEnergy, ExitedProcessesFromTheMostRecent) {
+  Device device;
+  device.power(10000);
+  // Each refresh lists a new process, the one of the previous refresh exited with the energy of one second
+  constexpr pid_t last_pid = GPUINFO_ENERGY_EXITED_PROCESSES + 6;
+  for (pid_t pid = 0; pid <= last_pid + 1; ++pid) {
+    device.usage_process(pid, 100);
+    device.refresh((uint64_t)(pid + 1) * second);
+  }
+  // The first process consumed nothing before its exit and is not remembered, the oldest exits were forgotten
+  ASSERT_EQ(gpuinfo_energy_exited_count(), (unsigned)GPUINFO_ENERGY_EXITED_PROCESSES);
+  const struct gpuinfo_energy_exited_process *newest = gpuinfo_energy_exited(0);
+  EXPECT_EQ(newest->pid, last_pid);
+  EXPECT_EQ(newest->sequence, (uint64_t)last_pid);
+  EXPECT_EQ(newest->energy, 10000u);
+  EXPECT_EQ(newest->device, 0u);
+  for (unsigned index = 1; index < GPUINFO_ENERGY_EXITED_PROCESSES; ++index) {
+    const struct gpuinfo_energy_exited_process *exited = gpuinfo_energy_exited(index);
+    EXPECT_EQ(exited->pid, last_pid - (pid_t)index);
+    EXPECT_EQ(exited->sequence, newest->sequence - index);
+  }
+}
+
+} // namespace
@@ -0,0 +1,251 @@
+/*
+ *
+ * Copyright (C) 2025 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <vector>
+
+extern "C" {
+#include "nvtop/gpuinfo_protocol.h"
+}
+
+namespace {
+
+char *copy_string(const char *string) {
+  char *copy = strdup(string);
+  EXPECT_NE(copy, nullptr);
+  return copy;
+}
+
+void set_process(struct gpu_process *process, pid_t pid, const char *cmdline, const char *user_name,
+                 unsigned gpu_usage, unsigned long long gpu_memory_usage) {
+  memset(process, 0, sizeof(*process));
+  process->type = gpu_process_compute;
+  process->pid = pid;
+  SET_GPUINFO_PROCESS(process, cmdline, copy_string(cmdline));
+  if (user_name)
+    SET_GPUINFO_PROCESS(process, user_name, copy_string(user_name));
+  SET_GPUINFO_PROCESS(process, gpu_usage, gpu_usage);
+  SET_GPUINFO_PROCESS(process, gpu_memory_usage, gpu_memory_usage);
+}
+
+// Two devices, the first one running two processes and the second one idle
+void fill_state(struct gpuinfo_protocol_state *state) {
+  state->devices_count = 2;
+  state->devices = (struct gpuinfo_protocol_device *)calloc(2, sizeof(*state->devices));
+  ASSERT_NE(state->devices, nullptr);
+
+  struct gpuinfo_protocol_device *device = &state->devices[0];
+  strcpy(device->pdev, "0000:01:00.0");
+  strcpy(device->static_info.device_name, "First device");
+  SET_VALID(gpuinfo_device_name_valid, device->static_info.valid);
+  SET_GPUINFO_STATIC(&device->static_info, max_pcie_gen, 4);
+  SET_GPUINFO_STATIC(&device->static_info, temperature_shutdown_threshold, 95);
+  device->static_info.encode_decode_shared = true;
+  SET_GPUINFO_DYNAMIC(&device->dynamic_info, gpu_util_rate, 42);
+  SET_GPUINFO_DYNAMIC(&device->dynamic_info, total_memory, 24ull << 30);
+  SET_GPUINFO_DYNAMIC(&device->dynamic_info, used_memory, 3ull << 30);
+  SET_GPUINFO_DYNAMIC(&device->dynamic_info, power_draw, 250000);
+  SET_GPUINFO_DYNAMIC(&device->dynamic_info, energy_consumed, 1ull << 40);
+  device->processes_count = 2;
+  device->processes = (struct gpu_process *)calloc(2, sizeof(*device->processes));
+  ASSERT_NE(device->processes, nullptr);
+  set_process(&device->processes[0], 1234, "python train.py", "alice", 80, 2ull << 30);
+  set_process(&device->processes[1], 5678, "blender", nullptr, 10, 1ull << 30);
+
+  device = &state->devices[1];
+  strcpy(device->pdev, "0000:02:00.0");
+  SET_GPUINFO_STATIC(&device->static_info, max_pcie_link_width, 16);
+  RESET_GPUINFO_DYNAMIC(&device->dynamic_info, gpu_util_rate);
+  SET_GPUINFO_DYNAMIC(&device->dynamic_info, gpu_temp, 35);
+}
+
+void expect_same_process(const struct gpu_process &expected, const struct gpu_process &decoded) {
+  EXPECT_EQ(expected.pid, decoded.pid);
+  EXPECT_EQ(expected.type, decoded.type);
+  EXPECT_EQ(0, memcmp(expected.valid, decoded.valid, sizeof(expected.valid))) << "Process " << expected.pid;
+  if (GPUINFO_PROCESS_FIELD_VALID(&expected, cmdline))
+    EXPECT_STREQ(expected.cmdline, decoded.cmdline);
+  if (GPUINFO_PROCESS_FIELD_VALID(&expected, user_name))
+    EXPECT_STREQ(expected.user_name, decoded.user_name);
+  EXPECT_EQ(expected.gpu_usage, decoded.gpu_usage);
+  EXPECT_EQ(expected.gpu_memory_usage, decoded.gpu_memory_usage);
+}
+
+void expect_same_state(const struct gpuinfo_protocol_state &expected, const struct gpuinfo_protocol_state &decoded) {
+  ASSERT_EQ(expected.devices_count, decoded.devices_count);
+  for (unsigned i = 0; i < expected.devices_count; ++i) {
+    const struct gpuinfo_protocol_device &device = expected.devices[i];
+    const struct gpuinfo_protocol_device &copy = decoded.devices[i];
+    EXPECT_STREQ(device.pdev, copy.pdev);
+    EXPECT_EQ(0, memcmp(&device.static_info, &copy.static_info, sizeof(device.static_info))) << "Device " << i;
+    EXPECT_EQ(0, memcmp(device.dynamic_info.valid, copy.dynamic_info.valid, sizeof(device.dynamic_info.valid)))
+        << "Device " << i;
+    EXPECT_EQ(device.dynamic_info.gpu_util_rate, copy.dynamic_info.gpu_util_rate);
+    EXPECT_EQ(device.dynamic_info.total_memory, copy.dynamic_info.total_memory);
+    EXPECT_EQ(device.dynamic_info.used_memory, copy.dynamic_info.used_memory);
+    EXPECT_EQ(device.dynamic_info.power_draw, copy.dynamic_info.power_draw);
+    EXPECT_EQ(device.dynamic_info.energy_consumed, copy.dynamic_info.energy_consumed);
+    EXPECT_EQ(device.dynamic_info.gpu_temp, copy.dynamic_info.gpu_temp);
+    ASSERT_EQ(device.processes_count, copy.processes_count) << "Device " << i;
+    for (unsigned j = 0; j < device.processes_count; ++j)
+      expect_same_process(device.processes[j], copy.processes[j]);
+  }
+}
+
+// Decodes every message of the buffer, checking their framing on the way
+std::vector<enum gpuinfo_protocol_message> decode_all(const struct gpuinfo_protocol_buffer &buffer,
+                                                      struct gpuinfo_protocol_state *state) {
+  std::vector<enum gpuinfo_protocol_message> types;
+  size_t position = 0;
+  while (position < buffer.size) {
+    size_t length = gpuinfo_protocol_message_length(buffer.data + position, buffer.size - position);
+    EXPECT_GT(length, 0u);
+    if (length == 0)
+      break;
+    enum gpuinfo_protocol_message type;
+    EXPECT_TRUE(gpuinfo_protocol_decode(buffer.data + position, length, state, &type));
+    types.push_back(type);
+    position += length;
+  }
+  EXPECT_EQ(position, buffer.size);
+  return types;
+}
+
+TEST(GpuinfoProtocol, HelloAndKeyframeRoundTrip) {
+  struct gpuinfo_protocol_state sent = {};
+  fill_state(&sent);
+  struct gpuinfo_protocol_buffer buffer = {};
+  gpuinfo_protocol_encode_hello(&buffer, &sent);
+  gpuinfo_protocol_encode_sample(&buffer, nullptr, &sent);
+
+  struct gpuinfo_protocol_state received = {};
+  std::vector<enum gpuinfo_protocol_message> types = decode_all(buffer, &received);
+  ASSERT_EQ(types.size(), 2u);
+  EXPECT_EQ(types[0], gpuinfo_protocol_hello);
+  EXPECT_EQ(types[1], gpuinfo_protocol_sample);
+  expect_same_state(sent, received);
+
+  gpuinfo_protocol_buffer_free(&buffer);
+  gpuinfo_protocol_state_clear(&sent);
+  gpuinfo_protocol_state_clear(&received);
+}
+
+TEST(GpuinfoProtocol, DeltaRoundTrip) {
+  struct gpuinfo_protocol_state previous = {}, current = {};
+  fill_state(&previous);
+  fill_state(&current);
+  struct gpuinfo_protocol_buffer buffer = {};
+  gpuinfo_protocol_encode_hello(&buffer, &previous);
+  gpuinfo_protocol_encode_sample(&buffer, nullptr, &previous);
+  struct gpuinfo_protocol_state received = {};
+  decode_all(buffer, &received);
+  buffer.size = 0;
+
+  // Values change, a field becomes invalid, a process exits and another one starts
+  struct gpuinfo_protocol_device *device = &current.devices[0];
+  SET_GPUINFO_DYNAMIC(&device->dynamic_info, gpu_util_rate, 99);
+  RESET_GPUINFO_DYNAMIC(&device->dynamic_info, power_draw);
+  free(device->processes[0].cmdline);
+  free(device->processes[0].user_name);
+  device->processes[0] = device->processes[1];
+  set_process(&device->processes[1], 9012, "ffmpeg -i input.mkv", "bob", 5, 512ull << 20);
+  SET_GPUINFO_DYNAMIC(&current.devices[1].dynamic_info, gpu_temp, 36);
+  gpuinfo_protocol_encode_sample(&buffer, &previous, &current);
+
+  std::vector<enum gpuinfo_protocol_message> types = decode_all(buffer, &received);
+  ASSERT_EQ(types.size(), 1u);
+  EXPECT_EQ(types[0], gpuinfo_protocol_sample);
+  expect_same_state(current, received);
+
+  // An unchanged sample keeps the state as it is
+  buffer.size = 0;
+  gpuinfo_protocol_encode_sample(&buffer, &current, &current);
+  decode_all(buffer, &received);
+  expect_same_state(current, received);
+
+  gpuinfo_protocol_buffer_free(&buffer);
+  gpuinfo_protocol_state_clear(&previous);
+  gpuinfo_protocol_state_clear(&current);
+  gpuinfo_protocol_state_clear(&received);
+}
+
+TEST(GpuinfoProtocol, TruncatedMessages) {
+  struct gpuinfo_protocol_state sent = {};
+  fill_state(&sent);
+  struct gpuinfo_protocol_buffer hello = {}, sample = {};
+  gpuinfo_protocol_encode_hello(&hello, &sent);
+  gpuinfo_protocol_encode_sample(&sample, nullptr, &sent);
+
+  struct gpuinfo_protocol_state received = {};
+  for (size_t size = 0; size < hello.size; ++size) {
+    // Copied so that the sanitizers catch any read past the end
+    std::vector<unsigned char> prefix(hello.data, hello.data + size);
+    EXPECT_EQ(gpuinfo_protocol_message_length(prefix.data(), size), 0u) << "Prefix of " << size << " bytes";
+    enum gpuinfo_protocol_message type;
+    EXPECT_FALSE(gpuinfo_protocol_decode(prefix.data(), size, &received, &type)) << "Prefix of " << size << " bytes";
+  }
+
+  enum gpuinfo_protocol_message type;
+  ASSERT_TRUE(gpuinfo_protocol_decode(hello.data, hello.size, &received, &type));
+  for (size_t size = 0; size < sample.size; ++size) {
+    std::vector<unsigned char> prefix(sample.data, sample.data + size);
+    EXPECT_EQ(gpuinfo_protocol_message_length(prefix.data(), size), 0u) << "Prefix of " << size << " bytes";
+    EXPECT_FALSE(gpuinfo_protocol_decode(prefix.data(), size, &received, &type)) << "Prefix of " << size << " bytes";
+  }
+
+  gpuinfo_protocol_buffer_free(&hello);
+  gpuinfo_protocol_buffer_free(&sample);
+  gpuinfo_protocol_state_clear(&sent);
+  gpuinfo_protocol_state_clear(&received);
+}
+
+TEST(GpuinfoProtocol, OversizedMessages) {
+  // The header announces a payload larger than the protocol allows
+  std::vector<unsigned char> oversized((64u << 20) + 5);
+  const unsigned char header[] = {0x01, 0x00, 0x00, 0x04, gpuinfo_protocol_hello};
+  memcpy(oversized.data(), header, sizeof(header));
+  EXPECT_EQ(gpuinfo_protocol_message_length(oversized.data(), oversized.size()), 4u);
+  struct gpuinfo_protocol_state received = {};
+  enum gpuinfo_protocol_message type;
+  EXPECT_FALSE(gpuinfo_protocol_decode(oversized.data(), oversized.size(), &received, &type));
+
+  // Counts larger than the remaining bytes are rejected before anything is allocated
+  struct gpuinfo_protocol_state sent = {};
+  fill_state(&sent);
+  struct gpuinfo_protocol_buffer hello = {};
+  gpuinfo_protocol_encode_hello(&hello, &sent);
+  std::vector<unsigned char> message(hello.data, hello.data + hello.size);
+  // Header, type, magic and version, then the devices count varint
+  const size_t devices_count_position = 4 + 1 + 4 + 1;
+  ASSERT_EQ(message[devices_count_position], 2);
+  message[devices_count_position] = 0xff;
+  message.insert(message.begin() + devices_count_position + 1, {0xff, 0xff, 0xff, 0x0f});
+  EXPECT_FALSE(gpuinfo_protocol_decode(message.data(), message.size(), &received, &type));
+  EXPECT_EQ(received.devices_count, 0u);
+
+  gpuinfo_protocol_buffer_free(&hello);
+  gpuinfo_protocol_state_clear(&sent);
+  gpuinfo_protocol_state_clear(&received);
+}
+
+} // namespace
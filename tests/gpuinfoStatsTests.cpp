@@ -0,0 +1,186 @@
+/*
+ *
+ * Copyright (C) 2025 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <vector>
+
+extern "C" {
+#include "nvtop/extract_gpuinfo.h"
+#include "nvtop/gpuinfo_stats.h"
+
+// The statistics only register what they need, the devices are not refreshed here
+void gpuinfo_add_consumer_needs(gpuinfo_subscription needs) { (void)needs; }
+}
+
+namespace {
+
+// STATS_MAX_PROCESSES
+constexpr unsigned max_processes = 256;
+// Half of the width of a bucket, relative to its lowest value
+constexpr double max_relative_error = 1. / 64.;
+
+// Records one sample per value as the power of a single device, and summarizes it
+struct gpuinfo_stats_summary power_summary(const std::vector<uint32_t> &values) {
+  gpuinfo_stats_clear();
+  struct gpu_info device = {};
+  LIST_HEAD(devices);
+  list_add_tail(&device.list, &devices);
+  for (uint32_t value : values) {
+    SET_GPUINFO_DYNAMIC(&device.dynamic_info, power_draw, value);
+    gpuinfo_stats_record(&devices, false);
+  }
+  struct gpuinfo_stats_summary summary;
+  gpuinfo_stats_device_summary(0, gpuinfo_stats_power, &summary);
+  gpuinfo_stats_clear();
+  return summary;
+}
+
+// The median of the value surrounded by the extremes, which are exact whatever their bucket
+double bucketed(uint32_t value) { return power_summary({0, value, value, value, UINT32_MAX}).p50; }
+
+TEST(GpuinfoStats, ExactBelow64) {
+  for (uint32_t value = 0; value < 64; ++value)
+    EXPECT_EQ(bucketed(value), value);
+}
+
+TEST(GpuinfoStats, ErrorBoundAtTheBucketEdges) {
+  // Each power of two from 2^6 is split into 32 buckets, the first and the last value of each one are the furthest
+  // from its middle
+  for (unsigned exponent = 6; exponent < 32; ++exponent) {
+    unsigned shift = exponent - 5;
+    for (uint64_t sub_bucket = 32; sub_bucket < 64; ++sub_bucket) {
+      uint64_t lowest = sub_bucket << shift;
+      uint64_t highest = lowest + (UINT64_C(1) << shift) - 1;
+      for (uint64_t value : {lowest, highest}) {
+        double p50 = bucketed((uint32_t)value);
+        EXPECT_LE(std::abs(p50 - (double)value), (double)value * max_relative_error) << "Value " << value;
+      }
+    }
+  }
+}
+
+TEST(GpuinfoStats, PercentilesOfKnownDistributions) {
+  std::vector<uint32_t> uniform;
+  for (uint32_t value = 1; value <= 100; ++value)
+    uniform.push_back(value);
+  struct gpuinfo_stats_summary summary = power_summary(uniform);
+  EXPECT_EQ(summary.count, 100u);
+  EXPECT_EQ(summary.min, 1.);
+  EXPECT_EQ(summary.max, 100.);
+  EXPECT_DOUBLE_EQ(summary.mean, 50.5);
+  EXPECT_EQ(summary.p50, 50.);
+  EXPECT_NEAR(summary.p95, 95., 95. * max_relative_error);
+  EXPECT_NEAR(summary.p99, 99., 99. * max_relative_error);
+
+  // Mostly idle with a few spikes, in the milliwatts of a large device
+  std::vector<uint32_t> spiky(1000, 80000);
+  for (unsigned i = 0; i < 20; ++i)
+    spiky[i * 50] = 450000;
+  summary = power_summary(spiky);
+  EXPECT_EQ(summary.min, 80000.);
+  EXPECT_EQ(summary.max, 450000.);
+  EXPECT_NEAR(summary.p50, 80000., 80000. * max_relative_error);
+  EXPECT_NEAR(summary.p95, 80000., 80000. * max_relative_error);
+  EXPECT_NEAR(summary.p99, 450000., 450000. * max_relative_error);
+
+  // Geometric, spanning many buckets
+  std::vector<uint32_t> geometric;
+  for (unsigned i = 0; i < 1000; ++i)
+    geometric.push_back((uint32_t)(1000. * std::pow(1.01, i)));
+  summary = power_summary(geometric);
+  EXPECT_NEAR(summary.p50, geometric[499], geometric[499] * max_relative_error);
+  EXPECT_NEAR(summary.p95, geometric[949], geometric[949] * max_relative_error);
+  EXPECT_NEAR(summary.p99, geometric[989], geometric[989] * max_relative_error);
+}
+
+// Records a sample of a device running the processes of the pids
+void record_processes(struct list_head *devices, struct gpu_info *device, const std::vector<pid_t> &pids) {
+  std::vector<struct gpu_process> processes(pids.size());
+  for (size_t i = 0; i < pids.size(); ++i) {
+    processes[i] = {};
+    processes[i].pid = pids[i];
+    SET_GPUINFO_PROCESS(&processes[i], gpu_usage, 10);
+  }
+  device->processes = processes.data();
+  device->processes_count = processes.size();
+  gpuinfo_stats_record(devices, true);
+  device->processes = nullptr;
+  device->processes_count = 0;
+}
+
+bool is_tracked(pid_t pid) {
+  for (unsigned i = 0; i < gpuinfo_stats_processes_count(); ++i) {
+    struct gpuinfo_stats_process process;
+    gpuinfo_stats_process_summary(i, &process);
+    if (process.pid == pid)
+      return true;
+  }
+  return false;
+}
+
+TEST(GpuinfoStats, EvictionWhenTheProcessTableIsFull) {
+  gpuinfo_stats_clear();
+  struct gpu_info device = {};
+  LIST_HEAD(devices);
+  list_add_tail(&device.list, &devices);
+
+  std::vector<pid_t> running;
+  for (unsigned i = 0; i < max_processes; ++i)
+    running.push_back(1000 + i);
+  record_processes(&devices, &device, running);
+  EXPECT_EQ(gpuinfo_stats_processes_count(), max_processes);
+
+  // All the tracked processes still run: the new one is not tracked
+  running.push_back(5000);
+  record_processes(&devices, &device, running);
+  EXPECT_EQ(gpuinfo_stats_processes_count(), max_processes);
+  EXPECT_FALSE(is_tracked(5000));
+
+  // The process gone for the longest time makes room
+  running.erase(running.begin());
+  record_processes(&devices, &device, running);
+  running.erase(running.begin());
+  record_processes(&devices, &device, running);
+  EXPECT_EQ(gpuinfo_stats_processes_count(), max_processes);
+  EXPECT_TRUE(is_tracked(5000));
+  EXPECT_FALSE(is_tracked(1000));
+  EXPECT_TRUE(is_tracked(1001));
+
+  // Another newcomer replaces the next oldest one
+  running.push_back(5001);
+  record_processes(&devices, &device, running);
+  EXPECT_TRUE(is_tracked(5001));
+  EXPECT_FALSE(is_tracked(1001));
+
+  for (unsigned i = 0; i < gpuinfo_stats_processes_count(); ++i) {
+    struct gpuinfo_stats_process process;
+    gpuinfo_stats_process_summary(i, &process);
+    if (process.pid == 5000) {
+      EXPECT_TRUE(process.running);
+      EXPECT_EQ(process.metrics[gpuinfo_stats_process_gpu_usage].count, 3u);
+    }
+  }
+  gpuinfo_stats_clear();
+}
+
+} // namespace
@@ -0,0 +1,124 @@
+/*
+ *
+ * Copyright (C) 2025 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+extern "C" {
+#include "nvtop/interface_history.h"
+}
+
+namespace {
+
+constexpr unsigned max_offset = 32;
+
+struct interface_history_reduction empty_reduction() { return {HISTORY_NO_DATA, HISTORY_NO_DATA, 0, 0}; }
+
+// Slots with data between 0 and HISTORY_NO_DATA - 1, no_data_percent of them without data
+std::vector<uint8_t> random_slots(std::mt19937 &generator, size_t count, unsigned no_data_percent) {
+  std::uniform_int_distribution<unsigned> value(0, HISTORY_NO_DATA - 1), percent(0, 99);
+  std::vector<uint8_t> slots(count);
+  for (uint8_t &slot : slots)
+    slot = percent(generator) < no_data_percent ? HISTORY_NO_DATA : value(generator);
+  return slots;
+}
+
+void expect_same_reduction(const struct interface_history_reduction &reduction,
+                           const struct interface_history_reduction &expected) {
+  EXPECT_EQ(reduction.min, expected.min);
+  EXPECT_EQ(reduction.max, expected.max);
+  EXPECT_EQ(reduction.sum, expected.sum);
+  EXPECT_EQ(reduction.values, expected.values);
+}
+
+// Every kernel gives the reduction of the scalar one, from every alignment of the slots
+void expect_kernels_agree(const uint8_t *min, const uint8_t *avg, const uint8_t *max, unsigned count,
+                          struct interface_history_reduction initial) {
+  const struct interface_history_reduce_kernel *kernels;
+  unsigned kernels_count = interface_history_reduce_kernels(&kernels);
+  ASSERT_GE(kernels_count, 1u);
+  ASSERT_STREQ(kernels[0].name, "scalar");
+  struct interface_history_reduction expected = initial;
+  kernels[0].reduce(min, avg, max, count, &expected);
+  for (unsigned kernel = 1; kernel < kernels_count; ++kernel) {
+    SCOPED_TRACE(kernels[kernel].name);
+    struct interface_history_reduction reduction = initial;
+    kernels[kernel].reduce(min, avg, max, count, &reduction);
+    expect_same_reduction(reduction, expected);
+  }
+}
+
+TEST(InterfaceHistory, ReduceKernelsOnRandomSlots) {
+  std::mt19937 generator(34);
+  for (unsigned no_data_percent : {0u, 10u, 50u, 100u}) {
+    SCOPED_TRACE(testing::Message() << no_data_percent << "% without data");
+    for (unsigned count = 0; count <= 200; ++count) {
+      SCOPED_TRACE(testing::Message() << count << " slots");
+      std::vector<uint8_t> min = random_slots(generator, count + max_offset, no_data_percent);
+      std::vector<uint8_t> avg = random_slots(generator, count + max_offset, no_data_percent);
+      std::vector<uint8_t> max = random_slots(generator, count + max_offset, no_data_percent);
+      for (unsigned offset = 0; offset < max_offset; ++offset) {
+        // The aggregated tiers and the sample tier, whose three aggregates are the same slots
+        expect_kernels_agree(&min[offset], &avg[offset], &max[offset], count, empty_reduction());
+        expect_kernels_agree(&avg[offset], &avg[offset], &avg[offset], count, empty_reduction());
+      }
+    }
+  }
+}
+
+TEST(InterfaceHistory, ReduceKernelsMergeIntoAReduction) {
+  std::mt19937 generator(340);
+  for (unsigned count : {5u, 16u, 47u, 100u}) {
+    std::vector<uint8_t> avg = random_slots(generator, count, 10);
+    expect_kernels_agree(avg.data(), avg.data(), avg.data(), count, {0, 254, 1000, 10});
+    expect_kernels_agree(avg.data(), avg.data(), avg.data(), count, {128, 128, 128, 1});
+  }
+}
+
+TEST(InterfaceHistory, ReduceKernelsAtTheExtremes) {
+  // The longest tier, full of the values the closest to HISTORY_NO_DATA
+  constexpr unsigned count = 7 * 24 * 60;
+  for (uint8_t value : {(uint8_t)0, (uint8_t)(HISTORY_NO_DATA - 1), (uint8_t)HISTORY_NO_DATA}) {
+    SCOPED_TRACE(testing::Message() << "Value " << (unsigned)value);
+    std::vector<uint8_t> slots(count + max_offset, value);
+    for (unsigned offset = 0; offset < max_offset; offset += 7)
+      expect_kernels_agree(&slots[offset], &slots[offset], &slots[offset], count - offset, empty_reduction());
+  }
+
+  // A single slot with data among the missing ones, in every position of a vector and of its tail
+  for (unsigned count : {16u, 32u, 45u, 64u}) {
+    for (unsigned position = 0; position < count; ++position) {
+      std::vector<uint8_t> slots(count, HISTORY_NO_DATA);
+      slots[position] = HISTORY_NO_DATA - 1;
+      expect_kernels_agree(slots.data(), slots.data(), slots.data(), count, empty_reduction());
+      const struct interface_history_reduce_kernel *kernels;
+      interface_history_reduce_kernels(&kernels);
+      struct interface_history_reduction reduction = empty_reduction();
+      kernels[0].reduce(slots.data(), slots.data(), slots.data(), count, &reduction);
+      EXPECT_EQ(reduction.max, HISTORY_NO_DATA - 1);
+      EXPECT_EQ(reduction.values, 1u);
+    }
+  }
+}
+
+} // namespace
@@ -20,6 +20,8 @@
  */
 
 #include <algorithm>
+#include <chrono>
+#include <climits>
 #include <gtest/gtest.h>
 #include <iostream>
 #include <vector>
@@ -200,6 +202,159 @@ TEST(InterfaceLayout, FixInfiniteLoop) {
 
 TEST(InterfaceLayout, LayoutSelection_test_fail_case1) { test_with_terminal_size(32, 3, 55, 16, 1760); }
 
+TEST(InterfaceLayout, CachedLayoutAfterResize) {
+  unsigned device_count = 16, header_rows = 3, header_cols = 78, rows = 120, cols = 400;
+
+  nvtop_interface_gpu_opts to_draw_default = {.to_draw = plot_default_draw_info()};
+  std::vector<nvtop_interface_gpu_opts> plot_display(device_count, to_draw_default);
+
+  process_field_displayed proc_display = process_default_displayed_field();
+
+  struct layout {
+    unsigned num_plots = 0;
+    std::vector<struct window_position> dev_positions;
+    std::vector<struct window_position> plot_positions;
+    struct window_position process_position;
+    struct window_position setup_position;
+    std::vector<unsigned> map_dev_to_plot;
+  };
+  auto compute_layout = [&](unsigned rows, unsigned cols) {
+    layout result;
+    result.dev_positions.resize(device_count);
+    result.plot_positions.resize(MAX_CHARTS);
+    result.map_dev_to_plot.resize(device_count);
+    compute_sizes_from_layout(device_count, header_rows, header_cols, rows, cols, plot_display.data(), proc_display,
+                              result.dev_positions.data(), &result.num_plots, result.plot_positions.data(),
+                              result.map_dev_to_plot.data(), &result.process_position, &result.setup_position, false);
+    result.plot_positions.resize(result.num_plots);
+    return result;
+  };
+  auto same_position = [](const struct window_position &w1, const struct window_position &w2) {
+    return w1.posX == w2.posX && w1.posY == w2.posY && w1.sizeX == w2.sizeX && w1.sizeY == w2.sizeY;
+  };
+
+  layout first = compute_layout(rows, cols);
+  compute_layout(rows / 2, cols / 2);
+  // Changing the plotted metrics must not reuse the previous layout
+  plot_display[0].to_draw = 0;
+  layout without_plot = compute_layout(rows, cols);
+  EXPECT_EQ(without_plot.num_plots + 1, first.num_plots);
+  plot_display[0].to_draw = to_draw_default.to_draw;
+  layout again = compute_layout(rows, cols);
+
+  ASSERT_EQ(first.num_plots, again.num_plots);
+  EXPECT_TRUE(std::equal(first.dev_positions.begin(), first.dev_positions.end(), again.dev_positions.begin(),
+                         same_position));
+  EXPECT_TRUE(std::equal(first.plot_positions.begin(), first.plot_positions.end(), again.plot_positions.begin(),
+                         same_position));
+  EXPECT_EQ(first.map_dev_to_plot, again.map_dev_to_plot);
+  EXPECT_TRUE(same_position(first.process_position, again.process_position));
+  EXPECT_TRUE(same_position(first.setup_position, again.setup_position));
+}
+
+namespace {
+
+// Lines of a block of the heatmap: the device indices and a line per metric (heatmap_metric_count + 1)
+constexpr unsigned heatmap_block_rows = 8;
+// Columns of the metric names (heatmap_label_cols)
+constexpr unsigned heatmap_label_cols = 5;
+
+unsigned heatmap_rows(unsigned device_count, unsigned cols) {
+  unsigned devices_per_block = cols > heatmap_label_cols ? cols - heatmap_label_cols : 1;
+  return (device_count + devices_per_block - 1) / devices_per_block * heatmap_block_rows;
+}
+
+// Longest time taken by the layouts of the terminal sizes up to rows x cols, in microseconds
+template <typename Layout> double slowest_layout(unsigned max_rows, unsigned max_cols, Layout layout) {
+  double slowest = 0.;
+  for (unsigned rows = 8; rows <= max_rows; rows += 3) {
+    for (unsigned cols = 40; cols <= max_cols; cols += 20) {
+      auto start = std::chrono::steady_clock::now();
+      layout(rows, cols);
+      std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+      slowest = std::max(slowest, elapsed.count());
+    }
+  }
+  return slowest;
+}
+
+} // namespace
+
+TEST(InterfaceLayout, HeatmapOnlyAboveMaxCharts) {
+  EXPECT_FALSE(heatmap_layout_selected(1, true));
+  EXPECT_FALSE(heatmap_layout_selected(8, false));
+  EXPECT_FALSE(heatmap_layout_selected(MAX_CHARTS, false));
+  EXPECT_TRUE(heatmap_layout_selected(8, true));
+  EXPECT_TRUE(heatmap_layout_selected(MAX_CHARTS + 1, false));
+  EXPECT_TRUE(heatmap_layout_selected(128, false));
+}
+
+TEST(InterfaceLayout, HeatmapLayoutWith128Devices) {
+  unsigned device_count = 128, header_rows = 3, header_cols = 78;
+  nvtop_interface_gpu_opts to_draw_default = {.to_draw = plot_default_draw_info()};
+  std::vector<nvtop_interface_gpu_opts> plot_display(device_count, to_draw_default);
+  process_field_displayed proc_display = process_default_displayed_field();
+
+  unsigned selected = 0;
+  auto layout = [&](unsigned rows, unsigned cols) {
+    unsigned num_plots = 0;
+    struct window_position heatmap_position;
+    std::vector<struct window_position> dev_positions(device_count);
+    std::vector<struct window_position> plot_positions(MAX_CHARTS);
+    struct window_position process_position, setup_position;
+    std::vector<unsigned> map_dev_to_plot(device_count);
+    compute_sizes_from_heatmap_layout(device_count, selected, heatmap_rows(device_count, cols), header_rows,
+                                      header_cols, rows, cols, plot_display.data(), proc_display, &heatmap_position,
+                                      dev_positions.data(), &num_plots, plot_positions.data(), map_dev_to_plot.data(),
+                                      &process_position, &setup_position, false);
+    plot_positions.resize(num_plots);
+
+    struct window_position screen = {.posX = 0, .posY = 0, .sizeX = cols, .sizeY = rows};
+    EXPECT_EQ(heatmap_position.posY, 0u);
+    EXPECT_EQ(heatmap_position.sizeX, cols);
+    EXPECT_GE(heatmap_position.sizeY, 1u);
+    EXPECT_LE(heatmap_position.sizeY, std::max(rows - header_rows, 1u));
+    // Only the selected device has windows, below the heatmap
+    EXPECT_GE(dev_positions[selected].posY, heatmap_position.sizeY);
+    std::vector<struct window_position> selected_position = {dev_positions[selected]};
+    if (heatmap_position.sizeY + header_rows <= rows)
+      EXPECT_TRUE(check_layout(screen, selected_position, plot_positions, process_position, setup_position))
+          << rows << "x" << cols;
+    for (unsigned i = 0; i < device_count; ++i) {
+      if (i != selected)
+        EXPECT_EQ(map_dev_to_plot[i], UINT_MAX);
+    }
+    selected = (selected + 37) % device_count;
+  };
+  double slowest = slowest_layout(80, 400, layout);
+  RecordProperty("slowest_layout_us", std::to_string(slowest));
+  std::cout << "Slowest layout of 128 devices: " << slowest << "us" << std::endl;
+  // Far below the refresh interval, with room for a loaded machine
+  EXPECT_LT(slowest, 50000.);
+}
+
+TEST(InterfaceLayout, HeaderLayoutWithMaxChartsDevices) {
+  unsigned device_count = MAX_CHARTS, header_rows = 3, header_cols = 78;
+  nvtop_interface_gpu_opts to_draw_default = {.to_draw = plot_default_draw_info()};
+  std::vector<nvtop_interface_gpu_opts> plot_display(device_count, to_draw_default);
+  process_field_displayed proc_display = process_default_displayed_field();
+  auto layout = [&](unsigned rows, unsigned cols) {
+    unsigned num_plots = 0;
+    std::vector<struct window_position> dev_positions(device_count);
+    std::vector<struct window_position> plot_positions(MAX_CHARTS);
+    struct window_position process_position, setup_position;
+    std::vector<unsigned> map_dev_to_plot(device_count);
+    compute_sizes_from_layout(device_count, header_rows, header_cols, rows, cols, plot_display.data(), proc_display,
+                              dev_positions.data(), &num_plots, plot_positions.data(), map_dev_to_plot.data(),
+                              &process_position, &setup_position, false);
+  };
+  double slowest = slowest_layout(80, 400, layout);
+  RecordProperty("slowest_layout_us", std::to_string(slowest));
+  std::cout << "Slowest layout of " << device_count << " devices: " << slowest << "us" << std::endl;
+  // Far below the refresh interval, with room for a loaded machine
+  EXPECT_LT(slowest, 50000.);
+}
+
 #ifdef THOROUGH_TESTING
 
 TEST(InterfaceLayout, CheckManyTermSize) {
@@ -0,0 +1,187 @@
+/*
+ *
+ * Copyright (C) 2025 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "metrics_lines.h"
+}
+
+namespace {
+
+// Writes in a buffer of the given size
+class Line {
+public:
+  explicit Line(size_t size) : buffer(size), writer{buffer.data(), buffer.data() + size, false} {}
+
+  std::string str() const { return std::string(buffer.data(), writer.pos - buffer.data()); }
+
+  std::vector<char> buffer;
+  struct line_writer writer;
+};
+
+std::string tag(enum exporter_format format, const char *value) {
+  Line line(EXPORTER_MAX_TAG_LENGTH * 2);
+  put_tag(&line.writer, format, value);
+  EXPECT_FALSE(line.writer.overflow);
+  return line.str();
+}
+
+std::string uint(uint64_t value) {
+  Line line(20);
+  put_uint(&line.writer, value);
+  EXPECT_FALSE(line.writer.overflow);
+  return line.str();
+}
+
+TEST(MetricsLines, InfluxTagEscaping) {
+  EXPECT_EQ(tag(exporter_influx, "NVIDIA GeForce RTX 4090"), "NVIDIA\\ GeForce\\ RTX\\ 4090");
+  EXPECT_EQ(tag(exporter_influx, "a,b=c d\\e"), "a\\,b\\=c\\ d\\\\e");
+  EXPECT_EQ(tag(exporter_influx, "line\none\ttab\r"), "line_one_tab_");
+  EXPECT_EQ(tag(exporter_influx, "python3 -c \"print('x')\""), "python3\\ -c\\ \"print('x')\"");
+  EXPECT_EQ(tag(exporter_influx, ""), "");
+}
+
+TEST(MetricsLines, StatsdTagSanitizing) {
+  EXPECT_EQ(tag(exporter_statsd, "gpu-node_01"), "gpu-node_01");
+  EXPECT_EQ(tag(exporter_statsd, "node.example.com"), "node_example_com");
+  EXPECT_EQ(tag(exporter_statsd, "a:b|c@d e,f=g\\h\n"), "a_b_c_d_e_f_g_h_");
+  // Each byte of the UTF-8 sequences
+  EXPECT_EQ(tag(exporter_statsd, "caf\xc3\xa9"), "caf__");
+}
+
+TEST(MetricsLines, TagsTruncated) {
+  std::string longest(EXPORTER_MAX_TAG_LENGTH, 'a');
+  EXPECT_EQ(tag(exporter_statsd, (longest + "bcd").c_str()), longest);
+  // The escaping does not count
+  std::string spaces(EXPORTER_MAX_TAG_LENGTH + 10, ' ');
+  std::string escaped;
+  for (unsigned i = 0; i < EXPORTER_MAX_TAG_LENGTH; ++i)
+    escaped += "\\ ";
+  EXPECT_EQ(tag(exporter_influx, spaces.c_str()), escaped);
+}
+
+TEST(MetricsLines, Uint) {
+  EXPECT_EQ(uint(0), "0");
+  EXPECT_EQ(uint(7), "7");
+  EXPECT_EQ(uint(10), "10");
+  EXPECT_EQ(uint(1234567890), "1234567890");
+  EXPECT_EQ(uint(UINT64_MAX), "18446744073709551615");
+}
+
+TEST(MetricsLines, Overflow) {
+  Line exact(5);
+  put_string(&exact.writer, "gpu");
+  put_uint(&exact.writer, 42);
+  EXPECT_FALSE(exact.writer.overflow);
+  EXPECT_EQ(exact.str(), "gpu42");
+  put_char(&exact.writer, '\n');
+  EXPECT_TRUE(exact.writer.overflow);
+
+  Line digits(4);
+  put_uint(&digits.writer, 12345);
+  EXPECT_TRUE(digits.writer.overflow);
+  EXPECT_EQ(digits.str(), "");
+
+  Line string(4);
+  put_string(&string.writer, "nvtop");
+  EXPECT_TRUE(string.writer.overflow);
+
+  Line escapes(3);
+  put_tag(&escapes.writer, exporter_influx, "a b");
+  EXPECT_TRUE(escapes.writer.overflow);
+}
+
+// A queue whose datagrams are filled by lines of a given size, each line starting with its number
+class Queue {
+public:
+  Queue() : datagrams(EXPORTER_QUEUE_LENGTH) { queue = {datagrams.data(), 0, 0, {}, 0}; }
+
+  void add_line(unsigned number, size_t size) {
+    std::vector<char> buffer(size);
+    struct line_writer writer = {buffer.data(), buffer.data() + size, false};
+    put_uint(&writer, number);
+    while (!writer.overflow && writer.pos != writer.end)
+      put_char(&writer, writer.pos + 1 == writer.end ? '\n' : ' ');
+    exporter_add_line(&queue, &writer, buffer.data());
+  }
+
+  // Number of the first line of a datagram
+  unsigned first_line(const struct exporter_datagram *datagram) const {
+    return std::stoul(std::string(datagram->data, datagram->size));
+  }
+
+  std::vector<struct exporter_datagram> datagrams;
+  struct exporter_queue queue;
+};
+
+TEST(MetricsLines, LinesBatchedInDatagrams) {
+  Queue queue;
+  constexpr size_t line_size = EXPORTER_DATAGRAM_SIZE / 4;
+  for (unsigned line = 0; line < 9; ++line)
+    queue.add_line(line, line_size);
+  // Four lines per datagram
+  EXPECT_EQ(queue.queue.count, 2u);
+  EXPECT_EQ(queue.queue.dropped, 0u);
+  EXPECT_EQ(queue.datagrams[0].size, 4 * line_size);
+  EXPECT_EQ(queue.first_line(&queue.datagrams[1]), 4u);
+  EXPECT_EQ(exporter_filling_datagram(&queue.queue)->size, line_size);
+  EXPECT_EQ(queue.first_line(exporter_filling_datagram(&queue.queue)), 8u);
+}
+
+TEST(MetricsLines, OverflowingLinesDiscarded) {
+  Queue queue;
+  std::vector<char> buffer(16);
+  struct line_writer writer = {buffer.data(), buffer.data() + buffer.size(), false};
+  put_string(&writer, "nvtop_gpu,name=");
+  put_tag(&writer, exporter_influx, "too long for the line");
+  ASSERT_TRUE(writer.overflow);
+  exporter_add_line(&queue.queue, &writer, buffer.data());
+  EXPECT_EQ(exporter_filling_datagram(&queue.queue)->size, 0u);
+  EXPECT_EQ(queue.queue.count, 0u);
+}
+
+TEST(MetricsLines, OldestDatagramsDroppedWhenTheQueueIsFull) {
+  Queue queue;
+  // One line per datagram: the queue holds the sealed datagrams and the one being filled
+  constexpr unsigned lines = EXPORTER_QUEUE_LENGTH + 36;
+  for (unsigned line = 0; line < lines; ++line)
+    queue.add_line(line, EXPORTER_DATAGRAM_SIZE / 2 + 1);
+  EXPECT_EQ(queue.queue.count, EXPORTER_QUEUE_LENGTH - 1u);
+  EXPECT_EQ(queue.queue.dropped, lines - EXPORTER_QUEUE_LENGTH);
+  EXPECT_EQ(queue.first_line(&queue.datagrams[queue.queue.head]), lines - EXPORTER_QUEUE_LENGTH);
+  for (unsigned i = 0; i < queue.queue.count; ++i) {
+    const struct exporter_datagram *datagram = &queue.datagrams[(queue.queue.head + i) % EXPORTER_QUEUE_LENGTH];
+    EXPECT_EQ(queue.first_line(datagram), lines - EXPORTER_QUEUE_LENGTH + i);
+  }
+  EXPECT_EQ(queue.first_line(exporter_filling_datagram(&queue.queue)), lines - 1);
+
+  // Sealing the last one drops one more
+  exporter_seal_datagram(&queue.queue);
+  EXPECT_EQ(queue.queue.count, EXPORTER_QUEUE_LENGTH - 1u);
+  EXPECT_EQ(queue.queue.dropped, lines - EXPORTER_QUEUE_LENGTH + 1);
+  EXPECT_EQ(exporter_filling_datagram(&queue.queue)->size, 0u);
+}
+
+} // namespace
@@ -0,0 +1,144 @@
+/*
+ *
+ * Copyright (C) 2025 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include "nvtop/extract_gpuinfo_common.h"
+#include "nvtop/power_sampler.h"
+#include "power_samples.h"
+}
+
+namespace {
+
+// POWER_SAMPLER_RING_SIZE
+constexpr unsigned ring_size = 2048;
+constexpr uint64_t millisecond = UINT64_C(1000000);
+
+unsigned power_from_energy(uint64_t previous, uint64_t value, unsigned counter_bits, uint64_t elapsed) {
+  unsigned power = 0;
+  EXPECT_TRUE(power_samples_from_energy(previous, value, counter_bits, elapsed, &power));
+  return power;
+}
+
+TEST(PowerSamples, EnergyIncrease) {
+  // 2000 uJ in a millisecond are 2 W
+  EXPECT_EQ(power_from_energy(1000, 3000, 64, millisecond), 2000u);
+  EXPECT_EQ(power_from_energy(1000, 3000, 32, millisecond), 2000u);
+}
+
+TEST(PowerSamples, MaskedWrapBelow64Bits) {
+  EXPECT_EQ(power_from_energy(UINT32_MAX - 999, 1000, 32, millisecond), 2000u);
+  EXPECT_EQ(power_from_energy((UINT64_C(1) << 48) - 1000, 1000, 48, millisecond), 2000u);
+  // The wrap to exactly 0
+  EXPECT_EQ(power_from_energy(UINT32_MAX - 1999, 0, 32, millisecond), 2000u);
+}
+
+TEST(PowerSamples, ResetOnADecreaseAt64Bits) {
+  unsigned power = 1234;
+  EXPECT_FALSE(power_samples_from_energy(5000, 1000, 64, millisecond, &power));
+  EXPECT_FALSE(power_samples_from_energy(UINT64_MAX - 999, 1000, 64, millisecond, &power));
+  EXPECT_EQ(power, 1234u);
+}
+
+TEST(PowerSamples, ClampedToUintMax) {
+  EXPECT_EQ(power_from_energy(0, UINT_MAX - 1, 64, millisecond), UINT_MAX - 1);
+  EXPECT_EQ(power_from_energy(0, UINT_MAX, 64, millisecond), UINT_MAX);
+  EXPECT_EQ(power_from_energy(0, UINT_MAX + UINT64_C(1), 64, millisecond), UINT_MAX);
+  // The energy in millions of milliwatts would overflow
+  EXPECT_EQ(power_from_energy(0, UINT64_MAX / 1000000 + 1, 64, 1), UINT_MAX);
+  EXPECT_EQ(power_from_energy(0, UINT64_MAX - 1, 64, UINT64_MAX), UINT_MAX);
+}
+
+struct power_samples_summary summarize(unsigned count) {
+  std::vector<unsigned> samples(count);
+  std::iota(samples.begin(), samples.end(), 1u);
+  std::shuffle(samples.begin(), samples.end(), std::mt19937(count));
+  struct power_samples_summary summary;
+  power_samples_summarize(samples.data(), count, &summary);
+  EXPECT_TRUE(std::is_sorted(samples.begin(), samples.end()));
+  return summary;
+}
+
+TEST(PowerSamples, NearestRankP99) {
+  // The smallest sample with at least 99% of the samples at or below it
+  for (auto [count, p99] : std::vector<std::pair<unsigned, unsigned>>{
+           {1, 1}, {2, 2}, {99, 99}, {100, 99}, {101, 100}, {200, 198}, {1000, 990}, {2048, 2028}}) {
+    struct power_samples_summary summary = summarize(count);
+    EXPECT_EQ(summary.p99, p99) << count << " samples";
+    EXPECT_EQ(summary.peak, count);
+    EXPECT_EQ(summary.average, (count + 1) / 2);
+  }
+}
+
+// A device whose power is the number of readings taken so far
+std::atomic<unsigned> readings;
+
+bool count_readings(struct gpu_info *gpu_info, struct gpuinfo_power_reading *reading) {
+  (void)gpu_info;
+  reading->is_energy = false;
+  reading->counter_bits = 0;
+  reading->value = ++readings;
+  return true;
+}
+
+TEST(PowerSampler, NewestSamplesDroppedWhenTheRingIsFull) {
+  struct gpu_vendor vendor = {};
+  vendor.sample_power = count_readings;
+  struct gpu_info device = {};
+  device.vendor = &vendor;
+  device.subscription = GPUINFO_SUBSCRIPTION_ALL;
+  LIST_HEAD(devices);
+  list_add_tail(&device.list, &devices);
+
+  // Far above the rates of the interface, for the ring to fill up while the refresh is late
+  ASSERT_TRUE(power_sampler_start(&devices, 100000));
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+  while (readings < ring_size + 100 && std::chrono::steady_clock::now() < deadline)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  ASSERT_GE(readings, ring_size + 100);
+
+  // The ring kept the first readings
+  power_sampler_apply(&device);
+  EXPECT_EQ(device.dynamic_info.power_draw_peak, ring_size);
+  EXPECT_EQ(device.dynamic_info.power_draw_p99, 2028u); // Nearest rank of 1 to 2048
+  EXPECT_EQ(device.dynamic_info.power_draw, ring_size / 2);
+
+  // Draining the ring makes room for the new readings, the dropped ones are gone
+  unsigned drained = readings;
+  while (readings < drained + 10 && std::chrono::steady_clock::now() < deadline)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  power_sampler_apply(&device);
+  power_sampler_stop();
+  EXPECT_GT(device.dynamic_info.power_draw_peak, drained);
+  EXPECT_GT(device.dynamic_info.power_draw, drained);
+}
+
+} // namespace
@@ -0,0 +1,124 @@
+/*
+ *
+ * Copyright (C) 2025 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "process_cpus.h"
+}
+
+namespace {
+
+std::vector<unsigned> cpus_of(const struct nvtop_cpu_set &cpus) {
+  std::vector<unsigned> set;
+  for (unsigned cpu = 0; cpu < NVTOP_MAX_CPUS; ++cpu) {
+    if (NVTOP_CPU_ISSET(cpu, &cpus))
+      set.push_back(cpu);
+  }
+  return set;
+}
+
+TEST(ProcessCpus, CpuList) {
+  struct nvtop_cpu_set cpus;
+  ASSERT_TRUE(parse_cpu_list("0-3,8,10-11", &cpus));
+  EXPECT_EQ(cpus_of(cpus), (std::vector<unsigned>{0, 1, 2, 3, 8, 10, 11}));
+  ASSERT_TRUE(parse_cpu_list("5", &cpus));
+  EXPECT_EQ(cpus_of(cpus), (std::vector<unsigned>{5}));
+  // The previous content is cleared
+  ASSERT_TRUE(parse_cpu_list("", &cpus));
+  EXPECT_TRUE(cpus_of(cpus).empty());
+}
+
+TEST(ProcessCpus, CpuListLineOfAFile) {
+  struct nvtop_cpu_set cpus;
+  ASSERT_TRUE(parse_cpu_list("0-1,4\n", &cpus));
+  EXPECT_EQ(cpus_of(cpus), (std::vector<unsigned>{0, 1, 4}));
+  // Only the first line
+  ASSERT_TRUE(parse_cpu_list("2\n3\n", &cpus));
+  EXPECT_EQ(cpus_of(cpus), (std::vector<unsigned>{2}));
+  ASSERT_TRUE(parse_cpu_list("\n", &cpus));
+  EXPECT_TRUE(cpus_of(cpus).empty());
+}
+
+TEST(ProcessCpus, InvalidCpuList) {
+  struct nvtop_cpu_set cpus;
+  EXPECT_FALSE(parse_cpu_list("3-1", &cpus));
+  EXPECT_FALSE(parse_cpu_list("0,8-7\n", &cpus));
+  EXPECT_FALSE(parse_cpu_list("0-", &cpus));
+  EXPECT_FALSE(parse_cpu_list("0,,1", &cpus));
+  EXPECT_FALSE(parse_cpu_list("0-3x", &cpus));
+  EXPECT_FALSE(parse_cpu_list("cpu0", &cpus));
+}
+
+TEST(ProcessCpus, CpusAboveTheMaximumIgnored) {
+  struct nvtop_cpu_set cpus;
+  std::string list = "1," + std::to_string(NVTOP_MAX_CPUS - 2) + "-" + std::to_string(NVTOP_MAX_CPUS + 5) + "," +
+                     std::to_string(NVTOP_MAX_CPUS);
+  ASSERT_TRUE(parse_cpu_list(list.c_str(), &cpus));
+  EXPECT_EQ(cpus_of(cpus), (std::vector<unsigned>{1, NVTOP_MAX_CPUS - 2, NVTOP_MAX_CPUS - 1}));
+  // A range up to the largest CPU number does not go through all of them
+  ASSERT_TRUE(parse_cpu_list("0-4294967295", &cpus));
+  EXPECT_EQ(cpus_of(cpus).size(), (size_t)NVTOP_MAX_CPUS);
+}
+
+// A stat file of 52 fields, field k holding 1000 + k except the processor in field 39
+std::string stat_file(const std::string &comm, unsigned processor) {
+  std::string stat = "4242 (" + comm + ") S";
+  for (unsigned field = 4; field <= 52; ++field)
+    stat += " " + std::to_string(field == 39 ? processor : 1000 + field);
+  return stat + "\n";
+}
+
+TEST(ProcessCpus, StatProcessor) {
+  unsigned cpu = 0;
+  ASSERT_TRUE(parse_stat_processor(stat_file("python3", 7).c_str(), &cpu));
+  EXPECT_EQ(cpu, 7u);
+  ASSERT_TRUE(parse_stat_processor(stat_file("kworker/u64:2", 0).c_str(), &cpu));
+  EXPECT_EQ(cpu, 0u);
+}
+
+TEST(ProcessCpus, StatProcessorOfAStrangeCommand) {
+  unsigned cpu = 0;
+  // The fields are counted from the last parenthesis
+  ASSERT_TRUE(parse_stat_processor(stat_file("a) (b", 12).c_str(), &cpu));
+  EXPECT_EQ(cpu, 12u);
+  ASSERT_TRUE(parse_stat_processor(stat_file(") 1 2 3 4 5 (", 13).c_str(), &cpu));
+  EXPECT_EQ(cpu, 13u);
+  ASSERT_TRUE(parse_stat_processor(stat_file("tmux: server", 14).c_str(), &cpu));
+  EXPECT_EQ(cpu, 14u);
+  ASSERT_TRUE(parse_stat_processor(stat_file("))", 15).c_str(), &cpu));
+  EXPECT_EQ(cpu, 15u);
+}
+
+TEST(ProcessCpus, TruncatedStat) {
+  unsigned cpu = 0;
+  EXPECT_FALSE(parse_stat_processor("4242 (python3) S 1 2 3", &cpu));
+  EXPECT_FALSE(parse_stat_processor(stat_file("python3", 7).substr(0, 8).c_str(), &cpu));
+  EXPECT_FALSE(parse_stat_processor("", &cpu));
+  std::string stat = stat_file("python3", 7);
+  // Cut right before the processor
+  stat = stat.substr(0, stat.find(" 7 ") + 1);
+  EXPECT_FALSE(parse_stat_processor(stat.c_str(), &cpu));
+}
+
+} // namespace